@@ -0,0 +1,128 @@
+/***********************************************************************
+ *                   GNU Lesser General Public License
+ *
+ * This file is part of the EDGI prototype package, developed by the
+ * GFDL Flexible Modeling System (FMS) group.
+ *
+ * EDGI is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * EDGI is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with EDGI.  If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************/
+
+#ifndef LAPACKE_TRAITS_HPP
+#define LAPACKE_TRAITS_HPP
+
+/** Use std::complex */
+#include <complex>
+
+/** Use LAPACKE_* */
+#ifdef WITH_MKL
+    #include "mkl_lapacke.h"
+#else
+    #include <lapacke.h>
+#endif
+
+
+
+
+
+//==============================================================================
+// Declaration
+//==============================================================================
+
+/**
+ * Maps an element type onto the matching LAPACKE routines, so that each
+ * solver can be written once as a template instead of once per type. The
+ * eigensolver is syevd for real types and heevd for complex types.
+ */
+template<typename T>
+struct lapacke_traits;
+
+
+
+
+
+//==============================================================================
+// Template Specializations
+//==============================================================================
+
+template<>
+struct lapacke_traits<float> {
+    typedef float real_t;
+
+    static lapack_int gesvd(int layout, char jobu, char jobvt, lapack_int m, lapack_int n,
+                            float* a, lapack_int lda, float* s,
+                            float* u, lapack_int ldu, float* vt, lapack_int ldvt, float* superb) {
+        return LAPACKE_sgesvd(layout, jobu, jobvt, m, n, a, lda, s, u, ldu, vt, ldvt, superb);
+    }
+
+    static lapack_int heevd(int layout, char jobz, char uplo, lapack_int n,
+                            float* a, lapack_int lda, float* w) {
+        return LAPACKE_ssyevd(layout, jobz, uplo, n, a, lda, w);
+    }
+};
+
+template<>
+struct lapacke_traits<double> {
+    typedef double real_t;
+
+    static lapack_int gesvd(int layout, char jobu, char jobvt, lapack_int m, lapack_int n,
+                            double* a, lapack_int lda, double* s,
+                            double* u, lapack_int ldu, double* vt, lapack_int ldvt, double* superb) {
+        return LAPACKE_dgesvd(layout, jobu, jobvt, m, n, a, lda, s, u, ldu, vt, ldvt, superb);
+    }
+
+    static lapack_int heevd(int layout, char jobz, char uplo, lapack_int n,
+                            double* a, lapack_int lda, double* w) {
+        return LAPACKE_dsyevd(layout, jobz, uplo, n, a, lda, w);
+    }
+};
+
+template<>
+struct lapacke_traits<std::complex<float>> {
+    typedef float real_t;
+
+    static lapack_int gesvd(int layout, char jobu, char jobvt, lapack_int m, lapack_int n,
+                            std::complex<float>* a, lapack_int lda, float* s,
+                            std::complex<float>* u, lapack_int ldu, std::complex<float>* vt, lapack_int ldvt, float* superb) {
+        return LAPACKE_cgesvd(layout, jobu, jobvt, m, n,
+                              (lapack_complex_float*) a, lda, s,
+                              (lapack_complex_float*) u, ldu,
+                              (lapack_complex_float*) vt, ldvt, superb);
+    }
+
+    static lapack_int heevd(int layout, char jobz, char uplo, lapack_int n,
+                            std::complex<float>* a, lapack_int lda, float* w) {
+        return LAPACKE_cheevd(layout, jobz, uplo, n, (lapack_complex_float*) a, lda, w);
+    }
+};
+
+template<>
+struct lapacke_traits<std::complex<double>> {
+    typedef double real_t;
+
+    static lapack_int gesvd(int layout, char jobu, char jobvt, lapack_int m, lapack_int n,
+                            std::complex<double>* a, lapack_int lda, double* s,
+                            std::complex<double>* u, lapack_int ldu, std::complex<double>* vt, lapack_int ldvt, double* superb) {
+        return LAPACKE_zgesvd(layout, jobu, jobvt, m, n,
+                              (lapack_complex_double*) a, lda, s,
+                              (lapack_complex_double*) u, ldu,
+                              (lapack_complex_double*) vt, ldvt, superb);
+    }
+
+    static lapack_int heevd(int layout, char jobz, char uplo, lapack_int n,
+                            std::complex<double>* a, lapack_int lda, double* w) {
+        return LAPACKE_zheevd(layout, jobz, uplo, n, (lapack_complex_double*) a, lda, w);
+    }
+};
+
+#endif
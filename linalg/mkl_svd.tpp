@@ -28,7 +28,9 @@
 using std::complex;
 
 #include "mkl.h"
-#include "mkl_lapacke.h"
+
+/** Use lapacke_traits */
+#include "lapacke_traits.hpp"
 
 #include "debug.hpp"
 
@@ -63,15 +65,16 @@ void mkl_svd_t<T>::set_num_threads(size_t num_threads) {
 
 
 //==============================================================================
-// Template Specializations
+// Template Implementation
 //==============================================================================
 
-template<>
-void mkl_svd_t<float>::calculate(
-    matrix_t<float>* input,
-    matrix_t<float>* u,
-    matrix_t<float>* s,
-    matrix_t<float>* vt
+template<typename T>
+template<typename U>
+void mkl_svd_t<T>::solve(
+    matrix_t<U>* input,
+    matrix_t<U>* u,
+    matrix_t<T>* s,
+    matrix_t<U>* vt
 ) {
     // Get the size of each dimension
     size_t rows = input->get_rows();
@@ -82,7 +85,7 @@ void mkl_svd_t<float>::calculate(
     bool delete_u = false;
     if (u == nullptr) {
         delete_u = true;
-        u = new matrix_t<float>(rows, rows);
+        u = new matrix_t<U>(rows, rows);
     } else {
         u->set_shape(rows, rows);
     }
@@ -91,7 +94,7 @@ void mkl_svd_t<float>::calculate(
     bool delete_s = false;
     if (s == nullptr) {
         delete_s = true;
-        s = new matrix_t<float>(1, min_dim);
+        s = new matrix_t<T>(1, min_dim);
     } else {
         s->set_shape(1, min_dim);
     }
@@ -100,7 +103,7 @@ void mkl_svd_t<float>::calculate(
     bool delete_vt = false;
     if (vt == nullptr) {
         delete_vt = true;
-        vt = new matrix_t<float>(cols, cols);
+        vt = new matrix_t<U>(cols, cols);
     } else {
         vt->set_shape(cols, cols);
     }
@@ -113,7 +116,7 @@ void mkl_svd_t<float>::calculate(
     
     // Launch SVD solver
     // TODO check return value for success / error code
-    LAPACKE_ssyevd(
+    lapacke_traits<U>::heevd(
         LAPACK_COL_MAJOR,
         'V',                      // jobz
         'U',                      // uplo
@@ -142,78 +145,22 @@ void mkl_svd_t<float>::calculate(
     }
 }
 
-template<>
-void mkl_svd_t<float>::calculate(
-    matrix_t<std::complex<float>>* input,
-    matrix_t<std::complex<float>>* u,
-    matrix_t<float>*               s,
-    matrix_t<std::complex<float>>* vt
+template<typename T>
+void mkl_svd_t<T>::calculate(
+    matrix_t<T>* input,
+    matrix_t<T>* u,
+    matrix_t<T>* s,
+    matrix_t<T>* vt
 ) {
-    // Get the size of each dimension
-    size_t rows = input->get_rows();
-    size_t cols = input->get_cols();
-    size_t min_dim = (rows <= cols) ? rows : cols;
-    
-    // Check and setup argument u
-    bool delete_u = false;
-    if (u == nullptr) {
-        delete_u = true;
-        u = new matrix_t<std::complex<float>>(rows, rows);
-    } else {
-        u->set_shape(rows, rows);
-    }
-    
-    // Check and setup argument s
-    bool delete_s = false;
-    if (s == nullptr) {
-        delete_s = true;
-        s = new matrix_t<float>(1, min_dim);
-    } else {
-        s->set_shape(1, min_dim);
-    }
-    
-    // Check and setup argument vt
-    bool delete_vt = false;
-    if (vt == nullptr) {
-        delete_vt = true;
-        vt = new matrix_t<std::complex<float>>(cols, cols);
-    } else {
-        vt->set_shape(cols, cols);
-    }
-    
-    //omp_set_num_threads(this->num_threads);
-    mkl_set_num_threads(this->num_threads);
-    
-    // Start the SVD timer
-    time_t start = time(nullptr);
-    
-    // Launch SVD solver
-    // TODO check return value for success / error code
-    LAPACKE_cheevd(
-        LAPACK_COL_MAJOR,
-        'V',                      // jobz
-        'U',                      // uplo
-        rows,                     // n
-        input->get_data_unsafe(), // a
-        rows,                     // lda
-        s->get_data_unsafe());    // work
+    this->solve(input, u, s, vt);
+}
 
-    // MKL solvers return answers in-situ, so copy input->data to u->data
-    u->set_submatrix(0, 0, rows, cols, input);
-    
-    // Print the time required to compute the SVD
-    time_t end = time(nullptr);
-    double time = difftime(end,start);
-    std::cout << "svd: " << time << "s; ";
-    
-    // Cleanup optional arguments u, s, and vt
-    if (delete_u) {
-        delete u;
-    }
-    if (delete_s) {
-        delete s;
-    }
-    if (delete_vt) {
-        delete vt;
-    }
+template<typename T>
+void mkl_svd_t<T>::calculate(
+    matrix_t<std::complex<T>>* input,
+    matrix_t<std::complex<T>>* u,
+    matrix_t<T>*               s,
+    matrix_t<std::complex<T>>* vt
+) {
+    this->solve(input, u, s, vt);
 }
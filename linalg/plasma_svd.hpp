@@ -39,6 +39,18 @@ template<typename T>
 class plasma_svd_t : public svd_t<T> {
 private:
     size_t num_threads;
+
+    /**
+     * The decomposition itself, written once for real (U = T) and complex
+     * (U = std::complex<T>) input
+     */
+    template<typename U>
+    void solve(
+        matrix_t<U>* input,
+        matrix_t<U>* u,
+        matrix_t<T>* s,
+        matrix_t<U>* vt
+    );
     
 public:
     /**
@@ -22,6 +22,9 @@
 
 #include <cstdlib>
 #include <plasma.h>
+
+/** Use plasma_traits */
+#include "plasma_traits.hpp"
 #include <omp.h>
 #include <ctime>
 
@@ -61,15 +64,16 @@ void plasma_svd_t<T>::set_num_threads(size_t num_threads) {
 
 
 //==============================================================================
-// Template Specializations
+// Template Implementation
 //==============================================================================
 
-template<>
-void plasma_svd_t<float>::calculate(
-    matrix_t<float>* input,
-    matrix_t<float>* u,
-    matrix_t<float>* s,
-    matrix_t<float>* vt
+template<typename T>
+template<typename U>
+void plasma_svd_t<T>::solve(
+    matrix_t<U>* input,
+    matrix_t<U>* u,
+    matrix_t<T>* s,
+    matrix_t<U>* vt
 ) {
     // Get the size of each dimension
     size_t rows = input->get_rows();
@@ -80,7 +84,7 @@ void plasma_svd_t<float>::calculate(
     bool delete_u = false;
     if (u == nullptr) {
         delete_u = true;
-        u = new matrix_t<float>(rows, rows);
+        u = new matrix_t<U>(rows, rows);
     } else {
         u->set_shape(rows, rows);
     }
@@ -89,7 +93,7 @@ void plasma_svd_t<float>::calculate(
     bool delete_s = false;
     if (s == nullptr) {
         delete_s = true;
-        s = new matrix_t<float>(1, min_dim);
+        s = new matrix_t<T>(1, min_dim);
     } else {
         s->set_shape(1, min_dim);
     }
@@ -98,7 +102,7 @@ void plasma_svd_t<float>::calculate(
     bool delete_vt = false;
     if (vt == nullptr) {
         delete_vt = true;
-        vt = new matrix_t<float>(cols, cols);
+        vt = new matrix_t<U>(cols, cols);
     } else {
         vt->set_shape(cols, cols);
     }
@@ -108,38 +112,23 @@ void plasma_svd_t<float>::calculate(
     
     // Allocate Plasma workspace
     PLASMA_desc* handle;
-    PLASMA_Alloc_Workspace_ssyevd(rows, cols, &handle);
+    plasma_traits<U>::alloc_workspace_heevd(rows, cols, &handle);
     
     // Start the SVD timer
     time_t start = time(nullptr);
     
     // Launch SVD solver
     // TODO check return value for success / error code
-/*
-    PLASMA_sgesdd(
-        PlasmaVec,                  // compute all vectors in U
-        PlasmaVec,                  // compute all vectors in VT
-        rows,                       // number of rows in M
-        cols,                       // number of columns in M
-        input->get_data_unsafe(),   // M
-        rows,                       // leading dimension of M
-        s->get_data_unsafe(),       // S
-        handle,                     // memory handle
-        u->get_data_unsafe(),       // U
-        rows,                       // leading dimension of U
-        vt->get_data_unsafe(),      // VT
-        cols                        // leading dimension of VT
-    );
-*/
-    PLASMA_ssyevd(PlasmaVec,                // jobz
-                  PlasmaUpper,              // uplo
-                  rows,                     // N
-                  input->get_data_unsafe(), // A
-                  rows,                     // LDA
-                  s->get_data_unsafe(),     // W
-                  handle,                   // descT
-                  u->get_data_unsafe(),     // Q
-                  rows);                    // LDQ
+    plasma_traits<U>::heevd(
+        PlasmaVec,                // jobz
+        PlasmaUpper,              // uplo
+        rows,                     // N
+        input->get_data_unsafe(), // A
+        rows,                     // LDA
+        s->get_data_unsafe(),     // W
+        handle,                   // descT
+        u->get_data_unsafe(),     // Q
+        rows);                    // LDQ
     
     // Print the time required to compute the SVD
     time_t end = time(nullptr);
@@ -162,101 +151,22 @@ void plasma_svd_t<float>::calculate(
     }
 }
 
-template<>
-void plasma_svd_t<float>::calculate(
-    matrix_t<std::complex<float>>* input,
-    matrix_t<std::complex<float>>* u,
-    matrix_t<float>*               s,
-    matrix_t<std::complex<float>>* vt
+template<typename T>
+void plasma_svd_t<T>::calculate(
+    matrix_t<T>* input,
+    matrix_t<T>* u,
+    matrix_t<T>* s,
+    matrix_t<T>* vt
 ) {
-    // Get the size of each dimension
-    size_t rows = input->get_rows();
-    size_t cols = input->get_cols();
-    size_t min_dim = (rows <= cols) ? rows : cols;
-    
-    // Check and setup argument u
-    bool delete_u = false;
-    if (u == nullptr) {
-        delete_u = true;
-        u = new matrix_t<std::complex<float>>(rows, rows);
-    } else {
-        u->set_shape(rows, rows);
-    }
-    
-    // Check and setup argument s
-    bool delete_s = false;
-    if (s == nullptr) {
-        delete_s = true;
-        s = new matrix_t<float>(1, min_dim);
-    } else {
-        s->set_shape(1, min_dim);
-    }
-    
-    // Check and setup argument vt
-    bool delete_vt = false;
-    if (vt == nullptr) {
-        delete_vt = true;
-        vt = new matrix_t<std::complex<float>>(cols, cols);
-    } else {
-        vt->set_shape(cols, cols);
-    }
-    
-    // Initialize Plasma
-    PLASMA_Init(this->num_threads);
-    
-    // Allocate Plasma workspace
-    PLASMA_desc* handle;
-    PLASMA_Alloc_Workspace_cheevd(rows, cols, &handle);
-    
-    // Start the SVD timer
-    time_t start = time(nullptr);
-    
-    // Launch SVD solver
-    // TODO check return value for success / error code
-/*
-    PLASMA_cgesdd(
-        PlasmaVec,                                      // compute all vectors in U
-        PlasmaVec,                                      // compute all vectors in VT
-        rows,                                           // number of rows in M
-        cols,                                           // number of columns in M
-        (PLASMA_Complex32_t*) input->get_data_unsafe(), // M
-        rows,                                           // leading dimension of M
-        s->get_data_unsafe(),                           // S
-        handle,                                         // memory handle
-        (PLASMA_Complex32_t*) u->get_data_unsafe(),     // U
-        rows,                                           // leading dimension of U
-        (PLASMA_Complex32_t*) vt->get_data_unsafe(),    // VT
-        cols                                            // leading dimension of VT
-    );
-*/
-    PLASMA_cheevd(PlasmaVec,                                        // jobz
-                  PlasmaUpper,                                      // uplo
-                  rows,                                             // N
-                  (PLASMA_Complex32_t*) input->get_data_unsafe(),   // A
-                  rows,                                             // LDA
-                  s->get_data_unsafe(),                             // W
-                  handle,                                           // descT
-                  (PLASMA_Complex32_t*) u->get_data_unsafe(),       // Q
-                  rows);                                            // LDQ
-    
-    // Print the time required to compute the SVD
-    time_t end = time(nullptr);
-    double time = difftime(end,start);
-    std::cout << "svd: " << time << "s; ";
-    
-    // Clean up Plasma
-    PLASMA_Dealloc_Handle((void**) &handle);
-    PLASMA_Finalize();
-    
-    // Cleanup optional arguments u, s, and vt
-    if (delete_u) {
-        delete u;
-    }
-    if (delete_s) {
-        delete s;
-    }
-    if (delete_vt) {
-        delete vt;
-    }
+    this->solve(input, u, s, vt);
 }
 
+template<typename T>
+void plasma_svd_t<T>::calculate(
+    matrix_t<std::complex<T>>* input,
+    matrix_t<std::complex<T>>* u,
+    matrix_t<T>*               s,
+    matrix_t<std::complex<T>>* vt
+) {
+    this->solve(input, u, s, vt);
+}
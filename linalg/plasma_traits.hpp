@@ -0,0 +1,109 @@
+/***********************************************************************
+ *                   GNU Lesser General Public License
+ *
+ * This file is part of the EDGI prototype package, developed by the
+ * GFDL Flexible Modeling System (FMS) group.
+ *
+ * EDGI is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * EDGI is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with EDGI.  If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************/
+
+#ifndef PLASMA_TRAITS_HPP
+#define PLASMA_TRAITS_HPP
+
+/** Use std::complex */
+#include <complex>
+
+/** Use PLASMA_* */
+#include <plasma.h>
+
+
+
+
+
+//==============================================================================
+// Declaration
+//==============================================================================
+
+/**
+ * Maps an element type onto the matching PLASMA eigensolver and workspace
+ * allocator: syevd for real types and heevd for complex types
+ */
+template<typename T>
+struct plasma_traits;
+
+
+
+
+
+//==============================================================================
+// Template Specializations
+//==============================================================================
+
+template<>
+struct plasma_traits<float> {
+    typedef float real_t;
+
+    static int alloc_workspace_heevd(int m, int n, PLASMA_desc** handle) {
+        return PLASMA_Alloc_Workspace_ssyevd(m, n, handle);
+    }
+
+    static int heevd(PLASMA_enum jobz, PLASMA_enum uplo, int n, float* a, int lda,
+                     float* w, PLASMA_desc* handle, float* q, int ldq) {
+        return PLASMA_ssyevd(jobz, uplo, n, a, lda, w, handle, q, ldq);
+    }
+};
+
+template<>
+struct plasma_traits<double> {
+    typedef double real_t;
+
+    static int alloc_workspace_heevd(int m, int n, PLASMA_desc** handle) {
+        return PLASMA_Alloc_Workspace_dsyevd(m, n, handle);
+    }
+
+    static int heevd(PLASMA_enum jobz, PLASMA_enum uplo, int n, double* a, int lda,
+                     double* w, PLASMA_desc* handle, double* q, int ldq) {
+        return PLASMA_dsyevd(jobz, uplo, n, a, lda, w, handle, q, ldq);
+    }
+};
+
+template<>
+struct plasma_traits<std::complex<float>> {
+    typedef float real_t;
+
+    static int alloc_workspace_heevd(int m, int n, PLASMA_desc** handle) {
+        return PLASMA_Alloc_Workspace_cheevd(m, n, handle);
+    }
+
+    static int heevd(PLASMA_enum jobz, PLASMA_enum uplo, int n, std::complex<float>* a, int lda,
+                     float* w, PLASMA_desc* handle, std::complex<float>* q, int ldq) {
+        return PLASMA_cheevd(jobz, uplo, n, (PLASMA_Complex32_t*) a, lda, w, handle, (PLASMA_Complex32_t*) q, ldq);
+    }
+};
+
+template<>
+struct plasma_traits<std::complex<double>> {
+    typedef double real_t;
+
+    static int alloc_workspace_heevd(int m, int n, PLASMA_desc** handle) {
+        return PLASMA_Alloc_Workspace_zheevd(m, n, handle);
+    }
+
+    static int heevd(PLASMA_enum jobz, PLASMA_enum uplo, int n, std::complex<double>* a, int lda,
+                     double* w, PLASMA_desc* handle, std::complex<double>* q, int ldq) {
+        return PLASMA_zheevd(jobz, uplo, n, (PLASMA_Complex64_t*) a, lda, w, handle, (PLASMA_Complex64_t*) q, ldq);
+    }
+};
+
+#endif
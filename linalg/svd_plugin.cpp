@@ -0,0 +1,51 @@
+/***********************************************************************
+ *                   GNU Lesser General Public License
+ *
+ * This file is part of the EDGI prototype package, developed by the
+ * GFDL Flexible Modeling System (FMS) group.
+ *
+ * EDGI is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * EDGI is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with EDGI.  If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************/
+
+// A linear algebra backend built as a plugin that any edgi executable can
+// load at run time (see svd_registry_t), with -b <backend>. "make plugin"
+// builds it, for the backend the makefile builds edgi with, as
+// bin/libedgi_svd_<backend>.so.
+
+#include <cstddef>
+
+#ifdef WITH_PLASMA
+    #include "plasma_svd.hpp"
+    #define SVD_TYPE plasma_svd_t
+#elif WITH_MKL
+    #include "mkl_svd.hpp"
+    #define SVD_TYPE mkl_svd_t
+#elif WITH_OPENBLAS
+    #include "openblas_svd.hpp"
+    #define SVD_TYPE openblas_svd_t
+#else
+    #error "Define WITH_OPENBLAS, WITH_MKL or WITH_PLASMA to choose the backend of the plugin"
+#endif
+
+
+
+
+
+extern "C" svd_t<float>* edgi_create_svd_float(size_t num_threads) {
+    return new SVD_TYPE<float>(num_threads);
+}
+
+extern "C" svd_t<double>* edgi_create_svd_double(size_t num_threads) {
+    return new SVD_TYPE<double>(num_threads);
+}
@@ -24,17 +24,24 @@
 #include <ctime>
 #include <omp.h>
 #include "src/eof_analysis.hpp"
+#include "src/svd_registry.hpp"
 #include "src/debug.hpp"
 
 #ifdef WITH_PLASMA
     #include "linalg/plasma_svd.hpp"
     #define SVD_TYPE plasma_svd_t
+    #define SVD_NAME "plasma"
 #elif WITH_MKL
     #include "linalg/mkl_svd.hpp"
     #define SVD_TYPE mkl_svd_t
+    #define SVD_NAME "mkl"
 #elif WITH_OPENBLAS
     #include "linalg/openblas_svd.hpp"
     #define SVD_TYPE openblas_svd_t
+    #define SVD_NAME "openblas"
+#else
+    #define SVD_TYPE basic_svd_t
+    #define SVD_NAME "native"
 #endif
 
 #include "src/fftw_fft.hpp"
@@ -58,7 +65,18 @@ int main(int argc, char** argv) {
         return 1;
     }
     
-    return basic_interface(args);
+    // Errors (such as being stopped with a tile checkpoint) end the run
+    // with a message rather than an abort
+    try {
+        // With more than one reader, every input is read up front by a pool
+        // of processes. They are forked here, before any file is opened or
+        // OpenMP thread started, neither of which survives a fork
+        reader_pool_t pool(args.num_readers, args.chunk_cache_mb * 1024 * 1024);
+        return basic_interface(args, &pool);
+    } catch (const eof_error_t& e) {
+        cerr << "[ERROR] " << e.what() << endl;
+        return 1;
+    }
 }
 
 
@@ -160,16 +178,40 @@ struct arg_data_t {
     bool is_spectral;
     string freq_name;
     bool do_hilbert;
+    bool native_complex;
+    string complex_dim;
     vector<string> files_in;
     vector<string> files_out;
     size_t ncores_in;
+    string storage;
+    string precision;
+    size_t chunk_cache_mb;
+    size_t num_readers;
+    string anomaly_cache_dir;
+    string checkpoint_save;
+    string checkpoint_resume;
+    string tile_checkpoint;
+    string backend;
+    size_t rank;
+    output_storage_t output_storage;
+    bool gathered;
+    selection_t selection;
 };
 
 bool parse_args(vector<string> argv, arg_data_t* data) {
     data->dim_in = "";
     data->do_hilbert = false;
+    data->native_complex = false;
     data->is_spectral = false;
     data->is_circular = false;
+    data->gathered = false;
+    data->storage = "float";
+    data->precision = "auto";
+    data->chunk_cache_mb = real_variable_t<float>::DEFAULT_CHUNK_CACHE_LIMIT / (1024 * 1024);
+    data->num_readers = 1;
+    data->backend = SVD_NAME;
+    data->rank = 0;
+    data->output_storage.chunk_dim = "eigenvalues";
 
     enum {
         ARG_NONE,
@@ -177,7 +219,22 @@ bool parse_args(vector<string> argv, arg_data_t* data) {
         ARG_VAR,
         ARG_CVAR,
         ARG_FILE,
-        ARG_NCORES
+        ARG_NCORES,
+        ARG_STORAGE,
+        ARG_PRECISION,
+        ARG_CHUNK_CACHE,
+        ARG_READERS,
+        ARG_COMPRESSION,
+        ARG_KEEP_BITS,
+        ARG_SELECT,
+        ARG_SELECT_INDEX,
+        ARG_COMPLEX_DIM,
+        ARG_ANOMALY_CACHE,
+        ARG_CHECKPOINT_SAVE,
+        ARG_CHECKPOINT_RESUME,
+        ARG_TILE_CHECKPOINT,
+        ARG_BACKEND,
+        ARG_RANK
     } state = ARG_NONE;
 
     for (string arg : argv) {
@@ -194,10 +251,43 @@ bool parse_args(vector<string> argv, arg_data_t* data) {
                 data->is_spectral = true;
             } else if (arg == "-H") {
                 data->do_hilbert = true;
+            } else if (arg == "-x") {
+                data->native_complex = true;
+                state = ARG_COMPLEX_DIM;
+            } else if (arg == "-G") {
+                data->gathered = true;
             } else if (arg == "-f") {
                 state = ARG_FILE;
             } else if (arg == "-n") {
                 state = ARG_NCORES;
+            } else if (arg == "-t") {
+                state = ARG_STORAGE;
+            } else if (arg == "-p") {
+                state = ARG_PRECISION;
+            } else if (arg == "-m") {
+                state = ARG_CHUNK_CACHE;
+            } else if (arg == "-r") {
+                state = ARG_READERS;
+            } else if (arg == "-a") {
+                state = ARG_ANOMALY_CACHE;
+            } else if (arg == "-w") {
+                state = ARG_CHECKPOINT_SAVE;
+            } else if (arg == "-e") {
+                state = ARG_CHECKPOINT_RESUME;
+            } else if (arg == "-T") {
+                state = ARG_TILE_CHECKPOINT;
+            } else if (arg == "-b") {
+                state = ARG_BACKEND;
+            } else if (arg == "-k") {
+                state = ARG_RANK;
+            } else if (arg == "-z") {
+                state = ARG_COMPRESSION;
+            } else if (arg == "-q") {
+                state = ARG_KEEP_BITS;
+            } else if (arg == "-s") {
+                state = ARG_SELECT;
+            } else if (arg == "-i") {
+                state = ARG_SELECT_INDEX;
             } else if (arg == "-h") {
                 return false;
             } else {
@@ -249,8 +339,76 @@ bool parse_args(vector<string> argv, arg_data_t* data) {
             data->ncores_in = stoi(arg);
             omp_set_num_threads(data->ncores_in);
 
+        } else if (state == ARG_STORAGE) {
+            if (arg != "float" && arg != "bf16" && arg != "fp16") {
+                cerr << "[ERROR] Unknown storage precision: '" << arg << "'" << endl;
+                return false;
+            }
+            data->storage = arg;
+
+        } else if (state == ARG_PRECISION) {
+            if (arg != "auto" && arg != "float" && arg != "double") {
+                cerr << "[ERROR] Unknown precision: '" << arg << "'" << endl;
+                return false;
+            }
+            data->precision = arg;
+
+        } else if (state == ARG_CHUNK_CACHE) {
+            data->chunk_cache_mb = stoul(arg);
+
+        } else if (state == ARG_READERS) {
+            data->num_readers = stoul(arg);
+
+        } else if (state == ARG_COMPRESSION) {
+            vector<string> words = split(arg, ':');
+            size_t size = words.size();
+            if (size > 3 || (words[0] != "none" && words[0] != "deflate" && words[0] != "zstd")
+                    || (size == 3 && words[2] != "shuffle")) {
+                cerr << "[ERROR] Invalid compression format: '" << arg << "'" << endl;
+                return false;
+            }
+            data->output_storage.codec = words[0];
+            data->output_storage.level = (size > 1) ? stoi(words[1]) : (words[0] == "zstd" ? 3 : 4);
+            data->output_storage.shuffle = (size == 3);
+
+        } else if (state == ARG_KEEP_BITS) {
+            data->output_storage.keep_bits = stoi(arg);
+
+        } else if (state == ARG_SELECT || state == ARG_SELECT_INDEX) {
+            try {
+                data->selection.add(arg, state == ARG_SELECT_INDEX);
+            } catch (const eof_error_t& e) {
+                cerr << "[ERROR] " << e.what() << endl;
+                return false;
+            }
+
+        } else if (state == ARG_COMPLEX_DIM) {
+            data->complex_dim = arg;
+
+        } else if (state == ARG_ANOMALY_CACHE) {
+            data->anomaly_cache_dir = arg;
+
+        } else if (state == ARG_CHECKPOINT_SAVE) {
+            data->checkpoint_save = arg;
+
+        } else if (state == ARG_CHECKPOINT_RESUME) {
+            data->checkpoint_resume = arg;
+
+        } else if (state == ARG_TILE_CHECKPOINT) {
+            data->tile_checkpoint = arg;
+
+        } else if (state == ARG_BACKEND) {
+            data->backend = arg;
+
+        } else if (state == ARG_RANK) {
+            data->rank = stoul(arg);
+            if (data->rank == 0) {
+                cerr << "[ERROR] At least one EOF must be calculated (-k)." << endl;
+                return false;
+            }
+
         } else {
-            cerr << "[ERROR] Expected a flag '-f', '-v', '-c', '-C', '-S', '-H', '-d', or '-n'." << endl;
+            cerr << "[ERROR] Expected a flag '-f', '-v', '-c', '-C', '-S', '-H', '-x', '-G', '-d', '-n', '-t', '-p', '-m', '-r', '-a', '-w', '-e', '-T', '-b', '-k', '-z', '-q', '-s', or '-i'." << endl;
             return false;
         }
     }
@@ -266,9 +424,16 @@ bool parse_args(vector<string> argv, arg_data_t* data) {
         return false;
     }
 
+    // -x reads both components from the -v variables
+    if(data->native_complex &&
+       (data->do_hilbert || data->cvars_in.size() != 0)){
+        cerr << "[ERROR] Native complex variables cannot be combined with -c or -H." << endl;
+        return false;
+    }
+
     // -c requires real data
     if(data->is_circular &&
-       data->cvars_in.size() != 0){
+       (data->do_hilbert || data->native_complex || data->cvars_in.size() != 0)){
         cerr << "[ERROR] Circular covariance kernel can only be used with real-valued data currently." << endl;
         return false;
     }
@@ -282,11 +447,42 @@ bool parse_args(vector<string> argv, arg_data_t* data) {
 
     // -S requires complex data
     if(data->is_spectral &&
-       data->cvars_in.size() == 0){
+       !data->native_complex && data->cvars_in.size() == 0){
         cerr << "[ERROR] Spectral data must have real and imaginary components." << endl;
         return false;
     }
 
+    // -t only applies to real data
+    if(data->storage != "float" &&
+       (data->do_hilbert || data->native_complex || data->cvars_in.size() != 0)){
+        cerr << "[ERROR] Reduced storage precision can only be used with real-valued data currently." << endl;
+        return false;
+    }
+
+    // -a only applies to real data read lazily
+    if(data->anomaly_cache_dir != "" &&
+       (data->do_hilbert || data->native_complex || data->cvars_in.size() != 0)){
+        cerr << "[ERROR] The anomaly cache can only be used with real-valued data currently." << endl;
+        return false;
+    }
+    if(data->anomaly_cache_dir != "" && data->num_readers > 1){
+        cerr << "[ERROR] The anomaly cache cannot be combined with more than one reader (-r)." << endl;
+        return false;
+    }
+
+    // -e starts from a covariance matrix -w would have saved
+    if(data->checkpoint_save != "" && data->checkpoint_resume != ""){
+        cerr << "[ERROR] A covariance checkpoint cannot be both saved (-w) and resumed (-e)." << endl;
+        return false;
+    }
+
+    // -k only limits the backends that find the leading EOFs alone
+    if(data->rank != 0 &&
+       data->backend != "randomized" && data->backend != "lanczos"){
+        cerr << "[ERROR] The number of EOFs (-k) can only be set for the randomized and lanczos backends." << endl;
+        return false;
+    }
+
     if (data->dim_in == "") {
         cerr << "[ERROR] No dimension specified." << endl;
         return false;
@@ -298,6 +494,13 @@ bool parse_args(vector<string> argv, arg_data_t* data) {
         return false;
     }
 
+    for (string file_out : data->files_out) {
+        if (zarr_writer_t::is_zarr_path(file_out) && data->output_storage.codec == "zstd") {
+            cerr << "[ERROR] Zarr outputs can only be compressed with deflate." << endl;
+            return false;
+        }
+    }
+
     return true;
 }
 
@@ -309,7 +512,9 @@ void usage(string cmd) {
     cerr << "Options:" << endl;
     cerr << "    -h                        Show this help message." << endl;
     cerr << "    -f <i>:<o> ... (required) Read data from file <i> and write to file <o>. Multiple" << endl;
-    cerr << "                              <i>:<o> pairs can be specified and separated by spaces." << endl;
+    cerr << "                              <i>:<o> pairs can be specified and separated by spaces. If <o>" << endl;
+    cerr << "                              ends in .zarr, it is written as a Zarr (v2) directory store. If <i>" << endl;
+    cerr << "                              has a sidecar file <i>.desc, it is read as a raw binary dump (see README)." << endl;
     cerr << "    -v <i>:<o> ... (required) Calculate EOFs on variable <i> and output as variable <o>. Multiple" << endl;
     cerr << "                              <i>:<o> pairs can be specified and separated by spaces" << endl;
     cerr << "    -c <i>:<o> ... (optional) Add imaginary component <i> to variable and output as <o>. Number" << endl;
@@ -321,31 +526,200 @@ void usage(string cmd) {
     cerr << "                              variable, and weights covariance calculation for T-series accordingly. " << endl;
     cerr << "    -H         ... (optional) Calculate analytic signal before running. Uses a Hilbert transform on" << endl;
     cerr << "                              a real- or complex-valued variable to generate complex-valued results." << endl;
+    cerr << "    -x [<d>]   ... (optional) The -v variables are complex: of a compound type of a real and an" << endl;
+    cerr << "                              imaginary part, or with the parts along their last dimension <d>, of" << endl;
+    cerr << "                              length 2. Both parts are read at once, and written as <o>_re and <o>_im." << endl;
+    cerr << "    -G         ... (optional) Write EOFs in CF compression-by-gathering form: only grid points that" << endl;
+    cerr << "                              are not always missing, listed by a 'points_<n>' dimension, instead of" << endl;
+    cerr << "                              the full grid with fill values. Gathered inputs are always read as is." << endl;
     cerr << "    -d <i>     ... (required) Time dimension name." << endl;
     cerr << "    -n <i>     ... (required) Set the number of cores to use." << endl;
+    cerr << "    -t <i>     ... (optional) Storage precision of the anomaly matrix: bf16, fp16, or float," << endl;
+    cerr << "                              which keeps the working precision (default). Sums are still accumulated in double." << endl;
+    cerr << "    -p <i>     ... (optional) Working precision: float, double, or auto (default). With auto, double" << endl;
+    cerr << "                              is used if the first variable is stored as double in the first file." << endl;
+    cerr << "    -m <i>     ... (optional) Most memory in MiB the NetCDF chunk cache may use per input variable" << endl;
+    cerr << "                              (default 256). Inputs are read one layer of chunks at a time." << endl;
+    cerr << "    -r <i>     ... (optional) Number of processes reading input variables at once (default 1). With" << endl;
+    cerr << "                              more than one, all inputs (except -x ones) are read up front into" << endl;
+    cerr << "                              shared memory." << endl;
+    cerr << "    -a <i>     ... (optional) Keep the anomaly matrix of each input variable in directory <i>, and" << endl;
+    cerr << "                              map it from there instead of reading the input again on later runs" << endl;
+    cerr << "                              with the same input file, selection and precision. Real data only." << endl;
+    cerr << "                              Each entry is as large as the anomaly matrix, and is replaced when" << endl;
+    cerr << "                              its input changes; entries of inputs no longer used must be deleted" << endl;
+    cerr << "                              by hand." << endl;
+    cerr << "    -w <i>     ... (optional) Save the covariance matrix to file <i> once it is built." << endl;
+    cerr << "    -e <i>     ... (optional) Resume from the covariance matrix saved to file <i> by -w, with the same" << endl;
+    cerr << "                              inputs and options: only the eigensolve and the outputs are redone." << endl;
+    cerr << "    -T <i>     ... (optional) Build the covariance matrix in scratch file <i>, saving finished tiles" << endl;
+    cerr << "                              every minute and on SIGUSR1, and stopping on SIGTERM once they are saved." << endl;
+    cerr << "                              Rerun with the same options to build only the missing tiles." << endl;
+    if (string(SVD_NAME) == "native") {
+        cerr << "    -b <i>     ... (optional) Linear algebra backend: native (default), randomized or lanczos." << endl;
+        cerr << "                              Any other name <i> is loaded from the plugin libedgi_svd_<i>.so" << endl;
+        cerr << "                              on the library path, or <i> is its path." << endl;
+    } else {
+        cerr << "    -b <i>     ... (optional) Linear algebra backend: native, randomized, lanczos, or " << SVD_NAME << " (default)," << endl;
+        cerr << "                              which this build is linked with. Any other name <i> is loaded from" << endl;
+        cerr << "                              the plugin libedgi_svd_<i>.so on the library path, or <i> is its path." << endl;
+    }
+    cerr << "    -k <i>     ... (optional) Number of leading EOFs the randomized and lanczos backends find" << endl;
+    cerr << "                              (default " << randomized_svd_t<float>::DEFAULT_RANK << "). The others find them all." << endl;
+    cerr << "    -z <c>:<l> ... (optional) Compress output variables with codec <c>: none (default), deflate," << endl;
+    cerr << "                              or zstd, at level <l> (default 4 for deflate, 3 for zstd). Append" << endl;
+    cerr << "                              ':shuffle' to shuffle bytes first. Each mode is stored as one chunk." << endl;
+    cerr << "    -q <i>     ... (optional) Keep only <i> significant bits of each output value (bit-rounding)," << endl;
+    cerr << "                              so that they compress better. All are kept by default." << endl;
+    cerr << "    -s <d>=<r> ... (optional) Only read the steps of dimension <d> in range <r>, <a>:<b>[:<s>]: from" << endl;
+    cerr << "                              coordinate value <a> to <b> (inclusive), every <s>th step (default 1)." << endl;
+    cerr << "                              <a> or <b> may be left out to run to the end, e.g. 'lat=-20:20' or" << endl;
+    cerr << "                              'time=::2'. Only the selected part of each input is ever read." << endl;
+    cerr << "    -i <d>=<r> ... (optional) As -s, but <a> and <b> are (zero-based) indices instead." << endl;
     cerr << endl;
 }
 
+/**
+ * Opens an input variable, to be read lazily from its file
+ */
+template<typename T>
+real_variable_t<T>* open_variable(string varname, string filename, arg_data_t args) {
+    real_variable_t<T>* var = new real_variable_t<T>(varname, filename, args.selection);
+    var->set_chunk_cache_limit(args.chunk_cache_mb * 1024 * 1024);
+    return var;
+}
+
+/**
+ * Opens an input variable as open_variable does, and remembers where it came
+ * from so that a reader pool can load it
+ */
+template<typename T>
+real_variable_t<T>* open_variable(string varname, string filename, arg_data_t args,
+        vector<real_variable_t<T>*>* opened, vector<string>* names, vector<string>* filenames) {
+    real_variable_t<T>* var = open_variable<T>(varname, filename, args);
+    opened->push_back(var);
+    names->push_back(varname);
+    filenames->push_back(filename);
+    return var;
+}
+
+/**
+ * Plans, in `writer` (NetCDF or Zarr), the dimensions gathered by any CF list dimension of
+ * `var`, as read from the input file `filename`, so that the output can be
+ * expanded again. Those not already in `gathered` are added to it, and must
+ * be kept until the writer commits.
+ */
+template<typename W, typename T>
+void add_gathered_dims(W* writer, const real_variable_t<T>* var, string filename,
+        vector<dimension_t<T>*>* gathered) {
+    for (size_t d = 0; d < var->get_num_dims(); d++) {
+        const dimension_t<T>* dim = var->get_dim(d);
+        if (!dim->has_attr(COMPRESS_ATTR_NAME)) {
+            continue;
+        }
+
+        const attribute_t* attr = dim->get_attr(COMPRESS_ATTR_NAME);
+        string names((const char*) attr->get_value(), attr->get_length());
+        names = names.substr(0, names.find('\0'));
+
+        netcdf_file_t file(filename, NETCDF_READ);
+        for (string name : split(names, ' ')) {
+            bool known = name.empty();
+            for (dimension_t<T>* other : *gathered) {
+                known = known || other->get_name() == name;
+            }
+
+            if (!known) {
+                gathered->push_back(new dimension_t<T>(name, &file));
+                writer->add_dim(gathered->back());
+            }
+        }
+    }
+}
+
+/**
+ * Has `eof` save its covariance matrix, or resume from it, as asked by -w or
+ * -e, and build it tile by tile, as asked by -T
+ */
+template<typename E>
+void set_checkpoint(E* eof, const arg_data_t& args) {
+    if (args.checkpoint_resume != "") {
+        eof->set_covariance_checkpoint(args.checkpoint_resume, true);
+    } else if (args.checkpoint_save != "") {
+        eof->set_covariance_checkpoint(args.checkpoint_save, false);
+    }
+    if (args.tile_checkpoint != "") {
+        eof->set_tile_checkpoint(new tile_checkpoint_t(args.tile_checkpoint));
+    }
+}
+
+/**
+ * Makes the linear algebra backend chosen by -b, running on -n threads and
+ * finding -k EOFs if it doesn't find them all
+ */
+template<typename T>
+svd_t<T>* make_svd(const arg_data_t& args) {
+    svd_registry_t<T> registry;
+    registry.add(SVD_NAME, [](size_t num_threads, size_t) -> svd_t<T>* {
+        return new SVD_TYPE<T>(num_threads);
+    });
+    size_t rank = (args.rank > 0) ? args.rank : randomized_svd_t<T>::DEFAULT_RANK;
+    return registry.create(args.backend, args.ncores_in, rank);
+}
+
+template<typename T, typename P>
+vector<real_variable_t<T>*> calculate_real_eofs(vector<real_variable_t<T>*> vars_in, arg_data_t args,
+        svd_t<T>* svd, typename real_eof_t<T, P>::output_sink_t sink) {
+    real_eof_t<T, P> eof;
+    eof.set_svd(svd);
+    eof.set_output_sink(sink);
+    eof.set_gathered_output(args.gathered);
+    set_checkpoint(&eof, args);
+    if (args.anomaly_cache_dir != "") {
+        eof.set_anomaly_cache(new anomaly_cache_t(args.anomaly_cache_dir));
+    }
+    return eof.calculate(vars_in, args.dim_in, args.ncores_in, args.is_circular);
+}
+
 // Sample usage:
 //     bin/main.x -f sample.nc:sample_eofs.nc -v a:a_eof b:b_eof c:c_eof -ai:ai_eof bi:bi_eof ci:ci_eof -d time:eof_coef
 
-int basic_interface(arg_data_t args) {
+template<typename T>
+int run_interface(arg_data_t args, reader_pool_t* pool) {
 
     cout << endl << args.ncores_in << " cores: ";
 
+    // Made first, so that a backend that can't be loaded fails before any
+    // input is read
+    svd_t<T>* svd = make_svd<T>(args);
+
     time_t start = time(nullptr);
     time_t rstart = time(nullptr); // reading time
 
-    if (!args.do_hilbert && args.cvars_in.size() == 0) {
-        vector<real_variable_t<float>*> vars_in;
+    // The pool holds the data of the inputs it reads until they are deleted
+    vector<real_variable_t<T>*> opened;
+    vector<string> opened_names;
+    vector<string> opened_files;
+
+    if (!args.do_hilbert && !args.native_complex && args.cvars_in.size() == 0) {
+        vector<real_variable_t<T>*> vars_in;
         vector<attribute_t**> attrs_global;
         vector<size_t> num_attrs_global;
         for (string filename : args.files_in) {
-            netcdf_file_t file(filename, NETCDF_READ);
+            // Variables are read lazily, so their data is only loaded when
+            // the covariance matrix is built from it, one variable at a time
             for (string varname : args.vars_in) {
-                vars_in.push_back(new real_variable_t<float>(varname, &file));
+                vars_in.push_back(open_variable<T>(varname, filename, args, &opened, &opened_names, &opened_files));
             }
 
+            // Raw dumps have no global attributes
+            if (raw_file_t::is_raw(filename)) {
+                attrs_global.push_back(nullptr);
+                num_attrs_global.push_back(0);
+                continue;
+            }
+
+            netcdf_file_t file(filename, NETCDF_READ);
             attribute_t** attrs = new attribute_t*[file.get_n_attrs()];
             for (size_t i = 0; i < file.get_n_attrs(); i++){
                 attrs[i] = new attribute_t(file.get_attr(i), &file);
@@ -354,143 +728,236 @@ int basic_interface(arg_data_t args) {
             num_attrs_global.push_back(file.get_n_attrs());
         }
 
+        // Resuming never reads the inputs, so they aren't loaded up front
+        if (args.num_readers > 1 && args.checkpoint_resume == "") {
+            pool->load(opened, opened_names, opened_files);
+        }
+
         time_t rend = time(nullptr);
         double rtime = difftime(rend,rstart);
         cout << "nc_in: " << rtime << "s; ";
 
-        // Calculate the eofs with n cores using PLASMA
-        real_eof_t<float> eof;
-        eof.set_svd(new SVD_TYPE<float>(args.ncores_in));
-        //eof.set_svd(new mkl_svd_t<float>(args.ncores_in));
-        vector<real_variable_t<float>*> vars_out = eof.calculate(vars_in, args.dim_in, args.ncores_in, args.is_circular);
-
-        time_t wstart = time(nullptr); // writing time
-
-        size_t i = 0;
-        for (size_t j = 0; j < args.files_out.size(); j++) {
-            string filename = args.files_out.at(j);
-            netcdf_file_t file(filename, NETCDF_OVERWRITE);
-
-            for(size_t k = 0; k < num_attrs_global.at(j); k++){
-                attribute_t* attr = attrs_global.at(j)[k];
-                file.begin_def();
-                file.set_attr(attr->get_name(), attr->get_type(), attr->get_length(), attr->get_value());
-                file.end_def();
-            }
+        // Each output file is planned as its variables arrive (on a writer
+        // thread), and then defined and written all at once after its last
+        // variable, while the next file's variables are restored
+        vector<netcdf_file_t*> files_out(args.files_out.size(), nullptr);
+        vector<netcdf_writer_t*> writers(args.files_out.size(), nullptr);
+        vector<zarr_writer_t*> zarr_writers(args.files_out.size(), nullptr);
+        vector<vector<dimension_t<T>*>> gathered_dims(args.files_out.size());
+        size_t num_vars = args.vars_out.size();
+        double wtime = 0; // writing time, overlapped with the restoring
+        auto write_output = [&](size_t i, const real_variable_t<T>* var) {
+            time_t wstart = time(nullptr);
+
+            size_t j = i / num_vars;
+            bool is_last = (i % num_vars == num_vars - 1);
+            if (zarr_writer_t::is_zarr_path(args.files_out.at(j))) {
+                if (zarr_writers[j] == nullptr) {
+                    zarr_writers[j] = new zarr_writer_t(args.files_out.at(j));
+                    zarr_writers[j]->set_storage(args.output_storage);
+                    for(size_t k = 0; k < num_attrs_global.at(j); k++){
+                        zarr_writers[j]->add_attr(attrs_global.at(j)[k]);
+                    }
+                }
+
+                zarr_writers[j]->add(var, args.vars_out.at(i % num_vars));
+                add_gathered_dims(zarr_writers[j], var, args.files_in.at(j), &gathered_dims[j]);
+
+                if (is_last) {
+                    zarr_writers[j]->commit();
+                    delete zarr_writers[j];
+                    zarr_writers[j] = nullptr;
+                }
+            } else {
+                if (files_out[j] == nullptr) {
+                    files_out[j] = new netcdf_file_t(args.files_out.at(j), NETCDF_OVERWRITE);
+                    writers[j] = new netcdf_writer_t(files_out[j]);
+                    writers[j]->set_storage(args.output_storage);
+                    for(size_t k = 0; k < num_attrs_global.at(j); k++){
+                        writers[j]->add_attr(attrs_global.at(j)[k]);
+                    }
+                }
 
-            for (string varname : args.vars_out) {
-                vars_out[i]->write(varname, &file);
+                writers[j]->add(var, args.vars_out.at(i % num_vars));
+                add_gathered_dims(writers[j], var, args.files_in.at(j), &gathered_dims[j]);
 
-                // Clean up
-                delete vars_in[i];
-                delete vars_out[i];
+                if (is_last) {
+                    writers[j]->commit();
+                    delete writers[j];
+                    delete files_out[j];
+                    writers[j] = nullptr;
+                    files_out[j] = nullptr;
+                }
+            }
 
-                i++;
+            if (is_last) {
+                for (dimension_t<T>* dim : gathered_dims[j]) {
+                    delete dim;
+                }
             }
+
+            wtime += difftime(time(nullptr), wstart);
+        };
+
+        // Calculate the eofs with n cores, storing anomalies at the requested precision
+        vector<real_variable_t<T>*> vars_out;
+        if (args.storage == "bf16") {
+            vars_out = calculate_real_eofs<T, bf16_precision_t>(vars_in, args, svd, write_output);
+        } else if (args.storage == "fp16") {
+            vars_out = calculate_real_eofs<T, fp16_precision_t>(vars_in, args, svd, write_output);
+        } else {
+            vars_out = calculate_real_eofs<T, typename default_precision<T>::type>(vars_in, args, svd, write_output);
+        }
+
+        // Clean up
+        for (size_t i = 0; i < vars_out.size(); i++) {
+            delete vars_in[i];
+            delete vars_out[i];
         }
 
-        time_t wend = time(nullptr);
-        double wtime = difftime(wend,wstart);
         cout << "nc_out: " << wtime << "s; ";
 
     }else{
 
-        vector<complex_variable_t<float>*> vars_in;
+        // Complex data is kept as separate real and imaginary parts all the
+        // way from reading to writing
+        vector<split_variable_t<T>*> vars_in;
         if (args.do_hilbert) {
 
-            vector<real_variable_t<float>*> rvars_in_raw;
-            vector<real_variable_t<float>*> cvars_in_raw;
-            vector<complex_variable_t<float>*> vars_in_raw;
+            vector<real_variable_t<T>*> rvars_in_raw;
             for (string filename : args.files_in) {
-                netcdf_file_t file(filename, NETCDF_READ);
-
                 for (string varname : args.vars_in) {
-                    rvars_in_raw.push_back(new real_variable_t<float>(varname, &file));
+                    rvars_in_raw.push_back(open_variable<T>(varname, filename, args, &opened, &opened_names, &opened_files));
                 }
+            }
 
-                if (args.cvars_in.size() != 0) {
-                    for (string cvarname : args.cvars_in) {
-                        cvars_in_raw.push_back(new real_variable_t<float>(cvarname, &file));
-                    }
-                    for (int v = 0; v < args.vars_in.size(); v++) {
-                        vars_in_raw.push_back(make_complex_variable(rvars_in_raw.at(v), cvars_in_raw.at(v)));
-                    }
+            // Resuming never reads the inputs, so neither are they loaded up
+            // front nor are their analytic signals made
+            real_spectrum_t<T> spec;
+            if (args.checkpoint_resume == "") {
+                if (args.num_readers > 1) {
+                    pool->load(opened, opened_names, opened_files);
                 }
+
+                spec.set_dft(new fftw_fft_t<T>(args.ncores_in));
+                vars_in = spec.analytic_split(rvars_in_raw, args.dim_in, args.ncores_in);
+            } else {
+                vars_in = spec.analytic_split_metadata(rvars_in_raw);
             }
 
-            if (args.cvars_in.size() == 0) {
-                real_spectrum_t<float> spec;
-                spec.set_dft(new fftw_fft_t<float>(args.ncores_in));
-                vars_in = spec.analytic(rvars_in_raw, args.dim_in, args.ncores_in);
-            }else{
-                complex_spectrum_t<float> spec;
-                spec.set_dft(new fftw_fft_t<float>(args.ncores_in));
-                vars_in = spec.analytic(vars_in_raw, args.dim_in, args.ncores_in);
+            for (real_variable_t<T>* var : rvars_in_raw) {
+                delete var;
             }
-        }else{
-            vector<real_variable_t<float>*> rvars_in;
-            vector<real_variable_t<float>*> cvars_in;
+        }else if (args.native_complex) {
+            // Both parts come from one variable, so they are read together
+            // rather than by a reader pool
             for (string filename : args.files_in) {
-                netcdf_file_t file(filename, NETCDF_READ);
                 for (string varname : args.vars_in) {
-                    rvars_in.push_back(new real_variable_t<float>(varname, &file));
+                    split_variable_t<T>* var = new split_variable_t<T>(varname, filename, args.selection, args.complex_dim);
+                    var->set_chunk_cache_limit(args.chunk_cache_mb * 1024 * 1024);
+                    vars_in.push_back(var);
                 }
-                for (string cvarname : args.cvars_in) {
-                    cvars_in.push_back(new real_variable_t<float>(cvarname, &file));
-                }
-                for (int v = 0; v < args.vars_in.size(); v++) {
-                    vars_in.push_back(make_complex_variable(rvars_in.at(v), cvars_in.at(v)));
+            }
+        }else{
+            for (string filename : args.files_in) {
+                for (size_t v = 0; v < args.vars_in.size(); v++) {
+                    vars_in.push_back(new split_variable_t<T>(
+                        open_variable<T>(args.vars_in.at(v), filename, args, &opened, &opened_names, &opened_files),
+                        open_variable<T>(args.cvars_in.at(v), filename, args, &opened, &opened_names, &opened_files)));
                 }
             }
+
+            if (args.num_readers > 1 && args.checkpoint_resume == "") {
+                pool->load(opened, opened_names, opened_files);
+            }
         }
 
-        /** Load frequency values if data is spectral */
-        float* omegas = nullptr;
+        /** Load frequency values if data is spectral (as far as they are selected) */
+        T* omegas = nullptr;
         int omegas_len = -1;
         if(args.is_spectral){
-            netcdf_file_t file(args.files_in[0], NETCDF_READ);
-            netcdf_var_t var_id = file.get_var(args.freq_name);
-            netcdf_dim_t dim_id = file.get_var_dim(var_id, 0);
-            omegas_len = file.get_dim_len(dim_id);
-            omegas = new float[omegas_len];
-            omegas = file.get_var_vals<float>(var_id);
+            const dimension_t<T>* freq = vars_in[0]->get_re()->get_dim(args.freq_name);
+            omegas_len = freq->get_size();
+            omegas = new T[omegas_len];
+            std::copy(freq->get_values(), freq->get_values() + omegas_len, omegas);
         }
 
         time_t rend = time(nullptr);
         double rtime = difftime(rend,rstart);
         cout << "nc_in: " << rtime << "s; ";
 
-        // Calculate the eofs with n cores using PLASMA
-        complex_eof_t<float> eof;
-        eof.set_svd(new SVD_TYPE<float>(args.ncores_in));
-        //eof.set_svd(new mkl_svd_t<float>(args.ncores_in));
-        vector<complex_variable_t<float>*> vars_out = eof.calculate(vars_in, args.dim_in, args.ncores_in, args.is_circular, args.is_spectral, omegas_len, omegas);
+        // Each output file is planned and written all at once, as for real
+        // data
+        vector<netcdf_file_t*> files_out(args.files_out.size(), nullptr);
+        vector<netcdf_writer_t*> writers(args.files_out.size(), nullptr);
+        vector<zarr_writer_t*> zarr_writers(args.files_out.size(), nullptr);
+        vector<vector<dimension_t<T>*>> gathered_dims(args.files_out.size());
+        size_t num_vars = args.vars_out.size();
+        double wtime = 0; // writing time, overlapped with the restoring
+        auto write_output = [&](size_t i, const split_variable_t<T>* var) {
+            time_t wstart = time(nullptr);
+
+            size_t j = i / num_vars;
+            size_t v = i % num_vars;
+            bool is_single = args.do_hilbert || args.native_complex;
+            string name_re = is_single ? args.vars_out[v] + "_re" : args.vars_out[v];
+            string name_im = is_single ? args.vars_out[v] + "_im" : args.cvars_out[v];
+            if (zarr_writer_t::is_zarr_path(args.files_out.at(j))) {
+                if (zarr_writers[j] == nullptr) {
+                    zarr_writers[j] = new zarr_writer_t(args.files_out.at(j));
+                    zarr_writers[j]->set_storage(args.output_storage);
+                }
 
+                var->add_to(zarr_writers[j], name_re, name_im);
+                add_gathered_dims(zarr_writers[j], var->get_re(), args.files_in.at(j), &gathered_dims[j]);
 
-        time_t wstart = time(nullptr); // writing time
+                if (v == num_vars - 1) {
+                    zarr_writers[j]->commit();
+                    delete zarr_writers[j];
+                    zarr_writers[j] = nullptr;
+                }
+            } else {
+                if (files_out[j] == nullptr) {
+                    files_out[j] = new netcdf_file_t(args.files_out.at(j), NETCDF_OVERWRITE);
+                    writers[j] = new netcdf_writer_t(files_out[j]);
+                    writers[j]->set_storage(args.output_storage);
+                }
 
-        size_t i = 0;
-        for (string filename : args.files_out) {
-            netcdf_file_t file(filename, NETCDF_OVERWRITE);
+                var->add_to(writers[j], name_re, name_im);
+                add_gathered_dims(writers[j], var->get_re(), args.files_in.at(j), &gathered_dims[j]);
 
-            for (int i = 0; i < args.vars_out.size(); i++) {
+                if (v == num_vars - 1) {
+                    writers[j]->commit();
+                    delete writers[j];
+                    delete files_out[j];
+                    writers[j] = nullptr;
+                    files_out[j] = nullptr;
+                }
+            }
 
-                if (args.do_hilbert) {
-                    vars_out[i]->write_complex(args.vars_out[i] + "_re", args.vars_out[i] + "_im", &file);
-                } else {
-                    vars_out[i]->write_complex(args.vars_out[i], args.cvars_out[i], &file);
+            if (v == num_vars - 1) {
+                for (dimension_t<T>* dim : gathered_dims[j]) {
+                    delete dim;
                 }
+            }
 
-                // Clean up
-                delete vars_in[i];
-                delete vars_out[i];
+            wtime += difftime(time(nullptr), wstart);
+        };
 
-                i++;
-            }
+        // Calculate the eofs with n cores using PLASMA
+        complex_eof_t<T> eof;
+        eof.set_svd(svd);
+        eof.set_split_output_sink(write_output);
+        eof.set_gathered_output(args.gathered);
+        set_checkpoint(&eof, args);
+        vector<split_variable_t<T>*> vars_out = eof.calculate(vars_in, args.dim_in, args.ncores_in, args.is_spectral, omegas_len, omegas);
+
+        // Clean up
+        for (size_t i = 0; i < vars_out.size(); i++) {
+            delete vars_in[i];
+            delete vars_out[i];
         }
 
-        time_t wend = time(nullptr);
-        double wtime = difftime(wend,wstart);
         cout << "nc_out: " << wtime << "s; ";
     }
 
@@ -501,3 +968,26 @@ int basic_interface(arg_data_t args) {
     return 0;
 }
 
+int basic_interface(arg_data_t args, reader_pool_t* pool) {
+    // Work in the precision the data is stored in, unless told otherwise
+    bool use_double = (args.precision == "double");
+    if (args.precision == "auto" && raw_file_t::is_raw(args.files_in[0])) {
+        raw_file_t file(args.files_in[0]);
+        use_double = (file.get_var_type() == NC_DOUBLE);
+    } else if (args.precision == "auto") {
+        netcdf_file_t file(args.files_in[0], NETCDF_READ);
+        netcdf_var_t var = file.get_var(args.vars_in[0]);
+        nc_type type = file.get_var_type(var);
+        if (args.native_complex) {
+            // The type of each part of a compound complex variable
+            file.get_complex_compound(var, &type);
+        }
+        use_double = (type == NC_DOUBLE);
+    }
+
+    if (use_double) {
+        return run_interface<double>(args, pool);
+    } else {
+        return run_interface<float>(args, pool);
+    }
+}
@@ -0,0 +1,196 @@
+/***********************************************************************
+ *                   GNU Lesser General Public License
+ *
+ * This file is part of the EDGI prototype package, developed by the
+ * GFDL Flexible Modeling System (FMS) group.
+ *
+ * EDGI is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * EDGI is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with EDGI.  If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************/
+
+#include "anomaly_cache.hpp"
+
+/** Use write_all, write_zeros, replace_file, align_up, fnv1a, describe_input */
+#include "file_utils.hpp"
+
+/** Use open, close */
+#include <fcntl.h>
+#include <unistd.h>
+
+/** Use fstat, mkdir */
+#include <sys/stat.h>
+
+/** Use mmap, munmap */
+#include <sys/mman.h>
+
+/** Use errno */
+#include <cerrno>
+
+/** Use memcmp, memcpy, strerror */
+#include <cstring>
+
+/** Use std::cerr */
+#include <iostream>
+
+/** Use std::ostringstream */
+#include <sstream>
+
+/** Use std::hex, std::setw, std::setfill */
+#include <iomanip>
+
+// <string>, <vector> and <utility> included in header
+using std::string;
+
+
+
+
+
+//==============================================================================
+// Local functions
+//==============================================================================
+
+namespace {
+
+    const char MAGIC[MAGIC_LEN] = {'E', 'D', 'G', 'I', 'A', 'N', 'O', 'M'};
+
+    const uint32_t FORMAT_VERSION = 1;
+}
+
+
+
+
+
+//==============================================================================
+// Private Methods
+//==============================================================================
+
+string anomaly_cache_t::get_path(const string key) const {
+    return this->directory + "/" + key.substr(0, key.find('\n')) + ".anom";
+}
+
+unsigned char* anomaly_cache_t::map_entry(const string key, size_t value_size, entry_header_t* header) {
+    if (key.empty()) {
+        return nullptr;
+    }
+
+    int fd = open(this->get_path(key).c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t) info.st_size < sizeof(entry_header_t)) {
+        close(fd);
+        return nullptr;
+    }
+
+    // Private and writable, so the matrix may be changed in place without
+    // changing the entry
+    size_t size = info.st_size;
+    void* mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        return nullptr;
+    }
+
+    unsigned char* entry = (unsigned char*) mapped;
+    std::memcpy(header, entry, sizeof(entry_header_t));
+
+    bool valid = has_magic(header->magic, MAGIC)
+        && header->version == FORMAT_VERSION
+        && header->value_size == value_size
+        && header->key_len == key.size()
+        && sizeof(entry_header_t) + header->key_len <= header->map_offset
+        && header->reduced_cols <= header->restored_cols
+        && header->map_offset + header->reduced_cols * sizeof(int) <= header->data_offset
+        && header->data_offset % DATA_ALIGNMENT == 0
+        && header->data_offset + header->rows * header->cols * value_size <= size
+        && std::memcmp(entry + sizeof(entry_header_t), key.data(), key.size()) == 0;
+
+    if (valid) {
+        const int* map = (const int*) (entry + header->map_offset);
+        for (size_t i = 0; i < header->reduced_cols; i++) {
+            if (map[i] < 0 || (size_t) map[i] >= header->restored_cols) {
+                valid = false;
+                break;
+            }
+        }
+    }
+
+    if (!valid) {
+        munmap(mapped, size);
+        return nullptr;
+    }
+
+    this->maps.push_back(std::make_pair(mapped, size));
+    return entry;
+}
+
+void anomaly_cache_t::write_entry(const string key, entry_header_t header, const int* map, const void* data) {
+    set_magic(header.magic, MAGIC);
+    header.version = FORMAT_VERSION;
+    header.key_len = key.size();
+    header.map_offset = sizeof(entry_header_t) + key.size();
+    size_t map_end = header.map_offset + header.reduced_cols * sizeof(int);
+    header.data_offset = align_up(map_end, DATA_ALIGNMENT);
+
+    // Replaced as a whole, so no other run maps a partial entry
+    string path = this->get_path(key);
+    int error = 0;
+    bool written = replace_file(path, [&](int fd) {
+        return write_all(fd, &header, sizeof(entry_header_t))
+            && write_all(fd, key.data(), key.size())
+            && write_all(fd, map, header.reduced_cols * sizeof(int))
+            && write_zeros(fd, header.data_offset - map_end)
+            && write_all(fd, data, header.rows * header.cols * header.value_size);
+    }, &error);
+
+    if (!written) {
+        std::cerr << "[WARNING] Could not write anomaly cache entry " << path << ": "
+                  << std::strerror(error) << std::endl;
+    }
+}
+
+
+
+
+
+//==============================================================================
+// Public Methods
+//==============================================================================
+
+anomaly_cache_t::anomaly_cache_t(const string directory) {
+    this->directory = directory;
+    mkdir(directory.c_str(), 0755);
+}
+
+anomaly_cache_t::~anomaly_cache_t() {
+    for (size_t i = 0; i < this->maps.size(); i++) {
+        munmap(this->maps[i].first, this->maps[i].second);
+    }
+}
+
+string anomaly_cache_t::make_key(const string filename, const string name, const string dim, const string variant) const {
+    string identity = describe_input(filename);
+    if (identity.empty()) {
+        return "";
+    }
+
+    // Named apart from the identity, so that an entry of an input that has
+    // since changed is written over rather than left behind
+    string entry = filename + "\n" + name + "\n" + dim + "\n" + variant;
+
+    std::ostringstream key;
+    key << std::hex << std::setw(16) << std::setfill('0') << fnv1a(entry) << "\n" << identity << "\n" << entry;
+    return key.str();
+}
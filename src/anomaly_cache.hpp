@@ -0,0 +1,157 @@
+/***********************************************************************
+ *                   GNU Lesser General Public License
+ *
+ * This file is part of the EDGI prototype package, developed by the
+ * GFDL Flexible Modeling System (FMS) group.
+ *
+ * EDGI is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * EDGI is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with EDGI.  If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************/
+
+#ifndef ANOMALY_CACHE_HPP
+#define ANOMALY_CACHE_HPP
+
+/** Use matrix_t */
+#include "matrix.hpp"
+
+/** Use matrix_reducer_t */
+#include "matrix_reducer.hpp"
+
+/** Use size_t */
+#include <cstddef>
+
+/** Use uint32_t, uint64_t */
+#include <cstdint>
+
+/** Use std::string */
+#include <string>
+
+/** Use std::vector */
+#include <vector>
+
+/** Use std::pair */
+#include <utility>
+
+
+
+
+
+//==============================================================================
+// Declaration
+//==============================================================================
+
+/**
+ * A directory of reduced anomaly matrices (with the maps of their reducers),
+ * kept between runs so that reruns on the same inputs can map them straight
+ * from disk instead of reading, reducing and centering the inputs again.
+ *
+ * A key covers the identity of the input file (its size, modification time
+ * and a hash of its first and last bytes), the variable, the dimension, and
+ * whatever else changes the anomalies (selection, precision, centering). Each
+ * entry is one file, named by a hash of all but the identity, so that an
+ * input that changes has its entry replaced rather than a new one added. The
+ * whole key is stored in the entry, so that a stale or colliding entry is
+ * never used.
+ * Entries are laid out so that the anomaly values start on a page boundary,
+ * and are mapped copy-on-write.
+ */
+class anomaly_cache_t {
+private:
+    //==========================================================================
+    // Private Fields
+    //==========================================================================
+
+    /** The fixed-size start of an entry, followed by the key, the map and the values */
+    struct entry_header_t {
+        char magic[8];
+        uint32_t version;
+        uint32_t value_size;
+        uint64_t key_len;
+        uint64_t rows;
+        uint64_t cols;
+        uint64_t restored_cols;
+        uint64_t reduced_cols;
+        double absmax;
+        uint64_t map_offset;
+        uint64_t data_offset;
+    };
+
+    std::string directory;
+
+    /** The entries mapped by load, unmapped when this cache is deleted */
+    std::vector<std::pair<void*, size_t>> maps;
+
+
+
+    //==========================================================================
+    // Private Methods
+    //==========================================================================
+
+    std::string get_path(const std::string key) const;
+
+    unsigned char* map_entry(const std::string key, size_t value_size, entry_header_t* header);
+
+    void write_entry(const std::string key, entry_header_t header, const int* map, const void* data);
+
+
+
+public:
+    //==========================================================================
+    // Public Methods
+    //==========================================================================
+
+    /**
+     * Keeps entries in `directory`, which is created if it does not exist
+     */
+    anomaly_cache_t(const std::string directory);
+
+    /**
+     * Unmaps all entries, so no matrix loaded from this cache may be used
+     * after it is deleted
+     */
+    ~anomaly_cache_t();
+
+    /**
+     * Returns the key of the anomalies of variable `name` in `filename` along
+     * dimension `dim`, made with settings described by `variant`, or an empty
+     * string if the file can't be identified
+     */
+    std::string make_key(const std::string filename, const std::string name, const std::string dim, const std::string variant) const;
+
+    /**
+     * Maps the entry with `key` into a new anomaly matrix and rebuilds its
+     * reducer, and gives the largest magnitude of the input it came from.
+     * Returns false if there is no usable entry.
+     */
+    template<typename A, typename R>
+    bool load(const std::string key, matrix_t<A>** anomaly, matrix_reducer_t<R>** reducer, double* absmax);
+
+    /**
+     * Writes the entry with `key`. Failing to write it is not an error,
+     * since the cache is only an optimization, so it is only reported.
+     */
+    template<typename A, typename R>
+    void store(const std::string key, const matrix_t<A>* anomaly, const matrix_reducer_t<R>* reducer, double absmax);
+};
+
+
+
+
+
+//==============================================================================
+// Implementation
+//==============================================================================
+
+#include "anomaly_cache.tpp"
+
+#endif
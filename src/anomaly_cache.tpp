@@ -0,0 +1,61 @@
+/***********************************************************************
+ *                   GNU Lesser General Public License
+ *
+ * This file is part of the EDGI prototype package, developed by the
+ * GFDL Flexible Modeling System (FMS) group.
+ *
+ * EDGI is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * EDGI is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with EDGI.  If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************/
+
+// Note: This is not intended to be a standalone implementation file.
+
+/** Use std::fill */
+#include <algorithm>
+
+
+
+
+
+//==============================================================================
+// Public Methods
+//==============================================================================
+
+template<typename A, typename R>
+bool anomaly_cache_t::load(const std::string key, matrix_t<A>** anomaly, matrix_reducer_t<R>** reducer, double* absmax) {
+    entry_header_t header;
+    unsigned char* entry = this->map_entry(key, sizeof(A), &header);
+    if (entry == nullptr) {
+        return false;
+    }
+
+    *anomaly = new matrix_t<A>();
+    (*anomaly)->map_data(header.rows, header.cols, (A*) (entry + header.data_offset));
+    *reducer = new matrix_reducer_t<R>(header.restored_cols, header.reduced_cols, (const int*) (entry + header.map_offset));
+    *absmax = header.absmax;
+    return true;
+}
+
+template<typename A, typename R>
+void anomaly_cache_t::store(const std::string key, const matrix_t<A>* anomaly, const matrix_reducer_t<R>* reducer, double absmax) {
+    entry_header_t header;
+    std::fill((char*) &header, (char*) (&header + 1), 0);
+    header.value_size = sizeof(A);
+    header.rows = anomaly->get_rows();
+    header.cols = anomaly->get_cols();
+    header.restored_cols = reducer->get_restored_cols();
+    header.reduced_cols = reducer->get_reduced_cols();
+    header.absmax = absmax;
+
+    this->write_entry(key, header, reducer->get_map_reduced_cols(), anomaly->get_data());
+}
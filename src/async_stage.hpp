@@ -0,0 +1,86 @@
+/***********************************************************************
+ *                   GNU Lesser General Public License
+ *
+ * This file is part of the EDGI prototype package, developed by the
+ * GFDL Flexible Modeling System (FMS) group.
+ *
+ * EDGI is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * EDGI is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with EDGI.  If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************/
+
+#ifndef ASYNC_STAGE_HPP
+#define ASYNC_STAGE_HPP
+
+/** Use std::future, std::async */
+#include <future>
+
+
+
+
+
+//==============================================================================
+// Declaration
+//==============================================================================
+
+/**
+ * One stage of a pipeline, run on a background thread so that it overlaps
+ * with whatever the caller does next. Jobs run one at a time and in the
+ * order they were submitted, so a stage that calls the NetCDF library never
+ * has two calls in flight. The caller must not use the library itself while
+ * a job is running.
+ *
+ * A job's result (or exception) is handed back by take(). Submitting a job
+ * first waits for the one before it, discarding its result.
+ */
+template<typename R>
+class async_stage_t {
+private:
+    //==========================================================================
+    // Private Fields
+    //==========================================================================
+
+    /** The job in flight, if any */
+    std::future<R> pending;
+
+
+
+public:
+    //==========================================================================
+    // Public Methods
+    //==========================================================================
+
+    async_stage_t();
+
+    ~async_stage_t();
+
+    template<typename F>
+    void submit(F job);
+
+    R take();
+
+    void drain();
+
+    bool is_busy() const;
+};
+
+
+
+
+
+//==============================================================================
+// Implementation
+//==============================================================================
+
+#include "async_stage.tpp"
+
+#endif
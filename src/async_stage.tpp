@@ -0,0 +1,90 @@
+/***********************************************************************
+ *                   GNU Lesser General Public License
+ *
+ * This file is part of the EDGI prototype package, developed by the
+ * GFDL Flexible Modeling System (FMS) group.
+ *
+ * EDGI is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * EDGI is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with EDGI.  If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************/
+
+// Note: This is not intended to be a standalone implementation file.
+
+#include "error.hpp"
+
+
+
+
+
+//==============================================================================
+// Constructing and Destructing
+//==============================================================================
+
+template<typename R>
+async_stage_t<R>::async_stage_t() {}
+
+/**
+ * Waits for the job in flight, if any. Its exception (if any) is dropped,
+ * since it can't be thrown from here.
+ */
+template<typename R>
+async_stage_t<R>::~async_stage_t() {
+    if (this->pending.valid()) {
+        this->pending.wait();
+    }
+}
+
+
+
+
+
+//==============================================================================
+// Public Methods
+//==============================================================================
+
+/**
+ * Waits for the job in flight, then starts `job` on a new thread
+ */
+template<typename R>
+template<typename F>
+void async_stage_t<R>::submit(F job) {
+    this->drain();
+    this->pending = std::async(std::launch::async, job);
+}
+
+/**
+ * Waits for the job in flight and returns its result, rethrowing anything
+ * it threw
+ */
+template<typename R>
+R async_stage_t<R>::take() {
+    if (!this->pending.valid()) {
+        throw eof_error_t("(Internal Error) No job was submitted to this stage");
+    }
+    return this->pending.get();
+}
+
+/**
+ * Waits for the job in flight, if any, rethrowing anything it threw
+ */
+template<typename R>
+void async_stage_t<R>::drain() {
+    if (this->pending.valid()) {
+        this->pending.get();
+    }
+}
+
+template<typename R>
+bool async_stage_t<R>::is_busy() const {
+    return this->pending.valid();
+}
@@ -0,0 +1,491 @@
+/***********************************************************************
+ *                   GNU Lesser General Public License
+ *
+ * This file is part of the EDGI prototype package, developed by the
+ * GFDL Flexible Modeling System (FMS) group.
+ *
+ * EDGI is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * EDGI is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with EDGI.  If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************/
+
+#include "cdf_mmap_reader.hpp"
+
+#include "error.hpp"
+
+/** Use open, close */
+#include <fcntl.h>
+#include <unistd.h>
+
+/** Use fstat */
+#include <sys/stat.h>
+
+/** Use mmap, munmap */
+#include <sys/mman.h>
+
+/** Use uint16_t, uint32_t, uint64_t, int16_t, int32_t */
+#include <cstdint>
+
+/** Use memcpy */
+#include <cstring>
+
+/** Use std::min */
+#include <algorithm>
+
+// <string> included in header
+using std::string;
+
+
+
+
+
+//==============================================================================
+// Local functions
+//==============================================================================
+
+namespace {
+
+    /** Header tags and types from the NetCDF classic format specification */
+    const uint32_t NC_DIMENSION = 0x0A;
+    const uint32_t NC_VARIABLE = 0x0B;
+    const uint32_t NC_ATTRIBUTE = 0x0C;
+    const uint64_t STREAMING = 0xFFFFFFFF;
+
+    const int CDF_SHORT = 3;
+    const int CDF_INT = 4;
+    const int CDF_FLOAT = 5;
+    const int CDF_DOUBLE = 6;
+
+    /** Values per piece of work handed to a thread when copying */
+    const size_t VALUES_PER_PIECE = 1 << 16;
+
+    /**
+     * Returns the size in bytes of a value of a classic NetCDF type, or 0 if
+     * the type is unknown
+     */
+    size_t type_size(int type) {
+        switch (type) {
+            case 1: case 2: case 7:
+                return 1;
+            case 3: case 8:
+                return 2;
+            case 4: case 5: case 9:
+                return 4;
+            case 6: case 10: case 11:
+                return 8;
+            default:
+                return 0;
+        }
+    }
+
+    /** Rounds up to a multiple of 4, as the header and data are padded */
+    size_t pad4(size_t len) {
+        return (len + 3) & ~((size_t) 3);
+    }
+
+    /**
+     * Walks the big-endian header of a classic file, throwing eof_error_t if
+     * it runs past the end of the map
+     */
+    class header_cursor_t {
+    private:
+        const unsigned char* map;
+        size_t size;
+        size_t pos;
+        int version;
+
+    public:
+        header_cursor_t(const unsigned char* map, size_t size, int version)
+                : map(map), size(size), pos(4), version(version) {}
+
+        uint64_t read_uint(size_t len) {
+            if (this->pos + len > this->size) {
+                throw eof_error_t("Truncated NetCDF header");
+            }
+            uint64_t value = 0;
+            for (size_t i = 0; i < len; i++) {
+                value = (value << 8) | this->map[this->pos + i];
+            }
+            this->pos += len;
+            return value;
+        }
+
+        /** NON_NEG values (counts and lengths) are 8 bytes in CDF5 */
+        uint64_t read_non_neg() {
+            return this->read_uint(this->version == 5 ? 8 : 4);
+        }
+
+        /** Data offsets are 4 bytes in CDF1 only */
+        uint64_t read_offset() {
+            return this->read_uint(this->version == 1 ? 4 : 8);
+        }
+
+        string read_name() {
+            size_t len = this->read_non_neg();
+            if (this->pos + len > this->size) {
+                throw eof_error_t("Truncated NetCDF header");
+            }
+            string name((const char*) this->map + this->pos, len);
+            this->pos += pad4(len);
+            return name;
+        }
+
+        /** Reads the tag and count starting a list, which may be absent */
+        uint64_t read_list(uint32_t tag) {
+            uint32_t found = this->read_uint(4);
+            uint64_t num = this->read_non_neg();
+            if (found != tag && !(found == 0 && num == 0)) {
+                throw eof_error_t("Malformed NetCDF header");
+            }
+            return num;
+        }
+
+        void skip_attrs() {
+            uint64_t num = this->read_list(NC_ATTRIBUTE);
+            for (uint64_t i = 0; i < num; i++) {
+                this->read_name();
+                size_t size = type_size(this->read_uint(4));
+                uint64_t len = this->read_non_neg();
+                if (size == 0) {
+                    throw eof_error_t("Malformed NetCDF header");
+                }
+                this->pos += pad4(size * len);
+            }
+        }
+    };
+
+    /**
+     * Loads one big-endian value of type F from the map
+     */
+    template<typename F, typename U>
+    inline F load_big_endian(const unsigned char* src) {
+        U bits;
+        std::memcpy(&bits, src, sizeof(U));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        if (sizeof(U) == 2) {
+            bits = __builtin_bswap16(bits);
+        } else if (sizeof(U) == 4) {
+            bits = __builtin_bswap32(bits);
+        } else {
+            bits = __builtin_bswap64(bits);
+        }
+#endif
+        F value;
+        std::memcpy(&value, &bits, sizeof(F));
+        return value;
+    }
+
+    /**
+     * Converts `len` big-endian values of type F into vals
+     */
+    template<typename F, typename U, typename S>
+    void convert_run(const unsigned char* src, size_t len, S* vals) {
+        for (size_t i = 0; i < len; i++) {
+            vals[i] = (S) load_big_endian<F, U>(src + i * sizeof(F));
+        }
+    }
+
+}
+
+
+
+
+
+//==============================================================================
+// Constructors and destructors
+//==============================================================================
+
+bool cdf_mmap_reader_t::is_classic(const string filename) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    unsigned char magic[4];
+    bool classic = ::read(fd, magic, 4) == 4 && magic[0] == 'C' && magic[1] == 'D' && magic[2] == 'F'
+            && (magic[3] == 1 || magic[3] == 2 || magic[3] == 5);
+    close(fd);
+    return classic;
+}
+
+cdf_mmap_reader_t::cdf_mmap_reader_t(const string filename, const string name) {
+    this->fd = open(filename.c_str(), O_RDONLY);
+    if (this->fd < 0) {
+        return;
+    }
+
+    struct stat info;
+    if (fstat(this->fd, &info) != 0 || info.st_size < 4) {
+        return;
+    }
+
+    void* map = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, this->fd, 0);
+    if (map == MAP_FAILED) {
+        return;
+    }
+    this->map = (const unsigned char*) map;
+    this->map_size = info.st_size;
+
+    // Anything in the header we can't follow leaves the reader unsupported,
+    // and the variable is then read through the NetCDF library instead
+    try {
+        this->supported = this->parse_header(name);
+    } catch (const eof_error_t& e) {
+        this->supported = false;
+    }
+}
+
+cdf_mmap_reader_t::~cdf_mmap_reader_t() {
+    if (this->map != nullptr) {
+        munmap((void*) this->map, this->map_size);
+    }
+    if (this->fd >= 0) {
+        close(this->fd);
+    }
+}
+
+
+
+
+
+//==============================================================================
+// Private Methods
+//==============================================================================
+
+/**
+ * Finds the variable `name` in the header, and works out where its values
+ * are. Returns whether it can be read here.
+ */
+bool cdf_mmap_reader_t::parse_header(const string name) {
+    const unsigned char* magic = this->map;
+    if (magic[0] != 'C' || magic[1] != 'D' || magic[2] != 'F') {
+        return false;
+    }
+    int version = magic[3];
+    if (version != 1 && version != 2 && version != 5) {
+        return false;
+    }
+
+    header_cursor_t cursor(this->map, this->map_size, version);
+
+    uint64_t num_records = cursor.read_non_neg();
+    if (num_records == STREAMING) {
+        return false;
+    }
+
+    uint64_t num_file_dims = cursor.read_list(NC_DIMENSION);
+    std::vector<size_t> file_dims(num_file_dims);
+    size_t record_dim = (size_t) -1;
+    for (uint64_t i = 0; i < num_file_dims; i++) {
+        cursor.read_name();
+        file_dims[i] = cursor.read_non_neg();
+        if (file_dims[i] == 0) {
+            record_dim = i;
+            file_dims[i] = num_records;
+        }
+    }
+
+    cursor.skip_attrs();
+
+    // Every record variable's record is padded to 4 bytes in the file,
+    // except when there is only one record variable
+    size_t num_record_vars = 0;
+    size_t record_size = 0;
+    size_t last_record_len = 0;
+    bool found = false;
+
+    uint64_t num_vars = cursor.read_list(NC_VARIABLE);
+    for (uint64_t i = 0; i < num_vars; i++) {
+        string var_name = cursor.read_name();
+        uint64_t num_dims = cursor.read_non_neg();
+        std::vector<size_t> dims(num_dims);
+        bool is_record = false;
+        for (uint64_t d = 0; d < num_dims; d++) {
+            uint64_t dim_id = cursor.read_non_neg();
+            if (dim_id >= num_file_dims) {
+                return false;
+            }
+            dims[d] = file_dims[dim_id];
+            if (d == 0 && dim_id == record_dim) {
+                is_record = true;
+            }
+        }
+
+        cursor.skip_attrs();
+        int type = cursor.read_uint(4);
+        cursor.read_non_neg();
+        size_t begin = cursor.read_offset();
+
+        size_t len = type_size(type);
+        for (size_t d = is_record ? 1 : 0; d < num_dims; d++) {
+            len *= dims[d];
+        }
+
+        if (is_record) {
+            num_record_vars++;
+            record_size += pad4(len);
+            last_record_len = len;
+        }
+
+        if (var_name == name) {
+            found = true;
+            this->type = type;
+            this->dims = dims;
+            this->is_record = is_record;
+            this->begin = begin;
+        }
+    }
+
+    if (num_record_vars == 1) {
+        record_size = last_record_len;
+    }
+    this->record_size = record_size;
+
+    if (!found) {
+        return false;
+    }
+    if (this->type != CDF_SHORT && this->type != CDF_INT && this->type != CDF_FLOAT && this->type != CDF_DOUBLE) {
+        return false;
+    }
+
+    // Make sure every value lies inside the file
+    size_t size = type_size(this->type);
+    size_t end = this->begin;
+    if (this->is_record) {
+        size_t len = size;
+        for (size_t d = 1; d < this->dims.size(); d++) {
+            len *= this->dims[d];
+        }
+        if (this->dims[0] > 0) {
+            end += (this->dims[0] - 1) * this->record_size + len;
+        }
+    } else {
+        size_t len = size;
+        for (size_t d = 0; d < this->dims.size(); d++) {
+            len *= this->dims[d];
+        }
+        end += len;
+    }
+
+    return end <= this->map_size;
+}
+
+/**
+ * Copies the hyperslab out of the map. The slab is cut into runs of values
+ * that are contiguous in the file, and the runs into pieces that are shared
+ * across the OpenMP threads, each byte-swapping and converting its piece.
+ */
+template<typename S>
+void cdf_mmap_reader_t::read_values(const size_t* start, const size_t* count, S* vals) const {
+    size_t n = this->dims.size();
+    size_t size = type_size(this->type);
+
+    // Byte strides in the file. Records of a record variable are
+    // interleaved with those of the other record variables.
+    std::vector<size_t> stride(n);
+    size_t len = size;
+    for (size_t d = n; d-- > 0;) {
+        stride[d] = len;
+        len *= this->dims[d];
+    }
+    if (this->is_record && n > 0) {
+        stride[0] = this->record_size;
+    }
+
+    // Runs cover dimension k onward, which needs every later dimension to
+    // be read whole. The records are never contiguous with each other.
+    size_t k = (n > 0) ? n - 1 : 0;
+    while (k > 0 && count[k] == this->dims[k] && !(this->is_record && k == 1)) {
+        k--;
+    }
+    if (this->is_record && k == 0) {
+        k = 1;
+    }
+
+    size_t run_len = 1;
+    for (size_t d = k; d < n; d++) {
+        if (count[d] == 0) {
+            return;
+        }
+        run_len *= count[d];
+    }
+    size_t num_runs = 1;
+    for (size_t d = 0; d < k; d++) {
+        if (count[d] == 0) {
+            return;
+        }
+        num_runs *= count[d];
+    }
+
+    size_t pieces_per_run = (run_len + VALUES_PER_PIECE - 1) / VALUES_PER_PIECE;
+    size_t num_pieces = num_runs * pieces_per_run;
+
+    #pragma omp parallel for schedule(static)
+    for (size_t p = 0; p < num_pieces; p++) {
+        size_t r = p / pieces_per_run;
+        size_t first = (p % pieces_per_run) * VALUES_PER_PIECE;
+        size_t num = std::min(VALUES_PER_PIECE, run_len - first);
+
+        // Find the start of run r in the file
+        size_t src = this->begin;
+        size_t rem = r;
+        for (size_t d = k; d-- > 0;) {
+            src += (start[d] + rem % count[d]) * stride[d];
+            rem /= count[d];
+        }
+        if (k < n) {
+            src += start[k] * stride[k];
+        }
+        src += first * size;
+
+        S* dst = vals + r * run_len + first;
+        const unsigned char* in = this->map + src;
+        switch (this->type) {
+            case CDF_SHORT:
+                convert_run<int16_t, uint16_t>(in, num, dst);
+                break;
+            case CDF_INT:
+                convert_run<int32_t, uint32_t>(in, num, dst);
+                break;
+            case CDF_FLOAT:
+                convert_run<float, uint32_t>(in, num, dst);
+                break;
+            default:
+                convert_run<double, uint64_t>(in, num, dst);
+                break;
+        }
+    }
+}
+
+
+
+
+
+//==============================================================================
+// Public Methods
+//==============================================================================
+
+bool cdf_mmap_reader_t::is_supported() const {
+    return this->supported;
+}
+
+void cdf_mmap_reader_t::read(const size_t* start, const size_t* count, float* vals) const {
+    this->read_values(start, count, vals);
+}
+
+void cdf_mmap_reader_t::read(const size_t* start, const size_t* count, double* vals) const {
+    this->read_values(start, count, vals);
+}
+
+void cdf_mmap_reader_t::read(const size_t* start, const size_t* count, short* vals) const {
+    this->read_values(start, count, vals);
+}
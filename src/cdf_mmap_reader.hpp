@@ -0,0 +1,122 @@
+/***********************************************************************
+ *                   GNU Lesser General Public License
+ *
+ * This file is part of the EDGI prototype package, developed by the
+ * GFDL Flexible Modeling System (FMS) group.
+ *
+ * EDGI is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * EDGI is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with EDGI.  If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************/
+
+#ifndef CDF_MMAP_READER_HPP
+#define CDF_MMAP_READER_HPP
+
+/** Use slab_reader_t */
+#include "slab_reader.hpp"
+
+/** Use size_t */
+#include <cstddef>
+
+/** Use std::string */
+#include <string>
+
+/** Use std::vector */
+#include <vector>
+
+
+
+
+
+//==============================================================================
+// Declaration
+//==============================================================================
+
+/**
+ * Reads hyperslabs of a variable in a NetCDF classic, 64-bit offset or CDF5
+ * file straight out of a read-only memory map of the file. The header is
+ * parsed here, and values are byte-swapped from big-endian and converted as
+ * they are copied out, so nothing is read through the NetCDF library and the
+ * page cache is shared between runs.
+ *
+ * Short, int, float and double variables are supported. Use is_supported()
+ * and fall back to netcdf_file_t for anything else (and for NetCDF-4 files,
+ * see is_classic()).
+ */
+class cdf_mmap_reader_t : public slab_reader_t {
+private:
+    //==========================================================================
+    // Private Fields
+    //==========================================================================
+
+    /** The mapped file */
+    int fd = -1;
+    const unsigned char* map = nullptr;
+    size_t map_size = 0;
+
+    /** The NetCDF type of the variable */
+    int type = 0;
+
+    /** The extent of the variable in each dimension */
+    std::vector<size_t> dims;
+
+    /** Is the first dimension the record dimension? */
+    bool is_record = false;
+
+    /** Offset of the variable's data, and bytes between its records */
+    size_t begin = 0;
+    size_t record_size = 0;
+
+    /** Can this variable be read here? */
+    bool supported = false;
+
+
+
+    //==========================================================================
+    // Private Methods
+    //==========================================================================
+
+    bool parse_header(const std::string name);
+
+    template<typename S>
+    void read_values(const size_t* start, const size_t* count, S* vals) const;
+
+
+
+public:
+    //==========================================================================
+    // Public Methods
+    //==========================================================================
+
+    /**
+     * Returns whether the file is in a NetCDF classic format (CDF1, CDF2 or
+     * CDF5)
+     */
+    static bool is_classic(const std::string filename);
+
+    /**
+     * Maps the file `filename` and looks up its variable `name`
+     */
+    cdf_mmap_reader_t(const std::string filename, const std::string name);
+
+    ~cdf_mmap_reader_t();
+
+    bool is_supported() const;
+
+    void read(const size_t* start, const size_t* count, float* vals) const;
+
+    void read(const size_t* start, const size_t* count, double* vals) const;
+
+    void read(const size_t* start, const size_t* count, short* vals) const;
+};
+
+#endif
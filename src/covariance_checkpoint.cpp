@@ -0,0 +1,206 @@
+/***********************************************************************
+ *                   GNU Lesser General Public License
+ *
+ * This file is part of the EDGI prototype package, developed by the
+ * GFDL Flexible Modeling System (FMS) group.
+ *
+ * EDGI is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * EDGI is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with EDGI.  If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************/
+
+#include "covariance_checkpoint.hpp"
+
+#include "error.hpp"
+
+/** Use write_all, write_zeros, replace_file, align_up */
+#include "file_utils.hpp"
+
+/** Use open, close */
+#include <fcntl.h>
+#include <unistd.h>
+
+/** Use fstat */
+#include <sys/stat.h>
+
+/** Use mmap, munmap */
+#include <sys/mman.h>
+
+/** Use errno */
+#include <cerrno>
+
+/** Use memcmp, memcpy, strerror */
+#include <cstring>
+
+/** Use std::cerr */
+#include <iostream>
+
+// <string> and <vector> included in header
+using std::string;
+using std::vector;
+
+
+
+
+
+//==============================================================================
+// Local functions
+//==============================================================================
+
+namespace {
+
+    const char MAGIC[MAGIC_LEN] = {'E', 'D', 'G', 'I', 'C', 'O', 'V', 'M'};
+
+    const uint32_t FORMAT_VERSION = 1;
+}
+
+
+
+
+
+//==============================================================================
+// Private Methods
+//==============================================================================
+
+unsigned char* covariance_checkpoint_t::map_file(const string key, size_t value_size, size_t num_vars, file_header_t* header) {
+    int fd = open(this->filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw eof_error_t("Could not open covariance checkpoint \"" + this->filename + "\": " + std::strerror(errno));
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t) info.st_size < sizeof(file_header_t)) {
+        close(fd);
+        throw eof_error_t("\"" + this->filename + "\" is not a covariance checkpoint");
+    }
+
+    // Private and writable, since the eigensolver may work on the matrix in place
+    size_t size = info.st_size;
+    void* mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        throw eof_error_t("Could not map covariance checkpoint \"" + this->filename + "\": " + std::strerror(errno));
+    }
+
+    unsigned char* file = (unsigned char*) mapped;
+    std::memcpy(header, file, sizeof(file_header_t));
+
+    string error;
+    if (!has_magic(header->magic, MAGIC) || header->version != FORMAT_VERSION) {
+        error = "\"" + this->filename + "\" is not a covariance checkpoint";
+    } else if (header->value_size != value_size
+            || header->num_vars != num_vars
+            || header->key_len != key.size()
+            || std::memcmp(file + sizeof(file_header_t), key.data(), key.size()) != 0) {
+        error = "Covariance checkpoint \"" + this->filename + "\" was saved from other inputs or settings";
+    } else if (header->vars_offset < sizeof(file_header_t) + header->key_len
+            || header->maps_offset < header->vars_offset + num_vars * sizeof(var_record_t)
+            || header->data_offset % DATA_ALIGNMENT != 0
+            || header->data_offset + header->rows * header->cols * value_size > size) {
+        error = "Covariance checkpoint \"" + this->filename + "\" is truncated or corrupt";
+    } else {
+        // Each map must fit, and list columns within its variable
+        const var_record_t* vars = (const var_record_t*) (file + header->vars_offset);
+        const int* map = (const int*) (file + header->maps_offset);
+        size_t map_len = 0;
+        for (size_t i = 0; i < num_vars && error.empty(); i++) {
+            if (vars[i].reduced_cols > vars[i].restored_cols
+                    || header->maps_offset + (map_len + vars[i].reduced_cols) * sizeof(int) > header->data_offset) {
+                error = "Covariance checkpoint \"" + this->filename + "\" is truncated or corrupt";
+                break;
+            }
+            for (size_t c = 0; c < vars[i].reduced_cols; c++) {
+                if (map[map_len + c] < 0 || (size_t) map[map_len + c] >= vars[i].restored_cols) {
+                    error = "Covariance checkpoint \"" + this->filename + "\" is truncated or corrupt";
+                    break;
+                }
+            }
+            map_len += vars[i].reduced_cols;
+        }
+
+        // The matrix is square, with a row for each kept column
+        if (error.empty() && (header->rows != header->cols || header->rows != map_len)) {
+            error = "Covariance checkpoint \"" + this->filename + "\" is truncated or corrupt";
+        }
+    }
+
+    if (!error.empty()) {
+        munmap(mapped, size);
+        throw eof_error_t(error);
+    }
+
+    if (this->mapped != nullptr) {
+        munmap(this->mapped, this->mapped_size);
+    }
+    this->mapped = mapped;
+    this->mapped_size = size;
+    return file;
+}
+
+void covariance_checkpoint_t::write_file(const string key, file_header_t header, const var_record_t* vars,
+        const vector<const int*>& maps, const void* data) {
+    size_t map_len = 0;
+    for (size_t i = 0; i < header.num_vars; i++) {
+        map_len += vars[i].reduced_cols;
+    }
+
+    set_magic(header.magic, MAGIC);
+    header.version = FORMAT_VERSION;
+    header.key_len = key.size();
+    header.vars_offset = align_up(sizeof(file_header_t) + key.size(), sizeof(uint64_t));
+    header.maps_offset = header.vars_offset + header.num_vars * sizeof(var_record_t);
+    size_t maps_end = header.maps_offset + map_len * sizeof(int);
+    header.data_offset = align_up(maps_end, DATA_ALIGNMENT);
+
+    // Replaced as a whole, so an earlier checkpoint is only replaced by a
+    // whole one
+    int error = 0;
+    bool written = replace_file(this->filename, [&](int fd) {
+        bool ok = write_all(fd, &header, sizeof(file_header_t))
+            && write_all(fd, key.data(), key.size())
+            && write_zeros(fd, header.vars_offset - sizeof(file_header_t) - key.size())
+            && write_all(fd, vars, header.num_vars * sizeof(var_record_t));
+        for (size_t i = 0; i < header.num_vars && ok; i++) {
+            ok = write_all(fd, maps[i], vars[i].reduced_cols * sizeof(int));
+        }
+        return ok
+            && write_zeros(fd, header.data_offset - maps_end)
+            && write_all(fd, data, header.rows * header.cols * header.value_size);
+    }, &error);
+
+    if (!written) {
+        std::cerr << "[WARNING] Could not write covariance checkpoint " << this->filename << ": "
+                  << std::strerror(error) << std::endl;
+    }
+}
+
+
+
+
+
+//==============================================================================
+// Public Methods
+//==============================================================================
+
+covariance_checkpoint_t::covariance_checkpoint_t(const string filename) {
+    this->filename = filename;
+}
+
+covariance_checkpoint_t::~covariance_checkpoint_t() {
+    if (this->mapped != nullptr) {
+        munmap(this->mapped, this->mapped_size);
+    }
+}
+
+const string covariance_checkpoint_t::get_filename() const {
+    return this->filename;
+}
@@ -0,0 +1,152 @@
+/***********************************************************************
+ *                   GNU Lesser General Public License
+ *
+ * This file is part of the EDGI prototype package, developed by the
+ * GFDL Flexible Modeling System (FMS) group.
+ *
+ * EDGI is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * EDGI is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with EDGI.  If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************/
+
+#ifndef COVARIANCE_CHECKPOINT_HPP
+#define COVARIANCE_CHECKPOINT_HPP
+
+/** Use matrix_t */
+#include "matrix.hpp"
+
+/** Use matrix_reducer_t */
+#include "matrix_reducer.hpp"
+
+/** Use size_t */
+#include <cstddef>
+
+/** Use uint32_t, uint64_t */
+#include <cstdint>
+
+/** Use std::string */
+#include <string>
+
+/** Use std::vector */
+#include <vector>
+
+
+
+
+
+//==============================================================================
+// Declaration
+//==============================================================================
+
+/**
+ * A file holding a finished covariance matrix, with the maps of the reducers
+ * of its variables and the largest magnitudes of their inputs (for fill
+ * values), so that the eigensolve and the outputs can be redone from it
+ * without building the covariance matrix again.
+ *
+ * The file starts with a key describing the inputs and settings the matrix
+ * was made with, which must match to resume from it. The matrix starts on a
+ * page boundary, and is mapped copy-on-write when resuming, so it is never
+ * read into a second copy.
+ */
+class covariance_checkpoint_t {
+private:
+    //==========================================================================
+    // Private Fields
+    //==========================================================================
+
+    /** The fixed-size start of the file, followed by the key, the variables, the maps and the matrix */
+    struct file_header_t {
+        char magic[8];
+        uint32_t version;
+        uint32_t value_size;
+        uint64_t key_len;
+        uint64_t num_vars;
+        uint64_t rows;
+        uint64_t cols;
+        uint64_t vars_offset;
+        uint64_t maps_offset;
+        uint64_t data_offset;
+    };
+
+    /** What is kept of each variable */
+    struct var_record_t {
+        uint64_t restored_cols;
+        uint64_t reduced_cols;
+        double absmax[2];
+    };
+
+    std::string filename;
+
+    /** The file, while mapped by load */
+    void* mapped = nullptr;
+    size_t mapped_size = 0;
+
+
+
+    //==========================================================================
+    // Private Methods
+    //==========================================================================
+
+    unsigned char* map_file(const std::string key, size_t value_size, size_t num_vars, file_header_t* header);
+
+    void write_file(const std::string key, file_header_t header, const var_record_t* vars,
+        const std::vector<const int*>& maps, const void* data);
+
+
+
+public:
+    //==========================================================================
+    // Public Methods
+    //==========================================================================
+
+    covariance_checkpoint_t(const std::string filename);
+
+    /**
+     * Unmaps the file, so no matrix loaded from it may be used after this is
+     * deleted
+     */
+    ~covariance_checkpoint_t();
+
+    const std::string get_filename() const;
+
+    /**
+     * Writes `cov`, the maps of the `num_vars` reducers, and two largest
+     * magnitudes per variable (real and imaginary, or of each part) from
+     * `absmaxes`. Failing to write is only reported, since the results can
+     * still be finished without the checkpoint.
+     */
+    template<typename S, typename R>
+    void save(const std::string key, const matrix_t<S>* cov, matrix_reducer_t<R>** reducers,
+        const double* absmaxes, size_t num_vars);
+
+    /**
+     * Maps the matrix into `cov`, and rebuilds the reducers and largest
+     * magnitudes saved with it. Throws if the file can't be read or was
+     * saved with another key.
+     */
+    template<typename S, typename R>
+    void load(const std::string key, matrix_t<S>* cov, matrix_reducer_t<R>** reducers,
+        double* absmaxes, size_t num_vars);
+};
+
+
+
+
+
+//==============================================================================
+// Implementation
+//==============================================================================
+
+#include "covariance_checkpoint.tpp"
+
+#endif
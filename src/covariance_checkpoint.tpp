@@ -0,0 +1,73 @@
+/***********************************************************************
+ *                   GNU Lesser General Public License
+ *
+ * This file is part of the EDGI prototype package, developed by the
+ * GFDL Flexible Modeling System (FMS) group.
+ *
+ * EDGI is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * EDGI is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with EDGI.  If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************/
+
+// Note: This is not intended to be a standalone implementation file.
+
+/** Use std::fill */
+#include <algorithm>
+
+
+
+
+
+//==============================================================================
+// Public Methods
+//==============================================================================
+
+template<typename S, typename R>
+void covariance_checkpoint_t::save(const std::string key, const matrix_t<S>* cov, matrix_reducer_t<R>** reducers,
+        const double* absmaxes, size_t num_vars) {
+    file_header_t header;
+    std::fill((char*) &header, (char*) (&header + 1), 0);
+    header.value_size = sizeof(S);
+    header.num_vars = num_vars;
+    header.rows = cov->get_rows();
+    header.cols = cov->get_cols();
+
+    std::vector<var_record_t> vars(num_vars);
+    std::vector<const int*> maps(num_vars);
+    for (size_t i = 0; i < num_vars; i++) {
+        vars[i].restored_cols = reducers[i]->get_restored_cols();
+        vars[i].reduced_cols = reducers[i]->get_reduced_cols();
+        vars[i].absmax[0] = absmaxes[2 * i];
+        vars[i].absmax[1] = absmaxes[2 * i + 1];
+        maps[i] = reducers[i]->get_map_reduced_cols();
+    }
+
+    this->write_file(key, header, vars.data(), maps, cov->get_data());
+}
+
+template<typename S, typename R>
+void covariance_checkpoint_t::load(const std::string key, matrix_t<S>* cov, matrix_reducer_t<R>** reducers,
+        double* absmaxes, size_t num_vars) {
+    file_header_t header;
+    unsigned char* file = this->map_file(key, sizeof(S), num_vars, &header);
+
+    const var_record_t* vars = (const var_record_t*) (file + header.vars_offset);
+    const int* map = (const int*) (file + header.maps_offset);
+    for (size_t i = 0; i < num_vars; i++) {
+        reducers[i] = new matrix_reducer_t<R>(vars[i].restored_cols, vars[i].reduced_cols, map);
+        absmaxes[2 * i] = vars[i].absmax[0];
+        absmaxes[2 * i + 1] = vars[i].absmax[1];
+        map += vars[i].reduced_cols;
+    }
+
+    cov->map_data(header.rows, header.cols, (S*) (file + header.data_offset));
+}
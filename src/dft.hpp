@@ -28,6 +28,12 @@
 /** Use std::complex */
 #include <complex>
 
+/** Use std::sin */
+#include <cmath>
+
+/** Use scratch_arena_t */
+#include "scratch_arena.hpp"
+
 
 
 
@@ -38,9 +44,21 @@
 
 template<typename T>
 class dft_t {
+protected:
+    /** Per-thread buffers lent by the owner of this transform, if any */
+    scratch_arena_t* scratch = nullptr;
+
 public:
     virtual ~dft_t() {}
 
+    /**
+     * Lends this transform a scratch arena for its per-thread column buffers.
+     * The arena is owned by the caller and must outlive any calculation.
+     */
+    void set_scratch(scratch_arena_t* scratch) {
+        this->scratch = scratch;
+    }
+
     /**
      *
      */
@@ -80,6 +98,15 @@ public:
         matrix_t<std::complex<T>>* input,
         matrix_t<std::complex<T>>* output
     ) = 0;
+
+    /**
+     * Hilbert transform of every column of a real matrix, i.e. the imaginary
+     * part of its analytic signal, kept separate from the real part
+     */
+    virtual void hilbert(
+        matrix_t<T>* input,
+        matrix_t<T>* output
+    ) = 0;
 };
 
 
@@ -133,6 +160,14 @@ public:
         matrix_t<std::complex<T>>* input,
         matrix_t<std::complex<T>>* output
     );
+
+    /**
+     *
+     */
+    void hilbert(
+        matrix_t<T>* input,
+        matrix_t<T>* output
+    );
 };
 
 
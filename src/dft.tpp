@@ -134,3 +134,50 @@ void basic_dft_t<T>::analytic(
         }
     }
 }
+
+/**
+ * Hilbert transform of every column straight from its definition: the
+ * positive frequencies are multiplied by -i and DC and Nyquist are dropped,
+ * which in the time domain is a circular convolution with a sine kernel
+ */
+template<typename T>
+void basic_dft_t<T>::hilbert(
+    matrix_t<T>* input,
+    matrix_t<T>* output
+) {
+    const size_t rows = input->get_rows();
+    const size_t cols = input->get_cols();
+
+    // Bins past the last positive frequency (the Nyquist term, for even
+    // lengths) are zeroed along with DC
+    const size_t last = (rows % 2 == 0) ? rows / 2 : rows / 2 + 1;
+
+    T* kernel = new T[rows];
+    for (size_t j = 0; j < rows; j++) {
+        T sum = 0;
+        for (size_t k = 1; k < last; k++) {
+            sum += std::sin(2 * M_PI * (T) ((k * j) % rows) / (T) rows);
+        }
+        kernel[j] = 2 * sum / (T) rows;
+    }
+
+    output->set_shape(rows, cols);
+
+    T* slice_in = new T[rows];
+    T* slice_out = new T[rows];
+    for (size_t c = 0; c < cols; c++) {
+        input->get_col(c, slice_in);
+        for (size_t n = 0; n < rows; n++) {
+            T sum = 0;
+            for (size_t m = 0; m < rows; m++) {
+                sum += slice_in[m] * kernel[(n + rows - m) % rows];
+            }
+            slice_out[n] = sum;
+        }
+        output->set_col(c, slice_out);
+    }
+
+    delete[] slice_in;
+    delete[] slice_out;
+    delete[] kernel;
+}
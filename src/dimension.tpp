@@ -229,11 +229,13 @@ void dimension_t<T>::set_name(const std::string name) {
 
 template<typename T>
 void dimension_t<T>::set_values(size_t size, const T* values) {
+    T* old_values = this->values;
     this->size = size;
     this->values = new T[size];
     for (size_t i = 0; i < size; i++) {
         this->values[i] = values[i];
     }
+    delete[] old_values;
 }
 
 
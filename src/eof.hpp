@@ -36,6 +36,12 @@
 /** Use std::conditional */
 #include <type_traits>
 
+/** Use std::function */
+#include <functional>
+
+/** Use std::pair */
+#include <utility>
+
 /** Use variable_t */
 #include "variable.hpp"
 
@@ -51,6 +57,27 @@
 /** Use matrix_reducer_t */
 #include "matrix_reducer.hpp"
 
+/** Use scratch_arena_t */
+#include "scratch_arena.hpp"
+
+/** Use precision_t, default_precision, split_traits */
+#include "precision.hpp"
+
+/** Use split_variable_t */
+#include "split_variable.hpp"
+
+/** Use async_stage_t */
+#include "async_stage.hpp"
+
+/** Use anomaly_cache_t */
+#include "anomaly_cache.hpp"
+
+/** Use covariance_checkpoint_t */
+#include "covariance_checkpoint.hpp"
+
+/** Use tile_checkpoint_t */
+#include "tile_checkpoint.hpp"
+
 
 
 
@@ -59,14 +86,54 @@
 // Declaration
 //==============================================================================
 
-template<typename S, typename T>
+/**
+ * Computes EOFs of variables with data type S and dimension type T. The
+ * precision policy P (see precision.hpp) selects how the anomaly matrix is
+ * stored and what the covariance kernels compute and accumulate in.
+ */
+template<typename S, typename T, typename P = typename default_precision<S>::type>
 class eof_t {
+public:
+    typedef typename P::storage_t storage_t;
+    typedef typename P::compute_t compute_t;
+    typedef typename P::accum_t   accum_t;
+
+    /** Anomaly matrices hold scalars; complex series are stored split */
+    typedef typename split_traits<storage_t>::scalar_t anomaly_t;
+    typedef typename split_traits<compute_t>::scalar_t compute_scalar_t;
+    typedef typename split_traits<accum_t>::scalar_t   accum_scalar_t;
+    static const size_t planes = split_traits<storage_t>::planes;
+
+    /** Receive each output variable, with its index, as soon as it is built */
+    typedef std::function<void(size_t, const variable_t<S, T>*)> output_sink_t;
+    typedef std::function<void(size_t, const split_variable_t<T>*)> split_output_sink_t;
+
 private:
     //==========================================================================
     // Private Fields
     //==========================================================================
 
     svd_t<T>* svd = nullptr;
+
+    /** Per-thread column buffers borrowed by the covariance kernels */
+    scratch_arena_t scratch;
+
+    /** Where outputs go (on a writer thread) as they are built, if anywhere */
+    output_sink_t output_sink;
+    split_output_sink_t split_output_sink;
+
+    /** Write outputs in CF "compression by gathering" form instead of restoring them? */
+    bool gathered_output = false;
+
+    /** Where reduced anomaly matrices are kept between runs, if anywhere */
+    anomaly_cache_t* anomaly_cache = nullptr;
+
+    /** Where the covariance matrix is saved once built, or resumed from, if anywhere */
+    std::string checkpoint_filename;
+    bool resume_from_checkpoint = false;
+
+    /** Where the covariance matrix is built tile by tile, if anywhere */
+    tile_checkpoint_t* tile_checkpoint = nullptr;
     
     //interp_t<S>* interp = nullptr;
     
@@ -83,38 +150,82 @@ private:
         F cmp
     );
     
+    template<typename V>
     void match_dimension_in_all_variables(
-        std::vector<variable_t<S, T>*> input_vars,
+        std::vector<V*> input_vars,
         std::string dim_name
     );
     
-    template<typename F>
+    template<typename V, typename F>
     void match_dimension_in_all_variables(
-        std::vector<variable_t<S, T>*> input_vars,
+        std::vector<V*> input_vars,
         std::string dim_name,
         F cmp
     );
 
+    template<typename V>
+    std::string make_checkpoint_key(
+        std::vector<V*> input_vars,
+        std::string dim_name,
+        bool is_circular,
+        bool is_spectral,
+        int omegas_len);
+
+    size_t get_tile_rows(size_t rows) const;
+
+    void reserve_scratch(const size_t num_threads, size_t len);
+
+    matrix_t<anomaly_t>* make_anomaly_matrix(
+        const matrix_t<S>* unreduced,
+        const matrix_reducer_t<S>* reducer,
+        bool center,
+        const size_t num_threads);
+
+    matrix_t<anomaly_t>* make_anomaly_matrix(
+        const matrix_t<short>* packed,
+        const matrix_reducer_t<S>* reducer,
+        double scale_factor,
+        double add_offset,
+        bool center,
+        const size_t num_threads);
+
+    matrix_t<anomaly_t>* make_anomaly_matrix(
+        const matrix_t<T>* unreduced_re,
+        const matrix_t<T>* unreduced_im,
+        const matrix_reducer_t<T>* reducer,
+        bool center,
+        const size_t num_threads);
+
     void covariance_kernal(
         size_t num_vars,
-        matrix_t<S>** matrices,
-        matrix_t<S>* cov,
-        const size_t num_threads);
+        matrix_t<anomaly_t>** anomalies,
+        matrix_t<S>* cov);
 
     void circular_covariance_kernal(
         size_t num_vars,
-        matrix_t<S>** matrices,
+        matrix_t<anomaly_t>** anomalies,
         matrix_t<S>* cov,
         const size_t num_threads);
 
     void spectral_covariance_kernal(
         size_t num_vars,
-        matrix_t<S>** matrices,
+        matrix_t<anomaly_t>** anomalies,
         matrix_t<S>* cov,
         int omegas_len,
         T* omegas,
         const size_t num_threads);
     
+    void fill_covariance_matrix(
+        size_t num_vars,
+        matrix_t<anomaly_t>** anomalies,
+        matrix_t<S>* cov,
+        const size_t num_threads,
+        bool is_circular,
+        bool is_spectral,
+        int omegas_len,
+        T* omegas
+    );
+
     void make_covariance_matrix(
         std::vector<variable_t<S, T>*> input_vars,
         std::string dim_name,
@@ -126,6 +237,17 @@ private:
         int omegas_len = -1,
         T* omegas = nullptr
     );
+
+    void make_covariance_matrix(
+        std::vector<split_variable_t<T>*> input_vars,
+        std::string dim_name,
+        matrix_t<S>* cov,
+        matrix_reducer_t<T>** reducers,
+        const size_t num_threads,
+        bool is_spectral = false,
+        int omegas_len = -1,
+        T* omegas = nullptr
+    );
     
     std::vector<variable_t<S, T>*> get_eofs(
         std::vector<variable_t<S, T>*> input_vars,
@@ -134,6 +256,14 @@ private:
         matrix_t<S>* vt,
         matrix_reducer_t<S>** reducers
     );
+
+    std::vector<split_variable_t<T>*> get_eofs(
+        std::vector<split_variable_t<T>*> input_vars,
+        std::string input_dim,
+        dimension_t<T>* eof_dim,
+        matrix_t<S>* u,
+        matrix_reducer_t<T>** reducers
+    );
     
     
     
@@ -148,6 +278,18 @@ public:
     
     void set_svd(svd_t<T>* svd);
 
+    void set_output_sink(output_sink_t sink);
+
+    void set_split_output_sink(split_output_sink_t sink);
+
+    void set_gathered_output(bool gathered);
+
+    void set_anomaly_cache(anomaly_cache_t* cache);
+
+    void set_covariance_checkpoint(const std::string filename, bool resume);
+
+    void set_tile_checkpoint(tile_checkpoint_t* checkpoint);
+
     //void set_interp(interp_t<S>* interp);
     
     //void no_interp();
@@ -182,6 +324,19 @@ public:
         T* omegas = nullptr
     );
     
+    /**
+     * Complex EOFs of variables stored as separate real and imaginary parts.
+     * The outputs are split the same way.
+     */
+    std::vector<split_variable_t<T>*> calculate(
+        std::vector<split_variable_t<T>*> input_vars,
+        const std::string input_dim,
+        const size_t input_nthreads,
+        bool is_spectral = false,
+        int omegas_len = -1,
+        T* omegas = nullptr
+    );
+    
     /*
     template<template<typename> class L>
     std::vector<variable_t<S, T>*> calculate(
@@ -200,11 +355,11 @@ public:
 //==============================================================================
 
 
-template<typename T>
-using real_eof_t = eof_t<T, T>;
+template<typename T, typename P = typename default_precision<T>::type>
+using real_eof_t = eof_t<T, T, P>;
 
-template<typename T>
-using complex_eof_t = eof_t<std::complex<T>, T>;
+template<typename T, typename P = typename default_precision<std::complex<T>>::type>
+using complex_eof_t = eof_t<std::complex<T>, T, P>;
 
 
 
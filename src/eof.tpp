@@ -23,8 +23,12 @@
 #include "error.hpp"
 #include "utils.hpp"
 #include "debug.hpp"
+#include "file_utils.hpp"
 
 #include <iterator>
+#include <algorithm>
+#include <typeinfo>
+#include <omp.h>
 
 
 
@@ -63,6 +67,115 @@ std::function<bool(S)> always_false() {
     };
 }
 
+/**
+ * Narrows one centered series into an anomaly matrix row
+ */
+template<typename C, typename A>
+void store_anomaly(const C* slice, C mean, A* dst, size_t len) {
+    #pragma omp simd
+    for (size_t r = 0; r < len; r++) {
+        dst[r] = (A) (slice[r] - mean);
+    }
+}
+
+/**
+ * Complex overload of store_anomaly, which splits the series into its real
+ * and imaginary parts on the way
+ */
+template<typename C, typename A>
+void store_anomaly(const std::complex<C>* slice, std::complex<C> mean, A* dst, size_t len) {
+    for (size_t r = 0; r < len; r++) {
+        dst[r]       = (A) (slice[r].real() - mean.real());
+        dst[len + r] = (A) (slice[r].imag() - mean.imag());
+    }
+}
+
+/**
+ * Describes `var` in the key of a covariance checkpoint: the identity of the
+ * file it is read from (as the anomaly cache keys it), its name there, how
+ * it was derived from that, the part of it selected, and its dimensions
+ */
+template<typename S, typename T>
+void describe_for_checkpoint(std::ostream& out, const variable_t<S, T>* var) {
+    out << describe_input(var->get_source_filename()) << "\n"
+        << var->get_source_name() << " " << var->get_derivation()
+        << " [" << var->get_selection().to_string() << "]";
+    for (size_t j = 0; j < var->get_num_dims(); j++) {
+        out << " " << var->get_dim(j)->get_name() << ":" << var->get_dim(j)->get_size();
+    }
+    out << "\n";
+}
+
+template<typename T>
+void describe_for_checkpoint(std::ostream& out, const split_variable_t<T>* var) {
+    describe_for_checkpoint(out, var->get_re());
+    describe_for_checkpoint(out, var->get_im());
+}
+
+/**
+ * Gets the largest magnitudes of `var`, as kept in a covariance checkpoint:
+ * two per variable, of its real and imaginary parts
+ */
+template<typename T>
+void get_checkpoint_absmax(const variable_t<T, T>* var, double* absmax) {
+    absmax[0] = var->get_absmax();
+    absmax[1] = 0;
+}
+
+template<typename T>
+void get_checkpoint_absmax(const variable_t<std::complex<T>, T>* var, double* absmax) {
+    absmax[0] = var->get_absmax().real();
+    absmax[1] = var->get_absmax().imag();
+}
+
+template<typename T>
+void get_checkpoint_absmax(const split_variable_t<T>* var, double* absmax) {
+    absmax[0] = var->get_re()->get_absmax();
+    absmax[1] = var->get_im()->get_absmax();
+}
+
+/**
+ * Inverse of get_checkpoint_absmax, so that resuming never reads the inputs
+ */
+template<typename T>
+void set_checkpoint_absmax(const variable_t<T, T>* var, const double* absmax) {
+    var->set_known_absmax(T(absmax[0]));
+}
+
+template<typename T>
+void set_checkpoint_absmax(const variable_t<std::complex<T>, T>* var, const double* absmax) {
+    var->set_known_absmax(std::complex<T>(absmax[0], absmax[1]));
+}
+
+template<typename T>
+void set_checkpoint_absmax(const split_variable_t<T>* var, const double* absmax) {
+    var->get_re()->set_known_absmax(T(absmax[0]));
+    var->get_im()->set_known_absmax(T(absmax[1]));
+}
+
+/**
+ * Copies the variable attributes of `var`, and the attributes of its
+ * dimensions other than `eof_dim`, onto the output variable `output`
+ */
+template<typename S, typename T>
+void copy_output_attrs(const variable_t<S, T>* var, variable_t<S, T>* output, const dimension_t<T>* eof_dim) {
+    output->set_attrs(var->get_num_attrs(), var->get_attrs());
+
+    for (size_t j = 0; j < var->get_num_dims(); j++){
+        if (var->get_dim(j) != eof_dim){
+            attribute_t** attrs = new attribute_t*[var->get_dim(j)->get_num_attrs()];
+            for (size_t k = 0; k < var->get_dim(j)->get_num_attrs(); k++){
+                attrs[k] = new attribute_t(*(var->get_dim(j)->get_attr(k)));
+            }
+            for (size_t k = 0; k < output->get_num_dims(); k++){
+                if (var->get_dim(j) == output->get_dim(k)){
+                    output->set_dim_attrs(k, var->get_dim(j)->get_num_attrs(), attrs);
+                }
+            }
+        }
+    }
+}
+
 
 
 
@@ -71,9 +184,9 @@ std::function<bool(S)> always_false() {
 // Private Methods
 //==============================================================================
 
-template<typename S, typename T>
+template<typename S, typename T, typename P>
 template<typename F>
-void eof_t<S, T>::match_dimensions(
+void eof_t<S, T, P>::match_dimensions(
     const dimension_t<T>* dim0,
     const dimension_t<T>* dim1,
     F cmp
@@ -97,9 +210,10 @@ void eof_t<S, T>::match_dimensions(
     //}
 }
 
-template<typename S, typename T>
-void eof_t<S, T>::match_dimension_in_all_variables(
-    std::vector<variable_t<S, T>*> input_vars,
+template<typename S, typename T, typename P>
+template<typename V>
+void eof_t<S, T, P>::match_dimension_in_all_variables(
+    std::vector<V*> input_vars,
     std::string dim_name
 ) {
     this->match_dimension_in_all_variables(input_vars, dim_name, [](T x, T y) { return x == y; });
@@ -110,14 +224,14 @@ void eof_t<S, T>::match_dimension_in_all_variables(
  * values are compared using the comparison function `cmp`. If any two
  * dimensions don't match, throw an exception
  */
-template<typename S, typename T>
-template<typename F>
-void eof_t<S, T>::match_dimension_in_all_variables(
-    std::vector<variable_t<S, T>*> input_vars,
+template<typename S, typename T, typename P>
+template<typename V, typename F>
+void eof_t<S, T, P>::match_dimension_in_all_variables(
+    std::vector<V*> input_vars,
     std::string dim_name,
     F cmp
 ) {
-    for (const variable_t<S, T>* var : input_vars) {
+    for (const V* var : input_vars) {
         if (!var->has_dim(dim_name)) {
             throw eof_error_t("At least one variable doesn't contain dimension \"" + dim_name + "\"");
         }
@@ -126,69 +240,267 @@ void eof_t<S, T>::match_dimension_in_all_variables(
     // Check every pair of variables for equality in the selected dimension
     // (since comparing dimension values for equality may not be transitive)
     for (size_t i = 0; i < input_vars.size(); i++) {
-        const variable_t<S, T>* var0 = input_vars[i];
-        const dimension_t<T>* dim0 = var0->get_dim(var0->find_dim(dim_name));
+        const V* var0 = input_vars[i];
+        const dimension_t<T>* dim0 = var0->get_dim(dim_name);
 
         for (size_t j = i + 1; j < input_vars.size(); j++) {
-            const variable_t<S, T>* var1 = input_vars[j];
-            const dimension_t<T>* dim1 = var1->get_dim(var1->find_dim(dim_name));
+            const V* var1 = input_vars[j];
+            const dimension_t<T>* dim1 = var1->get_dim(dim_name);
 
             this->match_dimensions(dim0, dim1, cmp);
         }
     }
 }
 
-template<typename S, typename T>
-void eof_t<S, T>::covariance_kernal(
+/**
+ * Describes everything the covariance matrix of `input_vars` depends on, so
+ * that a checkpoint is only resumed with the inputs and settings it was
+ * saved with
+ */
+template<typename S, typename T, typename P>
+template<typename V>
+std::string eof_t<S, T, P>::make_checkpoint_key(
+    std::vector<V*> input_vars,
+    std::string dim_name,
+    bool is_circular,
+    bool is_spectral,
+    int omegas_len
+) {
+    std::ostringstream key;
+    key << dim_name << "\n"
+        << typeid(S).name() << " " << typeid(anomaly_t).name() << " " << sizeof(anomaly_t) << "\n"
+        << (is_circular ? "circular" : "centered");
+    if (is_spectral) {
+        key << " spectral " << omegas_len;
+    }
+    key << "\n";
+
+    for (size_t i = 0; i < input_vars.size(); i++) {
+        describe_for_checkpoint(key, input_vars[i]);
+    }
+
+    return key.str();
+}
+
+/**
+ * Rows of the covariance matrix built at once for a variable with `rows`
+ * anomaly series: all of them, unless there is a tile checkpoint to save
+ * them to in between
+ */
+template<typename S, typename T, typename P>
+size_t eof_t<S, T, P>::get_tile_rows(size_t rows) const {
+    if (this->tile_checkpoint != nullptr) {
+        return tile_checkpoint_t::TILE_ROWS;
+    }
+    return std::max(rows, (size_t) 1);
+}
+
+/**
+ * Sizes the scratch arena so that every thread can borrow two compute-type
+ * series buffers for series of length `len`
+ */
+template<typename S, typename T, typename P>
+void eof_t<S, T, P>::reserve_scratch(const size_t num_threads, size_t len) {
+    size_t max_threads = (size_t) omp_get_max_threads();
+    this->scratch.template reserve<compute_scalar_t>(num_threads > max_threads ? num_threads : max_threads, 2, planes * len);
+}
+
+/**
+ * Builds the anomaly matrix of one variable directly from its unreduced
+ * matrix. Only the columns kept by `reducer` are copied, each one is centered
+ * (if `center`) with its mean accumulated in accum_t, and the result is
+ * narrowed to the storage type. The anomaly matrix is stored transposed, one
+ * row per reduced column, so that every time series is contiguous for the
+ * kernels; complex series are split into real and imaginary parts.
+ */
+template<typename S, typename T, typename P>
+matrix_t<typename split_traits<typename P::storage_t>::scalar_t>* eof_t<S, T, P>::make_anomaly_matrix(
+    const matrix_t<S>* unreduced,
+    const matrix_reducer_t<S>* reducer,
+    bool center,
+    const size_t num_threads
+) {
+    size_t len = unreduced->get_rows();
+    size_t unreduced_cols = unreduced->get_cols();
+    size_t cols = reducer->get_reduced_cols();
+    const int* map = reducer->get_map_reduced_cols();
+    const S* data = unreduced->get_data();
+
+    matrix_t<anomaly_t>* anomaly = new matrix_t<anomaly_t>(cols, planes * len);
+    anomaly_t* anomaly_data = anomaly->get_data_unsafe();
+
+    this->reserve_scratch(num_threads, len);
+
+    #pragma omp parallel for
+    for (size_t c = 0; c < cols; c++) {
+        compute_t* slice = this->scratch.template get<compute_t>(omp_get_thread_num(), 0);
+        const S* src = data + map[c];
+
+        accum_t sum = 0;
+        for (size_t r = 0; r < len; r++) {
+            slice[r] = (compute_t) src[r * unreduced_cols];
+            sum += (accum_t) slice[r];
+        }
+
+        compute_t mean = center ? (compute_t) (sum / (accum_t) len) : (compute_t) 0;
+
+        store_anomaly(slice, mean, anomaly_data + c * planes * len, len);
+    }
+
+    return anomaly;
+}
+
+/**
+ * Overload of make_anomaly_matrix for a variable read packed (see
+ * variable_t::to_packed_matrix). Each value is unpacked as it is copied, so
+ * unpacking, centering and narrowing take a single pass, and the unpacked
+ * values are never stored.
+ */
+template<typename S, typename T, typename P>
+matrix_t<typename split_traits<typename P::storage_t>::scalar_t>* eof_t<S, T, P>::make_anomaly_matrix(
+    const matrix_t<short>* packed,
+    const matrix_reducer_t<S>* reducer,
+    double scale_factor,
+    double add_offset,
+    bool center,
+    const size_t num_threads
+) {
+    size_t len = packed->get_rows();
+    size_t packed_cols = packed->get_cols();
+    size_t cols = reducer->get_reduced_cols();
+    const int* map = reducer->get_map_reduced_cols();
+    const short* data = packed->get_data();
+    compute_scalar_t scale = (compute_scalar_t) scale_factor;
+    compute_scalar_t offset = (compute_scalar_t) add_offset;
+
+    matrix_t<anomaly_t>* anomaly = new matrix_t<anomaly_t>(cols, planes * len);
+    anomaly_t* anomaly_data = anomaly->get_data_unsafe();
+
+    this->reserve_scratch(num_threads, len);
+
+    #pragma omp parallel for
+    for (size_t c = 0; c < cols; c++) {
+        compute_t* slice = this->scratch.template get<compute_t>(omp_get_thread_num(), 0);
+        const short* src = data + map[c];
+
+        accum_t sum = 0;
+        for (size_t r = 0; r < len; r++) {
+            slice[r] = (compute_t) ((compute_scalar_t) src[r * packed_cols] * scale + offset);
+            sum += (accum_t) slice[r];
+        }
+
+        compute_t mean = center ? (compute_t) (sum / (accum_t) len) : (compute_t) 0;
+
+        store_anomaly(slice, mean, anomaly_data + c * planes * len, len);
+    }
+
+    return anomaly;
+}
+
+/**
+ * Split-complex overload of make_anomaly_matrix, which builds the anomaly
+ * matrix straight from the unreduced real and imaginary parts
+ */
+template<typename S, typename T, typename P>
+matrix_t<typename split_traits<typename P::storage_t>::scalar_t>* eof_t<S, T, P>::make_anomaly_matrix(
+    const matrix_t<T>* unreduced_re,
+    const matrix_t<T>* unreduced_im,
+    const matrix_reducer_t<T>* reducer,
+    bool center,
+    const size_t num_threads
+) {
+    static_assert(planes == 2, "Split variables hold complex data");
+
+    size_t len = unreduced_re->get_rows();
+    size_t unreduced_cols = unreduced_re->get_cols();
+    size_t cols = reducer->get_reduced_cols();
+    const int* map = reducer->get_map_reduced_cols();
+
+    matrix_t<anomaly_t>* anomaly = new matrix_t<anomaly_t>(cols, planes * len);
+    anomaly_t* anomaly_data = anomaly->get_data_unsafe();
+
+    this->reserve_scratch(num_threads, len);
+
+    #pragma omp parallel for
+    for (size_t c = 0; c < cols; c++) {
+        compute_scalar_t* slice = this->scratch.template get<compute_scalar_t>(omp_get_thread_num(), 0);
+        anomaly_t* dst = anomaly_data + c * planes * len;
+
+        const T* parts[2] = { unreduced_re->get_data() + map[c], unreduced_im->get_data() + map[c] };
+        for (size_t p = 0; p < planes; p++) {
+            const T* src = parts[p];
+
+            accum_scalar_t sum = 0;
+            for (size_t r = 0; r < len; r++) {
+                slice[r] = (compute_scalar_t) src[r * unreduced_cols];
+                sum += (accum_scalar_t) slice[r];
+            }
+
+            compute_scalar_t mean = center ? (compute_scalar_t) (sum / (accum_scalar_t) len) : (compute_scalar_t) 0;
+
+            store_anomaly(slice, mean, dst + p * len, len);
+        }
+    }
+
+    return anomaly;
+}
+
+template<typename S, typename T, typename P>
+void eof_t<S, T, P>::covariance_kernal(
     size_t num_vars,
-    matrix_t<S>** matrices,
-    matrix_t<S>* cov,
-    const size_t num_threads){
+    matrix_t<anomaly_t>** anomalies,
+    matrix_t<S>* cov){
 
-    size_t len = matrices[0]->get_rows();
-    S slice1[num_threads][len];
-    S slice2[num_threads][len];
+    size_t len = anomalies[0]->get_cols() / planes;
 
     // Start the Covariance Matrix timer
     time_t start = time(nullptr);
 
-    int thread, xmax, ymax;
-    size_t row, row_offset;
-    size_t col, col_offset;
-    matrix_t<S>* m;
-    matrix_t<S>* n;
-    // For every slice (`slice1`) in dimension `dim` of every variable
+    size_t tile = 0;
+    size_t xmax, ymax;
+    size_t row_offset = 0;
+    size_t col_offset;
+    matrix_t<anomaly_t>* m;
+    matrix_t<anomaly_t>* n;
+    // For every anomaly series (`slice1`) of every variable
     for (size_t i = 0; i < num_vars; i++) {
-        m = matrices[i];
-        row_offset = i*(m->get_cols());
-        xmax = m->get_cols();
-        // For every slice (`slice2`) in dimension `dim` of every variable
+        m = anomalies[i];
+        xmax = m->get_rows();
+        col_offset = 0;
+        // For every anomaly series (`slice2`) of every variable
         for (size_t j = 0; j < num_vars; j++) {
-            n = matrices[j];
-            col_offset = j*(n->get_cols());
-            ymax = n->get_cols();
-
-            #pragma omp parallel for private(thread)
-            for (size_t x = 0; x < xmax; x++) {
-                thread = omp_get_thread_num();
-
-                m->get_col(x, (S*) slice1[thread]);
-                /*
-                #pragma omp critical
-                {
-                    std::cout << slice1[thread][0] << " " << std::endl;
-                }*/
-                subtract_mean(len, slice1[thread]);
-
-                for (size_t y = 0; y < ymax; y++) {
-                    n->get_col(y, (S*) slice2[thread]);
-                    subtract_mean(len, slice2[thread]);
-
-                    // Calculate the covariance of those two slices
-                    cov->at(x + row_offset, y + col_offset) = dot_product(slice1[thread], slice2[thread], len) / (S) (len - 1);
+            n = anomalies[j];
+            ymax = n->get_rows();
+
+            // Tiles already in the checkpoint are skipped
+            size_t tile_rows = this->get_tile_rows(xmax);
+            for (size_t x0 = 0; x0 < xmax; x0 += tile_rows, tile++) {
+                size_t x1 = std::min(xmax, x0 + tile_rows);
+                if (this->tile_checkpoint != nullptr && this->tile_checkpoint->is_done(tile)) {
+                    continue;
+                }
+
+                #pragma omp parallel for
+                for (size_t x = x0; x < x1; x++) {
+                    const anomaly_t* slice1 = m->get_data() + x * planes * len;
+
+                    for (size_t y = 0; y < ymax; y++) {
+                        const anomaly_t* slice2 = n->get_data() + y * planes * len;
+
+                        // Calculate the covariance of those two slices
+                        accum_t sum = series_ops<accum_t>::dot(slice1, slice2, len);
+                        cov->at(x + row_offset, y + col_offset) = (S) (sum / (accum_scalar_t) (len - 1));
+                    }
+                }
+
+                if (this->tile_checkpoint != nullptr) {
+                    this->tile_checkpoint->complete(tile);
                 }
             }
+
+            col_offset += ymax;
         }
+        row_offset += xmax;
     }
 
     // Print the time required to compute the covariance matrix
@@ -197,54 +509,70 @@ void eof_t<S, T>::covariance_kernal(
     std::cout << "covmat: " << time << "s; ";
 }
 
-template<typename S, typename T>
-void eof_t<S, T>::spectral_covariance_kernal(
+template<typename S, typename T, typename P>
+void eof_t<S, T, P>::spectral_covariance_kernal(
     size_t num_vars,
-    matrix_t<S>** matrices,
+    matrix_t<anomaly_t>** anomalies,
     matrix_t<S>* cov,
     int omegas_len,
     T* omegas,
     const size_t num_threads){
 
-    size_t len = matrices[0]->get_rows();
-    S slice1[num_threads][len];
-    S slice2[num_threads][len];
+    size_t len = anomalies[0]->get_cols() / planes;
+    this->reserve_scratch(num_threads, len);
 
     // Start the Covariance Matrix timer
     time_t start = time(nullptr);
 
-    int thread, xmax, ymax;
-    size_t row, row_offset;
-    size_t col, col_offset;
-    matrix_t<S>* m;
-    matrix_t<S>* n;
-    // For every slice (`slice1`) in dimension `dim` of every variable
+    size_t tile = 0;
+    int thread;
+    size_t xmax, ymax;
+    size_t row_offset = 0;
+    size_t col_offset;
+    matrix_t<anomaly_t>* m;
+    matrix_t<anomaly_t>* n;
+    // For every anomaly series (`slice1`) of every variable
     for (size_t i = 0; i < num_vars; i++) {
-        m = matrices[i];
-        row_offset = i*(m->get_cols());
-        xmax = m->get_cols();
-        // For every slice (`slice2`) in dimension `dim` of every variable
+        m = anomalies[i];
+        xmax = m->get_rows();
+        col_offset = 0;
+        // For every anomaly series (`slice2`) of every variable
         for (size_t j = 0; j < num_vars; j++) {
-            n = matrices[j];
-            col_offset = j*(n->get_cols());
-            ymax = n->get_cols();
+            n = anomalies[j];
+            ymax = n->get_rows();
+
+            // Tiles already in the checkpoint are skipped
+            size_t tile_rows = this->get_tile_rows(xmax);
+            for (size_t x0 = 0; x0 < xmax; x0 += tile_rows, tile++) {
+                size_t x1 = std::min(xmax, x0 + tile_rows);
+                if (this->tile_checkpoint != nullptr && this->tile_checkpoint->is_done(tile)) {
+                    continue;
+                }
 
-            #pragma omp parallel for private(thread)
-            for (size_t x = 0; x < xmax; x++) {
-                thread = omp_get_thread_num();
+                #pragma omp parallel for private(thread)
+                for (size_t x = x0; x < x1; x++) {
+                    thread = omp_get_thread_num();
+                    compute_scalar_t* slice1 = this->scratch.template get<compute_scalar_t>(thread, 0);
+                    compute_scalar_t* slice2 = this->scratch.template get<compute_scalar_t>(thread, 1);
 
-                m->get_col(x, (S*) slice1[thread]);
-                subtract_mean(len, slice1[thread]);
+                    widen(m->get_data() + x * planes * len, slice1, planes * len);
 
-                for (size_t y = 0; y < ymax; y++) {
-                    n->get_col(y, (S*) slice2[thread]);
-                    subtract_mean(len, slice2[thread]);
+                    for (size_t y = 0; y < ymax; y++) {
+                        widen(n->get_data() + y * planes * len, slice2, planes * len);
 
-                    // Calculate the covariance of those two slices
-                    cov->at(x + row_offset, y + col_offset) = convolve(slice1[thread], slice2[thread], omegas, len);
+                        // Calculate the covariance of those two slices
+                        cov->at(x + row_offset, y + col_offset) = (S) series_ops<compute_t>::convolve(slice1, slice2, omegas, len);
+                    }
+                }
+
+                if (this->tile_checkpoint != nullptr) {
+                    this->tile_checkpoint->complete(tile);
                 }
             }
+
+            col_offset += ymax;
         }
+        row_offset += xmax;
     }
 
     // Print the time required to compute the covariance matrix
@@ -253,55 +581,71 @@ void eof_t<S, T>::spectral_covariance_kernal(
     std::cout << "covmat: " << time << "s; ";
 }
 
-template<typename S, typename T>
-void eof_t<S, T>::circular_covariance_kernal(
+template<typename S, typename T, typename P>
+void eof_t<S, T, P>::circular_covariance_kernal(
     size_t num_vars,
-    matrix_t<S>** matrices,
+    matrix_t<anomaly_t>** anomalies,
     matrix_t<S>* cov,
     const size_t num_threads){
 
     if (!std::is_same<S,T>::value){
         FATAL("Circular covariance is currently only implemented for real-valued data.")
     }else{
-        size_t len = matrices[0]->get_rows();
-        S slice1[num_threads][len];
-        S slice2[num_threads][len];
+        size_t len = anomalies[0]->get_cols();
+        this->reserve_scratch(num_threads, len);
 
         // Start the Covariance Matrix timer
         time_t start = time(nullptr);
 
-        int thread, xmax, ymax;
-        size_t row, row_offset;
-        size_t col, col_offset;
-        matrix_t<S>* m;
-        matrix_t<S>* n;
-        // For every slice (`slice1`) in dimension `dim` of every variable
+        size_t tile = 0;
+        int thread;
+        size_t xmax, ymax;
+        size_t row_offset = 0;
+        size_t col_offset;
+        matrix_t<anomaly_t>* m;
+        matrix_t<anomaly_t>* n;
+        // For every series (`slice1`) of every variable
         for (size_t i = 0; i < num_vars; i++) {
-            m = matrices[i];
-            row_offset = i*(m->get_cols());
-            xmax = m->get_cols();
-            // For every slice (`slice2`) in dimension `dim` of every variable
+            m = anomalies[i];
+            xmax = m->get_rows();
+            col_offset = 0;
+            // For every series (`slice2`) of every variable
             for (size_t j = 0; j < num_vars; j++) {
-                n = matrices[j];
-                col_offset = j*(n->get_cols());
-                ymax = n->get_cols();
+                n = anomalies[j];
+                ymax = n->get_rows();
+
+                // Tiles already in the checkpoint are skipped
+                size_t tile_rows = this->get_tile_rows(xmax);
+                for (size_t x0 = 0; x0 < xmax; x0 += tile_rows, tile++) {
+                    size_t x1 = std::min(xmax, x0 + tile_rows);
+                    if (this->tile_checkpoint != nullptr && this->tile_checkpoint->is_done(tile)) {
+                        continue;
+                    }
 
-                #pragma omp parallel for private(thread)
-                for (size_t x = 0; x < xmax; x++) {
-                    thread = omp_get_thread_num();
+                    #pragma omp parallel for private(thread)
+                    for (size_t x = x0; x < x1; x++) {
+                        thread = omp_get_thread_num();
+                        compute_scalar_t* slice1 = this->scratch.template get<compute_scalar_t>(thread, 0);
+                        compute_scalar_t* slice2 = this->scratch.template get<compute_scalar_t>(thread, 1);
 
-                    m->get_col(x, (S*) slice1[thread]);
-                    //subtract_mean(len, slice1[thread]);
+                        widen(m->get_data() + x * len, slice1, len);
 
-                    for (size_t y = 0; y < ymax; y++) {
-                        n->get_col(y, (S*) slice2[thread]);
-                        //subtract_mean(len, slice2[thread]);
+                        for (size_t y = 0; y < ymax; y++) {
+                            widen(n->get_data() + y * len, slice2, len);
 
-                        // Calculate the covariance of those two slices
-                        cov->at(x + row_offset, y + col_offset) = circ_cov(slice1[thread], slice2[thread], len);
+                            // Calculate the covariance of those two slices
+                            cov->at(x + row_offset, y + col_offset) = (S) circ_cov(slice1, slice2, len);
+                        }
+                    }
+
+                    if (this->tile_checkpoint != nullptr) {
+                        this->tile_checkpoint->complete(tile);
                     }
                 }
+
+                col_offset += ymax;
             }
+            row_offset += xmax;
         }
 
         // Print the time required to compute the covariance matrix
@@ -312,12 +656,79 @@ void eof_t<S, T>::circular_covariance_kernal(
     }
 }
 
+/**
+ * Sizes the covariance matrix for the given anomaly matrices, runs the
+ * requested kernel on them, and then frees them
+ */
+template<typename S, typename T, typename P>
+void eof_t<S, T, P>::fill_covariance_matrix(
+    size_t num_vars,
+    matrix_t<anomaly_t>** anomalies,
+    matrix_t<S>* cov,
+    const size_t num_threads,
+    bool is_circular,
+    bool is_spectral,
+    int omegas_len,
+    T* omegas
+) {
+    size_t size = 0;
+    for (size_t i = 0; i < num_vars; i++) {
+        size += anomalies[i]->get_rows();
+    }
+
+    // With a tile checkpoint, the matrix is built in its file, and the tiles
+    // it already has are kept
+    if (this->tile_checkpoint != nullptr) {
+        size_t num_tiles = 0;
+        std::ostringstream layout;
+        layout << "len " << anomalies[0]->get_cols() << " rows";
+        for (size_t i = 0; i < num_vars; i++) {
+            size_t rows = anomalies[i]->get_rows();
+            num_tiles += num_vars * ((rows + this->get_tile_rows(rows) - 1) / this->get_tile_rows(rows));
+            layout << " " << rows;
+        }
+        this->tile_checkpoint->open(cov, size, num_tiles, layout.str());
+    } else {
+        cov->set_shape(size, size);
+    }
+
+    // TODO interpolate here? The data is organized into neat matrices so this
+    // is probably the best place to interpolate
+
+    // This assumes that all matrices have the same number of rows. If we
+    // need to, we've already interpolated
+
+    // kernel calls
+    if(is_circular){
+        this->circular_covariance_kernal(num_vars, anomalies, cov, num_threads);
+    }else{
+        if(is_spectral){
+            if(!omegas){
+                FATAL("Data is spectral, but no frequency data is present!")
+            }else{
+                this->spectral_covariance_kernal(num_vars, anomalies, cov, omegas_len, omegas, num_threads);
+            }
+        }else{
+            this->covariance_kernal(num_vars, anomalies, cov);
+        }
+    }
+
+    if (this->tile_checkpoint != nullptr) {
+        this->tile_checkpoint->finish();
+    }
+
+
+    for (size_t i = 0; i < num_vars; i++) {
+        delete anomalies[i];
+    }
+    delete[] anomalies;
+}
 
 /**
  * TODO
  */
-template<typename S, typename T>
-void eof_t<S, T>::make_covariance_matrix(
+template<typename S, typename T, typename P>
+void eof_t<S, T, P>::make_covariance_matrix(
     std::vector<variable_t<S, T>*> input_vars,
     std::string dim,
     matrix_t<S>* cov,
@@ -328,13 +739,70 @@ void eof_t<S, T>::make_covariance_matrix(
     int omegas_len,
     T* omegas
 ) {
-    size_t size = 0;
     size_t num_vars = input_vars.size();
-    matrix_t<S>** matrices;
-    matrices = new matrix_t<S>*[num_vars];
+    matrix_t<anomaly_t>** anomalies;
+    anomalies = new matrix_t<anomaly_t>*[num_vars];
+
+    // Anomalies of lazy variables made before with the same settings are
+    // mapped from the cache, if there is one; only the rest are read
+    std::vector<std::string> keys(num_vars);
+    std::vector<size_t> to_read;
     for (size_t i = 0; i < num_vars; i++) {
         variable_t<S, T>* var = input_vars[i];
-        matrix_t<S>* unreduced = var->to_matrix(dim);
+        if (this->anomaly_cache != nullptr && var->is_lazy()) {
+            std::ostringstream variant;
+            variant << var->get_selection().to_string() << "\n"
+                    << typeid(S).name() << " " << typeid(anomaly_t).name() << " " << sizeof(anomaly_t) << "\n"
+                    << (is_circular ? "raw" : "centered");
+            keys[i] = this->anomaly_cache->make_key(var->get_source_filename(), var->get_source_name(), dim, variant.str());
+
+            double absmax;
+            if (this->anomaly_cache->load(keys[i], &anomalies[i], &reducers[i], &absmax)) {
+                var->set_known_absmax(S(absmax));
+                keys[i].clear();
+                continue;
+            }
+        }
+        to_read.push_back(i);
+    }
+
+    // Read each variable while the one before it is reduced and centered.
+    // Variables packed as short are read that way, and only unpacked into
+    // their anomaly matrices.
+    typedef std::pair<matrix_t<S>*, matrix_t<short>*> read_t;
+    auto read_var = [dim](const variable_t<S, T>* var) {
+        if (var->can_read_packed()) {
+            return read_t(nullptr, var->to_packed_matrix(dim));
+        }
+        return read_t(var->to_matrix(dim), nullptr);
+    };
+    async_stage_t<read_t> reader;
+    if (!to_read.empty()) {
+        variable_t<S, T>* first = input_vars[to_read[0]];
+        reader.submit([read_var, first]() { return read_var(first); });
+    }
+
+    for (size_t k = 0; k < to_read.size(); k++) {
+        size_t i = to_read[k];
+        variable_t<S, T>* var = input_vars[i];
+        read_t read = reader.take();
+        if (k + 1 < to_read.size()) {
+            variable_t<S, T>* next = input_vars[to_read[k + 1]];
+            reader.submit([read_var, next]() { return read_var(next); });
+        }
+        if (read.second != nullptr) {
+            matrix_t<short>* packed = read.second;
+            if (var->has_missing_value()) {
+                reducers[i] = new matrix_reducer_t<S>(packed, is_equal_to<short>(var->get_packed_missing_value()));
+            } else {
+                reducers[i] = new matrix_reducer_t<S>(packed, always_false<short>());
+            }
+
+            anomalies[i] = this->make_anomaly_matrix(packed, reducers[i], var->get_scale_factor(), var->get_add_offset(), !is_circular, num_threads);
+            delete packed;
+            continue;
+        }
+        matrix_t<S>* unreduced = read.first;
 
 
         cout << endl << unreduced->get_cols() << endl;
@@ -347,46 +815,80 @@ void eof_t<S, T>::make_covariance_matrix(
 
         cout << endl << reducers[i]->get_reduced_cols() << endl;
 
-        size += reducers[i]->get_reduced_cols();
-        matrices[i] = reducers[i]->reduce(unreduced);
+        // Circular data is used as-is; everything else is centered here once
+        // rather than once per pair of columns in the kernels
+        anomalies[i] = this->make_anomaly_matrix(unreduced, reducers[i], !is_circular, num_threads);
         delete unreduced;
     }
 
-    cov->set_shape(size, size);
 
-    // TODO interpolate here? The data is organized into neat matrices so this
-    // is probably the best place to interpolate
+    // Finding the largest magnitudes may read lazy inputs, so do it only once
+    // the reader is done with the NetCDF library
+    for (size_t i = 0; i < num_vars; i++) {
+        if (!keys[i].empty()) {
+            this->anomaly_cache->store(keys[i], anomalies[i], reducers[i], std::abs(input_vars[i]->get_absmax()));
+        }
+    }
 
-    // This assumes that all matrices have the same number of rows. If we
-    // need to, we've already interpolated
+    this->fill_covariance_matrix(num_vars, anomalies, cov, num_threads, is_circular, is_spectral, omegas_len, omegas);
+}
 
-    // kernel calls
-    if(is_circular){
-        this->circular_covariance_kernal(num_vars, matrices, cov, num_threads);
-    }else{
-        if(is_spectral){
-            if(!omegas){
-                FATAL("Data is spectral, but no frequency data is present!")
-            }else{
-                this->spectral_covariance_kernal(num_vars, matrices, cov, omegas_len, omegas, num_threads);
-            }
-        }else{
-            this->covariance_kernal(num_vars, matrices, cov, num_threads);
+/**
+ * Split-complex overload of make_covariance_matrix. Columns are reduced by
+ * the missing values of the real parts.
+ */
+template<typename S, typename T, typename P>
+void eof_t<S, T, P>::make_covariance_matrix(
+    std::vector<split_variable_t<T>*> input_vars,
+    std::string dim,
+    matrix_t<S>* cov,
+    matrix_reducer_t<T>** reducers,
+    const size_t num_threads,
+    bool is_spectral,
+    int omegas_len,
+    T* omegas
+) {
+    size_t num_vars = input_vars.size();
+    matrix_t<anomaly_t>** anomalies;
+    anomalies = new matrix_t<anomaly_t>*[num_vars];
+
+    // Read each variable while the one before it is reduced and centered
+    typedef std::pair<matrix_t<T>*, matrix_t<T>*> parts_t;
+    auto read_parts = [dim](const split_variable_t<T>* var) {
+        return var->to_matrices(dim);
+    };
+    async_stage_t<parts_t> reader;
+    reader.submit([read_parts, input_vars]() { return read_parts(input_vars[0]); });
+
+    for (size_t i = 0; i < num_vars; i++) {
+        const variable_t<T, T>* re = input_vars[i]->get_re();
+        parts_t parts = reader.take();
+        if (i + 1 < num_vars) {
+            const split_variable_t<T>* next = input_vars[i + 1];
+            reader.submit([read_parts, next]() { return read_parts(next); });
         }
-    }
+        matrix_t<T>* unreduced_re = parts.first;
+        matrix_t<T>* unreduced_im = parts.second;
 
+        if (re->has_missing_value()) {
+            reducers[i] = new matrix_reducer_t<T>(unreduced_re, re->get_missing_value());
+        } else {
+            reducers[i] = new matrix_reducer_t<T>(unreduced_re, always_false<T>());
+        }
 
-    for (int i = 0; i < num_vars; i++) {
-        delete matrices[i];
+        anomalies[i] = this->make_anomaly_matrix(unreduced_re, unreduced_im, reducers[i], true, num_threads);
+        delete unreduced_re;
+        delete unreduced_im;
     }
 
+    this->fill_covariance_matrix(num_vars, anomalies, cov, num_threads, false, is_spectral, omegas_len, omegas);
 }
 
 /**
  * TODO
  */
-template<typename S, typename T>
-std::vector<variable_t<S, T>*> eof_t<S, T>::get_eofs(
+template<typename S, typename T, typename P>
+std::vector<variable_t<S, T>*> eof_t<S, T, P>::get_eofs(
     std::vector<variable_t<S, T>*> input_vars,
     std::string input_dim,
     dimension_t<T>* eof_dim,
@@ -395,6 +897,16 @@ std::vector<variable_t<S, T>*> eof_t<S, T>::get_eofs(
 ) {
     std::vector<variable_t<S, T>*> output_vars;
 
+    // Finding the fill values may read lazy inputs, so do it before the
+    // writer thread starts using the NetCDF library
+    std::vector<S> fills;
+    for (size_t i = 0; i < input_vars.size(); i++) {
+        fills.push_back(S(10) * input_vars[i]->get_absmax());
+    }
+
+    // Write each output while the next one is restored
+    async_stage_t<void> writer;
+
     size_t col = 0;
     for (size_t i = 0; i < input_vars.size(); i++) {
         variable_t<S, T>* var = input_vars[i];
@@ -402,33 +914,112 @@ std::vector<variable_t<S, T>*> eof_t<S, T>::get_eofs(
         size_t size = reducers[i]->get_reduced_cols();
 
         matrix_t<S>* mat = u->get_submatrix(0, col, u->get_rows(), size);
-        matrix_t<S>* restored = reducers[i]->restore(mat, 10.f*var->get_absmax());
-        variable_t<S, T>* output = var->from_matrix(restored, input_dim, eof_dim);
+        variable_t<S, T>* output;
+        if (this->gathered_output) {
+            output = var->from_matrix_gathered(mat, input_dim, eof_dim, reducers[i]->get_map_reduced_cols(), size, "points_" + std::to_string(i));
+        } else {
+            matrix_t<S>* restored = reducers[i]->restore(mat, fills[i]);
+            output = var->from_matrix(restored, input_dim, eof_dim);
+            delete restored;
+        }
 
         // Copy all variable variables and dimension attributes where applicable
-        output->set_attrs(var->get_num_attrs(), var->get_attrs());
+        copy_output_attrs(var, output, eof_dim);
 
-        for (size_t j = 0; j < var->get_num_dims(); j++){
-            if (var->get_dim(j) != eof_dim){
-                attribute_t** attrs = new attribute_t*[var->get_dim(j)->get_num_attrs()];
-                for (size_t k = 0; k < var->get_dim(j)->get_num_attrs(); k++){
-                    attrs[k] = new attribute_t(*(var->get_dim(j)->get_attr(k)));
-                }
-                for (size_t k = 0; k < output->get_num_dims(); k++){
-                    if (var->get_dim(j) == output->get_dim(k)){
-                        output->set_dim_attrs(k, var->get_dim(j)->get_num_attrs(), attrs);
-                    }
-                }
+        delete mat;
+
+        output_vars.push_back(output);
+        col += size;
+
+        if (this->output_sink) {
+            output_sink_t sink = this->output_sink;
+            writer.submit([sink, i, output]() { sink(i, output); });
+        }
+    }
+
+    writer.drain();
+
+    return output_vars;
+}
+
+/**
+ * Split-complex overload of get_eofs. Each block of `u` is split into real
+ * and imaginary parts as it is copied out, and each part is restored on its
+ * own.
+ */
+template<typename S, typename T, typename P>
+std::vector<split_variable_t<T>*> eof_t<S, T, P>::get_eofs(
+    std::vector<split_variable_t<T>*> input_vars,
+    std::string input_dim,
+    dimension_t<T>* eof_dim,
+    matrix_t<S>* u,
+    matrix_reducer_t<T>** reducers
+) {
+    std::vector<split_variable_t<T>*> output_vars;
+
+    // Finding the fill values may read lazy inputs, so do it before the
+    // writer thread starts using the NetCDF library
+    std::vector<T> fills_re;
+    std::vector<T> fills_im;
+    for (size_t i = 0; i < input_vars.size(); i++) {
+        fills_re.push_back(T(10) * input_vars[i]->get_re()->get_absmax());
+        fills_im.push_back(T(10) * input_vars[i]->get_im()->get_absmax());
+    }
+
+    // Write each output while the next one is restored
+    async_stage_t<void> writer;
+
+    size_t rows = u->get_rows();
+    size_t col = 0;
+    for (size_t i = 0; i < input_vars.size(); i++) {
+        const variable_t<T, T>* re = input_vars[i]->get_re();
+        const variable_t<T, T>* im = input_vars[i]->get_im();
+
+        size_t size = reducers[i]->get_reduced_cols();
+
+        matrix_t<T> mat_re(rows, size);
+        matrix_t<T> mat_im(rows, size);
+        for (size_t r = 0; r < rows; r++) {
+            for (size_t c = 0; c < size; c++) {
+                S value = u->at(r, col + c);
+                mat_re.at(r, c) = std::real(value);
+                mat_im.at(r, c) = std::imag(value);
             }
         }
 
-        delete restored;
-        delete mat;
+        variable_t<T, T>* output_re;
+        variable_t<T, T>* output_im;
+        if (this->gathered_output) {
+            // Both parts share one list dimension
+            std::string list_name = "points_" + std::to_string(i);
+            const int* map = reducers[i]->get_map_reduced_cols();
+            output_re = re->from_matrix_gathered(&mat_re, input_dim, eof_dim, map, size, list_name);
+            output_im = im->from_matrix_gathered(&mat_im, input_dim, eof_dim, map, size, list_name);
+        } else {
+            matrix_t<T>* restored_re = reducers[i]->restore(&mat_re, fills_re[i]);
+            matrix_t<T>* restored_im = reducers[i]->restore(&mat_im, fills_im[i]);
+            output_re = re->from_matrix(restored_re, input_dim, eof_dim);
+            output_im = im->from_matrix(restored_im, input_dim, eof_dim);
+            delete restored_re;
+            delete restored_im;
+        }
+
+        // Copy all variable variables and dimension attributes where applicable
+        copy_output_attrs(re, output_re, eof_dim);
+        copy_output_attrs(im, output_im, eof_dim);
 
+        split_variable_t<T>* output = new split_variable_t<T>(output_re, output_im);
         output_vars.push_back(output);
         col += size;
+
+        if (this->split_output_sink) {
+            split_output_sink_t sink = this->split_output_sink;
+            writer.submit([sink, i, output]() { sink(i, output); });
+        }
     }
 
+    writer.drain();
+
     return output_vars;
 }
 
@@ -443,8 +1034,8 @@ std::vector<variable_t<S, T>*> eof_t<S, T>::get_eofs(
 /**
  * TODO
  */
-template<typename S, typename T>
-eof_t<S, T>::eof_t() {
+template<typename S, typename T, typename P>
+eof_t<S, T, P>::eof_t() {
     this->svd = new basic_svd_t<T>();
     //this->interp = nullptr;
 }
@@ -452,9 +1043,11 @@ eof_t<S, T>::eof_t() {
 /**
  * TODO
  */
-template<typename S, typename T>
-eof_t<S, T>::~eof_t() {
+template<typename S, typename T, typename P>
+eof_t<S, T, P>::~eof_t() {
     delete this->svd;
+    delete this->anomaly_cache;
+    delete this->tile_checkpoint;
     /*
     if (this->interp != nullptr) {
         delete this->interp;
@@ -465,18 +1058,79 @@ eof_t<S, T>::~eof_t() {
 /**
  * TODO
  */
-template<typename S, typename T>
-void eof_t<S, T>::set_svd(svd_t<T>* svd) {
+template<typename S, typename T, typename P>
+void eof_t<S, T, P>::set_svd(svd_t<T>* svd) {
     delete this->svd;
     this->svd = svd;
 }
 
+/**
+ * Hands each output variable to `sink` as soon as it is restored, on a
+ * writer thread, so that writing it overlaps with building the next one.
+ * Calls to the sink never overlap each other, and have all finished when
+ * calculate returns. The outputs still belong to the caller of calculate.
+ */
+template<typename S, typename T, typename P>
+void eof_t<S, T, P>::set_output_sink(output_sink_t sink) {
+    this->output_sink = sink;
+}
+
+/**
+ * Like set_output_sink, for outputs split into real and imaginary parts
+ */
+template<typename S, typename T, typename P>
+void eof_t<S, T, P>::set_split_output_sink(split_output_sink_t sink) {
+    this->split_output_sink = sink;
+}
+
+/**
+ * Makes each output hold only the columns that were analyzed (those not
+ * entirely missing), gathered along a list dimension "points_<i>" in CF
+ * "compression by gathering" form, instead of restoring it to the full grid
+ * with fill values
+ */
+template<typename S, typename T, typename P>
+void eof_t<S, T, P>::set_gathered_output(bool gathered) {
+    this->gathered_output = gathered;
+}
+
+/**
+ * Takes ownership of `cache`. Outputs must be built before this is deleted,
+ * since anomaly matrices loaded from the cache are mapped from it.
+ */
+template<typename S, typename T, typename P>
+void eof_t<S, T, P>::set_anomaly_cache(anomaly_cache_t* cache) {
+    delete this->anomaly_cache;
+    this->anomaly_cache = cache;
+}
+
+/**
+ * Saves the covariance matrix to `filename` once it is built, or, if
+ * `resume`, loads it from there instead of building it, so that only the
+ * eigensolve and the outputs are done
+ */
+template<typename S, typename T, typename P>
+void eof_t<S, T, P>::set_covariance_checkpoint(const std::string filename, bool resume) {
+    this->checkpoint_filename = filename;
+    this->resume_from_checkpoint = resume;
+}
+
+/**
+ * Takes ownership of `checkpoint`, in which the covariance matrix is built
+ * tile by tile, so that a stopped run can be continued
+ */
+template<typename S, typename T, typename P>
+void eof_t<S, T, P>::set_tile_checkpoint(tile_checkpoint_t* checkpoint) {
+    delete this->tile_checkpoint;
+    this->tile_checkpoint = checkpoint;
+}
+
 /**
  * TODO
  */
 /*
-template<typename S, typename T>
-void eof_t<S, T>::set_interp(interp_t<S>* interp) {
+template<typename S, typename T, typename P>
+void eof_t<S, T, P>::set_interp(interp_t<S>* interp) {
     if (this->interp != nullptr) {
         delete this->interp;
     }
@@ -489,8 +1143,8 @@ void eof_t<S, T>::set_interp(interp_t<S>* interp) {
  * TODO
  */
 /*
-template<typename S, typename T>
-void eof_t<S, T>::no_interp() {
+template<typename S, typename T, typename P>
+void eof_t<S, T, P>::no_interp() {
     if (this->interp != nullptr) {
         delete this->interp;
     }
@@ -500,8 +1154,8 @@ void eof_t<S, T>::no_interp() {
 /**
  * TODO
  */
-template<typename S, typename T>
-std::vector<variable_t<S, T>*> eof_t<S, T>::calculate(
+template<typename S, typename T, typename P>
+std::vector<variable_t<S, T>*> eof_t<S, T, P>::calculate(
     variable_t<S, T>* input_var,
     const std::string input_dim,
     const size_t input_nthreads,
@@ -516,8 +1170,8 @@ std::vector<variable_t<S, T>*> eof_t<S, T>::calculate(
 /**
  * TODO
  */
-template<typename S, typename T>
-std::vector<variable_t<S, T>*> eof_t<S, T>::calculate(
+template<typename S, typename T, typename P>
+std::vector<variable_t<S, T>*> eof_t<S, T, P>::calculate(
     std::initializer_list<variable_t<S, T>*> input_vars_list,
     const std::string input_dim,
     const size_t input_nthreads,
@@ -533,8 +1187,8 @@ std::vector<variable_t<S, T>*> eof_t<S, T>::calculate(
 /**
  * TODO
  */
-template<typename S, typename T>
-std::vector<variable_t<S, T>*> eof_t<S, T>::calculate(
+template<typename S, typename T, typename P>
+std::vector<variable_t<S, T>*> eof_t<S, T, P>::calculate(
     std::vector<variable_t<S, T>*> input_vars,
     const std::string input_dim,
     const size_t input_nthreads,
@@ -560,7 +1214,29 @@ std::vector<variable_t<S, T>*> eof_t<S, T>::calculate(
 
     matrix_t<S> cov;
     matrix_reducer_t<S>* reducers[input_vars.size()];
-    this->make_covariance_matrix(input_vars, input_dim, &cov, reducers, input_nthreads, is_circular, is_spectral, omegas_len, omegas);
+
+    // The covariance matrix (mapped, if resumed) must outlive the eigensolve
+    covariance_checkpoint_t checkpoint(this->checkpoint_filename);
+    std::string key = this->make_checkpoint_key(input_vars, input_dim, is_circular, is_spectral, omegas_len);
+    double absmaxes[2 * input_vars.size()];
+    if (this->resume_from_checkpoint) {
+        checkpoint.load(key, &cov, reducers, absmaxes, input_vars.size());
+        for (size_t i = 0; i < input_vars.size(); i++) {
+            set_checkpoint_absmax(input_vars[i], absmaxes + 2 * i);
+        }
+    } else {
+        if (this->tile_checkpoint != nullptr) {
+            this->tile_checkpoint->set_key(key);
+        }
+        this->make_covariance_matrix(input_vars, input_dim, &cov, reducers, input_nthreads, is_circular, is_spectral, omegas_len, omegas);
+
+        if (!this->checkpoint_filename.empty()) {
+            for (size_t i = 0; i < input_vars.size(); i++) {
+                get_checkpoint_absmax(input_vars[i], absmaxes + 2 * i);
+            }
+            checkpoint.save(key, &cov, reducers, absmaxes, input_vars.size());
+        }
+    }
 
     matrix_t<T> s;
     matrix_t<S> u;
@@ -579,3 +1255,75 @@ std::vector<variable_t<S, T>*> eof_t<S, T>::calculate(
     return output_vars;
 }
 
+
+/**
+ * TODO
+ */
+template<typename S, typename T, typename P>
+std::vector<split_variable_t<T>*> eof_t<S, T, P>::calculate(
+    std::vector<split_variable_t<T>*> input_vars,
+    const std::string input_dim,
+    const size_t input_nthreads,
+    bool is_spectral,
+    int omegas_len,
+    T* omegas
+) {
+    static_assert(planes == 2, "Split variables hold complex data");
+
+    if (input_vars.size() == 0) {
+        throw eof_error_t("No variables to be analyzed");
+    }
+
+    if(is_spectral){
+        if(omegas_len == -1){
+            FATAL("Number of spectral frequencies was not specified.")
+        }
+        if(!omegas){
+            FATAL("Spectral frequencies were not specified.")
+        }
+    }
+
+    this->match_dimension_in_all_variables(input_vars, input_dim);
+
+    matrix_t<S> cov;
+    matrix_reducer_t<T>* reducers[input_vars.size()];
+
+    // The covariance matrix (mapped, if resumed) must outlive the eigensolve
+    covariance_checkpoint_t checkpoint(this->checkpoint_filename);
+    std::string key = this->make_checkpoint_key(input_vars, input_dim, false, is_spectral, omegas_len);
+    double absmaxes[2 * input_vars.size()];
+    if (this->resume_from_checkpoint) {
+        checkpoint.load(key, &cov, reducers, absmaxes, input_vars.size());
+        for (size_t i = 0; i < input_vars.size(); i++) {
+            set_checkpoint_absmax(input_vars[i], absmaxes + 2 * i);
+        }
+    } else {
+        if (this->tile_checkpoint != nullptr) {
+            this->tile_checkpoint->set_key(key);
+        }
+        this->make_covariance_matrix(input_vars, input_dim, &cov, reducers, input_nthreads, is_spectral, omegas_len, omegas);
+
+        if (!this->checkpoint_filename.empty()) {
+            for (size_t i = 0; i < input_vars.size(); i++) {
+                get_checkpoint_absmax(input_vars[i], absmaxes + 2 * i);
+            }
+            checkpoint.save(key, &cov, reducers, absmaxes, input_vars.size());
+        }
+    }
+
+    matrix_t<T> s;
+    matrix_t<S> u;
+    this->svd->calculate(&cov, &u, &s, nullptr);
+
+    const T* row = s.get_row(0);
+    std::string output_dim = "eigenvalues";
+    dimension_t<T> eof_dim(output_dim, s.get_cols(), row, 0, nullptr);
+    std::vector<split_variable_t<T>*> output_vars = this->get_eofs(input_vars, input_dim, &eof_dim, &u, reducers);
+    delete[] row;
+
+    for (size_t i = 0; i < input_vars.size(); i++) {
+        delete reducers[i];
+    }
+
+    return output_vars;
+}
@@ -23,8 +23,11 @@
 
 #include "netcdf_file.hpp"
 #include "variable.hpp"
+#include "split_variable.hpp"
 #include "eof.hpp"
 #include "spectrum.hpp"
+#include "reader_pool.hpp"
+#include "zarr_writer.hpp"
 
 #endif
 
@@ -26,11 +26,22 @@
 
 #include <complex>
 
+/** Use fftw_traits. Must be after <complex> */
+#include "fftw_traits.hpp"
+
 template<typename T>
 class fftw_fft_t : public dft_t<T> {
 private:
+    typedef typename fftw_traits<T>::plan_t    plan_t;
+    typedef typename fftw_traits<T>::complex_t fftw_complex_t;
+
     size_t num_threads;
 
+    /** Used when the owner of this transform hasn't lent an arena */
+    scratch_arena_t own_scratch;
+
+    scratch_arena_t* reserve_scratch(size_t num_slots, size_t num_bytes);
+
 public:
     /**
      * Create an instance running on the default number of threads
@@ -74,6 +85,11 @@ public:
         matrix_t<std::complex<T>>* output
     );
 
+    void hilbert(
+        matrix_t<T>* input,
+        matrix_t<T>* output
+    );
+
 };
 
 #include "fftw_fft.tpp"
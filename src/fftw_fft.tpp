@@ -26,14 +26,15 @@
 #include <ctime>
 #include <omp.h>
 #include <random>
+#include <algorithm>
 
 using std::complex;
 using std::rand;
 using std::srand;
 using std::time;
 
-/** Must be after <complex> */
-#include <fftw3.h>
+/** Use fftw_traits */
+#include "fftw_traits.hpp"
 
 #include "debug.hpp"
 
@@ -62,352 +63,351 @@ fftw_fft_t<T>::~fftw_fft_t() {
     //fftw_cleanup_threads();
 }
 
+/**
+ * Sizes the arena lent by the owner (or this transform's own arena, if none
+ * was lent) for `num_slots` buffers of `num_bytes` bytes per thread
+ */
+template<typename T>
+scratch_arena_t* fftw_fft_t<T>::reserve_scratch(size_t num_slots, size_t num_bytes) {
+    scratch_arena_t* arena = (this->scratch != nullptr) ? this->scratch : &this->own_scratch;
+    size_t max_threads = (size_t) omp_get_max_threads();
+    arena->reserve_bytes(this->num_threads > max_threads ? this->num_threads : max_threads, num_slots, num_bytes);
+    return arena;
+}
+
 
 //==============================================================================
-// Template Specializations
+// Template Implementation
 //==============================================================================
 
 
-template<>
-void fftw_fft_t<float>::calculate(
-    matrix_t<float>* input,
-    matrix_t<std::complex<float>>* output
+template<typename T>
+void fftw_fft_t<T>::calculate(
+    matrix_t<T>* input,
+    matrix_t<std::complex<T>>* output
 ) {
 
     int thread;
     size_t cols = input->get_cols();
     size_t rows = input->get_rows();
-    float               slice_in[num_threads][rows];
-    std::complex<float> slice_out[num_threads][(int)(floor(rows/2)+1)];
+    size_t out_rows = floor(rows/2)+1;
+    scratch_arena_t* arena = this->reserve_scratch(2,
+        std::max(rows * sizeof(T), out_rows * sizeof(std::complex<T>)));
 
     // Check and setup output
     bool delete_output = false;
     if (output == nullptr) {
         delete_output = true;
-        output = new matrix_t<std::complex<float>>(floor(rows/2)+1, cols);
+        output = new matrix_t<std::complex<T>>(floor(rows/2)+1, cols);
     } else {
         output->set_shape(floor(rows/2)+1, cols);
     }
 
     /** Use sentinel pattern to gather wisdom for later */
 
-    float* in_temp = new float[rows];
+    T* in_temp = new T[rows];
     for(int j = 0; j < rows; j++){
         in_temp[j] = rand() % 10 * sin(j);
     }
 
-    complex<float>* out_temp = new complex<float>[(int)(floor(rows/2)+1)];
+    complex<T>* out_temp = new complex<T>[(int)(floor(rows/2)+1)];
 
-    fftwf_plan planw = fftwf_plan_dft_r2c_1d(
+    plan_t planw = fftw_traits<T>::plan_dft_r2c_1d(
             rows,
             in_temp,
-            reinterpret_cast<fftwf_complex*>(out_temp),
+            reinterpret_cast<fftw_complex_t*>(out_temp),
             FFTW_PATIENT);
 
-    fftwf_execute(planw);
-    char* wisdom = fftwf_export_wisdom_to_string();
-    fftwf_destroy_plan(planw);
+    fftw_traits<T>::execute(planw);
+    char* wisdom = fftw_traits<T>::export_wisdom_to_string();
+    fftw_traits<T>::destroy_plan(planw);
 
-    fftwf_plan* plans = new fftwf_plan[cols];
+    plan_t* plans = new plan_t[cols];
     #pragma omp parallel for private(thread)
     for(size_t x = 0; x < cols; x++){
         thread = omp_get_thread_num();
+        T*               slice_in  = arena->template get<T>(thread, 0);
+        std::complex<T>* slice_out = arena->template get<std::complex<T>>(thread, 1);
 
         #pragma omp critical
         {
-        fftwf_import_wisdom_from_string(wisdom);
+        fftw_traits<T>::import_wisdom_from_string(wisdom);
         }
 
-        input->get_col(x, (float*)(slice_in[thread]));
+        input->get_col(x, slice_in);
 
-        plans[x] = fftwf_plan_dft_r2c_1d(
+        plans[x] = fftw_traits<T>::plan_dft_r2c_1d(
             rows,
-            slice_in[thread],
-            reinterpret_cast<fftwf_complex*>(slice_out[thread]),
+            slice_in,
+            reinterpret_cast<fftw_complex_t*>(slice_out),
             FFTW_PATIENT);
 
-        input->get_col(x, (float*)(slice_in[thread]));
-        fftwf_execute(plans[x]);
+        input->get_col(x, slice_in);
+        fftw_traits<T>::execute(plans[x]);
 
         // Normalization factor
-        for(size_t i = 0; i < floor(rows/2)+1; i++){
-            slice_out[thread][i] /= rows;
+        for(size_t i = 0; i < out_rows; i++){
+            slice_out[i] /= rows;
         }
 
-        output->set_col(x, (std::complex<float>*)(slice_out[thread]));
+        output->set_col(x, slice_out);
     }
 
 }
 
-template<>
-void fftw_fft_t<float>::calculate(
-    matrix_t<std::complex<float>>* input,
-    matrix_t<std::complex<float>>* output
+template<typename T>
+void fftw_fft_t<T>::calculate(
+    matrix_t<std::complex<T>>*,
+    matrix_t<std::complex<T>>*
 ) {
-
-    /*
-    int thread;
-    size_t cols = input->get_cols();
-    size_t rows = input->get_rows();
-    std::complex<float> slice_in[num_threads][rows];
-    std::complex<float> slice_out[num_threads][floor(rows/2)+1];
-
-    output->set_shape(floor(rows/2)+1, cols);
-
-    //* Use sentinel pattern to gather wisdom for later
-    complex<float>* in_temp = new complex<float>[rows];
-    for(int j = 0; j < rows; j++){
-        in_temp[j] = complex<float>(rand() % 10 * sin(j), rand() % 10 * cos(j));
-    }
-
-    complex<float>* out_temp = new complex<float>[floor(rows/2)+1];
-
-    fftwf_plan planw = fftwf_plan_dft_1d(
-            rows,
-            reinterpret_cast<fftwf_complex*>(in_temp),
-            reinterpret_cast<fftwf_complex*>(out_temp),
-            FFTW_FORWARD,
-            FFTW_PATIENT);
-
-    fftwf_execute(planw);
-    char* wisdom = fftwf_export_wisdom_to_string();
-    fftwf_destroy_plan(planw);
-
-    fftwf_plan* plans = new fftwf_plan[cols];
-    #pragma omp parallel for private(thread)
-    for(size_t x = 0; x < cols; x++){
-        thread = omp_get_thread_num();
-
-        #pragma omp critical
-        {
-        fftwf_import_wisdom_from_string(wisdom);
-        }
-
-        input->get_col(x, (std::complex<float>*)(slice_in[thread]));
-
-        plans[x] = fftwf_plan_dft_1d(
-            rows,
-            reinterpret_cast<fftwf_complex*>(slice_in[thread]),
-            reinterpret_cast<fftwf_complex*>(slice_out[thread]),
-            FFTW_FORWARD,
-            FFTW_PATIENT);
-
-        input->get_col(x, (std::complex<float>*)(slice_in[thread]));
-        fftwf_execute(plans[x]);
-
-        // Normalization factor
-        for(size_t i = 0; i < floor(rows/2)+1; i++){
-            slice_out[thread][i] /= floor(rows/2)+1;
-        }
-
-        output->set_col(x, (std::complex<float>*)(slice_out[thread]));
-    }
-
-*/
 }
 
 
-template<>
-void fftw_fft_t<float>::inverse(
-    matrix_t<std::complex<float>>* input,
-    matrix_t<float>* output
+template<typename T>
+void fftw_fft_t<T>::inverse(
+    matrix_t<std::complex<T>>* input,
+    matrix_t<T>* output
 ) {
 
     int thread;
     size_t cols = input->get_cols();
     size_t rows = input->get_rows();
-    std::complex<float> slice_in[num_threads][rows];
-    float              slice_out[num_threads][2*(rows - 1)];
+    size_t out_rows = 2*(rows - 1);
+    scratch_arena_t* arena = this->reserve_scratch(2,
+        std::max(rows * sizeof(std::complex<T>), out_rows * sizeof(T)));
 
     output->set_shape(2*(rows - 1), cols);
 
     /** Use sentinel pattern to gather wisdom for later */
 
-    complex<float>* in_temp = new complex<float>[rows];
+    complex<T>* in_temp = new complex<T>[rows];
     for(int j = 0; j < rows; j++){
-        in_temp[j] = complex<float>(rand() % 10 * sin(j), rand() % 10 * cos(j));
+        in_temp[j] = complex<T>(rand() % 10 * sin(j), rand() % 10 * cos(j));
     }
 
-    complex<float>* out_temp = new complex<float>[2*(rows - 1)];
+    complex<T>* out_temp = new complex<T>[2*(rows - 1)];
 
-    fftwf_plan planw = fftwf_plan_dft_c2r_1d(
+    plan_t planw = fftw_traits<T>::plan_dft_c2r_1d(
         rows,
-        reinterpret_cast<fftwf_complex*>(slice_in[thread]),
-        slice_out[thread],
+        reinterpret_cast<fftw_complex_t*>(arena->template get<std::complex<T>>(0, 0)),
+        arena->template get<T>(0, 1),
         FFTW_PATIENT);
 
-    fftwf_execute(planw);
-    char* wisdom = fftwf_export_wisdom_to_string();
-    fftwf_destroy_plan(planw);
+    fftw_traits<T>::execute(planw);
+    char* wisdom = fftw_traits<T>::export_wisdom_to_string();
+    fftw_traits<T>::destroy_plan(planw);
 
-    fftwf_plan* plans = new fftwf_plan[cols];
+    plan_t* plans = new plan_t[cols];
     #pragma omp parallel for private(thread)
     for(size_t x = 0; x < cols; x++){
         thread = omp_get_thread_num();
+        std::complex<T>* slice_in  = arena->template get<std::complex<T>>(thread, 0);
+        T*               slice_out = arena->template get<T>(thread, 1);
 
         #pragma omp critical
         {
-        fftwf_import_wisdom_from_string(wisdom);
+        fftw_traits<T>::import_wisdom_from_string(wisdom);
         }
 
-        input->get_col(x, (std::complex<float>*)(slice_in[thread]));
+        input->get_col(x, slice_in);
 
-        plans[x] = fftwf_plan_dft_c2r_1d(
+        plans[x] = fftw_traits<T>::plan_dft_c2r_1d(
             rows,
-            reinterpret_cast<fftwf_complex*>(slice_in[thread]),
-            slice_out[thread],
+            reinterpret_cast<fftw_complex_t*>(slice_in),
+            slice_out,
             FFTW_PATIENT);
 
-        input->get_col(x, (std::complex<float>*)(slice_in[thread]));
-        fftwf_execute(plans[x]);
+        input->get_col(x, slice_in);
+        fftw_traits<T>::execute(plans[x]);
 
-        output->set_col(x, (float*)(slice_out[thread]));
+        output->set_col(x, slice_out);
     }
 
 }
 
 
-template<>
-void fftw_fft_t<float>::inverse(
-    matrix_t<std::complex<float>>* input,
-    matrix_t<std::complex<float>>* output
+template<typename T>
+void fftw_fft_t<T>::inverse(
+    matrix_t<std::complex<T>>* input,
+    matrix_t<std::complex<T>>* output
 ) {
 
     int thread;
     size_t cols = input->get_cols();
     size_t rows = input->get_rows();
-    std::complex<float> slice_in[num_threads][rows];
-    std::complex<float> slice_out[num_threads][2*(rows - 1)];
+    scratch_arena_t* arena = this->reserve_scratch(2, 2*(rows - 1) * sizeof(std::complex<T>));
 
     output->set_shape(2*(rows - 1), cols);
 
     //* Use sentinel pattern to gather wisdom for later
 
-    complex<float>* in_temp = new complex<float>[rows];
+    complex<T>* in_temp = new complex<T>[rows];
     for(int j = 0; j < rows; j++){
-        in_temp[j] = complex<float>(rand() % 10 * sin(j), rand() % 10 * cos(j));
+        in_temp[j] = complex<T>(rand() % 10 * sin(j), rand() % 10 * cos(j));
     }
 
-    complex<float>* out_temp = new complex<float>[2*(rows - 1)];
+    complex<T>* out_temp = new complex<T>[2*(rows - 1)];
 
-    fftwf_plan planw = fftwf_plan_dft_1d(
+    plan_t planw = fftw_traits<T>::plan_dft_1d(
             rows,
-            reinterpret_cast<fftwf_complex*>(in_temp),
-            reinterpret_cast<fftwf_complex*>(out_temp),
+            reinterpret_cast<fftw_complex_t*>(in_temp),
+            reinterpret_cast<fftw_complex_t*>(out_temp),
             FFTW_BACKWARD,
             FFTW_PATIENT);
 
-    fftwf_execute(planw);
-    char* wisdom = fftwf_export_wisdom_to_string();
-    fftwf_destroy_plan(planw);
+    fftw_traits<T>::execute(planw);
+    char* wisdom = fftw_traits<T>::export_wisdom_to_string();
+    fftw_traits<T>::destroy_plan(planw);
 
-    fftwf_plan* plans = new fftwf_plan[cols];
+    plan_t* plans = new plan_t[cols];
     #pragma omp parallel for private(thread)
     for(size_t x = 0; x < cols; x++){
         thread = omp_get_thread_num();
+        std::complex<T>* slice_in  = arena->template get<std::complex<T>>(thread, 0);
+        std::complex<T>* slice_out = arena->template get<std::complex<T>>(thread, 1);
 
         #pragma omp critical
         {
-        fftwf_import_wisdom_from_string(wisdom);
+        fftw_traits<T>::import_wisdom_from_string(wisdom);
         }
 
-        input->get_col(x, (std::complex<float>*)(slice_in[thread]));
+        input->get_col(x, slice_in);
 
-        plans[x] = fftwf_plan_dft_1d(
+        plans[x] = fftw_traits<T>::plan_dft_1d(
             rows,
-            reinterpret_cast<fftwf_complex*>(slice_in[thread]),
-            reinterpret_cast<fftwf_complex*>(slice_out[thread]),
+            reinterpret_cast<fftw_complex_t*>(slice_in),
+            reinterpret_cast<fftw_complex_t*>(slice_out),
             FFTW_BACKWARD,
             FFTW_PATIENT);
 
-        input->get_col(x, (std::complex<float>*)(slice_in[thread]));
-        fftwf_execute(plans[x]);
+        input->get_col(x, slice_in);
+        fftw_traits<T>::execute(plans[x]);
 
-        output->set_col(x, (std::complex<float>*)(slice_out[thread]));
+        output->set_col(x, slice_out);
     }
 
 }
 
-template<>
-void fftw_fft_t<float>::analytic(
-    matrix_t<float>* input,
-    matrix_t<std::complex<float>>* output
+template<typename T>
+void fftw_fft_t<T>::analytic(
+    matrix_t<T>* input,
+    matrix_t<std::complex<T>>* output
 ) {
 
     size_t cols = input->get_cols();
     size_t rows = input->get_rows();
     output->set_shape(rows, cols);
 
-    matrix_t<std::complex<float>>* transformed = new matrix_t<std::complex<float>>(floor(rows/2)+1, cols);
+    matrix_t<std::complex<T>>* transformed = new matrix_t<std::complex<T>>(floor(rows/2)+1, cols);
     this->calculate(input, transformed);
 
+    scratch_arena_t* arena = this->reserve_scratch(3, rows * sizeof(std::complex<T>));
+
     #pragma omp parallel for
     for(size_t x = 0; x < cols; x++){
-        std::complex<float> slice_in[(int)(floor(rows/2)+1)];
-        std::complex<float> slice_out[rows];
+        int thread = omp_get_thread_num();
+        std::complex<T>* slice_in  = arena->template get<std::complex<T>>(thread, 0);
+        std::complex<T>* slice_out = arena->template get<std::complex<T>>(thread, 1);
 
-        transformed->get_col(x, (std::complex<float>*) slice_in);
+        transformed->get_col(x, slice_in);
         for(size_t i = 0; i < floor(rows/2)+1; i++){
-            slice_out[i] = std::complex<float>(0.0,1.0) * slice_in[i];
+            slice_out[i] = std::complex<T>(0.0,1.0) * slice_in[i];
         }
-        transformed->set_col(x, (std::complex<float>*) slice_out);
+        transformed->set_col(x, slice_out);
     }
 
-    matrix_t<std::complex<float>>* im = new matrix_t<std::complex<float>>(rows, cols);
+    matrix_t<std::complex<T>>* im = new matrix_t<std::complex<T>>(rows, cols);
     this->inverse(transformed, im);
 
+    // The inverse transform resized the arena, so size it again for this pass
+    arena = this->reserve_scratch(3, rows * sizeof(std::complex<T>));
+
     for(size_t x = 0; x < cols; x++){
-        float               slice_in[rows];
-        std::complex<float> slice_im[rows];
-        std::complex<float> slice_out[rows];
-        input->get_col(x, (float*)slice_in);
-        im->get_col(x, (std::complex<float>*)slice_im);
+        T*               slice_in  = arena->template get<T>(0, 0);
+        std::complex<T>* slice_im  = arena->template get<std::complex<T>>(0, 1);
+        std::complex<T>* slice_out = arena->template get<std::complex<T>>(0, 2);
+        input->get_col(x, slice_in);
+        im->get_col(x, slice_im);
         for(size_t i = 0; i < rows; i++){
-            slice_out[i] = std::complex<float>(slice_in[i], 0.0) + (std::complex<float>(0.0,1.0) * slice_im[i]);
+            slice_out[i] = std::complex<T>(slice_in[i], 0.0) + (std::complex<T>(0.0,1.0) * slice_im[i]);
         }
-        output->set_col(x, (std::complex<float>*) slice_out);
+        output->set_col(x, slice_out);
     }
 
 }
 
-template<>
-void fftw_fft_t<float>::analytic(
-    matrix_t<std::complex<float>>* input,
-    matrix_t<std::complex<float>>* output
+template<typename T>
+void fftw_fft_t<T>::analytic(
+    matrix_t<std::complex<T>>*,
+    matrix_t<std::complex<T>>*
+) {
+}
+
+
+/**
+ * Hilbert transform of every column: the spectrum of the column has its
+ * positive frequencies multiplied by -i and its DC and Nyquist terms dropped
+ * before transforming back. A single pair of plans is made up front and run
+ * on every thread's own buffers with the new-array execute interface.
+ */
+template<typename T>
+void fftw_fft_t<T>::hilbert(
+    matrix_t<T>* input,
+    matrix_t<T>* output
 ) {
 
-    /*
+    int thread;
     size_t cols = input->get_cols();
     size_t rows = input->get_rows();
+    size_t freqs = rows/2 + 1;
+    scratch_arena_t* arena = this->reserve_scratch(2,
+        std::max(rows * sizeof(T), freqs * sizeof(std::complex<T>)));
 
-    matrix_t<std::complex<float>>* transformed = new matrix_t<std::complex<float>>(rows, cols);
-    this->calculate(input, transformed);
+    output->set_shape(rows, cols);
 
-    float xf;
-    int* xh = new int[rows];
-    for(size_t i = 0; i < rows; i++){
-        xf = ((int)i + 1) - input->get_rows()/2.f;
-        if(xf - 0.5 < 0){
-            xh[i] = -1;
-        }else{
-            xh[i] = 1;
-        }
-    }
+    plan_t forward = fftw_traits<T>::plan_dft_r2c_1d(
+        rows,
+        arena->template get<T>(0, 0),
+        reinterpret_cast<fftw_complex_t*>(arena->template get<std::complex<T>>(0, 1)),
+        FFTW_PATIENT);
 
-    #pragma omp parallel for shared(xh)
+    plan_t backward = fftw_traits<T>::plan_dft_c2r_1d(
+        rows,
+        reinterpret_cast<fftw_complex_t*>(arena->template get<std::complex<T>>(0, 1)),
+        arena->template get<T>(0, 0),
+        FFTW_PATIENT);
+
+    // Bins past the last positive frequency (the Nyquist term, for even
+    // lengths) are zeroed along with DC
+    size_t last = (rows % 2 == 0) ? freqs - 1 : freqs;
+
+    #pragma omp parallel for private(thread)
     for(size_t x = 0; x < cols; x++){
-        std::complex<float> slice_in[rows];
-        std::complex<float> slice_out[rows];
+        thread = omp_get_thread_num();
+        T*               slice    = arena->template get<T>(thread, 0);
+        std::complex<T>* spectrum = arena->template get<std::complex<T>>(thread, 1);
 
-        transformed->get_col(x, (std::complex<float>*) slice_in);
+        input->get_col(x, slice);
+        fftw_traits<T>::execute_dft_r2c(forward, slice, reinterpret_cast<fftw_complex_t*>(spectrum));
+
+        spectrum[0] = 0;
+        for(size_t i = 1; i < last; i++){
+            spectrum[i] = std::complex<T>(spectrum[i].imag(), -spectrum[i].real());
+        }
+        for(size_t i = last; i < freqs; i++){
+            spectrum[i] = 0;
+        }
+
+        fftw_traits<T>::execute_dft_c2r(backward, reinterpret_cast<fftw_complex_t*>(spectrum), slice);
+
+        // Normalization factor
         for(size_t i = 0; i < rows; i++){
-            slice_out[i] = xh[i] * complex<float>(0.0, 1.0) * slice_in[i];
+            slice[i] /= rows;
         }
-        transformed->set_col(x, (std::complex<float>*) slice_out);
-    }
 
-    this->inverse(transformed, output);
+        output->set_col(x, slice);
+    }
 
-*/
+    fftw_traits<T>::destroy_plan(forward);
+    fftw_traits<T>::destroy_plan(backward);
 }
-
@@ -0,0 +1,135 @@
+/***********************************************************************
+ *                   GNU Lesser General Public License
+ *
+ * This file is part of the EDGI prototype package, developed by the
+ * GFDL Flexible Modeling System (FMS) group.
+ *
+ * EDGI is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * EDGI is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with EDGI.  If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************/
+
+#ifndef FFTW_TRAITS_HPP
+#define FFTW_TRAITS_HPP
+
+/** Must be after <complex> */
+#include <complex>
+#include <fftw3.h>
+
+
+
+
+
+//==============================================================================
+// Declaration
+//==============================================================================
+
+/**
+ * Maps a real type onto the matching FFTW interface (fftwf_* for float,
+ * fftw_* for double), so that fftw_fft_t is written once for both
+ */
+template<typename T>
+struct fftw_traits;
+
+
+
+
+
+//==============================================================================
+// Template Specializations
+//==============================================================================
+
+template<>
+struct fftw_traits<float> {
+    typedef fftwf_plan    plan_t;
+    typedef fftwf_complex complex_t;
+
+    static plan_t plan_dft_r2c_1d(int n, float* in, complex_t* out, unsigned flags) {
+        return fftwf_plan_dft_r2c_1d(n, in, out, flags);
+    }
+
+    static plan_t plan_dft_c2r_1d(int n, complex_t* in, float* out, unsigned flags) {
+        return fftwf_plan_dft_c2r_1d(n, in, out, flags);
+    }
+
+    static plan_t plan_dft_1d(int n, complex_t* in, complex_t* out, int sign, unsigned flags) {
+        return fftwf_plan_dft_1d(n, in, out, sign, flags);
+    }
+
+    static void execute(const plan_t plan) {
+        fftwf_execute(plan);
+    }
+
+    static void execute_dft_r2c(const plan_t plan, float* in, complex_t* out) {
+        fftwf_execute_dft_r2c(plan, in, out);
+    }
+
+    static void execute_dft_c2r(const plan_t plan, complex_t* in, float* out) {
+        fftwf_execute_dft_c2r(plan, in, out);
+    }
+
+    static void destroy_plan(plan_t plan) {
+        fftwf_destroy_plan(plan);
+    }
+
+    static char* export_wisdom_to_string() {
+        return fftwf_export_wisdom_to_string();
+    }
+
+    static int import_wisdom_from_string(const char* wisdom) {
+        return fftwf_import_wisdom_from_string(wisdom);
+    }
+};
+
+template<>
+struct fftw_traits<double> {
+    typedef fftw_plan    plan_t;
+    typedef fftw_complex complex_t;
+
+    static plan_t plan_dft_r2c_1d(int n, double* in, complex_t* out, unsigned flags) {
+        return fftw_plan_dft_r2c_1d(n, in, out, flags);
+    }
+
+    static plan_t plan_dft_c2r_1d(int n, complex_t* in, double* out, unsigned flags) {
+        return fftw_plan_dft_c2r_1d(n, in, out, flags);
+    }
+
+    static plan_t plan_dft_1d(int n, complex_t* in, complex_t* out, int sign, unsigned flags) {
+        return fftw_plan_dft_1d(n, in, out, sign, flags);
+    }
+
+    static void execute(const plan_t plan) {
+        fftw_execute(plan);
+    }
+
+    static void execute_dft_r2c(const plan_t plan, double* in, complex_t* out) {
+        fftw_execute_dft_r2c(plan, in, out);
+    }
+
+    static void execute_dft_c2r(const plan_t plan, complex_t* in, double* out) {
+        fftw_execute_dft_c2r(plan, in, out);
+    }
+
+    static void destroy_plan(plan_t plan) {
+        fftw_destroy_plan(plan);
+    }
+
+    static char* export_wisdom_to_string() {
+        return fftw_export_wisdom_to_string();
+    }
+
+    static int import_wisdom_from_string(const char* wisdom) {
+        return fftw_import_wisdom_from_string(wisdom);
+    }
+};
+
+#endif
@@ -0,0 +1,214 @@
+/***********************************************************************
+ *                   GNU Lesser General Public License
+ *
+ * This file is part of the EDGI prototype package, developed by the
+ * GFDL Flexible Modeling System (FMS) group.
+ *
+ * EDGI is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * EDGI is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with EDGI.  If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************/
+
+#include "file_utils.hpp"
+
+/** Use raw_file_t */
+#include "raw_file.hpp"
+
+/** Use open, close, pread, write, getpid */
+#include <fcntl.h>
+#include <unistd.h>
+
+/** Use fstat */
+#include <sys/stat.h>
+
+/** Use errno */
+#include <cerrno>
+
+/** Use memcmp, memcpy */
+#include <cstring>
+
+/** Use std::rename, std::remove */
+#include <cstdio>
+
+/** Use std::min */
+#include <algorithm>
+
+/** Use std::ostringstream */
+#include <sstream>
+
+/** Use std::hex */
+#include <ios>
+
+/** Use std::vector */
+#include <vector>
+
+// <string> and <functional> included in header
+using std::string;
+
+
+
+
+
+//==============================================================================
+// Local functions
+//==============================================================================
+
+namespace {
+
+    /** Bytes hashed at each end of an input file to tell its contents apart */
+    const size_t HASHED_BYTES = 1 << 16;
+
+    const uint64_t FNV_OFFSET = 14695981039346656037ull;
+    const uint64_t FNV_PRIME = 1099511628211ull;
+
+    /** 64-bit FNV-1a of `len` bytes, continuing from `hash` */
+    uint64_t fnv1a(const unsigned char* bytes, size_t len, uint64_t hash) {
+        for (size_t i = 0; i < len; i++) {
+            hash ^= bytes[i];
+            hash *= FNV_PRIME;
+        }
+        return hash;
+    }
+
+    /** Hashes the first and last bytes of the open file `fd`, of length `size` */
+    uint64_t hash_ends(int fd, size_t size) {
+        std::vector<unsigned char> buffer(HASHED_BYTES);
+        uint64_t hash = FNV_OFFSET;
+
+        size_t head = std::min(size, HASHED_BYTES);
+        ssize_t got = pread(fd, buffer.data(), head, 0);
+        hash = fnv1a(buffer.data(), (got > 0) ? got : 0, hash);
+
+        if (size > HASHED_BYTES) {
+            size_t tail = std::min(size - HASHED_BYTES, HASHED_BYTES);
+            got = pread(fd, buffer.data(), tail, size - tail);
+            hash = fnv1a(buffer.data(), (got > 0) ? got : 0, hash);
+        }
+
+        return hash;
+    }
+
+    /** Describes the identity of `filename` (size, mtime, hash), or returns "" */
+    string describe_file(const string filename) {
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return "";
+        }
+
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            close(fd);
+            return "";
+        }
+
+        std::ostringstream text;
+        text << filename << " " << info.st_size << " "
+             << info.st_mtim.tv_sec << "." << info.st_mtim.tv_nsec << " "
+             << std::hex << hash_ends(fd, info.st_size);
+        close(fd);
+        return text.str();
+    }
+}
+
+
+
+
+
+//==============================================================================
+// Implementation
+//==============================================================================
+
+size_t align_up(size_t offset, size_t alignment) {
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+void set_magic(char* header_magic, const char* magic) {
+    std::memcpy(header_magic, magic, MAGIC_LEN);
+}
+
+bool has_magic(const char* header_magic, const char* magic) {
+    return std::memcmp(header_magic, magic, MAGIC_LEN) == 0;
+}
+
+uint64_t fnv1a(const string& text) {
+    return fnv1a((const unsigned char*) text.data(), text.size(), FNV_OFFSET);
+}
+
+string describe_input(const string filename) {
+    string identity = describe_file(filename);
+    if (identity.empty()) {
+        return "";
+    }
+
+    // A raw dump is also described by its sidecar
+    if (raw_file_t::is_raw(filename)) {
+        string descriptor = describe_file(raw_file_t::get_descriptor_name(filename));
+        if (descriptor.empty()) {
+            return "";
+        }
+        identity += "\n" + descriptor;
+    }
+
+    return identity;
+}
+
+bool write_all(int fd, const void* data, size_t len) {
+    const char* bytes = (const char*) data;
+    while (len > 0) {
+        ssize_t written = write(fd, bytes, len);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        bytes += written;
+        len -= written;
+    }
+    return true;
+}
+
+bool write_zeros(int fd, size_t len) {
+    const char zeros[256] = {0};
+    while (len > 0) {
+        size_t part = std::min(len, sizeof(zeros));
+        if (!write_all(fd, zeros, part)) {
+            return false;
+        }
+        len -= part;
+    }
+    return true;
+}
+
+bool replace_file(const string path, const std::function<bool(int)>& write_contents, int* error) {
+    std::ostringstream temp_path;
+    temp_path << path << ".tmp." << getpid();
+
+    int fd = open(temp_path.str().c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    bool written = fd >= 0 && write_contents(fd);
+    *error = errno;
+
+    if (fd >= 0 && close(fd) != 0 && written) {
+        written = false;
+        *error = errno;
+    }
+
+    if (written && std::rename(temp_path.str().c_str(), path.c_str()) != 0) {
+        written = false;
+        *error = errno;
+    }
+
+    if (!written) {
+        std::remove(temp_path.str().c_str());
+    }
+    return written;
+}
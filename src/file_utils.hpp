@@ -0,0 +1,104 @@
+/***********************************************************************
+ *                   GNU Lesser General Public License
+ *
+ * This file is part of the EDGI prototype package, developed by the
+ * GFDL Flexible Modeling System (FMS) group.
+ *
+ * EDGI is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * EDGI is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with EDGI.  If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************/
+
+#ifndef FILE_UTILS_HPP
+#define FILE_UTILS_HPP
+
+/** Use size_t */
+#include <cstddef>
+
+/** Use uint64_t */
+#include <cstdint>
+
+/** Use std::function */
+#include <functional>
+
+/** Use std::string */
+#include <string>
+
+
+
+
+
+//==============================================================================
+// Declaration
+//==============================================================================
+
+/*
+ * Helpers shared by the files this program writes for itself (the anomaly
+ * cache, covariance checkpoints and tile checkpoints), which all start with
+ * a magic string and a header, keep their data on a page boundary so it can
+ * be mapped, and are keyed by the identity of the inputs they came from.
+ */
+
+/** Length of the magic string at the start of each file */
+const size_t MAGIC_LEN = 8;
+
+/** Bulk data starts on a boundary of this many bytes */
+const size_t DATA_ALIGNMENT = 4096;
+
+/**
+ * Rounds `offset` up to a multiple of `alignment`
+ */
+size_t align_up(size_t offset, size_t alignment);
+
+/**
+ * Copies the magic string `magic` into a header
+ */
+void set_magic(char* header_magic, const char* magic);
+
+/**
+ * Returns whether a header starts with the magic string `magic`
+ */
+bool has_magic(const char* header_magic, const char* magic);
+
+/**
+ * Writes all `len` bytes at `data`, retrying short and interrupted writes,
+ * or returns false
+ */
+bool write_all(int fd, const void* data, size_t len);
+
+/**
+ * Writes `len` zero bytes, or returns false
+ */
+bool write_zeros(int fd, size_t len);
+
+/**
+ * 64-bit FNV-1a hash of `text`
+ */
+uint64_t fnv1a(const std::string& text);
+
+/**
+ * Describes the identity of the input file `filename`: its name, size,
+ * modification time and a hash of its first and last bytes, followed for a
+ * raw dump by the same of its sidecar. Returns "" if it can't be read.
+ */
+std::string describe_input(const std::string filename);
+
+/**
+ * Writes a whole new file at `path` through `write_contents`, which is given a
+ * descriptor to write to and returns whether it succeeded. The file is
+ * written under a temporary name and then renamed over `path`, so no other
+ * run ever sees a partial file. On failure nothing is left behind, `error`
+ * is set to the errno and false is returned.
+ */
+bool replace_file(const std::string path, const std::function<bool(int)>& write_contents, int* error);
+
+#endif
@@ -0,0 +1,399 @@
+/***********************************************************************
+ *                   GNU Lesser General Public License
+ *
+ * This file is part of the EDGI prototype package, developed by the
+ * GFDL Flexible Modeling System (FMS) group.
+ *
+ * EDGI is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * EDGI is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with EDGI.  If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************/
+
+#ifdef WITH_HDF5
+
+#include "hdf5_chunk_reader.hpp"
+
+#include "error.hpp"
+
+/** Use uncompress */
+#include <zlib.h>
+
+/** Use std::min, std::max, std::fill */
+#include <algorithm>
+
+/** Use H5DOread_chunk on HDF5 releases older than 1.10.3 */
+#if !H5_VERSION_GE(1, 10, 3)
+#include <hdf5_hl.h>
+#endif
+
+// <string> included in header
+using std::string;
+
+
+
+
+
+//==============================================================================
+// Local functions
+//==============================================================================
+
+namespace {
+
+    /**
+     * Undoes the HDF5 shuffle filter, which stores the first bytes of all
+     * values, then the second bytes, and so on
+     */
+    void unshuffle(const unsigned char* in, unsigned char* out, size_t len, size_t value_size) {
+        size_t num_values = len / value_size;
+        for (size_t b = 0; b < value_size; b++) {
+            const unsigned char* src = in + b * num_values;
+            for (size_t i = 0; i < num_values; i++) {
+                out[i * value_size + b] = src[i];
+            }
+        }
+
+        // Trailing bytes that don't make up a whole value are not shuffled
+        size_t done = num_values * value_size;
+        std::copy(in + done, in + len, out + done);
+    }
+
+    /**
+     * Reads one raw chunk. A chunk that was never written comes back empty.
+     */
+    bool read_raw_chunk(hid_t dset_id, const hsize_t* offset, std::vector<unsigned char>& raw, uint32_t* mask) {
+        // HDF5 reports the size of a chunk that was never written as a
+        // failure, so treat any failure as an empty chunk
+        hsize_t nbytes = 0;
+        herr_t status;
+        H5E_BEGIN_TRY {
+            status = H5Dget_chunk_storage_size(dset_id, offset, &nbytes);
+        } H5E_END_TRY;
+        if (status < 0) {
+            nbytes = 0;
+        }
+
+        raw.resize(nbytes);
+        if (nbytes > 0) {
+#if H5_VERSION_GE(1, 10, 3)
+            status = H5Dread_chunk(dset_id, H5P_DEFAULT, offset, mask, raw.data());
+#else
+            status = H5DOread_chunk(dset_id, H5P_DEFAULT, offset, mask, raw.data());
+#endif
+            return status >= 0;
+        }
+
+        return true;
+    }
+
+}
+
+
+
+
+
+//==============================================================================
+// Constructors and destructors
+//==============================================================================
+
+bool hdf5_chunk_reader_t::is_hdf5(const string filename) {
+    htri_t result;
+    H5E_BEGIN_TRY {
+        result = H5Fis_hdf5(filename.c_str());
+    } H5E_END_TRY;
+    return result > 0;
+}
+
+hdf5_chunk_reader_t::hdf5_chunk_reader_t(const string filename, const string name) {
+    H5E_BEGIN_TRY {
+        this->file_id = H5Fopen(filename.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+        if (this->file_id >= 0) {
+            this->dset_id = H5Dopen2(this->file_id, name.c_str(), H5P_DEFAULT);
+        }
+    } H5E_END_TRY;
+
+    if (this->dset_id >= 0) {
+        this->inspect();
+    }
+}
+
+hdf5_chunk_reader_t::~hdf5_chunk_reader_t() {
+    if (this->dset_id >= 0) {
+        H5Dclose(this->dset_id);
+    }
+    if (this->file_id >= 0) {
+        H5Fclose(this->file_id);
+    }
+}
+
+
+
+
+
+//==============================================================================
+// Private Methods
+//==============================================================================
+
+/**
+ * Looks up the shape, type, filters and fill value of the dataset, and
+ * decides whether it can be decoded here
+ */
+void hdf5_chunk_reader_t::inspect() {
+    hid_t type = H5Dget_type(this->dset_id);
+    hid_t native = H5Tget_native_type(type, H5T_DIR_ASCEND);
+    bool is_float = H5Tequal(native, H5T_NATIVE_FLOAT) > 0;
+    bool is_double = H5Tequal(native, H5T_NATIVE_DOUBLE) > 0;
+    bool is_short = H5Tequal(native, H5T_NATIVE_SHORT) > 0;
+    bool native_order = H5Tget_order(type) == H5Tget_order(H5T_NATIVE_DOUBLE);
+    this->value_size = H5Tget_size(type);
+    H5Tclose(native);
+    H5Tclose(type);
+
+    hid_t space = H5Dget_space(this->dset_id);
+    int rank = H5Sget_simple_extent_ndims(space);
+    this->num_dims = (rank > 0) ? rank : 0;
+    this->dims.resize(this->num_dims);
+    H5Sget_simple_extent_dims(space, this->dims.data(), nullptr);
+    H5Sclose(space);
+
+    hid_t dcpl = H5Dget_create_plist(this->dset_id);
+    bool chunked = (rank > 0) && (H5Pget_layout(dcpl) == H5D_CHUNKED);
+    bool known_filters = true;
+
+    if (chunked) {
+        this->chunks.resize(this->num_dims);
+        H5Pget_chunk(dcpl, rank, this->chunks.data());
+
+        int num_filters = H5Pget_nfilters(dcpl);
+        for (int i = 0; i < num_filters; i++) {
+            unsigned int flags;
+            size_t num_values = 0;
+            unsigned int filter_config;
+            H5Z_filter_t filter = H5Pget_filter2(dcpl, i, &flags, &num_values, nullptr, 0, nullptr, &filter_config);
+            if (filter != H5Z_FILTER_DEFLATE && filter != H5Z_FILTER_SHUFFLE) {
+                known_filters = false;
+            }
+            this->filters.push_back(filter);
+        }
+
+        H5D_fill_value_t fill_status;
+        H5Pfill_value_defined(dcpl, &fill_status);
+        if (fill_status != H5D_FILL_VALUE_UNDEFINED) {
+            H5Pget_fill_value(dcpl, H5T_NATIVE_DOUBLE, &this->fill_value);
+        }
+    }
+    H5Pclose(dcpl);
+
+    this->supported = chunked && known_filters && native_order && (is_float || is_double || is_short);
+}
+
+/**
+ * Reads every chunk that overlaps the hyperslab exactly once. The raw chunks
+ * are all fetched by the calling thread (HDF5 is not safely reentrant), then
+ * the threads inflate and unshuffle them and copy the overlap into vals.
+ */
+template<typename S>
+void hdf5_chunk_reader_t::read_chunks(const size_t* start, const size_t* count, S* vals) const {
+    size_t n = this->num_dims;
+
+    // The range of chunk indices covered in each dimension
+    std::vector<hsize_t> first(n);
+    std::vector<hsize_t> num(n);
+    size_t total = 1;
+    for (size_t d = 0; d < n; d++) {
+        if (count[d] == 0) {
+            return;
+        }
+        first[d] = start[d] / this->chunks[d];
+        num[d] = (start[d] + count[d] - 1) / this->chunks[d] - first[d] + 1;
+        total *= num[d];
+    }
+
+    // Strides of a chunk and of the hyperslab, in values
+    std::vector<size_t> chunk_stride(n);
+    std::vector<size_t> vals_stride(n);
+    size_t chunk_values = 1;
+    size_t slab_values = 1;
+    for (size_t d = n; d-- > 0;) {
+        chunk_stride[d] = chunk_values;
+        vals_stride[d] = slab_values;
+        chunk_values *= this->chunks[d];
+        slab_values *= count[d];
+    }
+    size_t chunk_bytes = chunk_values * this->value_size;
+
+    // The offset (in values) of every chunk, and its raw bytes
+    std::vector<hsize_t> offsets(total * n);
+    std::vector<std::vector<unsigned char>> raws(total);
+    std::vector<uint32_t> masks(total, 0);
+    for (size_t k = 0; k < total; k++) {
+        hsize_t* offset = &offsets[k * n];
+        size_t rem = k;
+        for (size_t d = n; d-- > 0;) {
+            offset[d] = (first[d] + rem % num[d]) * this->chunks[d];
+            rem /= num[d];
+        }
+
+        if (!read_raw_chunk(this->dset_id, offset, raws[k], &masks[k])) {
+            throw eof_error_t("Failed to read a chunk of an HDF5 dataset");
+        }
+    }
+
+    bool failed = false;
+
+    #pragma omp parallel
+    {
+        std::vector<unsigned char> buffers[2] = {
+            std::vector<unsigned char>(chunk_bytes),
+            std::vector<unsigned char>(chunk_bytes)
+        };
+        std::vector<hsize_t> pos(n);
+
+        #pragma omp for schedule(dynamic)
+        for (size_t k = 0; k < total; k++) {
+            bool stop;
+            #pragma omp atomic read
+            stop = failed;
+            if (stop) {
+                continue;
+            }
+
+            const hsize_t* offset = &offsets[k * n];
+            const std::vector<unsigned char>& raw = raws[k];
+            uint32_t mask = masks[k];
+
+            const unsigned char* data = raw.data();
+            size_t len = raw.size();
+            bool decoded = true;
+            if (raw.empty()) {
+                // Never written, so the chunk is all fill values
+                unsigned char* out = buffers[0].data();
+                if (this->value_size == sizeof(short)) {
+                    std::fill((short*) out, (short*) out + chunk_values, (short) this->fill_value);
+                } else if (this->value_size == sizeof(float)) {
+                    std::fill((float*) out, (float*) out + chunk_values, (float) this->fill_value);
+                } else {
+                    std::fill((double*) out, (double*) out + chunk_values, this->fill_value);
+                }
+                data = out;
+                len = chunk_bytes;
+            } else {
+                // Undo the filters in reverse order, skipping any that were
+                // not applied to this chunk
+                int next = 0;
+                for (size_t f = this->filters.size(); f-- > 0;) {
+                    if (mask & (1u << f)) {
+                        continue;
+                    }
+
+                    unsigned char* out = buffers[next].data();
+                    if (this->filters[f] == H5Z_FILTER_DEFLATE) {
+                        uLongf out_len = chunk_bytes;
+                        if (uncompress(out, &out_len, data, len) != Z_OK) {
+                            decoded = false;
+                            break;
+                        }
+                        len = out_len;
+                    } else {
+                        unshuffle(data, out, len, this->value_size);
+                    }
+                    data = out;
+                    next = 1 - next;
+                }
+            }
+
+            if (!decoded || len != chunk_bytes) {
+                #pragma omp atomic write
+                failed = true;
+                continue;
+            }
+
+            // Copy the part of the chunk inside the hyperslab, one run along
+            // the last dimension at a time
+            size_t lo_last = std::max((size_t) offset[n - 1], start[n - 1]);
+            size_t hi_last = std::min((size_t) (offset[n - 1] + this->chunks[n - 1]), start[n - 1] + count[n - 1]);
+            size_t run = hi_last - lo_last;
+
+            for (size_t d = 0; d < n; d++) {
+                pos[d] = std::max((size_t) offset[d], start[d]);
+            }
+
+            while (true) {
+                size_t src = lo_last - offset[n - 1];
+                size_t dst = lo_last - start[n - 1];
+                for (size_t d = 0; d + 1 < n; d++) {
+                    src += (pos[d] - offset[d]) * chunk_stride[d];
+                    dst += (pos[d] - start[d]) * vals_stride[d];
+                }
+
+                if (this->value_size == sizeof(short)) {
+                    const short* in = (const short*) data + src;
+                    for (size_t i = 0; i < run; i++) {
+                        vals[dst + i] = (S) in[i];
+                    }
+                } else if (this->value_size == sizeof(float)) {
+                    const float* in = (const float*) data + src;
+                    for (size_t i = 0; i < run; i++) {
+                        vals[dst + i] = (S) in[i];
+                    }
+                } else {
+                    const double* in = (const double*) data + src;
+                    for (size_t i = 0; i < run; i++) {
+                        vals[dst + i] = (S) in[i];
+                    }
+                }
+
+                // Step to the next run, carrying through the outer dimensions
+                size_t d = n - 1;
+                while (d-- > 0) {
+                    size_t hi = std::min((size_t) (offset[d] + this->chunks[d]), start[d] + count[d]);
+                    if (++pos[d] < hi) {
+                        break;
+                    }
+                    pos[d] = std::max((size_t) offset[d], start[d]);
+                }
+                if (d == (size_t) -1) {
+                    break;
+                }
+            }
+        }
+    }
+
+    if (failed) {
+        throw eof_error_t("Failed to decode a chunk of an HDF5 dataset");
+    }
+}
+
+
+
+
+
+//==============================================================================
+// Public Methods
+//==============================================================================
+
+bool hdf5_chunk_reader_t::is_supported() const {
+    return this->supported;
+}
+
+void hdf5_chunk_reader_t::read(const size_t* start, const size_t* count, float* vals) const {
+    this->read_chunks(start, count, vals);
+}
+
+void hdf5_chunk_reader_t::read(const size_t* start, const size_t* count, double* vals) const {
+    this->read_chunks(start, count, vals);
+}
+
+void hdf5_chunk_reader_t::read(const size_t* start, const size_t* count, short* vals) const {
+    this->read_chunks(start, count, vals);
+}
+
+#endif
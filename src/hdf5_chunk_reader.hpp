@@ -0,0 +1,128 @@
+/***********************************************************************
+ *                   GNU Lesser General Public License
+ *
+ * This file is part of the EDGI prototype package, developed by the
+ * GFDL Flexible Modeling System (FMS) group.
+ *
+ * EDGI is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * EDGI is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with EDGI.  If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************/
+
+#ifndef HDF5_CHUNK_READER_HPP
+#define HDF5_CHUNK_READER_HPP
+
+#ifdef WITH_HDF5
+
+/** Use hid_t, hsize_t */
+#include <hdf5.h>
+
+/** Use slab_reader_t */
+#include "slab_reader.hpp"
+
+/** Use size_t */
+#include <cstddef>
+
+/** Use std::string */
+#include <string>
+
+/** Use std::vector */
+#include <vector>
+
+
+
+
+
+//==============================================================================
+// Declaration
+//==============================================================================
+
+/**
+ * Reads hyperslabs of a chunked variable in a NetCDF-4/HDF5 file by fetching
+ * its raw chunks with H5Dread_chunk and decoding them in parallel across the
+ * OpenMP threads. Only the calling thread makes HDF5 calls; the inflating,
+ * unshuffling and copying is shared.
+ *
+ * Only short (packed), float and double variables whose filters are shuffle
+ * and/or deflate are supported. Use is_supported() and fall back to
+ * netcdf_file_t for any other variable (and for classic-format files, see
+ * is_hdf5()).
+ */
+class hdf5_chunk_reader_t : public slab_reader_t {
+private:
+    //==========================================================================
+    // Private Fields
+    //==========================================================================
+
+    /** The HDF5 file and dataset */
+    hid_t file_id = -1;
+    hid_t dset_id = -1;
+
+    /** Number of dimensions, and the extent and chunk shape in each */
+    size_t num_dims = 0;
+    std::vector<hsize_t> dims;
+    std::vector<hsize_t> chunks;
+
+    /** Size in bytes of one (short, float or double) value in the file */
+    size_t value_size = 0;
+
+    /** The filters of the dataset, in the order they were applied */
+    std::vector<H5Z_filter_t> filters;
+
+    /** The value of chunks that were never written */
+    double fill_value = 0;
+
+    /** Can this dataset be decoded here? */
+    bool supported = false;
+
+
+
+    //==========================================================================
+    // Private Methods
+    //==========================================================================
+
+    void inspect();
+
+    template<typename S>
+    void read_chunks(const size_t* start, const size_t* count, S* vals) const;
+
+
+
+public:
+    //==========================================================================
+    // Public Methods
+    //==========================================================================
+
+    /**
+     * Returns whether the file is an HDF5 (and so NetCDF-4) file
+     */
+    static bool is_hdf5(const std::string filename);
+
+    /**
+     * Opens the variable `name` of the HDF5 file `filename`
+     */
+    hdf5_chunk_reader_t(const std::string filename, const std::string name);
+
+    ~hdf5_chunk_reader_t();
+
+    bool is_supported() const;
+
+    void read(const size_t* start, const size_t* count, float* vals) const;
+
+    void read(const size_t* start, const size_t* count, double* vals) const;
+
+    void read(const size_t* start, const size_t* count, short* vals) const;
+};
+
+#endif
+
+#endif
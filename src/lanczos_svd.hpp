@@ -0,0 +1,135 @@
+/***********************************************************************
+ *                   GNU Lesser General Public License
+ *
+ * This file is part of the EDGI prototype package, developed by the
+ * GFDL Flexible Modeling System (FMS) group.
+ *
+ * EDGI is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * EDGI is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with EDGI.  If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************/
+
+#ifndef LANCZOS_SVD_HPP
+#define LANCZOS_SVD_HPP
+
+/** Use svd_t */
+#include "svd.hpp"
+
+/** Use std::complex */
+#include <complex>
+
+
+
+
+
+//=============================================================================
+// Declaration of Class lanczos_svd_t
+//=============================================================================
+
+/**
+ * Finds only the leading modes of a Hermitian (covariance) matrix, by the
+ * Lanczos method with full reorthogonalization: the Krylov subspace of a
+ * random vector is grown one product at a time until the leading Ritz pairs
+ * of the tridiagonal matrix it projects to have converged. It needs a single
+ * vector product per step, and fewer steps the better the leading
+ * eigenvalues stand apart.
+ */
+template<typename T>
+class lanczos_svd_t : public svd_t<T> {
+private:
+    size_t num_threads;
+    size_t rank;
+
+    template<typename U>
+    void solve(
+        matrix_t<U>* input,
+        matrix_t<U>* u,
+        matrix_t<T>* s,
+        matrix_t<U>* vt
+    );
+
+public:
+    /** Modes found if not told otherwise */
+    static const size_t DEFAULT_RANK = 10;
+
+    /** Steps taken between checks of the Ritz pairs */
+    static const size_t CHECK_INTERVAL = 10;
+
+    /**
+     * Create an instance finding DEFAULT_RANK modes on the default number of
+     * threads
+     */
+    lanczos_svd_t();
+
+    /**
+     * Create an instance finding DEFAULT_RANK modes on the specified number
+     * of threads
+     */
+    lanczos_svd_t(size_t num_threads);
+
+    /**
+     * Create an instance finding `rank` modes on the specified number of
+     * threads
+     */
+    lanczos_svd_t(size_t num_threads, size_t rank);
+
+    ~lanczos_svd_t();
+
+    /**
+     * Set the number of threads to run on
+     */
+    void set_num_threads(size_t num_threads);
+
+    /**
+     * Set the number of leading modes to find (all of them, if the matrix is
+     * no bigger)
+     */
+    void set_rank(size_t rank);
+
+    /**
+     * Finds the leading modes of the square Hermitian matrix `input`, which
+     * is left as is
+     */
+    void calculate(
+        matrix_t<T>* input,
+        matrix_t<T>* u,
+        matrix_t<T>* s,
+        matrix_t<T>* vt
+    );
+
+    /**
+     * Finds the leading modes of the square Hermitian matrix `input`, which
+     * is left as is
+     */
+    void calculate(
+        matrix_t<std::complex<T>>* input,
+        matrix_t<std::complex<T>>* u,
+        matrix_t<T>*               s,
+        matrix_t<std::complex<T>>* vt
+    );
+};
+
+
+
+
+
+//=============================================================================
+// Template Implementation
+//=============================================================================
+
+#include "lanczos_svd.tpp"
+
+
+
+
+
+#endif
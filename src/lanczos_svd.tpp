@@ -0,0 +1,250 @@
+/***********************************************************************
+ *                   GNU Lesser General Public License
+ *
+ * This file is part of the EDGI prototype package, developed by the
+ * GFDL Flexible Modeling System (FMS) group.
+ *
+ * EDGI is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * EDGI is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with EDGI.  If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************/
+
+#include "lanczos_svd.hpp"
+
+#include "error.hpp"
+
+/** Use std::abs */
+#include <cmath>
+
+/** Use std::numeric_limits */
+#include <limits>
+
+/** Use std::mt19937 */
+#include <random>
+
+/** Use std::vector */
+#include <vector>
+
+/** Use std::sort */
+#include <algorithm>
+
+/** Use std::cout */
+#include <iostream>
+
+#include <ctime>
+#include <omp.h>
+
+
+
+
+
+//=============================================================================
+// Implementation of Class lanczos_svd_t
+//=============================================================================
+
+template<typename T>
+const size_t lanczos_svd_t<T>::DEFAULT_RANK;
+
+template<typename T>
+const size_t lanczos_svd_t<T>::CHECK_INTERVAL;
+
+template<typename T>
+lanczos_svd_t<T>::lanczos_svd_t() {
+    this->set_num_threads(omp_get_max_threads());
+    this->set_rank(DEFAULT_RANK);
+}
+
+template<typename T>
+lanczos_svd_t<T>::lanczos_svd_t(size_t num_threads) {
+    this->set_num_threads(num_threads);
+    this->set_rank(DEFAULT_RANK);
+}
+
+template<typename T>
+lanczos_svd_t<T>::lanczos_svd_t(size_t num_threads, size_t rank) {
+    this->set_num_threads(num_threads);
+    this->set_rank(rank);
+}
+
+template<typename T>
+lanczos_svd_t<T>::~lanczos_svd_t() {
+    // ...
+}
+
+template<typename T>
+void lanczos_svd_t<T>::set_num_threads(size_t num_threads) {
+    this->num_threads = (num_threads > 0) ? num_threads : 1;
+}
+
+template<typename T>
+void lanczos_svd_t<T>::set_rank(size_t rank) {
+    if (rank == 0) {
+        throw eof_error_t("At least one mode must be found");
+    }
+    this->rank = rank;
+}
+
+template<typename T>
+template<typename U>
+void lanczos_svd_t<T>::solve(
+    matrix_t<U>* input,
+    matrix_t<U>* u,
+    matrix_t<T>* s,
+    matrix_t<U>* vt
+) {
+    const size_t n = input->get_rows();
+    if (input->get_cols() != n) {
+        throw eof_error_t("The Lanczos eigensolver only decomposes square (covariance) matrices");
+    }
+
+    // Start the SVD timer
+    time_t start = time(nullptr);
+
+    const size_t k = std::min(this->rank, n);
+    const U* a = input->get_data();
+
+    // Ritz pairs are converged once their residuals are this small next to
+    // the largest eigenvalue, i.e. about as accurate as basic_svd_t's
+    const T eps = std::numeric_limits<T>::epsilon();
+    const T tolerance = 10 * eps;
+
+    // The Lanczos vectors, in the rows of qt, and the tridiagonal matrix with
+    // diagonal alpha and off-diagonal beta they reduce the matrix to
+    std::mt19937 rng(SVD_RANDOM_SEED);
+    std::vector<U> qt(n);
+    std::vector<T> alpha;
+    std::vector<T> beta;
+    std::vector<U> w(n);
+    random_fill(qt.data(), n, &rng);
+    orthonormalize_rows<T>(n, 0, 1, qt.data(), &rng, this->num_threads);
+
+    // Ritz values, their eigenvectors of the tridiagonal matrix (in rows of
+    // `m` entries), and their order by magnitude
+    std::vector<T> theta;
+    std::vector<T> y;
+    std::vector<size_t> order;
+
+    size_t m = 0;
+    T scale = 0;
+    while (n > 0) {
+        apply_hermitian(n, a, 1, qt.data() + m * n, w.data(), this->num_threads);
+        alpha.push_back(real_of(inner_of(qt.data() + m * n, w.data(), n)));
+
+        // Taking out all earlier vectors (twice) covers the three-term
+        // recurrence as well as the loss of orthogonality in it
+        T next_beta = orthogonalize_row<T>(n, m + 1, qt.data(), w.data(), this->num_threads);
+        scale = std::max(scale, std::abs(alpha[m]) + next_beta + ((m > 0) ? beta[m - 1] : T(0)));
+        m++;
+
+        // The subspace is invariant, so the next vector starts afresh
+        bool breakdown = (next_beta <= eps * scale);
+
+        if (m == n || breakdown || (m >= k && (m - k) % CHECK_INTERVAL == 0)) {
+            std::vector<T> tri(m * m, T(0));
+            for (size_t i = 0; i < m; i++) {
+                tri[i * m + i] = alpha[i];
+                if (i + 1 < m) {
+                    tri[i * m + i + 1] = beta[i];
+                    tri[(i + 1) * m + i] = beta[i];
+                }
+            }
+
+            theta.assign(m, T(0));
+            y.assign(m * m, T(0));
+            hermitian_eigensolve(m, tri.data(), theta.data(), y.data(), this->num_threads);
+
+            order.resize(m);
+            for (size_t i = 0; i < m; i++) {
+                order[i] = i;
+            }
+            std::sort(order.begin(), order.end(), [&theta](size_t i, size_t j) {
+                return std::abs(theta[i]) > std::abs(theta[j]);
+            });
+
+            // The residual of a Ritz pair is beta times the last entry of its
+            // eigenvector of the tridiagonal matrix
+            bool converged = (m >= k);
+            for (size_t r = 0; r < k && converged; r++) {
+                T residual = next_beta * std::abs(y[order[r] * m + m - 1]);
+                converged = (residual <= tolerance * std::abs(theta[order[0]]));
+            }
+
+            if (converged || m == n) {
+                break;
+            }
+        }
+
+        qt.resize((m + 1) * n);
+        if (breakdown) {
+            random_fill(qt.data() + m * n, n, &rng);
+            orthonormalize_rows<T>(n, m, m + 1, qt.data(), &rng, this->num_threads);
+            beta.push_back(0);
+        } else {
+            U* q = qt.data() + m * n;
+            for (size_t i = 0; i < n; i++) {
+                q[i] = w[i] / next_beta;
+            }
+            beta.push_back(next_beta);
+        }
+    }
+
+    // The leading Ritz vectors, Q times the eigenvectors of the tridiagonal
+    // matrix
+    std::vector<T> d(k);
+    std::vector<U> xt(k * n);
+    for (size_t r = 0; r < k; r++) {
+        d[r] = theta[order[r]];
+    }
+    #pragma omp parallel for num_threads(this->num_threads) schedule(static)
+    for (size_t i0 = 0; i0 < n; i0 += SVD_COLUMN_BLOCK) {
+        size_t len = std::min(n - i0, SVD_COLUMN_BLOCK);
+        for (size_t r = 0; r < k; r++) {
+            U* x = xt.data() + r * n + i0;
+            const T* yr = y.data() + order[r] * m;
+            for (size_t j = 0; j < m; j++) {
+                const U* q = qt.data() + j * n + i0;
+                T c = yr[j];
+                #pragma omp simd
+                for (size_t i = 0; i < len; i++) {
+                    x[i] += c * q[i];
+                }
+            }
+        }
+    }
+
+    write_modes(n, k, k, d.data(), xt.data(), u, s, vt, this->num_threads);
+
+    // Print the time required to compute the SVD
+    time_t end = time(nullptr);
+    double time = difftime(end,start);
+    std::cout << "svd: " << time << "s; ";
+}
+
+template<typename T>
+void lanczos_svd_t<T>::calculate(
+    matrix_t<T>* input,
+    matrix_t<T>* u,
+    matrix_t<T>* s,
+    matrix_t<T>* vt
+) {
+    this->solve(input, u, s, vt);
+}
+
+template<typename T>
+void lanczos_svd_t<T>::calculate(
+    matrix_t<std::complex<T>>* input,
+    matrix_t<std::complex<T>>* u,
+    matrix_t<T>*               s,
+    matrix_t<std::complex<T>>* vt
+) {
+    this->solve(input, u, s, vt);
+}
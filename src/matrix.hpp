@@ -41,6 +41,9 @@ private:
     size_t cols;
     
     T* data;
+
+    /** Was the data allocated by this matrix (rather than mapped in)? */
+    bool owns_data = true;
     
 public:
     matrix_t();
@@ -54,6 +57,8 @@ public:
     
     
     void set_shape(size_t rows, size_t cols);
+
+    void map_data(size_t rows, size_t cols, T* data);
     
     size_t get_rows() const;
     
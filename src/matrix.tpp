@@ -49,7 +49,7 @@ matrix_t<T>::matrix_t(const matrix_t& other) {
 
 template<typename T>
 matrix_t<T>::~matrix_t() {
-    if (data != nullptr) {
+    if (data != nullptr && this->owns_data) {
         delete[] this->data;
     }
 }
@@ -60,10 +60,11 @@ matrix_t<T>::~matrix_t() {
 
 template<typename T>
 void matrix_t<T>::set_shape(size_t rows, size_t cols) {
-    if (data != nullptr) {
+    if (data != nullptr && this->owns_data) {
         delete[] this->data;
-        this->data = nullptr;
     }
+    this->data = nullptr;
+    this->owns_data = true;
     
     this->rows = rows;
     this->cols = cols;
@@ -72,6 +73,23 @@ void matrix_t<T>::set_shape(size_t rows, size_t cols) {
     }
 }
 
+/**
+ * Makes `data`, which holds rows * cols values, the storage of this matrix,
+ * without copying it or taking ownership of it. It must outlive this matrix
+ * (or its next reshaping).
+ */
+template<typename T>
+void matrix_t<T>::map_data(size_t rows, size_t cols, T* data) {
+    if (this->data != nullptr && this->owns_data) {
+        delete[] this->data;
+    }
+
+    this->rows = rows;
+    this->cols = cols;
+    this->data = data;
+    this->owns_data = false;
+}
+
 template<typename T>
 size_t matrix_t<T>::get_rows() const {
     return this->rows;
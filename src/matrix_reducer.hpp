@@ -23,6 +23,15 @@
 
 #include <functional>
 
+/** Use std::complex */
+#include <complex>
+
+/** Use matrix_t */
+#include "matrix.hpp"
+
+/** Use eof_error_t */
+#include "error.hpp"
+
 
 
 
@@ -47,6 +56,13 @@ private:
 public:
     matrix_reducer_t(matrix_t<T>* mat, T missing_value);
     matrix_reducer_t(matrix_t<T>* mat, std::function<bool(T)> predicate);
+
+    /** Reduces by the columns of a matrix of another type, such as packed values */
+    template<typename U>
+    matrix_reducer_t(matrix_t<U>* mat, std::function<bool(U)> predicate);
+
+    /** Rebuilds a reducer from the columns it keeps, as get_map_reduced_cols lists them */
+    matrix_reducer_t(size_t num_restored_cols, size_t num_reduced_cols, const int* map_reduced_cols);
     
     ~matrix_reducer_t();
     
@@ -58,6 +74,9 @@ public:
     
     size_t get_reduced_cols() const;
     size_t get_restored_cols() const;
+
+    /** For each reduced column, the index of the column it came from */
+    const int* get_map_reduced_cols() const;
 };
 
 
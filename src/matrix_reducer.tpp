@@ -20,6 +20,7 @@
 
 #include <complex>
 #include <functional>
+#include <algorithm>
 
 
 
@@ -62,6 +63,60 @@ static void reduce_cols(
     *reduced_size = count;
 }
 
+/**
+ * Copies the columns listed in `map` out of `mat` into a new matrix with
+ * `num_cols` columns. Both matrices are row-major, so this walks each row once
+ * and needs no intermediate column buffer.
+ */
+template<typename U>
+static matrix_t<U>* gather_cols(const matrix_t<U>* mat, const int* map, size_t num_cols) {
+    size_t rows = mat->get_rows();
+    size_t mat_cols = mat->get_cols();
+    matrix_t<U>* reduced = new matrix_t<U>(rows, num_cols);
+
+    for (size_t c = 0; c < num_cols; c++) {
+        if (map[c] < 0) {
+            delete reduced;
+            throw eof_error_t("(Internal Error) Negative map value during reduction");
+        }
+    }
+
+    const U* src = mat->get_data();
+    U* dst = reduced->get_data_unsafe();
+    for (size_t r = 0; r < rows; r++) {
+        const U* src_row = src + r * mat_cols;
+        U* dst_row = dst + r * num_cols;
+        for (size_t c = 0; c < num_cols; c++) {
+            dst_row[c] = src_row[map[c]];
+        }
+    }
+
+    return reduced;
+}
+
+/**
+ * Inverse of gather_cols: spreads the columns of `mat` out to `num_cols`
+ * columns according to `map`, filling unmapped columns with `fill`
+ */
+template<typename U>
+static matrix_t<U>* scatter_cols(const matrix_t<U>* mat, const int* map, size_t num_cols, U fill) {
+    size_t rows = mat->get_rows();
+    size_t mat_cols = mat->get_cols();
+    matrix_t<U>* restored = new matrix_t<U>(rows, num_cols);
+
+    const U* src = mat->get_data();
+    U* dst = restored->get_data_unsafe();
+    for (size_t r = 0; r < rows; r++) {
+        const U* src_row = src + r * mat_cols;
+        U* dst_row = dst + r * num_cols;
+        for (size_t c = 0; c < num_cols; c++) {
+            dst_row[c] = (map[c] < 0) ? fill : src_row[map[c]];
+        }
+    }
+
+    return restored;
+}
+
 
 
 
@@ -87,6 +142,29 @@ matrix_reducer_t<T>::matrix_reducer_t(matrix_t<T>* mat, std::function<bool(T)> p
     reduce_cols(mat, predicate, this->map_restored_cols, this->map_reduced_cols, &this->num_reduced_cols);
 }
 
+template<typename T>
+template<typename U>
+matrix_reducer_t<T>::matrix_reducer_t(matrix_t<U>* mat, std::function<bool(U)> predicate) {
+    this->num_restored_cols = mat->get_cols();
+    this->map_restored_cols = new int[this->num_restored_cols];
+    this->map_reduced_cols = new int[this->num_restored_cols];
+    reduce_cols(mat, predicate, this->map_restored_cols, this->map_reduced_cols, &this->num_reduced_cols);
+}
+
+template<typename T>
+matrix_reducer_t<T>::matrix_reducer_t(size_t num_restored_cols, size_t num_reduced_cols, const int* map_reduced_cols) {
+    this->num_restored_cols = num_restored_cols;
+    this->num_reduced_cols = num_reduced_cols;
+    this->map_restored_cols = new int[num_restored_cols];
+    this->map_reduced_cols = new int[num_restored_cols];
+
+    std::fill(this->map_restored_cols, this->map_restored_cols + num_restored_cols, -1);
+    for (size_t i = 0; i < num_reduced_cols; i++) {
+        this->map_reduced_cols[i] = map_reduced_cols[i];
+        this->map_restored_cols[map_reduced_cols[i]] = i;
+    }
+}
+
 template<typename T>
 matrix_reducer_t<T>::~matrix_reducer_t() {
     delete[] this->map_restored_cols;
@@ -95,91 +173,22 @@ matrix_reducer_t<T>::~matrix_reducer_t() {
 
 template<typename T>
 matrix_t<T>* matrix_reducer_t<T>::reduce(const matrix_t<T>* mat) const {
-    size_t rows = mat->get_rows();
-    matrix_t<T>* reduced = new matrix_t<T>(rows, this->num_reduced_cols);
-
-    T buffer[rows];
-    for (size_t c = 0; c < this->num_reduced_cols; c++) {
-        int mapped_c = this->map_reduced_cols[c];
-
-        if (mapped_c < 0) {
-            throw eof_error_t("(Internal Error) Negative map value during reduction");
-        } else {
-            mat->get_col(mapped_c, buffer);
-            reduced->set_col(c, buffer);
-        }
-    }
-
-    return reduced;
+    return gather_cols(mat, this->map_reduced_cols, this->num_reduced_cols);
 }
 
 template<typename T>
 matrix_t<T>* matrix_reducer_t<T>::restore(const matrix_t<T>* mat, T fill) const {
-    size_t rows = mat->get_rows();
-    matrix_t<T>* restored = new matrix_t<T>(rows, this->num_restored_cols);
-
-    T fill_buffer[rows];
-    for (size_t i = 0; i < rows; i++) {
-        fill_buffer[i] = fill;
-    }
-
-    T buffer[rows];
-    for (size_t c = 0; c < this->num_restored_cols; c++) {
-        int mapped_c = this->map_restored_cols[c];
-
-        if (mapped_c < 0) {
-            restored->set_col(c, fill_buffer);
-        } else {
-            mat->get_col(mapped_c, buffer);
-            restored->set_col(c, buffer);
-        }
-    }
-
-    return restored;
+    return scatter_cols(mat, this->map_restored_cols, this->num_restored_cols, fill);
 }
+
 template<typename T>
 matrix_t<std::complex<T>>* matrix_reducer_t<T>::reduce(const matrix_t<std::complex<T>>* mat) const {
-    size_t rows = mat->get_rows();
-    matrix_t<std::complex<T>>* reduced = new matrix_t<std::complex<T>>(rows, this->num_reduced_cols);
-
-    std::complex<T> buffer[rows];
-    for (size_t c = 0; c < this->num_reduced_cols; c++) {
-        int mapped_c = this->map_reduced_cols[c];
-
-        if (mapped_c < 0) {
-            throw eof_error_t("(Internal Error) Negative map value during reduction");
-        } else {
-            mat->get_col(mapped_c, buffer);
-            reduced->set_col(c, buffer);
-        }
-    }
-
-    return reduced;
+    return gather_cols(mat, this->map_reduced_cols, this->num_reduced_cols);
 }
 
 template<typename T>
 matrix_t<std::complex<T>>* matrix_reducer_t<T>::restore(const matrix_t<std::complex<T>>* mat, std::complex<T> fill) const {
-    size_t rows = mat->get_rows();
-    matrix_t<std::complex<T>>* restored = new matrix_t<std::complex<T>>(rows, this->num_restored_cols);
-
-    std::complex<T> fill_buffer[rows];
-    for (size_t i = 0; i < rows; i++) {
-        fill_buffer[i] = fill;
-    }
-
-    std::complex<T> buffer[rows];
-    for (size_t c = 0; c < this->num_restored_cols; c++) {
-        int mapped_c = this->map_restored_cols[c];
-
-        if (mapped_c < 0) {
-            restored->set_col(c, fill_buffer);
-        } else {
-            mat->get_col(mapped_c, buffer);
-            restored->set_col(c, buffer);
-        }
-    }
-
-    return restored;
+    return scatter_cols(mat, this->map_restored_cols, this->num_restored_cols, fill);
 }
 
 template<typename T>
@@ -192,3 +201,7 @@ size_t matrix_reducer_t<T>::get_restored_cols() const {
     return this->num_restored_cols;
 }
 
+template<typename T>
+const int* matrix_reducer_t<T>::get_map_reduced_cols() const {
+    return this->map_reduced_cols;
+}
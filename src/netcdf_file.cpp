@@ -22,11 +22,27 @@
 
 extern "C" {
     #include "netcdf.h"
+
+    // Which optional features (such as Zstandard) the library was built with
+    #if defined(__has_include)
+    #if __has_include(<netcdf_meta.h>)
+    #include <netcdf_meta.h>
+    #endif
+    #endif
+
+    #if defined(NC_HAS_ZSTD) && NC_HAS_ZSTD
+    #include <netcdf_filter.h>
+    #endif
 }
 
 #include "error.hpp"
 #include "debug.hpp"
 
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <sys/stat.h>
+
 // <string> included in header
 using std::string;
 
@@ -63,6 +79,49 @@ namespace {
         return prod;
     }
 
+    /**
+     * Converts one value of NetCDF type `type` at `raw` to T
+     */
+    template<typename T>
+    T convert_value(nc_type type, const void* raw) {
+        switch (type) {
+            case NC_BYTE:   return (T) *((const signed char*) raw);
+            case NC_CHAR:   return (T) *((const char*) raw);
+            case NC_SHORT:  return (T) *((const short*) raw);
+            case NC_INT:    return (T) *((const int*) raw);
+            case NC_FLOAT:  return (T) *((const float*) raw);
+            case NC_DOUBLE: return (T) *((const double*) raw);
+            case NC_UBYTE:  return (T) *((const unsigned char*) raw);
+            case NC_USHORT: return (T) *((const unsigned short*) raw);
+            case NC_UINT:   return (T) *((const unsigned int*) raw);
+            case NC_INT64:  return (T) *((const long long*) raw);
+            case NC_UINT64: return (T) *((const unsigned long long*) raw);
+            default:
+                throw eof_error_t(string(nc_strerror(NC_EBADTYPE)));
+        }
+    }
+
+    /**
+     * The indexes of files opened for reading so far, by file and the
+     * version of it they describe
+     */
+    std::mutex indexes_mutex;
+    std::map<string, std::shared_ptr<const netcdf_index_t>> indexes;
+
+    /**
+     * Returns the key of the current version of a file among the indexes, or
+     * an empty string if it is not a local file
+     */
+    string index_key(const string filename) {
+        struct stat info;
+        if (stat(filename.c_str(), &info) != 0) {
+            return "";
+        }
+
+        return filename + ":" + std::to_string(info.st_dev) + ":" + std::to_string(info.st_ino) + ":"
+            + std::to_string(info.st_size) + ":" + std::to_string(info.st_mtim.tv_sec) + "." + std::to_string(info.st_mtim.tv_nsec);
+    }
+
 }
 
 
@@ -109,6 +168,128 @@ void netcdf_file_t::init(const string filename, netcdf_mode_t mode) {
 
     this->close_file = true;
     this->closed = false;
+
+    if (mode == NETCDF_READ) {
+        string key = index_key(filename);
+        if (key.empty()) {
+            this->index = this->build_index();
+        } else {
+            std::lock_guard<std::mutex> lock(indexes_mutex);
+            std::shared_ptr<const netcdf_index_t>& shared = indexes[key];
+            if (!shared) {
+                shared = this->build_index();
+            }
+            this->index = shared;
+        }
+    }
+}
+
+std::shared_ptr<const netcdf_index_t> netcdf_file_t::build_index() const {
+    int file_id = this->get_file_id();
+    std::shared_ptr<netcdf_index_t> index = std::make_shared<netcdf_index_t>();
+    char name[NC_MAX_NAME + 1];
+
+    int n_dims;
+    NETCDF_ERROR_CHECK(
+        nc_inq_ndims(file_id, &n_dims)
+    );
+    for (int dim = 0; dim < n_dims; dim++) {
+        netcdf_index_t::dim_info_t info;
+        NETCDF_ERROR_CHECK(
+            nc_inq_dim(file_id, dim, name, &info.len)
+        );
+        info.name = name;
+        index->dim_ids[info.name] = dim;
+        index->dims[dim] = info;
+    }
+
+    int n_vars;
+    NETCDF_ERROR_CHECK(
+        nc_inq_nvars(file_id, &n_vars)
+    );
+    for (int var = NC_GLOBAL; var < n_vars; var++) {
+        netcdf_index_t::var_info_t info;
+        int n_attrs;
+        if (var == NC_GLOBAL) {
+            info.type = NC_NAT;
+            info.chunked = false;
+            info.has_fill = false;
+            NETCDF_ERROR_CHECK(
+                nc_inq_natts(file_id, &n_attrs)
+            );
+        } else {
+            int n_var_dims;
+            NETCDF_ERROR_CHECK(
+                nc_inq_var(file_id, var, name, &info.type, &n_var_dims, nullptr, &n_attrs)
+            );
+            info.name = name;
+            info.dims.resize(n_var_dims);
+            NETCDF_ERROR_CHECK(
+                nc_inq_vardimid(file_id, var, info.dims.data())
+            );
+
+            int storage;
+            info.chunks.resize(n_var_dims);
+            NETCDF_ERROR_CHECK(
+                nc_inq_var_chunking(file_id, var, &storage, info.chunks.data())
+            );
+            info.chunked = (storage == NC_CHUNKED);
+
+            // Fills of strings and user-defined types are left to NetCDF
+            info.has_fill = false;
+            if (info.type != NC_STRING && info.type <= NC_MAX_ATOMIC_TYPE) {
+                int no_fill;
+                info.fill.resize(this->get_type_size(info.type));
+                NETCDF_ERROR_CHECK(
+                    nc_inq_var_fill(file_id, var, &no_fill, info.fill.data())
+                );
+                info.has_fill = !no_fill;
+            }
+
+            index->var_ids[info.name] = var;
+        }
+
+        for (int i = 0; i < n_attrs; i++) {
+            netcdf_index_t::attr_info_t attr;
+            NETCDF_ERROR_CHECK(
+                nc_inq_attname(file_id, var, i, name)
+            );
+            attr.name = name;
+            NETCDF_ERROR_CHECK(
+                nc_inq_att(file_id, var, name, &attr.type, &attr.len)
+            );
+            info.attrs.push_back(attr);
+        }
+
+        index->vars[var] = info;
+    }
+
+    return index;
+}
+
+const netcdf_index_t::var_info_t& netcdf_file_t::indexed_var(netcdf_var_t var) const {
+    std::map<int, netcdf_index_t::var_info_t>::const_iterator it = this->index->vars.find((int) var);
+    if (it == this->index->vars.end()) {
+        throw eof_error_t(string(nc_strerror(NC_ENOTVAR)));
+    }
+    return it->second;
+}
+
+const netcdf_index_t::dim_info_t& netcdf_file_t::indexed_dim(netcdf_dim_t dim) const {
+    std::map<int, netcdf_index_t::dim_info_t>::const_iterator it = this->index->dims.find((int) dim);
+    if (it == this->index->dims.end()) {
+        throw eof_error_t(string(nc_strerror(NC_EBADDIM)));
+    }
+    return it->second;
+}
+
+const netcdf_index_t::attr_info_t& netcdf_file_t::indexed_attr(netcdf_var_t var, const string name) const {
+    for (const netcdf_index_t::attr_info_t& attr : this->indexed_var(var).attrs) {
+        if (attr.name == name) {
+            return attr;
+        }
+    }
+    throw eof_error_t(string(nc_strerror(NC_ENOTATT)));
 }
 
 
@@ -184,6 +365,13 @@ void netcdf_file_t::end_def() {
     );
 }
 
+void netcdf_file_t::set_no_fill() {
+    int old_mode;
+    NETCDF_ERROR_CHECK(
+        nc_set_fill(this->get_file_id(), NC_NOFILL, &old_mode);
+    );
+}
+
 
 
 
@@ -193,6 +381,10 @@ void netcdf_file_t::end_def() {
 //==============================================================================
 
 bool netcdf_file_t::has_fill(netcdf_var_t var) const {
+    if (this->index && !this->indexed_var(var).fill.empty()) {
+        return this->indexed_var(var).has_fill;
+    }
+
     int no_fill;
     NETCDF_ERROR_CHECK(
         nc_inq_var_fill(this->get_file_id(), (int) var, &no_fill, nullptr)
@@ -202,16 +394,26 @@ bool netcdf_file_t::has_fill(netcdf_var_t var) const {
 
 template<typename T>
 T netcdf_file_t::get_fill(netcdf_var_t var) const {
+    if (this->index && !this->indexed_var(var).fill.empty()) {
+        const netcdf_index_t::var_info_t& info = this->indexed_var(var);
+        if (!info.has_fill) {
+            throw eof_error_t("This variable does not have a fill value.");
+        }
+
+        return convert_value<T>(info.type, info.fill.data());
+    }
+
+    // The fill value is in the variable's own type, which may not be T
     int no_fill;
-    T fill_value;
+    long long raw[2];
     NETCDF_ERROR_CHECK(
-        nc_inq_var_fill(this->get_file_id(), (int) var, &no_fill, (void*) &fill_value)
+        nc_inq_var_fill(this->get_file_id(), (int) var, &no_fill, (void*) raw)
     );
     if (no_fill) {
         throw eof_error_t("This variable does not have a fill value.");
     }
 
-    return fill_value;
+    return convert_value<T>(this->get_var_type(var), raw);
 }
 
 template
@@ -226,6 +428,9 @@ float netcdf_file_t::get_fill<float>(netcdf_var_t var) const;
 template
 double netcdf_file_t::get_fill<double>(netcdf_var_t var) const;
 
+template
+short netcdf_file_t::get_fill<short>(netcdf_var_t var) const;
+
 
 
 template<>
@@ -259,6 +464,10 @@ void netcdf_file_t::set_fill<double>(netcdf_var_t var, const double fill_value,
 
 
 size_t netcdf_file_t::get_n_attrs(netcdf_var_t var) const {
+    if (this->index) {
+        return this->indexed_var(var).attrs.size();
+    }
+
     int n;
     NETCDF_ERROR_CHECK(
         nc_inq_varnatts(this->get_file_id(), (int) var, &n);
@@ -267,6 +476,15 @@ size_t netcdf_file_t::get_n_attrs(netcdf_var_t var) const {
 }
 
 bool netcdf_file_t::has_attr(netcdf_var_t var, const string name) const {
+    if (this->index) {
+        for (const netcdf_index_t::attr_info_t& attr : this->indexed_var(var).attrs) {
+            if (attr.name == name) {
+                return true;
+            }
+        }
+        return false;
+    }
+
     int attr;
     int status = nc_inq_attid(this->get_file_id(), (int) var, name.c_str(), &attr);
     if (status == NC_NOERR) {
@@ -280,7 +498,15 @@ bool netcdf_file_t::has_attr(netcdf_var_t var, const string name) const {
 }
 
 string netcdf_file_t::get_attr(netcdf_var_t var, int index) const {
-    char* name = new char[NC_MAX_NAME + 1];
+    if (this->index) {
+        const netcdf_index_t::var_info_t& info = this->indexed_var(var);
+        if (index < 0 || (size_t) index >= info.attrs.size()) {
+            throw eof_error_t(string(nc_strerror(NC_ENOTATT)));
+        }
+        return info.attrs[index].name;
+    }
+
+    char name[NC_MAX_NAME + 1];
     NETCDF_ERROR_CHECK(
         nc_inq_attname(this->get_file_id(), (int) var, index, name);
     );
@@ -294,6 +520,10 @@ void netcdf_file_t::set_attr(netcdf_var_t var, const string name, nc_type type,
 }
 
 nc_type netcdf_file_t::get_attr_type(netcdf_var_t var, const string name) const {
+    if (this->index) {
+        return this->indexed_attr(var, name).type;
+    }
+
     nc_type type;
     NETCDF_ERROR_CHECK(
         nc_inq_atttype(this->get_file_id(), (int) var, name.c_str(), &type)
@@ -302,6 +532,10 @@ nc_type netcdf_file_t::get_attr_type(netcdf_var_t var, const string name) const
 }
 
 size_t netcdf_file_t::get_attr_len(netcdf_var_t var, const string name) const {
+    if (this->index) {
+        return this->indexed_attr(var, name).len;
+    }
+
     size_t length;
     NETCDF_ERROR_CHECK(
         nc_inq_attlen(this->get_file_id(), (int) var, name.c_str(), &length)
@@ -320,7 +554,24 @@ void* netcdf_file_t::get_attr_val(netcdf_var_t var, const string name) const {
     return buffer;
 }
 
+double netcdf_file_t::get_attr_double(netcdf_var_t var, const string name) const {
+    size_t length = this->get_attr_len(var, name);
+    if (length == 0) {
+        throw eof_error_t("Attribute \"" + name + "\" has no values");
+    }
+
+    std::vector<double> values(length);
+    NETCDF_ERROR_CHECK(
+        nc_get_att_double(this->get_file_id(), (int) var, name.c_str(), values.data())
+    );
+    return values[0];
+}
+
 size_t netcdf_file_t::get_n_attrs() const {
+    if (this->index) {
+        return this->get_n_attrs((netcdf_var_t) NC_GLOBAL);
+    }
+
     int n;
     NETCDF_ERROR_CHECK(
         nc_inq_natts(this->get_file_id(), &n);
@@ -358,6 +609,10 @@ void* netcdf_file_t::get_attr_val(const string name) const {
 //==============================================================================
 
 bool netcdf_file_t::has_dim(const string name) const {
+    if (this->index) {
+        return this->index->dim_ids.count(name) > 0;
+    }
+
     int dim;
     int status = nc_inq_dimid(this->get_file_id(), name.c_str(), &dim);
     if (status == NC_NOERR) {
@@ -371,6 +626,14 @@ bool netcdf_file_t::has_dim(const string name) const {
 }
 
 netcdf_dim_t netcdf_file_t::get_dim(const string name) const {
+    if (this->index) {
+        std::map<string, int>::const_iterator it = this->index->dim_ids.find(name);
+        if (it == this->index->dim_ids.end()) {
+            throw eof_error_t(string(nc_strerror(NC_EBADDIM)));
+        }
+        return (netcdf_dim_t) it->second;
+    }
+
     int dim;
     NETCDF_ERROR_CHECK(
         nc_inq_dimid(this->get_file_id(), name.c_str(), &dim)
@@ -379,6 +642,10 @@ netcdf_dim_t netcdf_file_t::get_dim(const string name) const {
 }
 
 string netcdf_file_t::get_dim_name(netcdf_dim_t dim) const {
+    if (this->index) {
+        return this->indexed_dim(dim).name;
+    }
+
     char cname[NC_MAX_NAME + 1];
     NETCDF_ERROR_CHECK(
         nc_inq_dimname(this->get_file_id(), (int) dim, cname)
@@ -387,6 +654,10 @@ string netcdf_file_t::get_dim_name(netcdf_dim_t dim) const {
 }
 
 size_t netcdf_file_t::get_dim_len(netcdf_dim_t dim) const {
+    if (this->index) {
+        return this->indexed_dim(dim).len;
+    }
+
     size_t len;
     NETCDF_ERROR_CHECK(
         nc_inq_dimlen(this->get_file_id(), (int) dim, &len)
@@ -411,6 +682,10 @@ netcdf_dim_t netcdf_file_t::def_dim(const string name, size_t len) {
 //==============================================================================
 
 int netcdf_file_t::get_n_vars() const {
+    if (this->index) {
+        return (int) this->index->var_ids.size();
+    }
+
     int n_vars;
     NETCDF_ERROR_CHECK(
         nc_inq_nvars(this->get_file_id(), &n_vars)
@@ -419,6 +694,10 @@ int netcdf_file_t::get_n_vars() const {
 }
 
 bool netcdf_file_t::has_var(const string name) const {
+    if (this->index) {
+        return this->index->var_ids.count(name) > 0;
+    }
+
     int var;
     int status = nc_inq_varid(this->get_file_id(), name.c_str(), &var);
     if (status == NC_NOERR) {
@@ -432,6 +711,14 @@ bool netcdf_file_t::has_var(const string name) const {
 }
 
 netcdf_var_t netcdf_file_t::get_var(const string name) const {
+    if (this->index) {
+        std::map<string, int>::const_iterator it = this->index->var_ids.find(name);
+        if (it == this->index->var_ids.end()) {
+            throw eof_error_t(string(nc_strerror(NC_ENOTVAR)));
+        }
+        return (netcdf_var_t) it->second;
+    }
+
     int var;
     NETCDF_ERROR_CHECK(
         nc_inq_varid(this->get_file_id(), name.c_str(), &var)
@@ -440,6 +727,10 @@ netcdf_var_t netcdf_file_t::get_var(const string name) const {
 }
 
 string netcdf_file_t::get_var_name(netcdf_var_t var) const {
+    if (this->index) {
+        return this->indexed_var(var).name;
+    }
+
     char cname[NC_MAX_NAME + 1];
     NETCDF_ERROR_CHECK(
         nc_inq_varname(this->get_file_id(), (int) var, cname)
@@ -448,7 +739,23 @@ string netcdf_file_t::get_var_name(netcdf_var_t var) const {
     return name;
 }
 
+nc_type netcdf_file_t::get_var_type(netcdf_var_t var) const {
+    if (this->index) {
+        return this->indexed_var(var).type;
+    }
+
+    nc_type type;
+    NETCDF_ERROR_CHECK(
+        nc_inq_vartype(this->get_file_id(), (int) var, &type)
+    );
+    return type;
+}
+
 int netcdf_file_t::get_var_n_dims(netcdf_var_t var) const {
+    if (this->index) {
+        return (int) this->indexed_var(var).dims.size();
+    }
+
     int n_dims;
     NETCDF_ERROR_CHECK(
         nc_inq_varndims(this->get_file_id(), (int) var, &n_dims)
@@ -457,6 +764,10 @@ int netcdf_file_t::get_var_n_dims(netcdf_var_t var) const {
 }
 
 netcdf_dim_t netcdf_file_t::get_var_dim(netcdf_var_t var, int i) const {
+    if (this->index) {
+        return (netcdf_dim_t) this->indexed_var(var).dims.at(i);
+    }
+
     int dims[this->get_var_n_dims(var)];
     NETCDF_ERROR_CHECK(
         nc_inq_vardimid(this->get_file_id(), (int) var, dims)
@@ -465,6 +776,15 @@ netcdf_dim_t netcdf_file_t::get_var_dim(netcdf_var_t var, int i) const {
 }
 
 netcdf_dim_t* netcdf_file_t::get_var_dims(netcdf_var_t var) const {
+    if (this->index) {
+        const std::vector<int>& indexed = this->indexed_var(var).dims;
+        netcdf_dim_t* dims = new netcdf_dim_t[indexed.size()];
+        for (size_t i = 0; i < indexed.size(); i++) {
+            dims[i] = (netcdf_dim_t) indexed[i];
+        }
+        return dims;
+    }
+
     int* dims = new int[this->get_var_n_dims(var)];
     NETCDF_ERROR_CHECK(
         nc_inq_vardimid(this->get_file_id(), (int) var, dims)
@@ -473,6 +793,14 @@ netcdf_dim_t* netcdf_file_t::get_var_dims(netcdf_var_t var) const {
 }
 
 size_t netcdf_file_t::get_var_len(netcdf_var_t var) const {
+    if (this->index) {
+        size_t len = 1;
+        for (int dim : this->indexed_var(var).dims) {
+            len *= this->indexed_dim((netcdf_dim_t) dim).len;
+        }
+        return len;
+    }
+
     size_t n_dims = this->get_var_n_dims(var);
     int dim_ids[n_dims];
     size_t dim_lens[n_dims];
@@ -496,6 +824,99 @@ string netcdf_file_t::get_var_dim_name(netcdf_var_t var, int i) const {
     return this->get_dim_name(this->get_var_dim(var, i));
 }
 
+bool netcdf_file_t::get_var_chunking(netcdf_var_t var, size_t* chunks) const {
+    if (this->index) {
+        const netcdf_index_t::var_info_t& info = this->indexed_var(var);
+        std::copy(info.chunks.begin(), info.chunks.end(), chunks);
+        return info.chunked;
+    }
+
+    int storage;
+    NETCDF_ERROR_CHECK(
+        nc_inq_var_chunking(this->get_file_id(), (int) var, &storage, chunks)
+    );
+    return storage == NC_CHUNKED;
+}
+
+bool netcdf_file_t::get_complex_compound(netcdf_var_t var, nc_type* part_type) const {
+    nc_type type = this->get_var_type(var);
+    if (type <= NC_MAX_ATOMIC_TYPE) {
+        return false;
+    }
+
+    size_t size;
+    size_t num_fields;
+    int type_class;
+    NETCDF_ERROR_CHECK(
+        nc_inq_user_type(this->get_file_id(), type, NULL, &size, NULL, &num_fields, &type_class)
+    );
+    if (type_class != NC_COMPOUND || num_fields != 2) {
+        return false;
+    }
+
+    // Both parts must be scalars of one floating-point type, packed one
+    // after the other, so that the values can be read as pairs
+    size_t offsets[2];
+    nc_type field_types[2];
+    int field_dims[2];
+    for (int i = 0; i < 2; i++) {
+        NETCDF_ERROR_CHECK(
+            nc_inq_compound_field(this->get_file_id(), type, i, NULL, &offsets[i], &field_types[i], &field_dims[i], NULL)
+        );
+    }
+
+    if (field_types[0] != field_types[1] || (field_types[0] != NC_FLOAT && field_types[0] != NC_DOUBLE) ||
+            field_dims[0] != 0 || field_dims[1] != 0) {
+        return false;
+    }
+
+    size_t part_size = this->get_type_size(field_types[0]);
+    if (offsets[0] != 0 || offsets[1] != part_size || size != 2 * part_size) {
+        return false;
+    }
+
+    *part_type = field_types[0];
+    return true;
+}
+
+void netcdf_file_t::set_var_chunk_cache(netcdf_var_t var, size_t size, size_t nelems, float preemption) const {
+    NETCDF_ERROR_CHECK(
+        nc_set_var_chunk_cache(this->get_file_id(), (int) var, size, nelems, preemption)
+    );
+}
+
+void netcdf_file_t::set_var_chunking(netcdf_var_t var, const size_t* chunks) {
+    NETCDF_ERROR_CHECK(
+        nc_def_var_chunking(this->get_file_id(), (int) var, NC_CHUNKED, chunks)
+    );
+}
+
+void netcdf_file_t::set_var_deflate(netcdf_var_t var, bool shuffle, int level) {
+    NETCDF_ERROR_CHECK(
+        nc_def_var_deflate(this->get_file_id(), (int) var, shuffle ? 1 : 0, level > 0 ? 1 : 0, level)
+    );
+}
+
+void netcdf_file_t::set_var_zstandard(netcdf_var_t var, int level) {
+#if defined(NC_HAS_ZSTD) && NC_HAS_ZSTD
+    NETCDF_ERROR_CHECK(
+        nc_def_var_zstandard(this->get_file_id(), (int) var, level)
+    );
+#else
+    throw eof_error_t("This NetCDF library was built without Zstandard compression.");
+#endif
+}
+
+void netcdf_file_t::set_var_bitround(netcdf_var_t var, int bits) {
+#ifdef NC_QUANTIZE_BITROUND
+    NETCDF_ERROR_CHECK(
+        nc_def_var_quantize(this->get_file_id(), (int) var, NC_QUANTIZE_BITROUND, bits)
+    );
+#else
+    throw eof_error_t("This NetCDF library does not support quantization.");
+#endif
+}
+
 template<>
 netcdf_var_t netcdf_file_t::def_var<int>(const string name, size_t n_dims, const netcdf_dim_t* dim_ids) {
     int var;
@@ -664,3 +1085,115 @@ double* netcdf_file_t::get_var_vals<double>(netcdf_var_t var, const size_t* star
     return vals;
 }
 
+template<>
+void netcdf_file_t::get_var_vals<int>(netcdf_var_t var, const size_t* start, const size_t* count, int* vals) const {
+    NETCDF_ERROR_CHECK(
+        nc_get_vara_int(this->get_file_id(), (int) var, start, count, vals)
+    );
+}
+
+template<>
+void netcdf_file_t::get_var_vals<long>(netcdf_var_t var, const size_t* start, const size_t* count, long* vals) const {
+    NETCDF_ERROR_CHECK(
+        nc_get_vara_long(this->get_file_id(), (int) var, start, count, vals)
+    );
+}
+
+template<>
+void netcdf_file_t::get_var_vals<float>(netcdf_var_t var, const size_t* start, const size_t* count, float* vals) const {
+    NETCDF_ERROR_CHECK(
+        nc_get_vara_float(this->get_file_id(), (int) var, start, count, vals)
+    );
+}
+
+template<>
+void netcdf_file_t::get_var_vals<double>(netcdf_var_t var, const size_t* start, const size_t* count, double* vals) const {
+    NETCDF_ERROR_CHECK(
+        nc_get_vara_double(this->get_file_id(), (int) var, start, count, vals)
+    );
+}
+
+template<>
+short* netcdf_file_t::get_var_vals<short>(netcdf_var_t var) const {
+    short* vals = new short[this->get_var_len(var)];
+    NETCDF_ERROR_CHECK(
+        nc_get_var_short(this->get_file_id(), (int) var, vals)
+    );
+    return vals;
+}
+
+template<>
+short* netcdf_file_t::get_var_vals<short>(netcdf_var_t var, const size_t* start, const size_t* count) const {
+    size_t size = product(this->get_var_n_dims(var), count);
+    short* vals = new short[size];
+    NETCDF_ERROR_CHECK(
+        nc_get_vara_short(this->get_file_id(), (int) var, start, count, vals)
+    );
+    return vals;
+}
+
+template<>
+void netcdf_file_t::get_var_vals<short>(netcdf_var_t var, const size_t* start, const size_t* count, short* vals) const {
+    NETCDF_ERROR_CHECK(
+        nc_get_vara_short(this->get_file_id(), (int) var, start, count, vals)
+    );
+}
+
+template<>
+void netcdf_file_t::get_var_vals<int>(netcdf_var_t var, const size_t* start, const size_t* count, const size_t* stride, int* vals) const {
+    size_t n_dims = this->get_var_n_dims(var);
+    ptrdiff_t strides[n_dims];
+    std::copy(stride, stride + n_dims, strides);
+    NETCDF_ERROR_CHECK(
+        nc_get_vars_int(this->get_file_id(), (int) var, start, count, strides, vals)
+    );
+}
+
+template<>
+void netcdf_file_t::get_var_vals<long>(netcdf_var_t var, const size_t* start, const size_t* count, const size_t* stride, long* vals) const {
+    size_t n_dims = this->get_var_n_dims(var);
+    ptrdiff_t strides[n_dims];
+    std::copy(stride, stride + n_dims, strides);
+    NETCDF_ERROR_CHECK(
+        nc_get_vars_long(this->get_file_id(), (int) var, start, count, strides, vals)
+    );
+}
+
+template<>
+void netcdf_file_t::get_var_vals<float>(netcdf_var_t var, const size_t* start, const size_t* count, const size_t* stride, float* vals) const {
+    size_t n_dims = this->get_var_n_dims(var);
+    ptrdiff_t strides[n_dims];
+    std::copy(stride, stride + n_dims, strides);
+    NETCDF_ERROR_CHECK(
+        nc_get_vars_float(this->get_file_id(), (int) var, start, count, strides, vals)
+    );
+}
+
+template<>
+void netcdf_file_t::get_var_vals<double>(netcdf_var_t var, const size_t* start, const size_t* count, const size_t* stride, double* vals) const {
+    size_t n_dims = this->get_var_n_dims(var);
+    ptrdiff_t strides[n_dims];
+    std::copy(stride, stride + n_dims, strides);
+    NETCDF_ERROR_CHECK(
+        nc_get_vars_double(this->get_file_id(), (int) var, start, count, strides, vals)
+    );
+}
+
+template<>
+void netcdf_file_t::get_var_vals<short>(netcdf_var_t var, const size_t* start, const size_t* count, const size_t* stride, short* vals) const {
+    size_t n_dims = this->get_var_n_dims(var);
+    ptrdiff_t strides[n_dims];
+    std::copy(stride, stride + n_dims, strides);
+    NETCDF_ERROR_CHECK(
+        nc_get_vars_short(this->get_file_id(), (int) var, start, count, strides, vals)
+    );
+}
+
+void netcdf_file_t::get_var_raw(netcdf_var_t var, const size_t* start, const size_t* count, const size_t* stride, void* vals) const {
+    size_t n_dims = this->get_var_n_dims(var);
+    ptrdiff_t strides[n_dims];
+    std::copy(stride, stride + n_dims, strides);
+    NETCDF_ERROR_CHECK(
+        nc_get_vars(this->get_file_id(), (int) var, start, count, strides, vals)
+    );
+}
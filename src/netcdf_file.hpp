@@ -27,6 +27,10 @@ using std::string;
 #include <fstream>
 #include <netcdf.h>
 
+#include <map>
+#include <memory>
+#include <vector>
+
 #include "wrapper_type.hpp"
 
 
@@ -67,6 +71,54 @@ WRAPPER_TYPE(netcdf_dim_t, int)
  */
 WRAPPER_TYPE(netcdf_var_t, int)
 
+/**
+ * The attribute holding the fill (missing) value of a variable
+ */
+static const std::string MISSING_VALUE_NAME = "_FillValue";
+
+/**
+ * The attribute of a CF list variable naming the dimensions it gathers
+ * ("compression by gathering")
+ */
+static const std::string COMPRESS_ATTR_NAME = "compress";
+
+/**
+ * Everything netcdf_file_t looks up about the metadata of a file: the names,
+ * IDs and lengths of its dimensions, and the names, IDs, types, dimensions,
+ * attributes, chunking and fill values of its variables. It is read once
+ * when a file is opened for reading, and shared by every netcdf_file_t that
+ * opens the same (unchanged) file.
+ */
+struct netcdf_index_t {
+    struct dim_info_t {
+        std::string name;
+        size_t len;
+    };
+
+    struct attr_info_t {
+        std::string name;
+        nc_type type;
+        size_t len;
+    };
+
+    /** A variable or, under the ID NC_GLOBAL, the file's global attributes */
+    struct var_info_t {
+        std::string name;
+        nc_type type;
+        std::vector<int> dims;
+        std::vector<attr_info_t> attrs;
+        bool chunked;
+        std::vector<size_t> chunks;
+        bool has_fill;
+        std::vector<char> fill;
+    };
+
+    std::map<std::string, int> dim_ids;
+    std::map<int, dim_info_t> dims;
+    std::map<std::string, int> var_ids;
+    std::map<int, var_info_t> vars;
+};
+
 
 
 
@@ -96,6 +148,12 @@ private:
      */
     bool closed;
 
+    /**
+     * The metadata of a file opened for reading, which all lookups use. Files
+     * that can be written are always asked directly, since they may change.
+     */
+    std::shared_ptr<const netcdf_index_t> index;
+
 
 
 
@@ -105,6 +163,19 @@ private:
      */
     void init(const std::string filename, netcdf_mode_t mode);
 
+    /**
+     * Reads the metadata of this file into a new index
+     */
+    std::shared_ptr<const netcdf_index_t> build_index() const;
+
+    /**
+     * Returns what the index knows of a variable (or NC_GLOBAL), dimension
+     * or attribute, throwing the error NetCDF would if there is no such thing
+     */
+    const netcdf_index_t::var_info_t& indexed_var(netcdf_var_t var) const;
+    const netcdf_index_t::dim_info_t& indexed_dim(netcdf_dim_t dim) const;
+    const netcdf_index_t::attr_info_t& indexed_attr(netcdf_var_t var, const std::string name) const;
+
 
 
 
@@ -172,6 +243,12 @@ public:
      */
     void end_def();
 
+    /**
+     * Stop prefilling variables defined from now on with fill values, for
+     * when every value is going to be written anyway
+     */
+    void set_no_fill();
+
 
 
 
@@ -186,7 +263,8 @@ public:
     bool has_fill(netcdf_var_t var) const;
 
     /**
-     * Returns the fill value of a variable
+     * Returns the fill value of a variable, converted to T from the
+     * variable's own type
      */
     template<typename T>
     T get_fill(netcdf_var_t var) const;
@@ -235,6 +313,11 @@ public:
      */
     void* get_attr_val(netcdf_var_t var, const string name) const;
 
+    /**
+     * Returns the first value of a numeric attribute, converted to double
+     */
+    double get_attr_double(netcdf_var_t var, const string name) const;
+
     /**
      * Returns the number of global attributes present, including _FillValue and missing_value
      */
@@ -329,6 +412,11 @@ public:
      */
     std::string get_var_name(netcdf_var_t var) const;
 
+    /**
+     * Returns the type of the variable represented by var as an nc_type
+     */
+    nc_type get_var_type(netcdf_var_t var) const;
+
     /**
      * Returns the number of dimensions of the variable represented by var
      */
@@ -363,6 +451,54 @@ public:
      */
     std::string get_var_dim_name(netcdf_var_t var, int i) const;
 
+    /**
+     * Returns whether the variable represented by var is stored in chunks
+     * and, if so, writes the chunk length in each of its dimensions to chunks
+     */
+    bool get_var_chunking(netcdf_var_t var, size_t* chunks) const;
+
+    /**
+     * Returns whether the variable represented by var holds complex values as
+     * a compound type of two members of the same floating-point type (the
+     * real part first, then the imaginary part) and, if so, writes that type
+     * to part_type
+     */
+    bool get_complex_compound(netcdf_var_t var, nc_type* part_type) const;
+
+    /**
+     * Sets the size (in bytes), number of hash slots, and preemption (between
+     * 0 and 1) of the chunk cache of the variable represented by var. Only
+     * has an effect on chunked variables.
+     */
+    void set_var_chunk_cache(netcdf_var_t var, size_t size, size_t nelems, float preemption) const;
+
+    /**
+     * Stores the variable represented by var in chunks of the given length in
+     * each of its dimensions. Must be in define mode (begin_def)
+     */
+    void set_var_chunking(netcdf_var_t var, const size_t* chunks);
+
+    /**
+     * Turns on the shuffle filter and/or deflate compression at the given
+     * level (1-9, or 0 for none) for the variable represented by var. Must be
+     * in define mode (begin_def)
+     */
+    void set_var_deflate(netcdf_var_t var, bool shuffle, int level);
+
+    /**
+     * Turns on Zstandard compression at the given level for the variable
+     * represented by var. Must be in define mode (begin_def), and the NetCDF
+     * library must have been built with Zstandard
+     */
+    void set_var_zstandard(netcdf_var_t var, int level);
+
+    /**
+     * Rounds the values written to the variable represented by var to the
+     * given number of significant bits, so they compress better. Must be in
+     * define mode (begin_def), and the NetCDF library must support quantization
+     */
+    void set_var_bitround(netcdf_var_t var, int bits);
+
     /**
      * Define a new variable with the specified name, number of dimensions, and
      * dimension objects. Must be in define mode (begin_def)
@@ -400,6 +536,28 @@ public:
     template<typename T>
     T* get_var_vals(netcdf_var_t var, const size_t* start, const size_t* count) const;
 
+    /**
+     * Reads selected values of the variable represented by var into the
+     * caller's array vals, which must hold the product of count values
+     */
+    template<typename T>
+    void get_var_vals(netcdf_var_t var, const size_t* start, const size_t* count, T* vals) const;
+
+    /**
+     * Reads the values of the variable represented by var from start, count
+     * in each dimension, stride apart (as in nc_get_vars), into the caller's
+     * array vals, which must hold the product of count values
+     */
+    template<typename T>
+    void get_var_vals(netcdf_var_t var, const size_t* start, const size_t* count, const size_t* stride, T* vals) const;
+
+    /**
+     * Reads values of the variable represented by var, as get_var_vals does
+     * but in whatever type they are stored in (such as a compound type), into
+     * the caller's buffer vals
+     */
+    void get_var_raw(netcdf_var_t var, const size_t* start, const size_t* count, const size_t* stride, void* vals) const;
+
 };
 
 #endif
@@ -0,0 +1,83 @@
+/***********************************************************************
+ *                   GNU Lesser General Public License
+ *
+ * This file is part of the EDGI prototype package, developed by the
+ * GFDL Flexible Modeling System (FMS) group.
+ *
+ * EDGI is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * EDGI is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with EDGI.  If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************/
+
+#include "netcdf_writer.hpp"
+
+// <string> included in header
+using std::string;
+
+
+
+
+
+//==============================================================================
+// Constructors and destructors
+//==============================================================================
+
+netcdf_writer_t::netcdf_writer_t(netcdf_file_t* file) : file(file) {}
+
+
+
+
+
+//==============================================================================
+// Public Methods
+//==============================================================================
+
+/**
+ * Sets how the variables added from now on (but not their coordinate
+ * variables) are chunked and compressed
+ */
+void netcdf_writer_t::set_storage(const output_storage_t& storage) {
+    this->storage = storage;
+}
+
+/**
+ * Plans a global attribute
+ */
+void netcdf_writer_t::add_attr(const attribute_t* attr) {
+    this->defines.push_back([this, attr]() {
+        this->file->set_attr(attr->get_name(), attr->get_type(), attr->get_length(), attr->get_value());
+    });
+}
+
+/**
+ * Defines everything planned so far in one define phase, then writes all the
+ * values and synchronizes the file once. Every value of every new variable
+ * is written, so the variables are not prefilled.
+ */
+void netcdf_writer_t::commit() {
+    if (!this->defines.empty()) {
+        this->file->begin_def();
+        this->file->set_no_fill();
+        for (std::function<void()>& define : this->defines) {
+            define();
+        }
+        this->file->end_def();
+    }
+
+    for (std::function<void()>& write : this->writes) {
+        write();
+    }
+    this->file->sync();
+
+    this->defines.clear();
+    this->writes.clear();
+}
@@ -0,0 +1,174 @@
+/***********************************************************************
+ *                   GNU Lesser General Public License
+ *
+ * This file is part of the EDGI prototype package, developed by the
+ * GFDL Flexible Modeling System (FMS) group.
+ *
+ * EDGI is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * EDGI is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with EDGI.  If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************/
+
+#ifndef NETCDF_WRITER_HPP
+#define NETCDF_WRITER_HPP
+
+/** Use netcdf_file_t, netcdf_dim_t, netcdf_var_t */
+#include "netcdf_file.hpp"
+
+/** Use attribute_t */
+#include "attribute.hpp"
+
+/** Use dimension_t */
+#include "dimension.hpp"
+
+/** Use std::complex */
+#include <complex>
+
+/** Use std::function */
+#include <functional>
+
+/** Use std::map */
+#include <map>
+
+/** Use std::string */
+#include <string>
+
+/** Use std::vector */
+#include <vector>
+
+template<typename S, typename T>
+class variable_t;
+
+
+
+
+
+//==============================================================================
+// Declaration
+//==============================================================================
+
+/**
+ * How the values of output variables are laid out and compressed. The
+ * defaults leave everything to the NetCDF library.
+ */
+struct output_storage_t {
+    /** Compression codec: "none", "deflate" or "zstd" */
+    std::string codec = "none";
+
+    /** Compression level of the codec */
+    int level = 0;
+
+    /** Shuffle the bytes of values before compressing them? */
+    bool shuffle = false;
+
+    /** Significant bits kept in each value (bit-rounding), or 0 to keep all */
+    int keep_bits = 0;
+
+    /**
+     * Store one step of this dimension per chunk, spanning all the others,
+     * in variables that have it. Empty to keep the default chunking.
+     */
+    std::string chunk_dim = "";
+};
+
+/**
+ * Writes a batch of variables and attributes to a NetCDF file. Everything
+ * added is only planned at first; commit() then defines all of it in a
+ * single define phase, with prefilling turned off, writes each variable's
+ * values in as few calls as possible, and synchronizes the file once.
+ *
+ * Variables (and their dimensions and attributes) are read when they are
+ * committed, not when they are added, so they must outlive the commit.
+ */
+class netcdf_writer_t {
+public:
+    /** Most bytes of each part of a complex variable separated at once (4 MiB) */
+    static const size_t COMPLEX_BLOCK_BYTES = 4 * 1024 * 1024;
+
+private:
+    //==========================================================================
+    // Private Fields
+    //==========================================================================
+
+    netcdf_file_t* file;
+
+    /** The IDs of dimensions and variables, once they are defined */
+    std::map<std::string, netcdf_dim_t> dim_ids;
+    std::map<std::string, netcdf_var_t> var_ids;
+
+    /** Run in order in the define phase, then in order after it */
+    std::vector<std::function<void()>> defines;
+    std::vector<std::function<void()>> writes;
+
+    /** How variables added from now on are stored */
+    output_storage_t storage;
+
+
+
+    //==========================================================================
+    // Private Methods
+    //==========================================================================
+
+    template<typename O>
+    void plan_attrs(const std::string var_name, const O* owner);
+
+    template<typename T>
+    void plan_dim(const dimension_t<T>* dim);
+
+    template<typename E, typename S, typename T>
+    void plan_var(const std::string name, const variable_t<S, T>* var, bool has_fill, E fill);
+
+    template<typename S, typename T>
+    void apply_storage(netcdf_var_t var_id, const variable_t<S, T>* var, const output_storage_t& storage);
+
+    template<typename S, typename T>
+    void write_values(netcdf_var_t var_id, const variable_t<S, T>* var);
+
+    template<typename S, typename T>
+    void write_complex_values(netcdf_var_t var_id_re, netcdf_var_t var_id_im, const variable_t<std::complex<S>, T>* var);
+
+
+
+public:
+    //==========================================================================
+    // Public Methods
+    //==========================================================================
+
+    netcdf_writer_t(netcdf_file_t* file);
+
+    void set_storage(const output_storage_t& storage);
+
+    void add_attr(const attribute_t* attr);
+
+    template<typename T>
+    void add_dim(const dimension_t<T>* dim);
+
+    template<typename S, typename T>
+    void add(const variable_t<S, T>* var, const std::string name);
+
+    template<typename S, typename T>
+    void add_complex(const variable_t<std::complex<S>, T>* var, const std::string name_re, const std::string name_im);
+
+    void commit();
+};
+
+
+
+
+
+//==============================================================================
+// Implementation
+//==============================================================================
+
+#include "netcdf_writer.tpp"
+
+#endif
@@ -0,0 +1,306 @@
+/***********************************************************************
+ *                   GNU Lesser General Public License
+ *
+ * This file is part of the EDGI prototype package, developed by the
+ * GFDL Flexible Modeling System (FMS) group.
+ *
+ * EDGI is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * EDGI is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with EDGI.  If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************/
+
+// Note: This is not intended to be a standalone implementation file.
+
+#include "error.hpp"
+
+/** Use std::min */
+#include <algorithm>
+
+
+
+
+
+//==============================================================================
+// Private Methods
+//==============================================================================
+
+/**
+ * Plans the attributes of `owner` (a variable or dimension) on the variable
+ * `var_name`, skipping any the file already has
+ */
+template<typename O>
+void netcdf_writer_t::plan_attrs(const std::string var_name, const O* owner) {
+    for (size_t i = 0; i < owner->get_num_attrs(); i++) {
+        const attribute_t* attr = owner->get_attr(i);
+        this->defines.push_back([this, var_name, attr]() {
+            netcdf_var_t var_id = this->var_ids.at(var_name);
+            if (!this->file->has_attr(var_id, attr->get_name())) {
+                this->file->set_attr(var_id, attr->get_name(), attr->get_type(), attr->get_length(), attr->get_value());
+            }
+        });
+    }
+}
+
+/**
+ * Plans a dimension and its coordinate variable, unless they are already
+ * planned. Either may already be in the file. The coordinate variable of a
+ * CF list dimension (with a "compress" attribute) holds indices, so it is
+ * written as integers.
+ */
+template<typename T>
+void netcdf_writer_t::plan_dim(const dimension_t<T>* dim) {
+    std::string name = dim->get_name();
+
+    if (this->dim_ids.count(name) == 0) {
+        if (this->file->has_dim(name)) {
+            this->dim_ids[name] = this->file->get_dim(name);
+        } else {
+            size_t size = dim->get_size();
+            this->dim_ids[name] = netcdf_dim_t(-1);
+            this->defines.push_back([this, name, size]() {
+                this->dim_ids[name] = this->file->def_dim(name, size);
+            });
+        }
+    }
+
+    if (this->var_ids.count(name) == 0) {
+        bool is_list = dim->has_attr(COMPRESS_ATTR_NAME);
+        if (this->file->has_var(name)) {
+            this->var_ids[name] = this->file->get_var(name);
+        } else {
+            this->var_ids[name] = netcdf_var_t(-1);
+            this->defines.push_back([this, name, is_list]() {
+                netcdf_dim_t dim_id = this->dim_ids.at(name);
+                if (is_list) {
+                    this->var_ids[name] = this->file->def_var<int>(name, 1, &dim_id);
+                } else {
+                    this->var_ids[name] = this->file->def_var<T>(name, 1, &dim_id);
+                }
+            });
+            this->plan_attrs(name, dim);
+        }
+
+        this->writes.push_back([this, name, dim, is_list]() {
+            if (is_list) {
+                std::vector<int> indices(dim->get_values(), dim->get_values() + dim->get_size());
+                this->file->set_var_vals<int>(this->var_ids.at(name), indices.data());
+            } else {
+                this->file->set_var_vals<T>(this->var_ids.at(name), dim->get_values());
+            }
+        });
+    }
+}
+
+/**
+ * Plans a variable named `name` with the shape and attributes of `var`, and
+ * values of type E, unless it is already planned or in the file
+ */
+template<typename E, typename S, typename T>
+void netcdf_writer_t::plan_var(const std::string name, const variable_t<S, T>* var, bool has_fill, E fill) {
+    std::vector<std::string> dim_names;
+    for (size_t i = 0; i < var->get_num_dims(); i++) {
+        this->plan_dim(var->get_dim(i));
+        dim_names.push_back(var->get_dim(i)->get_name());
+    }
+
+    if (this->var_ids.count(name) == 0) {
+        if (this->file->has_var(name)) {
+            this->var_ids[name] = this->file->get_var(name);
+        } else {
+            this->var_ids[name] = netcdf_var_t(-1);
+            output_storage_t storage = this->storage;
+            this->defines.push_back([this, name, var, dim_names, has_fill, fill, storage]() {
+                std::vector<netcdf_dim_t> ids;
+                for (const std::string& dim_name : dim_names) {
+                    ids.push_back(this->dim_ids.at(dim_name));
+                }
+
+                netcdf_var_t var_id = this->file->def_var<E>(name, ids.size(), ids.data());
+                this->apply_storage(var_id, var, storage);
+                if (has_fill) {
+                    this->file->set_fill(var_id, fill, MISSING_VALUE_NAME);
+                }
+                this->var_ids[name] = var_id;
+            });
+        }
+    }
+
+    this->plan_attrs(name, var);
+}
+
+/**
+ * Sets the chunking, filters and quantization of a newly defined variable
+ * with the shape of `var`. The filters are given in the order HDF5 runs
+ * them: shuffle, then the codec.
+ */
+template<typename S, typename T>
+void netcdf_writer_t::apply_storage(netcdf_var_t var_id, const variable_t<S, T>* var, const output_storage_t& storage) {
+    if (storage.chunk_dim != "" && var->has_dim(storage.chunk_dim)) {
+        std::vector<size_t> chunks;
+        for (size_t i = 0; i < var->get_num_dims(); i++) {
+            const dimension_t<T>* dim = var->get_dim(i);
+            chunks.push_back(dim->get_name() == storage.chunk_dim ? 1 : dim->get_size());
+        }
+        this->file->set_var_chunking(var_id, chunks.data());
+    }
+
+    if (storage.keep_bits > 0) {
+        this->file->set_var_bitround(var_id, storage.keep_bits);
+    }
+
+    if (storage.codec == "deflate") {
+        this->file->set_var_deflate(var_id, storage.shuffle, storage.level);
+    } else if (storage.codec == "zstd") {
+        if (storage.shuffle) {
+            this->file->set_var_deflate(var_id, true, 0);
+        }
+        this->file->set_var_zstandard(var_id, storage.level);
+    } else if (storage.shuffle) {
+        this->file->set_var_deflate(var_id, true, 0);
+    }
+}
+
+/**
+ * Writes all values of a variable in one call. Lazy variables are copied in
+ * chunk-aligned slabs along the first dimension instead.
+ */
+template<typename S, typename T>
+void netcdf_writer_t::write_values(netcdf_var_t var_id, const variable_t<S, T>* var) {
+    if (!var->is_lazy() || var->get_num_dims() == 0) {
+        this->file->set_var_vals<S>(var_id, var->get_data());
+        return;
+    }
+
+    size_t num_dims = var->get_num_dims();
+    size_t records = var->get_dim(0)->get_size();
+    size_t slab_len = var->get_slab_len(0);
+    std::vector<size_t> start(num_dims, 0);
+    std::vector<size_t> count(num_dims);
+    size_t record_size = 1;
+    for (size_t i = 0; i < num_dims; i++) {
+        count[i] = var->get_dim(i)->get_size();
+        if (i > 0) {
+            record_size *= count[i];
+        }
+    }
+
+    S* slab = new S[slab_len * record_size];
+    for (size_t r = 0; r < records; r += slab_len) {
+        start[0] = r;
+        count[0] = std::min(slab_len, records - r);
+        var->get_slice(start.data(), count.data(), slab);
+        this->file->set_var_vals<S>(var_id, slab, start.data(), count.data());
+    }
+    delete[] slab;
+}
+
+
+/**
+ * Writes the real and imaginary parts of a complex variable, separating them
+ * a block of records (along the first dimension) at a time into two buffers
+ * that are reused for every block, so at most COMPLEX_BLOCK_BYTES is copied
+ * at once instead of the whole variable
+ */
+template<typename S, typename T>
+void netcdf_writer_t::write_complex_values(netcdf_var_t var_id_re, netcdf_var_t var_id_im, const variable_t<std::complex<S>, T>* var) {
+    size_t num_dims = var->get_num_dims();
+    const std::complex<S>* data = var->get_data();
+    if (num_dims == 0) {
+        S re = data[0].real();
+        S im = data[0].imag();
+        this->file->set_var_vals<S>(var_id_re, &re);
+        this->file->set_var_vals<S>(var_id_im, &im);
+        return;
+    }
+
+    size_t records = var->get_dim(0)->get_size();
+    std::vector<size_t> start(num_dims, 0);
+    std::vector<size_t> count(num_dims);
+    size_t record_size = 1;
+    for (size_t i = 0; i < num_dims; i++) {
+        count[i] = var->get_dim(i)->get_size();
+        if (i > 0) {
+            record_size *= count[i];
+        }
+    }
+
+    size_t block_len = std::max((size_t) 1, COMPLEX_BLOCK_BYTES / (sizeof(S) * std::max(record_size, (size_t) 1)));
+    block_len = std::min(block_len, records);
+    S* block_re = new S[block_len * record_size];
+    S* block_im = new S[block_len * record_size];
+
+    for (size_t r = 0; r < records; r += block_len) {
+        start[0] = r;
+        count[0] = std::min(block_len, records - r);
+
+        const std::complex<S>* block = data + r * record_size;
+        long long block_size = (long long) (count[0] * record_size);
+        #pragma omp parallel for schedule(static)
+        for (long long i = 0; i < block_size; i++) {
+            block_re[i] = block[i].real();
+            block_im[i] = block[i].imag();
+        }
+
+        this->file->set_var_vals<S>(var_id_re, block_re, start.data(), count.data());
+        this->file->set_var_vals<S>(var_id_im, block_im, start.data(), count.data());
+    }
+
+    delete[] block_re;
+    delete[] block_im;
+}
+
+
+
+
+
+//==============================================================================
+// Public Methods
+//==============================================================================
+
+/**
+ * Plans a dimension and its coordinate variable on their own, such as the
+ * dimensions a CF list dimension gathers
+ */
+template<typename T>
+void netcdf_writer_t::add_dim(const dimension_t<T>* dim) {
+    this->plan_dim(dim);
+}
+
+/**
+ * Plans a real-valued variable, along with its dimensions, their coordinate
+ * variables and all their attributes
+ */
+template<typename S, typename T>
+void netcdf_writer_t::add(const variable_t<S, T>* var, const std::string name) {
+    bool has_fill = var->has_missing_value();
+    this->plan_var<S>(name, var, has_fill, has_fill ? var->get_missing_value() : S());
+
+    this->writes.push_back([this, name, var]() {
+        this->write_values(this->var_ids.at(name), var);
+    });
+}
+
+/**
+ * Plans a complex-valued variable as two real-valued variables holding its
+ * real and imaginary parts
+ */
+template<typename S, typename T>
+void netcdf_writer_t::add_complex(const variable_t<std::complex<S>, T>* var, const std::string name_re, const std::string name_im) {
+    bool has_fill = var->has_missing_value();
+    std::complex<S> fill = has_fill ? var->get_missing_value() : std::complex<S>();
+    this->plan_var<S>(name_re, var, has_fill, fill.real());
+    this->plan_var<S>(name_im, var, has_fill, fill.imag());
+
+    this->writes.push_back([this, name_re, name_im, var]() {
+        this->write_complex_values(this->var_ids.at(name_re), this->var_ids.at(name_im), var);
+    });
+}
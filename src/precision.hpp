@@ -0,0 +1,235 @@
+/***********************************************************************
+ *                   GNU Lesser General Public License
+ *
+ * This file is part of the EDGI prototype package, developed by the
+ * GFDL Flexible Modeling System (FMS) group.
+ *
+ * EDGI is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * EDGI is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with EDGI.  If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************/
+
+#ifndef PRECISION_HPP
+#define PRECISION_HPP
+
+/** Use uint16_t, uint32_t */
+#include <cstdint>
+
+/** Use memcpy */
+#include <cstring>
+
+/** Use size_t */
+#include <cstddef>
+
+/** Use std::complex */
+#include <complex>
+
+
+
+
+
+//==============================================================================
+// Reduced-Precision Storage Types
+//==============================================================================
+
+/**
+ * A 16-bit brain floating point number: the upper half of an IEEE float. It
+ * keeps the full float exponent range with an 8-bit significand, and widens
+ * to float with a single shift.
+ */
+struct bfloat16_t {
+    uint16_t bits;
+
+    bfloat16_t() : bits(0) { }
+
+    bfloat16_t(float value) {
+        uint32_t x;
+        memcpy(&x, &value, sizeof(x));
+        if ((x & 0x7fffffff) > 0x7f800000) {
+            // Keep NaNs quiet instead of letting rounding turn them into inf
+            this->bits = (uint16_t) ((x >> 16) | 0x0040);
+        } else {
+            // Round to nearest, ties to even
+            x += 0x7fff + ((x >> 16) & 1);
+            this->bits = (uint16_t) (x >> 16);
+        }
+    }
+
+    operator float() const {
+        uint32_t x = ((uint32_t) this->bits) << 16;
+        float value;
+        memcpy(&value, &x, sizeof(value));
+        return value;
+    }
+};
+
+/**
+ * An IEEE 754 binary16 number. It has more significand bits than bfloat16_t
+ * but a much smaller range (about 6e-8 to 65504), so it suits anomalies of
+ * well-scaled fields.
+ */
+struct half_t {
+    uint16_t bits;
+
+    half_t() : bits(0) { }
+
+    half_t(float value) {
+        uint32_t x;
+        memcpy(&x, &value, sizeof(x));
+
+        uint32_t sign = (x >> 16) & 0x8000;
+        uint32_t raw_exp = (x >> 23) & 0xff;
+        int32_t  exp = (int32_t) raw_exp - 127 + 15;
+        uint32_t mant = x & 0x7fffff;
+
+        if (raw_exp == 0xff) {
+            // Infinity or NaN
+            this->bits = (uint16_t) (sign | 0x7c00 | (mant ? 0x200 : 0));
+        } else if (exp >= 0x1f) {
+            // Too large, so overflow to infinity
+            this->bits = (uint16_t) (sign | 0x7c00);
+        } else if (exp <= 0) {
+            // Subnormal or zero
+            if (exp < -10) {
+                this->bits = (uint16_t) sign;
+            } else {
+                mant |= 0x800000;
+                uint32_t shift = 14 - exp;
+                uint32_t half_mant = mant >> shift;
+                uint32_t rem = mant & ((1u << shift) - 1);
+                uint32_t halfway = 1u << (shift - 1);
+                if (rem > halfway || (rem == halfway && (half_mant & 1))) {
+                    half_mant++;
+                }
+                this->bits = (uint16_t) (sign | half_mant);
+            }
+        } else {
+            // Normal; a carry out of the significand correctly bumps the exponent
+            uint32_t half = sign | ((uint32_t) exp << 10) | (mant >> 13);
+            uint32_t rem = mant & 0x1fff;
+            if (rem > 0x1000 || (rem == 0x1000 && (half & 1))) {
+                half++;
+            }
+            this->bits = (uint16_t) half;
+        }
+    }
+
+    operator float() const {
+        uint32_t sign = ((uint32_t) this->bits & 0x8000) << 16;
+        uint32_t exp = (this->bits >> 10) & 0x1f;
+        uint32_t mant = this->bits & 0x3ff;
+        uint32_t x;
+
+        if (exp == 0) {
+            if (mant == 0) {
+                x = sign;
+            } else {
+                // Renormalize a subnormal value
+                exp = 1;
+                while (!(mant & 0x400)) {
+                    mant <<= 1;
+                    exp--;
+                }
+                mant &= 0x3ff;
+                x = sign | ((exp + 112) << 23) | (mant << 13);
+            }
+        } else if (exp == 0x1f) {
+            x = sign | 0x7f800000 | (mant << 13);
+        } else {
+            x = sign | ((exp + 112) << 23) | (mant << 13);
+        }
+
+        float value;
+        memcpy(&value, &x, sizeof(value));
+        return value;
+    }
+};
+
+static_assert(sizeof(bfloat16_t) == 2, "bfloat16_t must be 2 bytes");
+static_assert(sizeof(half_t) == 2, "half_t must be 2 bytes");
+
+
+
+
+
+//==============================================================================
+// Precision Policies
+//==============================================================================
+
+/**
+ * Selects the types used by eof_t for the anomaly matrix:
+ *   - Storage: how the (centered) anomaly matrix is held in memory
+ *   - Compute: what stored values are widened to before arithmetic
+ *   - Accum:   what sums over the T dimension are accumulated in
+ */
+template<typename Storage, typename Compute, typename Accum>
+struct precision_t {
+    typedef Storage storage_t;
+    typedef Compute compute_t;
+    typedef Accum   accum_t;
+};
+
+/**
+ * The default policy for each data type: store and compute at the data's own
+ * precision, but accumulate in double so that long time series don't lose
+ * precision
+ */
+template<typename S>
+struct default_precision;
+
+template<>
+struct default_precision<float> {
+    typedef precision_t<float, float, double> type;
+};
+
+template<>
+struct default_precision<double> {
+    typedef precision_t<double, double, double> type;
+};
+
+template<>
+struct default_precision<std::complex<float>> {
+    typedef precision_t<std::complex<float>, std::complex<float>, std::complex<double>> type;
+};
+
+template<>
+struct default_precision<std::complex<double>> {
+    typedef precision_t<std::complex<double>, std::complex<double>, std::complex<double>> type;
+};
+
+/**
+ * Describes how a value type is laid out in an anomaly series. Complex series
+ * are stored split: all real parts, then all imaginary parts, so that the
+ * kernels only ever loop over plain scalars.
+ */
+template<typename U>
+struct split_traits {
+    typedef U scalar_t;
+    static const size_t planes = 1;
+};
+
+template<typename U>
+struct split_traits<std::complex<U>> {
+    typedef U scalar_t;
+    static const size_t planes = 2;
+};
+
+/** Float data held as bfloat16, halving the memory of the anomaly matrix */
+typedef precision_t<bfloat16_t, float, double> bf16_precision_t;
+
+/** Float data held as IEEE half precision */
+typedef precision_t<half_t, float, double> fp16_precision_t;
+
+/** Plain single precision throughout, matching the original behaviour */
+typedef precision_t<float, float, float> single_precision_t;
+
+#endif
@@ -0,0 +1,137 @@
+/***********************************************************************
+ *                   GNU Lesser General Public License
+ *
+ * This file is part of the EDGI prototype package, developed by the
+ * GFDL Flexible Modeling System (FMS) group.
+ *
+ * EDGI is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * EDGI is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with EDGI.  If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************/
+
+#ifndef RANDOMIZED_SVD_HPP
+#define RANDOMIZED_SVD_HPP
+
+/** Use svd_t */
+#include "svd.hpp"
+
+/** Use std::complex */
+#include <complex>
+
+
+
+
+
+//=============================================================================
+// Declaration of Class randomized_svd_t
+//=============================================================================
+
+/**
+ * Finds only the leading modes of a Hermitian (covariance) matrix, by
+ * randomized subspace iteration: the matrix is applied to a few more random
+ * vectors than there are modes, a couple of times over, and the modes are
+ * taken from the small matrix it projects to on their span. Each pass reads
+ * the matrix once, so it suits large matrices of which few EOFs are wanted.
+ */
+template<typename T>
+class randomized_svd_t : public svd_t<T> {
+private:
+    size_t num_threads;
+    size_t rank;
+
+    template<typename U>
+    void solve(
+        matrix_t<U>* input,
+        matrix_t<U>* u,
+        matrix_t<T>* s,
+        matrix_t<U>* vt
+    );
+
+public:
+    /** Modes found if not told otherwise */
+    static const size_t DEFAULT_RANK = 10;
+
+    /** Random vectors used beyond the modes wanted */
+    static const size_t OVERSAMPLING = 10;
+
+    /** Passes of subspace iteration after the first product */
+    static const size_t POWER_ITERATIONS = 2;
+
+    /**
+     * Create an instance finding DEFAULT_RANK modes on the default number of
+     * threads
+     */
+    randomized_svd_t();
+
+    /**
+     * Create an instance finding DEFAULT_RANK modes on the specified number
+     * of threads
+     */
+    randomized_svd_t(size_t num_threads);
+
+    /**
+     * Create an instance finding `rank` modes on the specified number of
+     * threads
+     */
+    randomized_svd_t(size_t num_threads, size_t rank);
+
+    ~randomized_svd_t();
+
+    /**
+     * Set the number of threads to run on
+     */
+    void set_num_threads(size_t num_threads);
+
+    /**
+     * Set the number of leading modes to find (all of them, if the matrix is
+     * no bigger)
+     */
+    void set_rank(size_t rank);
+
+    /**
+     * Finds the leading modes of the square Hermitian matrix `input`, which
+     * is left as is
+     */
+    void calculate(
+        matrix_t<T>* input,
+        matrix_t<T>* u,
+        matrix_t<T>* s,
+        matrix_t<T>* vt
+    );
+
+    /**
+     * Finds the leading modes of the square Hermitian matrix `input`, which
+     * is left as is
+     */
+    void calculate(
+        matrix_t<std::complex<T>>* input,
+        matrix_t<std::complex<T>>* u,
+        matrix_t<T>*               s,
+        matrix_t<std::complex<T>>* vt
+    );
+};
+
+
+
+
+
+//=============================================================================
+// Template Implementation
+//=============================================================================
+
+#include "randomized_svd.tpp"
+
+
+
+
+
+#endif
@@ -0,0 +1,188 @@
+/***********************************************************************
+ *                   GNU Lesser General Public License
+ *
+ * This file is part of the EDGI prototype package, developed by the
+ * GFDL Flexible Modeling System (FMS) group.
+ *
+ * EDGI is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * EDGI is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with EDGI.  If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************/
+
+#include "randomized_svd.hpp"
+
+#include "error.hpp"
+
+/** Use std::mt19937 */
+#include <random>
+
+/** Use std::vector */
+#include <vector>
+
+/** Use std::cout */
+#include <iostream>
+
+#include <ctime>
+#include <omp.h>
+
+
+
+
+
+//=============================================================================
+// Implementation of Class randomized_svd_t
+//=============================================================================
+
+template<typename T>
+const size_t randomized_svd_t<T>::DEFAULT_RANK;
+
+template<typename T>
+const size_t randomized_svd_t<T>::OVERSAMPLING;
+
+template<typename T>
+const size_t randomized_svd_t<T>::POWER_ITERATIONS;
+
+template<typename T>
+randomized_svd_t<T>::randomized_svd_t() {
+    this->set_num_threads(omp_get_max_threads());
+    this->set_rank(DEFAULT_RANK);
+}
+
+template<typename T>
+randomized_svd_t<T>::randomized_svd_t(size_t num_threads) {
+    this->set_num_threads(num_threads);
+    this->set_rank(DEFAULT_RANK);
+}
+
+template<typename T>
+randomized_svd_t<T>::randomized_svd_t(size_t num_threads, size_t rank) {
+    this->set_num_threads(num_threads);
+    this->set_rank(rank);
+}
+
+template<typename T>
+randomized_svd_t<T>::~randomized_svd_t() {
+    // ...
+}
+
+template<typename T>
+void randomized_svd_t<T>::set_num_threads(size_t num_threads) {
+    this->num_threads = (num_threads > 0) ? num_threads : 1;
+}
+
+template<typename T>
+void randomized_svd_t<T>::set_rank(size_t rank) {
+    if (rank == 0) {
+        throw eof_error_t("At least one mode must be found");
+    }
+    this->rank = rank;
+}
+
+template<typename T>
+template<typename U>
+void randomized_svd_t<T>::solve(
+    matrix_t<U>* input,
+    matrix_t<U>* u,
+    matrix_t<T>* s,
+    matrix_t<U>* vt
+) {
+    const size_t n = input->get_rows();
+    if (input->get_cols() != n) {
+        throw eof_error_t("The randomized eigensolver only decomposes square (covariance) matrices");
+    }
+
+    // Start the SVD timer
+    time_t start = time(nullptr);
+
+    const size_t k = std::min(this->rank, n);
+    const size_t l = std::min(k + OVERSAMPLING, n);
+    const U* a = input->get_data();
+
+    // Orthonormal basis Q (in the rows of qt) of the range of A^(q + 1) on
+    // random vectors, re-orthonormalized after each product
+    std::mt19937 rng(SVD_RANDOM_SEED);
+    std::vector<U> qt(l * n);
+    std::vector<U> yt(l * n);
+    random_fill(qt.data(), l * n, &rng);
+    for (size_t pass = 0; pass <= POWER_ITERATIONS; pass++) {
+        apply_hermitian(n, a, l, qt.data(), yt.data(), this->num_threads);
+        orthonormalize_rows<T>(n, 0, l, yt.data(), &rng, this->num_threads);
+        qt.swap(yt);
+    }
+
+    // B = Q^H A Q, made exactly Hermitian
+    apply_hermitian(n, a, l, qt.data(), yt.data(), this->num_threads);
+    std::vector<U> b(l * l);
+    #pragma omp parallel for num_threads(this->num_threads) schedule(static)
+    for (size_t r = 0; r < l; r++) {
+        for (size_t c = 0; c < l; c++) {
+            b[r * l + c] = inner_of(qt.data() + r * n, yt.data() + c * n, n);
+        }
+    }
+    for (size_t r = 0; r < l; r++) {
+        for (size_t c = 0; c < r; c++) {
+            U mean = (b[r * l + c] + conj_of(b[c * l + r])) / T(2);
+            b[r * l + c] = mean;
+            b[c * l + r] = conj_of(mean);
+        }
+        b[r * l + r] = real_of(b[r * l + r]);
+    }
+
+    std::vector<T> d(l);
+    std::vector<U> z(l * l);
+    hermitian_eigensolve(l, b.data(), d.data(), z.data(), this->num_threads);
+
+    // The Ritz vectors, Q times the eigenvectors of B
+    #pragma omp parallel for num_threads(this->num_threads) schedule(static)
+    for (size_t i0 = 0; i0 < n; i0 += SVD_COLUMN_BLOCK) {
+        size_t len = std::min(n - i0, SVD_COLUMN_BLOCK);
+        for (size_t j = 0; j < l; j++) {
+            U* x = yt.data() + j * n + i0;
+            std::fill(x, x + len, U(0));
+            for (size_t r = 0; r < l; r++) {
+                const U* q = qt.data() + r * n + i0;
+                U zr = z[j * l + r];
+                #pragma omp simd
+                for (size_t i = 0; i < len; i++) {
+                    x[i] += zr * q[i];
+                }
+            }
+        }
+    }
+
+    write_modes(n, l, k, d.data(), yt.data(), u, s, vt, this->num_threads);
+
+    // Print the time required to compute the SVD
+    time_t end = time(nullptr);
+    double time = difftime(end,start);
+    std::cout << "svd: " << time << "s; ";
+}
+
+template<typename T>
+void randomized_svd_t<T>::calculate(
+    matrix_t<T>* input,
+    matrix_t<T>* u,
+    matrix_t<T>* s,
+    matrix_t<T>* vt
+) {
+    this->solve(input, u, s, vt);
+}
+
+template<typename T>
+void randomized_svd_t<T>::calculate(
+    matrix_t<std::complex<T>>* input,
+    matrix_t<std::complex<T>>* u,
+    matrix_t<T>*               s,
+    matrix_t<std::complex<T>>* vt
+) {
+    this->solve(input, u, s, vt);
+}
@@ -0,0 +1,516 @@
+/***********************************************************************
+ *                   GNU Lesser General Public License
+ *
+ * This file is part of the EDGI prototype package, developed by the
+ * GFDL Flexible Modeling System (FMS) group.
+ *
+ * EDGI is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * EDGI is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with EDGI.  If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************/
+
+#include "raw_file.hpp"
+
+#include "error.hpp"
+
+/** Use open, close */
+#include <fcntl.h>
+#include <unistd.h>
+
+/** Use fstat */
+#include <sys/stat.h>
+
+/** Use mmap, munmap, madvise */
+#include <sys/mman.h>
+
+/** Use uint16_t, uint32_t, uint64_t, int16_t, uintptr_t */
+#include <cstdint>
+
+/** Use memcpy */
+#include <cstring>
+
+/** Use std::min */
+#include <algorithm>
+
+/** Use std::ifstream */
+#include <fstream>
+
+/** Use std::istringstream */
+#include <sstream>
+
+// <string>, <vector> and <utility> included in header
+using std::string;
+using std::vector;
+
+
+
+
+
+//==============================================================================
+// Local functions
+//==============================================================================
+
+namespace {
+
+    /** Values per piece of work handed to a thread when copying */
+    const size_t VALUES_PER_PIECE = 1 << 16;
+
+    /** Strips spaces and tabs from both ends of `text` */
+    string trim(const string& text) {
+        size_t first = text.find_first_not_of(" \t\r");
+        if (first == string::npos) {
+            return "";
+        }
+        size_t last = text.find_last_not_of(" \t\r");
+        return text.substr(first, last - first + 1);
+    }
+
+    /** Splits `text` into its words */
+    vector<string> words(const string& text) {
+        vector<string> result;
+        std::istringstream stream(text);
+        string word;
+        while (stream >> word) {
+            result.push_back(word);
+        }
+        return result;
+    }
+
+    /**
+     * Parses a number in the value of `key`, throwing eof_error_t if it is
+     * not one
+     */
+    double parse_double(const string& key, const string& text) {
+        size_t end = 0;
+        double value = 0;
+        try {
+            value = std::stod(text, &end);
+        } catch (const std::exception& e) {
+            end = 0;
+        }
+        if (end == 0 || end != text.size()) {
+            throw eof_error_t("Invalid value of \"" + key + "\" in raw file descriptor: '" + text + "'");
+        }
+        return value;
+    }
+
+    size_t parse_size(const string& key, const string& text) {
+        double value = parse_double(key, text);
+        if (value < 0 || value != (double) (size_t) value) {
+            throw eof_error_t("Invalid value of \"" + key + "\" in raw file descriptor: '" + text + "'");
+        }
+        return (size_t) value;
+    }
+
+    /**
+     * Loads one value of type F from the map, swapping its bytes if it is in
+     * the other byte order
+     */
+    template<typename F, typename U, bool SWAP>
+    inline F load_value(const unsigned char* src) {
+        U bits;
+        std::memcpy(&bits, src, sizeof(U));
+        if (SWAP) {
+            if (sizeof(U) == 2) {
+                bits = __builtin_bswap16(bits);
+            } else if (sizeof(U) == 4) {
+                bits = __builtin_bswap32(bits);
+            } else {
+                bits = __builtin_bswap64(bits);
+            }
+        }
+        F value;
+        std::memcpy(&value, &bits, sizeof(F));
+        return value;
+    }
+
+    /**
+     * Converts `len` values of type F into vals
+     */
+    template<typename F, typename U, typename S>
+    void convert_run(const unsigned char* src, size_t len, bool swapped, S* vals) {
+        if (swapped) {
+            for (size_t i = 0; i < len; i++) {
+                vals[i] = (S) load_value<F, U, true>(src + i * sizeof(F));
+            }
+        } else {
+            for (size_t i = 0; i < len; i++) {
+                vals[i] = (S) load_value<F, U, false>(src + i * sizeof(F));
+            }
+        }
+    }
+
+    /** Returns the size in bytes of a value of a raw file's type */
+    size_t type_size(nc_type type) {
+        switch (type) {
+            case NC_SHORT:
+                return 2;
+            case NC_FLOAT:
+                return 4;
+            default:
+                return 8;
+        }
+    }
+
+}
+
+
+
+
+
+//==============================================================================
+// Constructors and destructors
+//==============================================================================
+
+string raw_file_t::get_descriptor_name(const string filename) {
+    return filename + ".desc";
+}
+
+bool raw_file_t::is_raw(const string filename) {
+    struct stat info;
+    return stat(get_descriptor_name(filename).c_str(), &info) == 0 && S_ISREG(info.st_mode);
+}
+
+raw_file_t::raw_file_t(const string filename) {
+    this->parse_descriptor(get_descriptor_name(filename));
+
+    try {
+        this->map_file(filename);
+    } catch (...) {
+        if (this->fd >= 0) {
+            close(this->fd);
+        }
+        throw;
+    }
+}
+
+raw_file_t::~raw_file_t() {
+    if (this->map != nullptr) {
+        munmap((void*) this->map, this->map_size);
+    }
+    if (this->fd >= 0) {
+        close(this->fd);
+    }
+}
+
+
+
+
+
+//==============================================================================
+// Private Methods
+//==============================================================================
+
+/**
+ * Reads the sidecar file `filename` (see the class comment)
+ */
+void raw_file_t::parse_descriptor(const string filename) {
+    std::ifstream in(filename);
+    if (!in) {
+        throw eof_error_t("Cannot open raw file descriptor \"" + filename + "\"");
+    }
+
+    vector<std::pair<string, string>> coord_lines;
+    string byte_order = "little";
+    string line;
+    while (std::getline(in, line)) {
+        line = trim(line.substr(0, line.find('#')));
+        if (line.empty()) {
+            continue;
+        }
+
+        size_t equals = line.find('=');
+        if (equals == string::npos) {
+            throw eof_error_t("Invalid line in raw file descriptor: '" + line + "'");
+        }
+        string key = trim(line.substr(0, equals));
+        string value = trim(line.substr(equals + 1));
+
+        if (key == "variable") {
+            this->var_name = value;
+        } else if (key == "type") {
+            if (value == "float" || value == "float32") {
+                this->type = NC_FLOAT;
+            } else if (value == "double" || value == "float64") {
+                this->type = NC_DOUBLE;
+            } else if (value == "short" || value == "int16") {
+                this->type = NC_SHORT;
+            } else {
+                throw eof_error_t("Unknown type in raw file descriptor: '" + value + "'");
+            }
+        } else if (key == "dims") {
+            this->dim_names = words(value);
+        } else if (key == "shape") {
+            this->dims.clear();
+            for (string word : words(value)) {
+                this->dims.push_back(parse_size(key, word));
+            }
+        } else if (key == "byte_order") {
+            byte_order = value;
+        } else if (key == "offset") {
+            this->begin = parse_size(key, value);
+        } else if (key == "fill_value") {
+            this->contains_fill = true;
+            this->fill_value = parse_double(key, value);
+        } else if (key == "scale_factor") {
+            this->packed = true;
+            this->scale_factor = parse_double(key, value);
+        } else if (key == "add_offset") {
+            this->packed = true;
+            this->add_offset = parse_double(key, value);
+        } else if (key.compare(0, 6, "coord.") == 0) {
+            coord_lines.push_back(std::make_pair(key.substr(6), value));
+        } else if (key.compare(0, 5, "attr.") == 0) {
+            this->attrs.push_back(std::make_pair(key.substr(5), value));
+        } else {
+            throw eof_error_t("Unknown key in raw file descriptor: '" + key + "'");
+        }
+    }
+
+    if (this->var_name.empty() || this->type == NC_NAT || this->dim_names.empty()) {
+        throw eof_error_t("Raw file descriptor \"" + filename + "\" needs a variable, type and dims");
+    }
+    if (this->dims.size() != this->dim_names.size()) {
+        throw eof_error_t("Raw file descriptor \"" + filename + "\" has a shape that does not match its dims");
+    }
+    if (byte_order != "little" && byte_order != "big") {
+        throw eof_error_t("Unknown byte order in raw file descriptor: '" + byte_order + "'");
+    }
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    this->swapped = (byte_order == "big");
+#else
+    this->swapped = (byte_order == "little");
+#endif
+
+    // Dimensions without coordinates count their steps
+    this->coords.resize(this->dims.size());
+    for (size_t i = 0; i < this->dims.size(); i++) {
+        for (size_t j = 0; j < this->dims[i]; j++) {
+            this->coords[i].push_back(j);
+        }
+    }
+
+    for (std::pair<string, string> coord : coord_lines) {
+        size_t i = std::find(this->dim_names.begin(), this->dim_names.end(), coord.first) - this->dim_names.begin();
+        if (i == this->dim_names.size()) {
+            throw eof_error_t("Raw file descriptor has coordinates of unknown dimension \"" + coord.first + "\"");
+        }
+
+        vector<string> values = words(coord.second);
+        if (values.size() != this->dims[i]) {
+            throw eof_error_t("Raw file descriptor has the wrong number of coordinates of dimension \"" + coord.first + "\"");
+        }
+        for (size_t j = 0; j < values.size(); j++) {
+            this->coords[i][j] = parse_double("coord." + coord.first, values[j]);
+        }
+    }
+}
+
+/**
+ * Maps the dump, and checks that it holds every value
+ */
+void raw_file_t::map_file(const string filename) {
+    this->fd = open(filename.c_str(), O_RDONLY);
+    if (this->fd < 0) {
+        throw eof_error_t("Cannot open raw file \"" + filename + "\"");
+    }
+
+    size_t len = type_size(this->type);
+    for (size_t d : this->dims) {
+        len *= d;
+    }
+
+    struct stat info;
+    if (fstat(this->fd, &info) != 0 || (size_t) info.st_size < this->begin + len) {
+        throw eof_error_t("Raw file \"" + filename + "\" is shorter than its descriptor says");
+    }
+    if (info.st_size == 0) {
+        return;
+    }
+
+    void* map = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, this->fd, 0);
+    if (map == MAP_FAILED) {
+        throw eof_error_t("Cannot map raw file \"" + filename + "\"");
+    }
+    this->map = (const unsigned char*) map;
+    this->map_size = info.st_size;
+
+    // Slabs are read in order, so let the kernel read far ahead
+    madvise(map, this->map_size, MADV_SEQUENTIAL);
+}
+
+/**
+ * Copies the hyperslab out of the map, as cdf_mmap_reader_t does: the slab is
+ * cut into runs of values that are contiguous in the dump, and the runs into
+ * pieces that are shared across the OpenMP threads. The whole span of the
+ * slab is requested from the kernel first, so that it is read in one go.
+ */
+template<typename S>
+void raw_file_t::read_values(const size_t* start, const size_t* count, S* vals) const {
+    size_t n = this->dims.size();
+    size_t size = type_size(this->type);
+
+    vector<size_t> stride(n);
+    size_t len = size;
+    for (size_t d = n; d-- > 0;) {
+        stride[d] = len;
+        len *= this->dims[d];
+    }
+
+    // Runs cover dimension k onward, which needs every later dimension to
+    // be read whole
+    size_t k = (n > 0) ? n - 1 : 0;
+    while (k > 0 && count[k] == this->dims[k]) {
+        k--;
+    }
+
+    size_t run_len = 1;
+    for (size_t d = k; d < n; d++) {
+        if (count[d] == 0) {
+            return;
+        }
+        run_len *= count[d];
+    }
+    size_t num_runs = 1;
+    for (size_t d = 0; d < k; d++) {
+        if (count[d] == 0) {
+            return;
+        }
+        num_runs *= count[d];
+    }
+
+    size_t first_byte = this->begin;
+    size_t last_byte = this->begin + size;
+    for (size_t d = 0; d < n; d++) {
+        first_byte += start[d] * stride[d];
+        last_byte += (start[d] + count[d] - 1) * stride[d];
+    }
+    size_t page = sysconf(_SC_PAGESIZE);
+    size_t advice_start = first_byte - first_byte % page;
+    madvise((void*) (this->map + advice_start), last_byte - advice_start, MADV_WILLNEED);
+
+    size_t pieces_per_run = (run_len + VALUES_PER_PIECE - 1) / VALUES_PER_PIECE;
+    size_t num_pieces = num_runs * pieces_per_run;
+
+    #pragma omp parallel for schedule(static)
+    for (size_t p = 0; p < num_pieces; p++) {
+        size_t r = p / pieces_per_run;
+        size_t first = (p % pieces_per_run) * VALUES_PER_PIECE;
+        size_t num = std::min(VALUES_PER_PIECE, run_len - first);
+
+        // Find the start of run r in the dump
+        size_t src = this->begin;
+        size_t rem = r;
+        for (size_t d = k; d-- > 0;) {
+            src += (start[d] + rem % count[d]) * stride[d];
+            rem /= count[d];
+        }
+        if (k < n) {
+            src += start[k] * stride[k];
+        }
+        src += first * size;
+
+        S* dst = vals + r * run_len + first;
+        const unsigned char* in = this->map + src;
+        switch (this->type) {
+            case NC_SHORT:
+                convert_run<int16_t, uint16_t>(in, num, this->swapped, dst);
+                break;
+            case NC_FLOAT:
+                convert_run<float, uint32_t>(in, num, this->swapped, dst);
+                break;
+            default:
+                convert_run<double, uint64_t>(in, num, this->swapped, dst);
+                break;
+        }
+    }
+}
+
+
+
+
+
+//==============================================================================
+// Public Methods
+//==============================================================================
+
+string raw_file_t::get_var_name() const {
+    return this->var_name;
+}
+
+nc_type raw_file_t::get_var_type() const {
+    return this->type;
+}
+
+size_t raw_file_t::get_num_dims() const {
+    return this->dims.size();
+}
+
+string raw_file_t::get_dim_name(size_t i) const {
+    return this->dim_names.at(i);
+}
+
+size_t raw_file_t::get_dim_len(size_t i) const {
+    return this->dims.at(i);
+}
+
+const vector<double>& raw_file_t::get_coords(size_t i) const {
+    return this->coords.at(i);
+}
+
+bool raw_file_t::has_fill() const {
+    return this->contains_fill;
+}
+
+double raw_file_t::get_fill() const {
+    return this->fill_value;
+}
+
+bool raw_file_t::is_packed() const {
+    return this->packed;
+}
+
+double raw_file_t::get_scale_factor() const {
+    return this->scale_factor;
+}
+
+double raw_file_t::get_add_offset() const {
+    return this->add_offset;
+}
+
+size_t raw_file_t::get_num_attrs() const {
+    return this->attrs.size();
+}
+
+string raw_file_t::get_attr_name(size_t i) const {
+    return this->attrs.at(i).first;
+}
+
+string raw_file_t::get_attr_value(size_t i) const {
+    return this->attrs.at(i).second;
+}
+
+bool raw_file_t::is_supported() const {
+    return true;
+}
+
+void raw_file_t::read(const size_t* start, const size_t* count, float* vals) const {
+    this->read_values(start, count, vals);
+}
+
+void raw_file_t::read(const size_t* start, const size_t* count, double* vals) const {
+    this->read_values(start, count, vals);
+}
+
+void raw_file_t::read(const size_t* start, const size_t* count, short* vals) const {
+    this->read_values(start, count, vals);
+}
@@ -0,0 +1,185 @@
+/***********************************************************************
+ *                   GNU Lesser General Public License
+ *
+ * This file is part of the EDGI prototype package, developed by the
+ * GFDL Flexible Modeling System (FMS) group.
+ *
+ * EDGI is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * EDGI is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with EDGI.  If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************/
+
+#ifndef RAW_FILE_HPP
+#define RAW_FILE_HPP
+
+/** Use slab_reader_t */
+#include "slab_reader.hpp"
+
+/** Use nc_type */
+#include <netcdf.h>
+
+/** Use size_t */
+#include <cstddef>
+
+/** Use std::string */
+#include <string>
+
+/** Use std::vector */
+#include <vector>
+
+/** Use std::pair */
+#include <utility>
+
+
+
+
+
+//==============================================================================
+// Declaration
+//==============================================================================
+
+/**
+ * A raw binary dump of one variable (such as a model writes), described by a
+ * small text sidecar file next to it, named as the dump with ".desc"
+ * appended. Each line of the sidecar is a "<key> = <value>" pair, and '#'
+ * starts a comment:
+ *
+ *     variable = temp                 (required) The variable's name
+ *     type = float                    (required) float, double or short
+ *     dims = time lat lon             (required) Dimension names, slowest first
+ *     shape = 120 180 360             (required) Length of each dimension
+ *     byte_order = little             little (default) or big
+ *     offset = 0                      Bytes to skip before the first value
+ *     fill_value = -1e34              The missing value, if there is one
+ *     scale_factor = 0.01             CF packing, if the values are packed
+ *     add_offset = 250
+ *     coord.lat = -89.5 -88.5 ...     Coordinate values of a dimension (by
+ *                                     default its indices)
+ *     attr.units = K                  A text attribute of the variable
+ *
+ * The dump is mapped read-only, and hyperslabs are copied (byte-swapped and
+ * converted as needed) straight out of the map, so that it is read in large
+ * sequential pieces through the page cache, shared between runs.
+ */
+class raw_file_t : public slab_reader_t {
+private:
+    //==========================================================================
+    // Private Fields
+    //==========================================================================
+
+    /** The variable's name and type (NC_FLOAT, NC_DOUBLE or NC_SHORT) */
+    std::string var_name;
+    nc_type type = NC_NAT;
+
+    /** Are the values stored in the other byte order than this machine's? */
+    bool swapped = false;
+
+    /** Offset of the first value in the dump */
+    size_t begin = 0;
+
+    /** The name, length and coordinate values of each dimension */
+    std::vector<std::string> dim_names;
+    std::vector<size_t> dims;
+    std::vector<std::vector<double>> coords;
+
+    /** The fill value and packing, if there are any */
+    bool contains_fill = false;
+    double fill_value = 0;
+    bool packed = false;
+    double scale_factor = 1;
+    double add_offset = 0;
+
+    /** The text attributes, as name and value */
+    std::vector<std::pair<std::string, std::string>> attrs;
+
+    /** The mapped dump */
+    int fd = -1;
+    const unsigned char* map = nullptr;
+    size_t map_size = 0;
+
+
+
+    //==========================================================================
+    // Private Methods
+    //==========================================================================
+
+    void parse_descriptor(const std::string filename);
+
+    void map_file(const std::string filename);
+
+    template<typename S>
+    void read_values(const size_t* start, const size_t* count, S* vals) const;
+
+
+
+public:
+    //==========================================================================
+    // Public Methods
+    //==========================================================================
+
+    /**
+     * Returns the name of the sidecar file describing the dump `filename`
+     */
+    static std::string get_descriptor_name(const std::string filename);
+
+    /**
+     * Returns whether `filename` is a raw dump, i.e. whether it has a sidecar
+     * file
+     */
+    static bool is_raw(const std::string filename);
+
+    /**
+     * Reads the sidecar of the dump `filename` and maps the dump. Throws
+     * eof_error_t if the sidecar is malformed or the dump is too short.
+     */
+    raw_file_t(const std::string filename);
+
+    ~raw_file_t();
+
+    std::string get_var_name() const;
+
+    nc_type get_var_type() const;
+
+    size_t get_num_dims() const;
+
+    std::string get_dim_name(size_t i) const;
+
+    size_t get_dim_len(size_t i) const;
+
+    const std::vector<double>& get_coords(size_t i) const;
+
+    bool has_fill() const;
+
+    double get_fill() const;
+
+    bool is_packed() const;
+
+    double get_scale_factor() const;
+
+    double get_add_offset() const;
+
+    size_t get_num_attrs() const;
+
+    std::string get_attr_name(size_t i) const;
+
+    std::string get_attr_value(size_t i) const;
+
+    bool is_supported() const;
+
+    void read(const size_t* start, const size_t* count, float* vals) const;
+
+    void read(const size_t* start, const size_t* count, double* vals) const;
+
+    void read(const size_t* start, const size_t* count, short* vals) const;
+};
+
+#endif
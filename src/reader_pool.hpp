@@ -0,0 +1,166 @@
+/***********************************************************************
+ *                   GNU Lesser General Public License
+ *
+ * This file is part of the EDGI prototype package, developed by the
+ * GFDL Flexible Modeling System (FMS) group.
+ *
+ * EDGI is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * EDGI is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with EDGI.  If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************/
+
+#ifndef READER_POOL_HPP
+#define READER_POOL_HPP
+
+/** Use variable_t */
+#include "variable.hpp"
+
+/** Use size_t */
+#include <cstddef>
+
+/** Use uint64_t */
+#include <cstdint>
+
+/** Use pid_t */
+#include <sys/types.h>
+
+/** Use std::string */
+#include <string>
+
+/** Use std::vector */
+#include <vector>
+
+
+
+
+
+//==============================================================================
+// Declaration
+//==============================================================================
+
+/**
+ * Reads many input variables at once with a pool of forked processes. The
+ * NetCDF library is not thread-safe, but separate processes can each have
+ * their own files open, so ingestion runs at the bandwidth of the whole
+ * filesystem rather than of one file at a time.
+ *
+ * The processes are forked when the pool is made, which must be before any
+ * OpenMP thread is started and before any file is opened (neither the
+ * threads nor the state of the NetCDF and HDF5 libraries survive a fork).
+ * They then wait for variables to read, which they open themselves.
+ *
+ * The variables are read into shared memory, which then becomes their
+ * storage in the parent (see variable_t::map_data) without being copied.
+ * The memory belongs to the pool, so the pool must outlive the variables it
+ * loaded.
+ */
+class reader_pool_t {
+private:
+    //==========================================================================
+    // Private Fields
+    //==========================================================================
+
+    /** One variable for a reader to read into the shared memory */
+    struct job_t {
+        /** 'f' for float or 'd' for double */
+        char type;
+        std::string name;
+        std::string filename;
+
+        /** The selection of the variable, as given by selection_t::to_string */
+        std::string selection;
+
+        /** Where the variable starts in the shared memory, and its length in values */
+        uint64_t offset;
+        uint64_t len;
+    };
+
+    /** The most processes reading at once */
+    size_t num_procs;
+
+    /** The most memory the chunk cache of each variable may use */
+    size_t chunk_cache_limit;
+
+    /** The reader processes, and the socket to each, if there are more than one */
+    std::vector<pid_t> pids;
+    std::vector<int> sockets;
+
+    /** Names the shared memory of each load apart */
+    size_t num_loads = 0;
+
+    /** The shared memory holding all the variables' data */
+    void* region = nullptr;
+    size_t region_size = 0;
+
+
+
+    //==========================================================================
+    // Private Methods
+    //==========================================================================
+
+    static bool send_all(int socket, const void* data, size_t len);
+    static bool recv_all(int socket, void* data, size_t len);
+    static bool send_u64(int socket, uint64_t value);
+    static bool recv_u64(int socket, uint64_t* value);
+    static bool send_string(int socket, const std::string& text);
+    static bool recv_string(int socket, std::string* text);
+    static bool wait_for(pid_t pid);
+
+    void release();
+
+    void stop();
+
+    void serve(int socket) const;
+
+    void read_job(const job_t& job, void* region) const;
+
+    template<typename T>
+    void read_var(const job_t& job, void* region) const;
+
+    void read_jobs(const std::vector<job_t>& jobs, size_t size);
+
+
+
+public:
+    //==========================================================================
+    // Public Methods
+    //==========================================================================
+
+    reader_pool_t(size_t num_procs);
+
+    reader_pool_t(size_t num_procs, size_t chunk_cache_limit);
+
+    /** The processes can't be shared, so a pool can't be copied */
+    reader_pool_t(const reader_pool_t&) = delete;
+    reader_pool_t& operator=(const reader_pool_t&) = delete;
+
+    ~reader_pool_t();
+
+    template<typename S, typename T>
+    void load(
+        std::vector<variable_t<S, T>*> vars,
+        std::vector<std::string> names,
+        std::vector<std::string> filenames
+    );
+};
+
+
+
+
+
+//==============================================================================
+// Implementation
+//==============================================================================
+
+#include "reader_pool.tpp"
+
+#endif
@@ -0,0 +1,459 @@
+/***********************************************************************
+ *                   GNU Lesser General Public License
+ *
+ * This file is part of the EDGI prototype package, developed by the
+ * GFDL Flexible Modeling System (FMS) group.
+ *
+ * EDGI is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * EDGI is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with EDGI.  If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************/
+
+// Note: This is not intended to be a standalone implementation file.
+
+#include "error.hpp"
+
+/** Use CACHE_LINE_SIZE */
+#include "scratch_arena.hpp"
+
+/** Use selection_t */
+#include "selection.hpp"
+
+/** Use std::is_same */
+#include <type_traits>
+
+/** Use fork, close, ftruncate, getpid, _exit */
+#include <unistd.h>
+
+/** Use waitpid */
+#include <sys/wait.h>
+
+/** Use mmap, munmap, shm_open, shm_unlink */
+#include <sys/mman.h>
+
+/** Use socketpair, send, recv */
+#include <sys/socket.h>
+
+/** Use O_CREAT, O_EXCL, O_RDWR */
+#include <fcntl.h>
+
+/** Use errno, EINTR */
+#include <cerrno>
+
+/** Use omp_set_num_threads */
+#include <omp.h>
+
+/** Use std::cout, std::cerr */
+#include <iostream>
+
+
+
+
+
+//==============================================================================
+// Messaging
+//==============================================================================
+
+/** Sends all `len` bytes of `data` down `socket`, returning whether it could */
+inline bool reader_pool_t::send_all(int socket, const void* data, size_t len) {
+    const char* bytes = (const char*) data;
+    while (len > 0) {
+        ssize_t sent = send(socket, bytes, len, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent <= 0) {
+            return false;
+        }
+        bytes += sent;
+        len -= sent;
+    }
+    return true;
+}
+
+/** Receives exactly `len` bytes from `socket`, returning whether it could */
+inline bool reader_pool_t::recv_all(int socket, void* data, size_t len) {
+    char* bytes = (char*) data;
+    while (len > 0) {
+        ssize_t got = recv(socket, bytes, len, 0);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            return false;
+        }
+        bytes += got;
+        len -= got;
+    }
+    return true;
+}
+
+inline bool reader_pool_t::send_u64(int socket, uint64_t value) {
+    return send_all(socket, &value, sizeof(value));
+}
+
+inline bool reader_pool_t::recv_u64(int socket, uint64_t* value) {
+    return recv_all(socket, value, sizeof(*value));
+}
+
+inline bool reader_pool_t::send_string(int socket, const std::string& text) {
+    return send_u64(socket, text.size()) && send_all(socket, text.data(), text.size());
+}
+
+inline bool reader_pool_t::recv_string(int socket, std::string* text) {
+    uint64_t len;
+    if (!recv_u64(socket, &len)) {
+        return false;
+    }
+    text->resize(len);
+    return len == 0 || recv_all(socket, &(*text)[0], len);
+}
+
+/** Waits for the process `pid` to end, returning whether it exited cleanly */
+inline bool reader_pool_t::wait_for(pid_t pid) {
+    int status;
+    pid_t result;
+    do {
+        result = waitpid(pid, &status, 0);
+    } while (result < 0 && errno == EINTR);
+
+    return result >= 0 && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+
+
+
+
+//==============================================================================
+// Constructing and Destructing
+//==============================================================================
+
+inline reader_pool_t::reader_pool_t(size_t num_procs)
+        : reader_pool_t(num_procs, variable_t<double, double>::DEFAULT_CHUNK_CACHE_LIMIT) {}
+
+/**
+ * Makes a pool of up to `num_procs` reader processes, each letting a variable
+ * cache up to `chunk_cache_limit` bytes of chunks. With only one, variables
+ * are read in this process, and nothing is forked.
+ */
+inline reader_pool_t::reader_pool_t(size_t num_procs, size_t chunk_cache_limit)
+        : num_procs(num_procs > 0 ? num_procs : 1), chunk_cache_limit(chunk_cache_limit) {
+
+    if (this->num_procs == 1) {
+        return;
+    }
+
+    // Output buffered now would otherwise be flushed by every child too
+    std::cout.flush();
+
+    for (size_t p = 0; p < this->num_procs; p++) {
+        int ends[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, ends) != 0) {
+            this->stop();
+            throw eof_error_t("Failed to connect to a reader process");
+        }
+
+        pid_t pid = fork();
+        if (pid < 0) {
+            close(ends[0]);
+            close(ends[1]);
+            this->stop();
+            throw eof_error_t("Failed to start a reader process");
+        }
+
+        if (pid == 0) {
+            // Only keep this reader's own end
+            for (int socket : this->sockets) {
+                close(socket);
+            }
+            close(ends[0]);
+
+            // Never return into the caller, which is the parent's code
+            try {
+                this->serve(ends[1]);
+            } catch (...) {
+                _exit(1);
+            }
+            _exit(0);
+        }
+
+        close(ends[1]);
+        this->pids.push_back(pid);
+        this->sockets.push_back(ends[0]);
+    }
+}
+
+inline reader_pool_t::~reader_pool_t() {
+    this->release();
+    this->stop();
+}
+
+
+
+
+
+//==============================================================================
+// Private Methods
+//==============================================================================
+
+inline void reader_pool_t::release() {
+    if (this->region != nullptr) {
+        munmap(this->region, this->region_size);
+        this->region = nullptr;
+        this->region_size = 0;
+    }
+}
+
+/** Ends the reader processes, each of which finishes once its socket is closed */
+inline void reader_pool_t::stop() {
+    for (int socket : this->sockets) {
+        close(socket);
+    }
+    for (pid_t pid : this->pids) {
+        wait_for(pid);
+    }
+    this->sockets.clear();
+    this->pids.clear();
+}
+
+/**
+ * Runs in a reader process, reading the variables it is sent through
+ * `socket` into the shared memory named with them, and answering with
+ * whether it could. Returns once the socket is closed.
+ */
+inline void reader_pool_t::serve(int socket) const {
+    // The readers run alongside each other, so each keeps to one thread
+    omp_set_num_threads(1);
+
+    while (true) {
+        std::string shm_name;
+        uint64_t size, num_jobs;
+        if (!recv_string(socket, &shm_name) || !recv_u64(socket, &size) || !recv_u64(socket, &num_jobs)) {
+            break;
+        }
+
+        std::vector<job_t> jobs(num_jobs);
+        bool received = true;
+        for (job_t& job : jobs) {
+            received = received && recv_all(socket, &job.type, 1)
+                && recv_string(socket, &job.name)
+                && recv_string(socket, &job.filename)
+                && recv_string(socket, &job.selection)
+                && recv_u64(socket, &job.offset)
+                && recv_u64(socket, &job.len);
+        }
+        if (!received) {
+            break;
+        }
+
+        char status = 1;
+        int fd = shm_open(shm_name.c_str(), O_RDWR, 0600);
+        void* region = (fd < 0) ? MAP_FAILED : mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (fd >= 0) {
+            close(fd);
+        }
+
+        if (region == MAP_FAILED) {
+            std::cerr << "A reader process couldn't map its shared memory" << std::endl;
+        } else {
+            status = 0;
+            try {
+                for (const job_t& job : jobs) {
+                    this->read_job(job, region);
+                }
+            } catch (const std::exception& e) {
+                std::cerr << e.what() << std::endl;
+                status = 1;
+            }
+            munmap(region, size);
+        }
+
+        if (!send_all(socket, &status, 1)) {
+            break;
+        }
+    }
+
+    close(socket);
+}
+
+inline void reader_pool_t::read_job(const job_t& job, void* region) const {
+    if (job.type == 'f') {
+        this->read_var<float>(job, region);
+    } else {
+        this->read_var<double>(job, region);
+    }
+}
+
+/**
+ * Reads the variable of `job`, of type T, into its place in `region`. It is
+ * opened afresh, so that no file handle (or file offset) is shared with the
+ * parent.
+ */
+template<typename T>
+void reader_pool_t::read_var(const job_t& job, void* region) const {
+    variable_t<T, T> var(job.name, job.filename, selection_t::from_string(job.selection));
+    var.set_chunk_cache_limit(this->chunk_cache_limit);
+
+    size_t num_dims = var.get_num_dims();
+    std::vector<size_t> start(num_dims, 0);
+    std::vector<size_t> count(num_dims);
+    size_t len = 1;
+    for (size_t d = 0; d < num_dims; d++) {
+        count[d] = var.get_dim(d)->get_size();
+        len *= count[d];
+    }
+    if (len != job.len) {
+        throw eof_error_t("\"" + job.name + "\" of \"" + job.filename + "\" changed while it was being read");
+    }
+
+    T* dst = (T*) ((unsigned char*) region + job.offset);
+    var.get_slice(start.data(), count.data(), dst);
+}
+
+/**
+ * Reads every job into a new shared region of `size` bytes, spread over the
+ * readers, and keeps the region as this->region.
+ */
+inline void reader_pool_t::read_jobs(const std::vector<job_t>& jobs, size_t size) {
+    if (this->pids.empty()) {
+        void* region = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (region == MAP_FAILED) {
+            throw eof_error_t("Failed to map memory for the input variables");
+        }
+        this->region = region;
+        this->region_size = size;
+
+        try {
+            for (const job_t& job : jobs) {
+                this->read_job(job, region);
+            }
+        } catch (...) {
+            this->release();
+            throw;
+        }
+        return;
+    }
+
+    // The readers are already running, so they can only share memory by name
+    std::string shm_name = "/edgi-readers-" + std::to_string(getpid()) + "-" + std::to_string(this->num_loads++);
+    int fd = shm_open(shm_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        throw eof_error_t("Failed to make shared memory for the reader processes");
+    }
+
+    void* region = MAP_FAILED;
+    if (ftruncate(fd, size) == 0) {
+        region = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (region == MAP_FAILED) {
+        shm_unlink(shm_name.c_str());
+        throw eof_error_t("Failed to map shared memory for the reader processes");
+    }
+    this->region = region;
+    this->region_size = size;
+
+    // Deal the variables out in turn to as many readers as there are variables
+    size_t num_procs = (this->pids.size() < jobs.size()) ? this->pids.size() : jobs.size();
+    bool failed = false;
+    for (size_t p = 0; p < num_procs; p++) {
+        int socket = this->sockets[p];
+        size_t num_jobs = (jobs.size() - p + num_procs - 1) / num_procs;
+        bool sent = send_string(socket, shm_name) && send_u64(socket, size) && send_u64(socket, num_jobs);
+        for (size_t i = p; i < jobs.size() && sent; i += num_procs) {
+            const job_t& job = jobs[i];
+            sent = send_all(socket, &job.type, 1)
+                && send_string(socket, job.name)
+                && send_string(socket, job.filename)
+                && send_string(socket, job.selection)
+                && send_u64(socket, job.offset)
+                && send_u64(socket, job.len);
+        }
+        if (!sent) {
+            failed = true;
+            num_procs = p;
+            break;
+        }
+    }
+
+    for (size_t p = 0; p < num_procs; p++) {
+        char status;
+        if (!recv_all(this->sockets[p], &status, 1) || status != 0) {
+            failed = true;
+        }
+    }
+
+    shm_unlink(shm_name.c_str());
+
+    if (failed) {
+        this->release();
+        throw eof_error_t("A reader process failed to read its input variables");
+    }
+}
+
+
+
+
+
+//==============================================================================
+// Public Methods
+//==============================================================================
+
+/**
+ * Reads the data of the lazy variables `vars`, the variables `names` of the
+ * files `filenames`, in parallel, and maps each into its variable. Any
+ * variables loaded earlier by this pool must have been deleted first.
+ */
+template<typename S, typename T>
+void reader_pool_t::load(
+    std::vector<variable_t<S, T>*> vars,
+    std::vector<std::string> names,
+    std::vector<std::string> filenames
+) {
+    static_assert(std::is_same<S, T>::value, "Only real-valued variables are read by a reader pool");
+    static_assert(std::is_same<T, float>::value || std::is_same<T, double>::value,
+        "Only float and double variables are read by a reader pool");
+
+    size_t num_vars = vars.size();
+    if (names.size() != num_vars || filenames.size() != num_vars) {
+        throw eof_error_t("(Internal Error) Every variable needs a name and a file to be read from");
+    }
+
+    // Lay the variables out one after another, each starting on a cache line
+    std::vector<job_t> jobs(num_vars);
+    size_t total = 0;
+    for (size_t i = 0; i < num_vars; i++) {
+        size_t len = 1;
+        for (size_t d = 0; d < vars[i]->get_num_dims(); d++) {
+            len *= vars[i]->get_dim(d)->get_size();
+        }
+
+        jobs[i].type = std::is_same<T, float>::value ? 'f' : 'd';
+        jobs[i].name = names[i];
+        jobs[i].filename = filenames[i];
+        jobs[i].selection = vars[i]->get_selection().to_string();
+        jobs[i].offset = total;
+        jobs[i].len = len;
+        total += (len * sizeof(S) + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+    }
+
+    this->release();
+    if (total == 0) {
+        return;
+    }
+
+    this->read_jobs(jobs, total);
+
+    for (size_t i = 0; i < num_vars; i++) {
+        vars[i]->map_data((S*) ((unsigned char*) this->region + jobs[i].offset));
+    }
+}
@@ -0,0 +1,84 @@
+/***********************************************************************
+ *                   GNU Lesser General Public License
+ *
+ * This file is part of the EDGI prototype package, developed by the
+ * GFDL Flexible Modeling System (FMS) group.
+ *
+ * EDGI is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * EDGI is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with EDGI.  If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************/
+
+#include "scratch_arena.hpp"
+
+/** Use posix_memalign, free */
+#include <cstdlib>
+
+
+
+
+
+//==============================================================================
+// Constructors and destructors
+//==============================================================================
+
+scratch_arena_t::scratch_arena_t() {
+    // nothing to do
+}
+
+scratch_arena_t::~scratch_arena_t() {
+    free(this->data);
+}
+
+
+
+
+
+//==============================================================================
+// Public Methods
+//==============================================================================
+
+void scratch_arena_t::reserve_bytes(size_t num_threads, size_t num_slots, size_t num_bytes) {
+    // Round every slot up to a whole number of cache lines so that slots (and
+    // therefore threads) never share a line
+    size_t slot_size = ((num_bytes + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE) * CACHE_LINE_SIZE;
+    size_t total = num_threads * num_slots * slot_size;
+
+    if (total > this->capacity) {
+        free(this->data);
+        this->data = nullptr;
+        this->capacity = 0;
+
+        void* ptr = nullptr;
+        if (posix_memalign(&ptr, CACHE_LINE_SIZE, total) != 0) {
+            throw eof_error_t("Failed to allocate scratch memory");
+        }
+        this->data = (unsigned char*) ptr;
+        this->capacity = total;
+    }
+
+    this->num_threads = num_threads;
+    this->num_slots = num_slots;
+    this->slot_size = slot_size;
+}
+
+size_t scratch_arena_t::get_num_threads() const {
+    return this->num_threads;
+}
+
+size_t scratch_arena_t::get_num_slots() const {
+    return this->num_slots;
+}
+
+size_t scratch_arena_t::get_slot_size() const {
+    return this->slot_size;
+}
@@ -0,0 +1,130 @@
+/***********************************************************************
+ *                   GNU Lesser General Public License
+ *
+ * This file is part of the EDGI prototype package, developed by the
+ * GFDL Flexible Modeling System (FMS) group.
+ *
+ * EDGI is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * EDGI is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with EDGI.  If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************/
+
+#ifndef SCRATCH_ARENA_HPP
+#define SCRATCH_ARENA_HPP
+
+/** Use size_t */
+#include <cstddef>
+
+#include "error.hpp"
+
+
+
+
+
+//==============================================================================
+// Constants
+//==============================================================================
+
+/**
+ * Size (in bytes) of a cache line. Every buffer handed out by a scratch arena
+ * starts on a boundary of this size and is padded to a multiple of it.
+ */
+const size_t CACHE_LINE_SIZE = 64;
+
+
+
+
+
+//==============================================================================
+// Declaration
+//==============================================================================
+
+/**
+ * Per-thread scratch memory for the column kernels. The owner sizes the arena
+ * once per call with reserve(), after which each of `num_threads` threads may
+ * borrow `num_slots` buffers from it. Buffers are cache-line aligned and
+ * padded so that no two threads ever share a line, and the arena only grows,
+ * so repeated calls don't churn the heap.
+ */
+class scratch_arena_t {
+private:
+    size_t num_threads = 0;
+
+    size_t num_slots = 0;
+
+    /** Size of each slot in bytes, always a multiple of CACHE_LINE_SIZE */
+    size_t slot_size = 0;
+
+    /** Number of bytes currently allocated */
+    size_t capacity = 0;
+
+    unsigned char* data = nullptr;
+
+public:
+    scratch_arena_t();
+
+    /** The buffers are owned, so an arena can't be copied */
+    scratch_arena_t(const scratch_arena_t&) = delete;
+    scratch_arena_t& operator=(const scratch_arena_t&) = delete;
+
+    ~scratch_arena_t();
+
+    /**
+     * Makes room for `num_slots` buffers of at least `num_bytes` bytes for
+     * each of `num_threads` threads. Any previously borrowed buffers become
+     * invalid.
+     */
+    void reserve_bytes(size_t num_threads, size_t num_slots, size_t num_bytes);
+
+    /**
+     * Makes room for `num_slots` buffers of `len` elements of type T for each
+     * of `num_threads` threads
+     */
+    template<typename T>
+    void reserve(size_t num_threads, size_t num_slots, size_t len);
+
+    /**
+     * Returns buffer `slot` belonging to thread `thread`
+     */
+    template<typename T>
+    T* get(size_t thread, size_t slot) const;
+
+    size_t get_num_threads() const;
+
+    size_t get_num_slots() const;
+
+    size_t get_slot_size() const;
+};
+
+
+
+
+
+//==============================================================================
+// Template Implementation
+//==============================================================================
+
+template<typename T>
+void scratch_arena_t::reserve(size_t num_threads, size_t num_slots, size_t len) {
+    this->reserve_bytes(num_threads, num_slots, len * sizeof(T));
+}
+
+template<typename T>
+T* scratch_arena_t::get(size_t thread, size_t slot) const {
+    if (thread >= this->num_threads || slot >= this->num_slots) {
+        throw eof_error_t("(Internal Error) Scratch buffer requested outside of the reserved arena");
+    }
+
+    return reinterpret_cast<T*>(this->data + (thread * this->num_slots + slot) * this->slot_size);
+}
+
+#endif
@@ -0,0 +1,232 @@
+/***********************************************************************
+ *                   GNU Lesser General Public License
+ *
+ * This file is part of the EDGI prototype package, developed by the
+ * GFDL Flexible Modeling System (FMS) group.
+ *
+ * EDGI is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * EDGI is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with EDGI.  If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************/
+
+#include "selection.hpp"
+
+#include "error.hpp"
+
+/** Use std::min, std::swap */
+#include <algorithm>
+
+/** Use HUGE_VAL */
+#include <cmath>
+
+/** Use std::logic_error */
+#include <stdexcept>
+
+/** Use std::ostringstream */
+#include <sstream>
+
+
+
+
+
+//==============================================================================
+// Private Methods
+//==============================================================================
+
+const selection_t::range_t* selection_t::find(const std::string dim) const {
+    for (const range_t& range : this->ranges) {
+        if (range.dim == dim) {
+            return &range;
+        }
+    }
+    return nullptr;
+}
+
+
+
+
+
+//==============================================================================
+// Public Methods
+//==============================================================================
+
+void selection_t::add(const std::string spec, bool by_index) {
+    size_t eq = spec.find('=');
+    if (eq == std::string::npos || eq == 0) {
+        throw eof_error_t("Invalid selection format: '" + spec + "'");
+    }
+
+    range_t range;
+    range.dim = spec.substr(0, eq);
+    range.by_index = by_index;
+    range.has_first = false;
+    range.has_last = false;
+    range.first = 0;
+    range.last = 0;
+    range.stride = 1;
+
+    if (this->has_dim(range.dim)) {
+        throw eof_error_t("Dimension \"" + range.dim + "\" is selected more than once");
+    }
+
+    // Empty fields count, even at the end, as in "90:"
+    std::vector<std::string> words;
+    size_t begin = eq + 1;
+    while (true) {
+        size_t colon = spec.find(':', begin);
+        words.push_back(spec.substr(begin, colon - begin));
+        if (colon == std::string::npos) {
+            break;
+        }
+        begin = colon + 1;
+    }
+    if (words.size() < 2 || words.size() > 3) {
+        throw eof_error_t("Invalid selection format: '" + spec + "'");
+    }
+
+    try {
+        if (!words[0].empty()) {
+            range.has_first = true;
+            range.first = std::stod(words[0]);
+        }
+        if (!words[1].empty()) {
+            range.has_last = true;
+            range.last = std::stod(words[1]);
+        }
+        if (words.size() == 3 && !words[2].empty()) {
+            long stride = std::stol(words[2]);
+            if (stride < 1) {
+                throw eof_error_t("Selection strides must be positive: '" + spec + "'");
+            }
+            range.stride = (size_t) stride;
+        }
+    } catch (const std::logic_error&) {
+        throw eof_error_t("Invalid selection format: '" + spec + "'");
+    }
+
+    if (by_index && ((range.has_first && range.first < 0) || (range.has_last && range.last < 0))) {
+        throw eof_error_t("Selected indices cannot be negative: '" + spec + "'");
+    }
+
+    this->ranges.push_back(range);
+}
+
+bool selection_t::empty() const {
+    return this->ranges.empty();
+}
+
+bool selection_t::has_dim(const std::string dim) const {
+    return this->find(dim) != nullptr;
+}
+
+std::string selection_t::to_string() const {
+    std::ostringstream text;
+    text.precision(17);
+    for (const range_t& range : this->ranges) {
+        text << range.dim << (range.by_index ? "#" : "=");
+        if (range.has_first) {
+            text << range.first;
+        }
+        text << ":";
+        if (range.has_last) {
+            text << range.last;
+        }
+        text << ":" << range.stride << ";";
+    }
+    return text.str();
+}
+
+selection_t selection_t::from_string(const std::string text) {
+    selection_t selection;
+    size_t begin = 0;
+    while (begin < text.size()) {
+        size_t end = text.find(';', begin);
+        if (end == std::string::npos) {
+            end = text.size();
+        }
+
+        // The numbers never hold '=' or '#', so the last one ends the name
+        std::string spec = text.substr(begin, end - begin);
+        size_t sep = spec.find_last_of("=#");
+        if (sep == std::string::npos) {
+            throw eof_error_t("Invalid selection format: '" + spec + "'");
+        }
+        bool by_index = (spec[sep] == '#');
+        spec[sep] = '=';
+        selection.add(spec, by_index);
+
+        begin = end + 1;
+    }
+    return selection;
+}
+
+void selection_t::resolve(const std::string dim, size_t len, const std::vector<double>& values,
+        size_t* start, size_t* count, size_t* stride) const {
+    const range_t* range = this->find(dim);
+    if (range == nullptr) {
+        *start = 0;
+        *count = len;
+        *stride = 1;
+        return;
+    }
+
+    if (len == 0) {
+        throw eof_error_t("The selection of dimension \"" + dim + "\" is empty");
+    }
+
+    // The first and last steps in the range, inclusive
+    size_t first = 0;
+    size_t last = len - 1;
+    if (range->by_index) {
+        if (range->has_first) {
+            first = (size_t) range->first;
+        }
+        if (range->has_last) {
+            last = std::min((size_t) range->last, len - 1);
+        }
+    } else {
+        // Coordinates may run either way, so the range is taken as the steps
+        // between its ends, whichever way around they are given
+        double low = range->has_first ? range->first : -HUGE_VAL;
+        double high = range->has_last ? range->last : HUGE_VAL;
+        if (range->has_first && range->has_last && low > high) {
+            std::swap(low, high);
+        }
+
+        bool found = false;
+        for (size_t i = 0; i < len; i++) {
+            if (values[i] < low || values[i] > high) {
+                continue;
+            }
+
+            if (!found) {
+                first = i;
+                found = true;
+            } else if (last + 1 != i) {
+                throw eof_error_t("The coordinates of dimension \"" + dim + "\" are not monotonic, so they cannot be selected by value");
+            }
+            last = i;
+        }
+
+        if (!found) {
+            throw eof_error_t("The selection of dimension \"" + dim + "\" is empty");
+        }
+    }
+
+    if (first > last) {
+        throw eof_error_t("The selection of dimension \"" + dim + "\" is empty");
+    }
+
+    *start = first;
+    *stride = range->stride;
+    *count = (last - first) / range->stride + 1;
+}
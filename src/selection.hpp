@@ -0,0 +1,123 @@
+/***********************************************************************
+ *                   GNU Lesser General Public License
+ *
+ * This file is part of the EDGI prototype package, developed by the
+ * GFDL Flexible Modeling System (FMS) group.
+ *
+ * EDGI is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * EDGI is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with EDGI.  If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************/
+
+#ifndef SELECTION_HPP
+#define SELECTION_HPP
+
+/** Use size_t */
+#include <cstddef>
+
+/** Use std::string */
+#include <string>
+
+/** Use std::vector */
+#include <vector>
+
+
+
+
+
+//==============================================================================
+// Declaration
+//==============================================================================
+
+/**
+ * The part of each dimension of the inputs to analyze, as hyperslabs like
+ * those of nc_get_vars: a range of steps and a stride through it. Ranges are
+ * given either as coordinate values or as indices, and both ends are
+ * included. Dimensions without a range are read whole.
+ */
+class selection_t {
+private:
+    //==========================================================================
+    // Private Fields
+    //==========================================================================
+
+    struct range_t {
+        std::string dim;
+
+        /** Are first and last indices rather than coordinate values? */
+        bool by_index;
+
+        bool has_first;
+        double first;
+
+        bool has_last;
+        double last;
+
+        size_t stride;
+    };
+
+    std::vector<range_t> ranges;
+
+
+
+    //==========================================================================
+    // Private Methods
+    //==========================================================================
+
+    const range_t* find(const std::string dim) const;
+
+
+
+public:
+    //==========================================================================
+    // Public Methods
+    //==========================================================================
+
+    /**
+     * Adds the range `spec`, formatted as <dim>=<first>:<last>[:<stride>],
+     * where first and last may be left out to run to the ends of the
+     * dimension. They are indices if `by_index`, and coordinate values
+     * otherwise. Each dimension can only have one range.
+     */
+    void add(const std::string spec, bool by_index);
+
+    /**
+     * Returns whether nothing is selected, so that variables are read whole
+     */
+    bool empty() const;
+
+    /**
+     * Returns whether dimension `dim` has a range
+     */
+    bool has_dim(const std::string dim) const;
+
+    /**
+     * Returns the ranges as text, which is the same for equal selections
+     * (such as for keying caches)
+     */
+    std::string to_string() const;
+
+    /**
+     * Returns the selection with the ranges `text`, as given by to_string
+     */
+    static selection_t from_string(const std::string text);
+
+    /**
+     * Finds the steps of dimension `dim`, of length `len` and with the
+     * (monotonic) coordinates `values`, to read: `count` steps from `start`,
+     * `stride` apart. Throws an eof_error_t if the range selects nothing.
+     */
+    void resolve(const std::string dim, size_t len, const std::vector<double>& values,
+        size_t* start, size_t* count, size_t* stride) const;
+};
+
+#endif
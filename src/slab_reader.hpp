@@ -0,0 +1,63 @@
+/***********************************************************************
+ *                   GNU Lesser General Public License
+ *
+ * This file is part of the EDGI prototype package, developed by the
+ * GFDL Flexible Modeling System (FMS) group.
+ *
+ * EDGI is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * EDGI is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with EDGI.  If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************/
+
+#ifndef SLAB_READER_HPP
+#define SLAB_READER_HPP
+
+/** Use size_t */
+#include <cstddef>
+
+
+
+
+
+//=============================================================================
+// Declaration of Abstract Class slab_reader_t
+//=============================================================================
+
+/**
+ * Reads hyperslabs of one variable of a file without going through the
+ * NetCDF library. Lazy variables use one when it supports their file and
+ * fall back to netcdf_file_t otherwise.
+ */
+class slab_reader_t {
+public:
+    virtual ~slab_reader_t() {}
+
+    /**
+     * Returns whether this reader can read its variable
+     */
+    virtual bool is_supported() const = 0;
+
+    /**
+     * Reads the hyperslab given by start and count (as in nc_get_vara) into
+     * vals, which must hold the product of count values
+     */
+    virtual void read(const size_t* start, const size_t* count, float* vals) const = 0;
+
+    virtual void read(const size_t* start, const size_t* count, double* vals) const = 0;
+
+    /**
+     * Reads values as short, for packed variables stored that way
+     */
+    virtual void read(const size_t* start, const size_t* count, short* vals) const = 0;
+};
+
+#endif
@@ -39,6 +39,9 @@
 /** Use matrix_reducer_t */
 #include "matrix_reducer.hpp"
 
+/** Use split_variable_t */
+#include "split_variable.hpp"
+
 
 
 
@@ -48,6 +51,9 @@ private:
 
     dft_t<T>* dft = nullptr;
 
+    /** Per-thread column buffers lent to the transform */
+    scratch_arena_t scratch;
+
     std::vector<variable_t<std::complex<T>, T>*> get_spectra(
         std::vector<variable_t<S, T>*> input_vars,
         std::string input_dim,
@@ -118,6 +124,25 @@ public:
         const size_t input_nthreads
     );
 
+    /**
+     * Analytic signals of real variables, with the real parts (the inputs)
+     * and imaginary parts (their Hilbert transforms) kept separate
+     */
+    std::vector<split_variable_t<T>*> analytic_split(
+        std::vector<variable_t<S, T>*> input_vars,
+        const std::string input_dim,
+        const size_t input_nthreads
+    );
+
+    /**
+     * The variables analytic_split would make of `input_vars` (with their
+     * dimensions, attributes and sources), but without their values, for
+     * when the EOFs are resumed from a covariance checkpoint instead
+     */
+    std::vector<split_variable_t<T>*> analytic_split_metadata(
+        std::vector<variable_t<S, T>*> input_vars
+    );
+
 };
 
 
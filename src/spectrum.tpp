@@ -31,6 +31,7 @@
 template<typename S, typename T>
 spectrum_t<S, T>::spectrum_t() {
     this->dft = new basic_dft_t<T>();
+    this->dft->set_scratch(&this->scratch);
 }
 
 template<typename S, typename T>
@@ -41,6 +42,7 @@ template<typename S, typename T>
 void spectrum_t<S, T>::set_dft(dft_t<T>* dft) {
     delete this->dft;
     this->dft = dft;
+    this->dft->set_scratch(&this->scratch);
 }
 
 template<typename S, typename T>
@@ -296,3 +298,84 @@ std::vector<variable_t<std::complex<T>, T>*> spectrum_t<S, T>::analytic(
 
     return output_vars;
 }
+
+
+template<typename S, typename T>
+std::vector<split_variable_t<T>*> spectrum_t<S, T>::analytic_split(
+    std::vector<variable_t<S, T>*> input_vars,
+    const std::string input_dim,
+    const size_t input_nthreads
+) {
+    static_assert(std::is_same<S, T>::value, "Analytic signals are only computed for real-valued data");
+
+    if (input_vars.size() == 0) {
+        throw eof_error_t("No variables to be analyzed");
+    }
+
+    std::vector<split_variable_t<T>*> output_vars;
+
+    for (size_t i = 0; i < input_vars.size(); i++) {
+        variable_t<T, T>* var = input_vars[i];
+        matrix_t<T>* unreduced = var->to_matrix(input_dim);
+
+        matrix_reducer_t<T>* reducer;
+        if (var->has_missing_value()) {
+            reducer = new matrix_reducer_t<T>(unreduced, var->get_missing_value());
+        } else {
+            reducer = new matrix_reducer_t<T>(unreduced, always_false<T>());
+        }
+
+        matrix_t<T>* reduced = reducer->reduce(unreduced);
+        delete unreduced;
+
+        matrix_t<T> transformed;
+        this->dft->hilbert(reduced, &transformed);
+
+        T fill = T(10) * var->get_absmax();
+        matrix_t<T>* restored_re = reducer->restore(reduced, fill);
+        matrix_t<T>* restored_im = reducer->restore(&transformed, fill);
+
+        dimension_t<T>* same_dim = (dimension_t<T>*)var->get_dim(input_dim);
+        variable_t<T, T>* re = var->from_matrix(restored_re, input_dim, same_dim);
+        variable_t<T, T>* im = var->from_matrix(restored_im, input_dim, same_dim);
+        re->set_attrs(var->get_num_attrs(), var->get_attrs());
+        im->set_attrs(var->get_num_attrs(), var->get_attrs());
+        re->set_derived_from(var, "analytic re");
+        im->set_derived_from(var, "analytic im");
+
+        delete restored_re;
+        delete restored_im;
+        delete reduced;
+        delete reducer;
+
+        output_vars.push_back(new split_variable_t<T>(re, im));
+    }
+
+    return output_vars;
+}
+
+template<typename S, typename T>
+std::vector<split_variable_t<T>*> spectrum_t<S, T>::analytic_split_metadata(
+    std::vector<variable_t<S, T>*> input_vars
+) {
+    static_assert(std::is_same<S, T>::value, "Analytic signals are only computed for real-valued data");
+
+    if (input_vars.size() == 0) {
+        throw eof_error_t("No variables to be analyzed");
+    }
+
+    std::vector<split_variable_t<T>*> output_vars;
+
+    // Both parts are opened lazily from the input, so nothing is read
+    for (size_t i = 0; i < input_vars.size(); i++) {
+        variable_t<T, T>* var = input_vars[i];
+        variable_t<T, T>* re = new variable_t<T, T>(var->get_source_name(), var->get_source_filename(), var->get_selection());
+        variable_t<T, T>* im = new variable_t<T, T>(var->get_source_name(), var->get_source_filename(), var->get_selection());
+        re->set_derived_from(var, "analytic re");
+        im->set_derived_from(var, "analytic im");
+
+        output_vars.push_back(new split_variable_t<T>(re, im));
+    }
+
+    return output_vars;
+}
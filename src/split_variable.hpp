@@ -0,0 +1,114 @@
+/***********************************************************************
+ *                   GNU Lesser General Public License
+ *
+ * This file is part of the EDGI prototype package, developed by the
+ * GFDL Flexible Modeling System (FMS) group.
+ *
+ * EDGI is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * EDGI is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with EDGI.  If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************/
+
+#ifndef SPLIT_VARIABLE_HPP
+#define SPLIT_VARIABLE_HPP
+
+/** Use variable_t */
+#include "variable.hpp"
+
+/** Use netcdf_file_t */
+#include "netcdf_file.hpp"
+
+/** Use std::string */
+#include <string>
+
+/** Use std::pair */
+#include <utility>
+
+
+
+
+
+//==============================================================================
+// Declaration
+//==============================================================================
+
+/**
+ * A complex-valued variable stored as two real variables, one holding the
+ * real parts and one the imaginary parts (structure of arrays). Both parts
+ * share the same dimensions. Unlike complex_variable_t, nothing is ever
+ * interleaved: the parts are read, analyzed and written as they are.
+ */
+template<typename T>
+class split_variable_t {
+private:
+    //==========================================================================
+    // Private Fields
+    //==========================================================================
+
+    /** The real parts */
+    variable_t<T, T>* re = nullptr;
+
+    /** The imaginary parts */
+    variable_t<T, T>* im = nullptr;
+
+
+
+public:
+    //==========================================================================
+    // Public Methods
+    //==========================================================================
+
+    /**
+     * Takes ownership of both parts, which must have the same shape
+     */
+    split_variable_t(variable_t<T, T>* re, variable_t<T, T>* im);
+
+    /**
+     * Opens the real and imaginary parts of the complex values of variable
+     * `name` lazily, from its compound type or, if `part_dim` is not empty,
+     * from its trailing dimension `part_dim` of length 2
+     */
+    split_variable_t(const std::string name, const std::string filename, const selection_t& selection, const std::string part_dim);
+
+    ~split_variable_t();
+
+    const variable_t<T, T>* get_re() const;
+
+    const variable_t<T, T>* get_im() const;
+
+    size_t get_num_dims() const;
+
+    bool has_dim(const std::string name) const;
+
+    const dimension_t<T>* get_dim(const std::string name) const;
+
+    void set_chunk_cache_limit(size_t bytes);
+
+    std::pair<matrix_t<T>*, matrix_t<T>*> to_matrices(const std::string dim_name) const;
+
+    void write(const std::string name_re, const std::string name_im, netcdf_file_t* file) const;
+
+    template<typename W>
+    void add_to(W* writer, const std::string name_re, const std::string name_im) const;
+};
+
+
+
+
+
+//==============================================================================
+// Implementation
+//==============================================================================
+
+#include "split_variable.tpp"
+
+#endif
@@ -0,0 +1,161 @@
+/***********************************************************************
+ *                   GNU Lesser General Public License
+ *
+ * This file is part of the EDGI prototype package, developed by the
+ * GFDL Flexible Modeling System (FMS) group.
+ *
+ * EDGI is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * EDGI is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with EDGI.  If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************/
+
+// Note: This is not intended to be a standalone implementation file.
+
+#include "error.hpp"
+
+
+
+
+
+//==============================================================================
+// Constructing and Destructing
+//==============================================================================
+
+template<typename T>
+split_variable_t<T>::split_variable_t(variable_t<T, T>* re, variable_t<T, T>* im) {
+    if (re->get_num_dims() != im->get_num_dims()) {
+        throw eof_error_t("Real and imaginary parts have different numbers of dimensions");
+    }
+    for (size_t i = 0; i < re->get_num_dims(); i++) {
+        if (re->get_dim(i)->get_size() != im->get_dim(i)->get_size()) {
+            throw eof_error_t("Real and imaginary parts have different shapes");
+        }
+    }
+
+    this->re = re;
+    this->im = im;
+}
+
+template<typename T>
+split_variable_t<T>::split_variable_t(const std::string name, const std::string filename, const selection_t& selection, const std::string part_dim) {
+    this->re = new variable_t<T, T>();
+    this->im = new variable_t<T, T>();
+
+    try {
+        this->re->load_part_lazily_from_netcdf(name, filename, selection, 0, part_dim);
+        this->im->load_part_lazily_from_netcdf(name, filename, selection, 1, part_dim);
+    } catch (...) {
+        delete this->re;
+        delete this->im;
+        throw;
+    }
+}
+
+template<typename T>
+split_variable_t<T>::~split_variable_t() {
+    delete this->re;
+    delete this->im;
+}
+
+
+
+
+
+//==============================================================================
+// Getting Fields
+//==============================================================================
+
+template<typename T>
+const variable_t<T, T>* split_variable_t<T>::get_re() const {
+    return this->re;
+}
+
+template<typename T>
+const variable_t<T, T>* split_variable_t<T>::get_im() const {
+    return this->im;
+}
+
+template<typename T>
+void split_variable_t<T>::set_chunk_cache_limit(size_t bytes) {
+    this->re->set_chunk_cache_limit(bytes);
+    this->im->set_chunk_cache_limit(bytes);
+}
+
+template<typename T>
+size_t split_variable_t<T>::get_num_dims() const {
+    return this->re->get_num_dims();
+}
+
+template<typename T>
+bool split_variable_t<T>::has_dim(const std::string name) const {
+    return this->re->has_dim(name);
+}
+
+template<typename T>
+const dimension_t<T>* split_variable_t<T>::get_dim(const std::string name) const {
+    return this->re->get_dim(name);
+}
+
+
+
+
+
+//==============================================================================
+// Reading
+//==============================================================================
+
+/**
+ * Reads both parts into matrices laid out as by variable_t::to_matrix. Parts
+ * of one complex variable in the file are read together, with one read.
+ */
+template<typename T>
+std::pair<matrix_t<T>*, matrix_t<T>*> split_variable_t<T>::to_matrices(const std::string dim_name) const {
+    if (this->re->is_complex_part()) {
+        matrix_t<T>* re_mat;
+        matrix_t<T>* im_mat;
+        this->re->to_part_matrices(dim_name, &re_mat, &im_mat);
+        return std::pair<matrix_t<T>*, matrix_t<T>*>(re_mat, im_mat);
+    }
+
+    matrix_t<T>* re_mat = this->re->to_matrix(dim_name);
+    matrix_t<T>* im_mat = this->im->to_matrix(dim_name);
+    return std::pair<matrix_t<T>*, matrix_t<T>*>(re_mat, im_mat);
+}
+
+
+
+
+
+//==============================================================================
+// Writing
+//==============================================================================
+
+/**
+ * Writes each part as its own real variable, straight from its own buffer
+ */
+template<typename T>
+void split_variable_t<T>::write(const std::string name_re, const std::string name_im, netcdf_file_t* file) const {
+    netcdf_writer_t writer(file);
+    this->add_to(&writer, name_re, name_im);
+    writer.commit();
+}
+
+/**
+ * Plans both parts in a writer (netcdf_writer_t or zarr_writer_t), to be
+ * written along with everything else in it
+ */
+template<typename T>
+template<typename W>
+void split_variable_t<T>::add_to(W* writer, const std::string name_re, const std::string name_im) const {
+    writer->add(this->re, name_re);
+    writer->add(this->im, name_im);
+}
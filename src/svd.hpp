@@ -69,15 +69,51 @@ public:
 // Declaration of Class basic_svd_t
 //=============================================================================
 
+/**
+ * A dependency-free solver for the Hermitian (covariance) matrices EOFs are
+ * computed from: the singular value decomposition is found through the
+ * eigendecomposition, by a Householder reduction to a real tridiagonal
+ * matrix followed by implicit QL iterations, both parallelized with OpenMP.
+ * Results are laid out as by the LAPACK backends, with singular values in
+ * decreasing order.
+ */
 template<typename T>
 class basic_svd_t : public svd_t<T> {
+private:
+    size_t num_threads;
+
+    /**
+     * The decomposition itself, written once for real (U = T) and complex
+     * (U = std::complex<T>) input
+     */
+    template<typename U>
+    void solve(
+        matrix_t<U>* input,
+        matrix_t<U>* u,
+        matrix_t<T>* s,
+        matrix_t<U>* vt
+    );
+
 public:
+    /**
+     * Create an instance running on the default number of threads
+     */
     basic_svd_t();
+
+    /**
+     * Create an instance running on the specified number of threads
+     */
+    basic_svd_t(size_t num_threads);
     
     ~basic_svd_t();
+
+    /**
+     * Set the number of threads to run on
+     */
+    void set_num_threads(size_t num_threads);
     
     /**
-     * 
+     * Decomposes the square Hermitian matrix `input`, which is overwritten
      */
     void calculate(
         matrix_t<T>* input,
@@ -87,7 +123,7 @@ public:
     );
     
     /**
-     * 
+     * Decomposes the square Hermitian matrix `input`, which is overwritten
      */
     void calculate(
         matrix_t<std::complex<T>>* input,
@@ -20,6 +20,534 @@
 
 #include "svd.hpp"
 
+#include "error.hpp"
+
+/** Use std::sqrt, std::abs, std::hypot */
+#include <cmath>
+
+/** Use std::numeric_limits */
+#include <limits>
+
+/** Use std::vector */
+#include <vector>
+
+/** Use std::sort */
+#include <algorithm>
+
+/** Use std::mt19937, std::normal_distribution */
+#include <random>
+
+/** Use std::cout */
+#include <iostream>
+
+#include <ctime>
+#include <omp.h>
+
+
+
+
+
+//=============================================================================
+// Local Helper Functions
+//=============================================================================
+
+/** Entries of each vector a thread works through at once, when updating many vectors */
+static const size_t SVD_COLUMN_BLOCK = 256;
+
+/** Most implicit QL iterations spent on one eigenvalue */
+static const size_t SVD_MAX_ITERATIONS = 60;
+
+/** Seed of the random starting vectors, so that runs are repeatable */
+static const unsigned SVD_RANDOM_SEED = 20160501;
+
+template<typename T>
+static T conj_of(T x) {
+    return x;
+}
+
+template<typename T>
+static std::complex<T> conj_of(std::complex<T> x) {
+    return std::conj(x);
+}
+
+template<typename T>
+static T real_of(T x) {
+    return x;
+}
+
+template<typename T>
+static T real_of(std::complex<T> x) {
+    return x.real();
+}
+
+/** Squared magnitude */
+template<typename T>
+static T norm_of(T x) {
+    return x * x;
+}
+
+template<typename T>
+static T norm_of(std::complex<T> x) {
+    return std::norm(x);
+}
+
+/** Sum of x[i] * y[i], vectorized as a reduction */
+template<typename T>
+static T dot_of(const T* x, const T* y, size_t m) {
+    T sum = 0;
+    #pragma omp simd reduction(+:sum)
+    for (size_t i = 0; i < m; i++) {
+        sum += x[i] * y[i];
+    }
+    return sum;
+}
+
+template<typename T>
+static std::complex<T> dot_of(const std::complex<T>* x, const std::complex<T>* y, size_t m) {
+    T re = 0;
+    T im = 0;
+    #pragma omp simd reduction(+:re, im)
+    for (size_t i = 0; i < m; i++) {
+        re += x[i].real() * y[i].real() - x[i].imag() * y[i].imag();
+        im += x[i].real() * y[i].imag() + x[i].imag() * y[i].real();
+    }
+    return std::complex<T>(re, im);
+}
+
+/** Sum of conj(x[i]) * y[i], the inner product of x and y */
+template<typename T>
+static T inner_of(const T* x, const T* y, size_t m) {
+    return dot_of(x, y, m);
+}
+
+template<typename T>
+static std::complex<T> inner_of(const std::complex<T>* x, const std::complex<T>* y, size_t m) {
+    T re = 0;
+    T im = 0;
+    #pragma omp simd reduction(+:re, im)
+    for (size_t i = 0; i < m; i++) {
+        re += x[i].real() * y[i].real() + x[i].imag() * y[i].imag();
+        im += x[i].real() * y[i].imag() - x[i].imag() * y[i].real();
+    }
+    return std::complex<T>(re, im);
+}
+
+/** Fills `x` with standard normal values */
+template<typename T>
+static void random_fill(T* x, size_t m, std::mt19937* rng) {
+    std::normal_distribution<T> dist;
+    for (size_t i = 0; i < m; i++) {
+        x[i] = dist(*rng);
+    }
+}
+
+template<typename T>
+static void random_fill(std::complex<T>* x, size_t m, std::mt19937* rng) {
+    std::normal_distribution<T> dist;
+    for (size_t i = 0; i < m; i++) {
+        T re = dist(*rng);
+        x[i] = std::complex<T>(re, dist(*rng));
+    }
+}
+
+/**
+ * Reduces the `n` by `n` Hermitian matrix `a` (row-major, both triangles) to
+ * a tridiagonal one with diagonal `d` and subdiagonal `sub`, by Householder
+ * reflections I - beta[k] v v^H. Each v is left in row k of `a`, right of the
+ * diagonal, and the rest of `a` is overwritten.
+ */
+template<typename U, typename T>
+static void tridiagonalize(size_t n, U* a, T* d, U* sub, T* beta, size_t num_threads) {
+    std::vector<U> w(n);
+    std::vector<U> conj_v(n);
+    std::vector<U> conj_w(n);
+
+    for (size_t k = 0; k + 1 < n; k++) {
+        size_t m = n - k - 1;
+        d[k] = real_of(a[k * n + k]);
+
+        // The column below the diagonal is the conjugate of the row right of it
+        U* v = a + k * n + k + 1;
+        for (size_t i = 0; i < m; i++) {
+            v[i] = conj_of(v[i]);
+        }
+
+        T rest = 0;
+        for (size_t i = 1; i < m; i++) {
+            rest += norm_of(v[i]);
+        }
+
+        // Already tridiagonal in this column
+        if (rest == 0) {
+            sub[k] = v[0];
+            beta[k] = 0;
+            continue;
+        }
+
+        T abs_x0 = std::abs(v[0]);
+        T x_norm = std::sqrt(rest + abs_x0 * abs_x0);
+        U phase = (abs_x0 == 0) ? U(1) : v[0] / abs_x0;
+        U alpha = -phase * x_norm;
+
+        v[0] -= alpha;
+        sub[k] = alpha;
+        beta[k] = T(1) / (x_norm * (x_norm + abs_x0));
+
+        // The rest of the matrix B becomes (I - beta v v^H) B (I - beta v v^H),
+        // which is B - v w^H - w v^H, for p = beta B v and w = p - (beta/2) (v^H p) v
+        U* p = w.data();
+        #pragma omp parallel for num_threads(num_threads) schedule(static)
+        for (size_t i = 0; i < m; i++) {
+            p[i] = beta[k] * dot_of(a + (k + 1 + i) * n + k + 1, v, m);
+        }
+
+        U vp = 0;
+        for (size_t i = 0; i < m; i++) {
+            vp += conj_of(v[i]) * p[i];
+        }
+        U half_k = (beta[k] / 2) * vp;
+
+        for (size_t i = 0; i < m; i++) {
+            w[i] = p[i] - half_k * v[i];
+            conj_v[i] = conj_of(v[i]);
+            conj_w[i] = conj_of(w[i]);
+        }
+
+        const U* cv = conj_v.data();
+        const U* cw = conj_w.data();
+        #pragma omp parallel for num_threads(num_threads) schedule(static)
+        for (size_t i = 0; i < m; i++) {
+            U* row = a + (k + 1 + i) * n + k + 1;
+            U vi = v[i];
+            U wi = w[i];
+            #pragma omp simd
+            for (size_t j = 0; j < m; j++) {
+                row[j] -= vi * cw[j] + wi * cv[j];
+            }
+        }
+    }
+
+    d[n - 1] = real_of(a[(n - 1) * n + n - 1]);
+}
+
+/**
+ * Forms the product Q of the reflections left in `a` by tridiagonalize, as
+ * its transpose `zt` (row-major, so row j is column j of Q), accumulating
+ * them from the last one back
+ */
+template<typename U, typename T>
+static void form_reflections(size_t n, const U* a, const T* beta, U* zt, size_t num_threads) {
+    std::fill(zt, zt + n * n, U(0));
+    for (size_t i = 0; i < n; i++) {
+        zt[i * n + i] = 1;
+    }
+
+    std::vector<U> conj_v(n);
+    for (size_t k = n - 1; k-- > 0;) {
+        if (beta[k] == 0) {
+            continue;
+        }
+
+        size_t m = n - k - 1;
+        const U* v = a + k * n + k + 1;
+        for (size_t i = 0; i < m; i++) {
+            conj_v[i] = conj_of(v[i]);
+        }
+
+        // Each column of Q (row of Z^T) past k loses its part along v
+        const U* cv = conj_v.data();
+        #pragma omp parallel for num_threads(num_threads) schedule(static)
+        for (size_t j = k + 1; j < n; j++) {
+            U* row = zt + j * n + k + 1;
+            U t = beta[k] * dot_of(cv, row, m);
+            #pragma omp simd
+            for (size_t i = 0; i < m; i++) {
+                row[i] -= t * v[i];
+            }
+        }
+    }
+}
+
+/**
+ * Finds the eigenvalues of the real symmetric tridiagonal matrix with
+ * diagonal `d` and off-diagonal `e` (e[i] couples i and i + 1) by implicit
+ * QL iterations, overwriting `d`, and applies the rotations to the rows of
+ * `zt` (the columns of Z). The rotations of each iteration are applied
+ * together, one block of columns of `zt` per thread.
+ */
+template<typename U, typename T>
+static void tridiagonal_ql(size_t n, T* d, T* e, U* zt, size_t num_threads) {
+    const T eps = std::numeric_limits<T>::epsilon();
+    std::vector<T> cs(n);
+    std::vector<T> sn(n);
+
+    // Off-diagonals below this are negligible even next to tiny (or zero)
+    // eigenvalues, which the reduction only found to this accuracy anyway
+    T norm = 0;
+    for (size_t i = 0; i < n; i++) {
+        norm = std::max(norm, std::abs(d[i]) + std::abs(e[i]) + ((i > 0) ? std::abs(e[i - 1]) : T(0)));
+    }
+    const T negligible = eps * norm;
+
+    for (size_t l = 0; l < n; l++) {
+        size_t iterations = 0;
+        size_t m;
+        do {
+            for (m = l; m + 1 < n; m++) {
+                T dd = std::abs(d[m]) + std::abs(d[m + 1]);
+                if (std::abs(e[m]) <= eps * dd || std::abs(e[m]) <= negligible) {
+                    break;
+                }
+            }
+            if (m == l) {
+                break;
+            }
+            if (iterations++ == SVD_MAX_ITERATIONS) {
+                throw eof_error_t("The eigensolver did not converge");
+            }
+
+            T g = (d[l + 1] - d[l]) / (2 * e[l]);
+            T r = std::hypot(g, T(1));
+            g = d[m] - d[l] + e[l] / (g + ((g >= 0) ? r : -r));
+            T s = 1;
+            T c = 1;
+            T p = 0;
+
+            // Rotations are on (i, i + 1), for i from m - 1 down to `first`
+            size_t first = l;
+            bool deflated = false;
+            for (size_t i = m; i-- > l;) {
+                T f = s * e[i];
+                T b = c * e[i];
+                r = std::hypot(f, g);
+                e[i + 1] = r;
+                if (r == 0) {
+                    d[i + 1] -= p;
+                    e[m] = 0;
+                    first = i + 1;
+                    deflated = true;
+                    break;
+                }
+                s = f / r;
+                c = g / r;
+                g = d[i + 1] - p;
+                r = (d[i] - g) * s + 2 * c * b;
+                p = s * r;
+                d[i + 1] = g + p;
+                g = c * r - b;
+                cs[i] = c;
+                sn[i] = s;
+            }
+
+            if (first < m) {
+                const T* cp = cs.data();
+                const T* sp = sn.data();
+                // Row i + 1 is final once rotation i is applied, so only the
+                // row moving down is kept, in `carry`, rather than reloaded
+                #pragma omp parallel for num_threads(num_threads) schedule(static)
+                for (size_t k0 = 0; k0 < n; k0 += SVD_COLUMN_BLOCK) {
+                    size_t len = std::min(n - k0, SVD_COLUMN_BLOCK);
+                    U carry[SVD_COLUMN_BLOCK];
+                    std::copy(zt + m * n + k0, zt + m * n + k0 + len, carry);
+                    for (size_t i = m; i-- > first;) {
+                        const U* row0 = zt + i * n + k0;
+                        U* row1 = zt + (i + 1) * n + k0;
+                        T c = cp[i];
+                        T s = sp[i];
+                        #pragma omp simd
+                        for (size_t k = 0; k < len; k++) {
+                            U f = carry[k];
+                            row1[k] = s * row0[k] + c * f;
+                            carry[k] = c * row0[k] - s * f;
+                        }
+                    }
+                    std::copy(carry, carry + len, zt + first * n + k0);
+                }
+            }
+
+            if (!deflated) {
+                d[l] -= p;
+                e[l] = g;
+                e[m] = 0;
+            }
+        } while (m != l);
+    }
+}
+
+/**
+ * Finds the eigenvalues `d` and eigenvectors (the rows of `zt`, `n` by `n`)
+ * of the `n` by `n` Hermitian matrix `a` (row-major, both triangles), which
+ * is overwritten
+ */
+template<typename U, typename T>
+static void hermitian_eigensolve(size_t n, U* a, T* d, U* zt, size_t num_threads) {
+    if (n == 0) {
+        return;
+    }
+
+    std::vector<U> sub(n);
+    std::vector<T> beta(n);
+    tridiagonalize(n, a, d, sub.data(), beta.data(), num_threads);
+    form_reflections(n, a, beta.data(), zt, num_threads);
+
+    // Scale the columns of Z by unit phases that make the subdiagonal real
+    // (and nonnegative), so the rest is real arithmetic
+    std::vector<T> e(n, T(0));
+    std::vector<U> phase(n, U(1));
+    for (size_t k = 0; k + 1 < n; k++) {
+        T abs_sub = std::abs(sub[k]);
+        phase[k + 1] = (abs_sub == 0) ? phase[k] : phase[k] * (sub[k] / abs_sub);
+        e[k] = abs_sub;
+    }
+    #pragma omp parallel for num_threads(num_threads) schedule(static)
+    for (size_t j = 0; j < n; j++) {
+        for (size_t i = 0; i < n; i++) {
+            zt[j * n + i] *= phase[j];
+        }
+    }
+
+    tridiagonal_ql(n, d, e.data(), zt, num_threads);
+}
+
+/**
+ * Multiplies the `count` vectors in the rows of `xt` (each of length `n`) by
+ * the `n` by `n` Hermitian matrix `a` as the LAPACK backends read it
+ * (column-major, i.e. conjugated), into the rows of `yt`. Each row of `a` is
+ * read once for all the vectors.
+ */
+template<typename U>
+static void apply_hermitian(size_t n, const U* a, size_t count, const U* xt, U* yt, size_t num_threads) {
+    std::vector<U> conj_x(count * n);
+    for (size_t i = 0; i < count * n; i++) {
+        conj_x[i] = conj_of(xt[i]);
+    }
+
+    const U* cx = conj_x.data();
+    #pragma omp parallel for num_threads(num_threads) schedule(static)
+    for (size_t i = 0; i < n; i++) {
+        const U* row = a + i * n;
+        for (size_t r = 0; r < count; r++) {
+            yt[r * n + i] = conj_of(dot_of(row, cx + r * n, n));
+        }
+    }
+}
+
+/**
+ * Removes from `q` (of length `n`) its parts along the first `rows`
+ * orthonormal rows of `qt`, by classical Gram-Schmidt run twice, and returns
+ * the norm of what is left
+ */
+template<typename T, typename U>
+static T orthogonalize_row(size_t n, size_t rows, const U* qt, U* q, size_t num_threads) {
+    std::vector<U> c(rows);
+    for (int pass = 0; pass < 2 && rows > 0; pass++) {
+        #pragma omp parallel for num_threads(num_threads) schedule(static)
+        for (size_t r = 0; r < rows; r++) {
+            c[r] = inner_of(qt + r * n, q, n);
+        }
+
+        #pragma omp parallel for num_threads(num_threads) schedule(static)
+        for (size_t i0 = 0; i0 < n; i0 += SVD_COLUMN_BLOCK) {
+            size_t len = std::min(n - i0, SVD_COLUMN_BLOCK);
+            for (size_t r = 0; r < rows; r++) {
+                const U* qr = qt + r * n + i0;
+                U cr = c[r];
+                #pragma omp simd
+                for (size_t i = 0; i < len; i++) {
+                    q[i0 + i] -= cr * qr[i];
+                }
+            }
+        }
+    }
+
+    return std::sqrt(real_of(inner_of(q, q, n)));
+}
+
+/**
+ * Makes rows `first` to `count` of `qt` (each of length `n`) orthonormal,
+ * against each other and the rows before them, which already are. A row
+ * found to depend on the others is replaced by a random one, so that the
+ * rows always span `count` (at most `n`) dimensions.
+ */
+template<typename T, typename U>
+static void orthonormalize_rows(size_t n, size_t first, size_t count, U* qt, std::mt19937* rng, size_t num_threads) {
+    const T eps = std::numeric_limits<T>::epsilon();
+    for (size_t r = first; r < count; r++) {
+        U* q = qt + r * n;
+        T original = std::sqrt(real_of(inner_of(q, q, n)));
+        T norm = orthogonalize_row<T>(n, r, qt, q, num_threads);
+        while (norm == 0 || norm <= std::sqrt(eps) * original) {
+            random_fill(q, n, rng);
+            original = std::sqrt(real_of(inner_of(q, q, n)));
+            norm = orthogonalize_row<T>(n, r, qt, q, num_threads);
+        }
+
+        for (size_t i = 0; i < n; i++) {
+            q[i] /= norm;
+        }
+    }
+}
+
+/**
+ * Writes the `k` eigenpairs of largest magnitude, out of the `count` in `d`
+ * and the rows of `zt` (each of length `n`), as the singular vectors and
+ * values of a Hermitian matrix, laid out as the LAPACK backends do. Any of
+ * `u`, `s` and `vt` may be null.
+ */
+template<typename U, typename T>
+static void write_modes(
+    size_t n,
+    size_t count,
+    size_t k,
+    const T* d,
+    const U* zt,
+    matrix_t<U>* u,
+    matrix_t<T>* s,
+    matrix_t<U>* vt,
+    size_t num_threads
+) {
+    // Singular values are the magnitudes of the eigenvalues, largest first
+    std::vector<size_t> order(count);
+    for (size_t i = 0; i < count; i++) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [d](size_t i, size_t j) {
+        return std::abs(d[i]) > std::abs(d[j]);
+    });
+
+    // Row r of u is the r-th singular vector, as written by LAPACK
+    // (column-major) into a row-major matrix
+    if (u != nullptr) {
+        u->set_shape(k, n);
+        U* ud = u->get_data_unsafe();
+        #pragma omp parallel for num_threads(num_threads) schedule(static)
+        for (size_t r = 0; r < k; r++) {
+            std::copy(zt + order[r] * n, zt + (order[r] + 1) * n, ud + r * n);
+        }
+    }
+
+    if (s != nullptr) {
+        s->set_shape(1, k);
+        for (size_t r = 0; r < k; r++) {
+            s->at(0, r) = std::abs(d[order[r]]);
+        }
+    }
+
+    // The right singular vectors differ from the left ones only by the signs
+    // of the eigenvalues
+    if (vt != nullptr) {
+        vt->set_shape(n, k);
+        U* vd = vt->get_data_unsafe();
+        #pragma omp parallel for num_threads(num_threads) schedule(static)
+        for (size_t i = 0; i < n; i++) {
+            for (size_t j = 0; j < k; j++) {
+                T sign = (d[order[j]] < 0) ? -1 : 1;
+                vd[i * k + j] = sign * conj_of(zt[order[j] * n + i]);
+            }
+        }
+    }
+}
+
 
 
 
@@ -30,7 +558,12 @@
 
 template<typename T>
 basic_svd_t<T>::basic_svd_t() {
-    // ...
+    this->set_num_threads(omp_get_max_threads());
+}
+
+template<typename T>
+basic_svd_t<T>::basic_svd_t(size_t num_threads) {
+    this->set_num_threads(num_threads);
 }
 
 template<typename T>
@@ -38,6 +571,46 @@ basic_svd_t<T>::~basic_svd_t() {
     // ...
 }
 
+template<typename T>
+void basic_svd_t<T>::set_num_threads(size_t num_threads) {
+    this->num_threads = (num_threads > 0) ? num_threads : 1;
+}
+
+template<typename T>
+template<typename U>
+void basic_svd_t<T>::solve(
+    matrix_t<U>* input,
+    matrix_t<U>* u,
+    matrix_t<T>* s,
+    matrix_t<U>* vt
+) {
+    const size_t n = input->get_rows();
+    if (input->get_cols() != n) {
+        throw eof_error_t("The native eigensolver only decomposes square (covariance) matrices");
+    }
+
+    // Start the SVD timer
+    time_t start = time(nullptr);
+
+    // The LAPACK backends read the matrix column-major, i.e. transposed,
+    // which for a Hermitian matrix is its conjugate
+    U* a = input->get_data_unsafe();
+    #pragma omp parallel for num_threads(this->num_threads) schedule(static)
+    for (size_t i = 0; i < n * n; i++) {
+        a[i] = conj_of(a[i]);
+    }
+
+    std::vector<T> d(n);
+    std::vector<U> zt(n * n);
+    hermitian_eigensolve(n, a, d.data(), zt.data(), this->num_threads);
+    write_modes(n, n, n, d.data(), zt.data(), u, s, vt, this->num_threads);
+
+    // Print the time required to compute the SVD
+    time_t end = time(nullptr);
+    double time = difftime(end,start);
+    std::cout << "svd: " << time << "s; ";
+}
+
 template<typename T>
 void basic_svd_t<T>::calculate(
     matrix_t<T>* input,
@@ -45,30 +618,7 @@ void basic_svd_t<T>::calculate(
     matrix_t<T>* s,
     matrix_t<T>* vt
 ) {
-    const size_t rows = input->get_rows();
-    const size_t cols = input->get_cols();
-    
-    // TODO do some real SVD calculations. This is all fake
-    TODO
-    
-    u->set_shape(rows, rows);
-    for (size_t r = 0; r < u->get_rows(); r++) {
-        for (size_t c = 0; c < u->get_cols(); c++) {
-            u->set_elem(r, c, r + c);
-        }
-    }
-    
-    s->set_shape(1, rows <= cols ? rows : cols);
-    for (size_t r = 0; r < rows <= cols ? rows : cols; r++) {
-        s->set_elem(r, 1, r + 1);
-    }
-    
-    vt->set_shape(cols, cols);
-    for (size_t r = 0; r < vt->get_rows(); r++) {
-        for (size_t c = 0; c < vt->get_cols(); c++) {
-            vt->set_elem(r, c, r + c);
-        }
-    }
+    this->solve(input, u, s, vt);
 }
 
 template<typename T>
@@ -78,29 +628,5 @@ void basic_svd_t<T>::calculate(
     matrix_t<T>*               s,
     matrix_t<std::complex<T>>* vt
 ) {
-    const size_t rows = input->get_rows();
-    const size_t cols = input->get_cols();
-    
-    // TODO do some real SVD calculations. This is all fake
-    TODO
-    
-    u->set_shape(rows, rows);
-    for (size_t r = 0; r < u->get_rows(); r++) {
-        for (size_t c = 0; c < u->get_cols(); c++) {
-            u->set_elem(r, c, r + c);
-        }
-    }
-
-    s->set_shape(1, rows <= cols ? rows : cols);
-    for (size_t r = 0; r < rows <= cols ? rows : cols; r++) {
-        s->set_elem(r, 1, r + 1);
-    }
-    
-    vt->set_shape(cols, cols);
-    for (size_t r = 0; r < vt->get_rows(); r++) {
-        for (size_t c = 0; c < vt->get_cols(); c++) {
-            vt->set_elem(r, c, r + c);
-        }
-    }
+    this->solve(input, u, s, vt);
 }
-
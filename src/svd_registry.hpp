@@ -0,0 +1,129 @@
+/***********************************************************************
+ *                   GNU Lesser General Public License
+ *
+ * This file is part of the EDGI prototype package, developed by the
+ * GFDL Flexible Modeling System (FMS) group.
+ *
+ * EDGI is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * EDGI is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with EDGI.  If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************/
+
+#ifndef SVD_REGISTRY_HPP
+#define SVD_REGISTRY_HPP
+
+/** Use svd_t, basic_svd_t */
+#include "svd.hpp"
+
+/** Use randomized_svd_t */
+#include "randomized_svd.hpp"
+
+/** Use lanczos_svd_t */
+#include "lanczos_svd.hpp"
+
+/** Use std::function */
+#include <functional>
+
+/** Use std::map */
+#include <map>
+
+/** Use std::string */
+#include <string>
+
+/** Use std::vector */
+#include <vector>
+
+
+
+
+
+//=============================================================================
+// Declaration of Class svd_registry_t
+//=============================================================================
+
+/**
+ * Picks the linear algebra backend by name at run time. The native,
+ * randomized and lanczos backends are always there; others, such as the
+ * vendor backend the executable was built with, are added to it. Any other
+ * name is looked up as a plugin: a shared object, given by path or named
+ * lib<PLUGIN_PREFIX><name>.so and found on the library search path, which
+ * defines the functions
+ *
+ *     extern "C" svd_t<float>* edgi_create_svd_float(size_t num_threads);
+ *     extern "C" svd_t<double>* edgi_create_svd_double(size_t num_threads);
+ *
+ * linalg/svd_plugin.cpp builds one from any of the LAPACK backends. As svd_t
+ * is a C++ class, a plugin must be built by the same compiler, from the same
+ * headers, as the executable.
+ */
+template<typename T>
+class svd_registry_t {
+public:
+    /**
+     * Makes a backend running on `num_threads` threads, which finds the
+     * leading `rank` modes if it doesn't find them all
+     */
+    typedef std::function<svd_t<T>*(size_t num_threads, size_t rank)> factory_t;
+
+    /** Start of the file name of the plugin of a backend */
+    static const std::string PLUGIN_PREFIX;
+
+private:
+    std::map<std::string, factory_t> factories;
+
+public:
+    svd_registry_t();
+    ~svd_registry_t();
+
+    /**
+     * Adds (or replaces) the backend called `name`
+     */
+    void add(const std::string name, factory_t factory);
+
+    /**
+     * Whether the backend called `name` was added, rather than in a plugin
+     */
+    bool has(const std::string name) const;
+
+    /**
+     * Names of the backends that were added, in alphabetical order
+     */
+    std::vector<std::string> get_names() const;
+
+    /**
+     * Makes the backend called `name`, loading its plugin if it wasn't
+     * added. Throws eof_error_t if there is neither.
+     */
+    svd_t<T>* create(const std::string name, size_t num_threads, size_t rank) const;
+
+    /**
+     * File name of the plugin of the backend called `name` (`name` itself, if
+     * it is a path)
+     */
+    static std::string get_plugin_filename(const std::string name);
+};
+
+
+
+
+
+//=============================================================================
+// Template Implementation
+//=============================================================================
+
+#include "svd_registry.tpp"
+
+
+
+
+
+#endif
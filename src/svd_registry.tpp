@@ -0,0 +1,136 @@
+/***********************************************************************
+ *                   GNU Lesser General Public License
+ *
+ * This file is part of the EDGI prototype package, developed by the
+ * GFDL Flexible Modeling System (FMS) group.
+ *
+ * EDGI is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * EDGI is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with EDGI.  If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************/
+
+#include "svd_registry.hpp"
+
+#include "error.hpp"
+
+/** Use dlopen, dlsym, dlerror */
+#include <dlfcn.h>
+
+
+
+
+
+//=============================================================================
+// Plugin Entry Points
+//=============================================================================
+
+/** Name of the function of a plugin making a backend of each precision */
+template<typename T>
+struct svd_plugin_traits;
+
+template<>
+struct svd_plugin_traits<float> {
+    static const char* symbol() {
+        return "edgi_create_svd_float";
+    }
+};
+
+template<>
+struct svd_plugin_traits<double> {
+    static const char* symbol() {
+        return "edgi_create_svd_double";
+    }
+};
+
+
+
+
+
+//=============================================================================
+// Implementation of Class svd_registry_t
+//=============================================================================
+
+template<typename T>
+const std::string svd_registry_t<T>::PLUGIN_PREFIX = "edgi_svd_";
+
+template<typename T>
+svd_registry_t<T>::svd_registry_t() {
+    this->add("native", [](size_t num_threads, size_t) -> svd_t<T>* {
+        return new basic_svd_t<T>(num_threads);
+    });
+    this->add("randomized", [](size_t num_threads, size_t rank) -> svd_t<T>* {
+        return new randomized_svd_t<T>(num_threads, rank);
+    });
+    this->add("lanczos", [](size_t num_threads, size_t rank) -> svd_t<T>* {
+        return new lanczos_svd_t<T>(num_threads, rank);
+    });
+}
+
+template<typename T>
+svd_registry_t<T>::~svd_registry_t() {
+    // ...
+}
+
+template<typename T>
+void svd_registry_t<T>::add(const std::string name, factory_t factory) {
+    this->factories[name] = factory;
+}
+
+template<typename T>
+bool svd_registry_t<T>::has(const std::string name) const {
+    return this->factories.count(name) > 0;
+}
+
+template<typename T>
+std::vector<std::string> svd_registry_t<T>::get_names() const {
+    std::vector<std::string> names;
+    for (auto it = this->factories.begin(); it != this->factories.end(); it++) {
+        names.push_back(it->first);
+    }
+    return names;
+}
+
+template<typename T>
+svd_t<T>* svd_registry_t<T>::create(const std::string name, size_t num_threads, size_t rank) const {
+    auto it = this->factories.find(name);
+    if (it != this->factories.end()) {
+        return it->second(num_threads, rank);
+    }
+
+    // Not RTLD_DEEPBIND, which would keep the plugin's LAPACK apart from the
+    // executable's, but also give it an std::cout of its own
+    std::string filename = get_plugin_filename(name);
+    void* handle = dlopen(filename.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (handle == nullptr) {
+        throw eof_error_t("Unknown linear algebra backend '" + name + "': " + dlerror());
+    }
+
+    typedef svd_t<T>* (*create_t)(size_t);
+    create_t create = (create_t) dlsym(handle, svd_plugin_traits<T>::symbol());
+    if (create == nullptr) {
+        std::string error = dlerror();
+        dlclose(handle);
+        throw eof_error_t("'" + filename + "' is not a linear algebra backend: " + error);
+    }
+
+    // The plugin is never unloaded, as the backend runs its code until it
+    // is deleted
+    return create(num_threads);
+}
+
+template<typename T>
+std::string svd_registry_t<T>::get_plugin_filename(const std::string name) {
+    if (name.find('/') != std::string::npos) {
+        return name;
+    }
+    return "lib" + PLUGIN_PREFIX + name + ".so";
+}
@@ -0,0 +1,299 @@
+/***********************************************************************
+ *                   GNU Lesser General Public License
+ *
+ * This file is part of the EDGI prototype package, developed by the
+ * GFDL Flexible Modeling System (FMS) group.
+ *
+ * EDGI is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * EDGI is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with EDGI.  If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************/
+
+#include "tile_checkpoint.hpp"
+
+#include "error.hpp"
+
+/** Use align_up, set_magic, has_magic */
+#include "file_utils.hpp"
+
+/** Use open, close, pwrite, ftruncate */
+#include <fcntl.h>
+#include <unistd.h>
+
+/** Use fstat */
+#include <sys/stat.h>
+
+/** Use mmap, munmap, msync */
+#include <sys/mman.h>
+
+/** Use errno */
+#include <cerrno>
+
+/** Use memset, strerror */
+#include <cstring>
+
+/** Use std::cout */
+#include <iostream>
+
+/** Use std::ostringstream */
+#include <sstream>
+
+// <string> and <vector> included in header
+using std::string;
+
+
+
+
+
+//==============================================================================
+// Local functions
+//==============================================================================
+
+namespace {
+
+    const char MAGIC[MAGIC_LEN] = {'E', 'D', 'G', 'I', 'T', 'I', 'L', 'E'};
+
+    const uint32_t FORMAT_VERSION = 1;
+
+    /** The last of SIGTERM or SIGUSR1 received, with SIGTERM taking precedence */
+    volatile sig_atomic_t pending_signal = 0;
+
+    void on_signal(int sig) {
+        if (pending_signal != SIGTERM) {
+            pending_signal = sig;
+        }
+    }
+}
+
+const size_t tile_checkpoint_t::TILE_ROWS;
+const time_t tile_checkpoint_t::FLUSH_SECONDS;
+
+
+
+
+
+//==============================================================================
+// Private Methods
+//==============================================================================
+
+void* tile_checkpoint_t::map_file(size_t value_size, size_t rows, size_t num_tiles, const string layout) {
+    this->close_file();
+
+    this->fd = ::open(this->filename.c_str(), O_RDWR | O_CREAT, 0644);
+    if (this->fd < 0) {
+        throw eof_error_t("Could not open tile checkpoint \"" + this->filename + "\": " + std::strerror(errno));
+    }
+
+    string key = this->key + "\n" + layout;
+    size_t bitmap_offset = sizeof(file_header_t) + key.size();
+    size_t data_offset = align_up(bitmap_offset + (num_tiles + 7) / 8, DATA_ALIGNMENT);
+    size_t size = data_offset + rows * rows * value_size;
+
+    // Keep the file if it holds tiles of this same matrix
+    file_header_t found;
+    struct stat info;
+    bool existed = fstat(this->fd, &info) == 0 && info.st_size > 0;
+    bool resumed = existed
+        && (size_t) info.st_size == size
+        && pread(this->fd, &found, sizeof(file_header_t), 0) == (ssize_t) sizeof(file_header_t)
+        && has_magic(found.magic, MAGIC)
+        && found.version == FORMAT_VERSION
+        && found.value_size == value_size
+        && found.key_len == key.size()
+        && found.rows == rows
+        && found.num_tiles == num_tiles
+        && found.bitmap_offset == bitmap_offset
+        && found.data_offset == data_offset;
+    if (resumed) {
+        string found_key(key.size(), '\0');
+        resumed = pread(this->fd, &found_key[0], key.size(), sizeof(file_header_t)) == (ssize_t) key.size()
+            && found_key == key;
+    }
+
+    if (!resumed) {
+        // Tiles of other inputs (or of changed ones) are never reused
+        if (existed) {
+            std::cout << "tiles: \"" << this->filename << "\" was made from other inputs or settings, starting over; ";
+        }
+
+        std::memset(&found, 0, sizeof(file_header_t));
+        set_magic(found.magic, MAGIC);
+        found.version = FORMAT_VERSION;
+        found.value_size = value_size;
+        found.key_len = key.size();
+        found.rows = rows;
+        found.num_tiles = num_tiles;
+        found.bitmap_offset = bitmap_offset;
+        found.data_offset = data_offset;
+
+        // Truncating first clears the bitmap
+        bool written = ftruncate(this->fd, 0) == 0
+            && ftruncate(this->fd, size) == 0
+            && pwrite(this->fd, &found, sizeof(file_header_t), 0) == (ssize_t) sizeof(file_header_t)
+            && pwrite(this->fd, key.data(), key.size(), sizeof(file_header_t)) == (ssize_t) key.size();
+        if (!written) {
+            int error = errno;
+            this->close_file();
+            throw eof_error_t("Could not write tile checkpoint \"" + this->filename + "\": " + std::strerror(error));
+        }
+    }
+
+    void* mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, this->fd, 0);
+    if (mapped == MAP_FAILED) {
+        int error = errno;
+        this->close_file();
+        throw eof_error_t("Could not map tile checkpoint \"" + this->filename + "\": " + std::strerror(error));
+    }
+    this->mapped = (unsigned char*) mapped;
+    this->mapped_size = size;
+    this->header = found;
+
+    this->done.assign(num_tiles, false);
+    this->num_done = 0;
+    const unsigned char* bitmap = this->mapped + bitmap_offset;
+    for (size_t tile = 0; tile < num_tiles; tile++) {
+        if (bitmap[tile / 8] & (1 << (tile % 8))) {
+            this->done[tile] = true;
+            this->num_done++;
+        }
+    }
+    if (this->num_done > 0) {
+        std::cout << "tiles: " << this->num_done << " of " << num_tiles << " already done; ";
+    }
+
+    this->last_flush = time(nullptr);
+    this->handle_signals();
+
+    return this->mapped + data_offset;
+}
+
+void tile_checkpoint_t::close_file() {
+    this->restore_signals();
+    if (this->mapped != nullptr) {
+        munmap(this->mapped, this->mapped_size);
+        this->mapped = nullptr;
+    }
+    if (this->fd >= 0) {
+        close(this->fd);
+        this->fd = -1;
+    }
+}
+
+void tile_checkpoint_t::flush() {
+    // The tiles must reach the file before the bitmap says they did
+    size_t data_offset = this->header.data_offset;
+    if (msync(this->mapped + data_offset, this->mapped_size - data_offset, MS_SYNC) != 0) {
+        throw eof_error_t("Could not flush tile checkpoint \"" + this->filename + "\": " + std::strerror(errno));
+    }
+
+    unsigned char* bitmap = this->mapped + this->header.bitmap_offset;
+    for (size_t tile = 0; tile < this->done.size(); tile++) {
+        if (this->done[tile]) {
+            bitmap[tile / 8] |= (1 << (tile % 8));
+        }
+    }
+    if (msync(this->mapped, data_offset, MS_SYNC) != 0) {
+        throw eof_error_t("Could not flush tile checkpoint \"" + this->filename + "\": " + std::strerror(errno));
+    }
+
+    this->last_flush = time(nullptr);
+}
+
+void tile_checkpoint_t::handle_signals() {
+    if (this->handling_signals) {
+        return;
+    }
+
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = on_signal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+
+    pending_signal = 0;
+    sigaction(SIGTERM, &action, &this->old_term);
+    sigaction(SIGUSR1, &action, &this->old_usr1);
+    this->handling_signals = true;
+}
+
+void tile_checkpoint_t::restore_signals() {
+    if (!this->handling_signals) {
+        return;
+    }
+
+    sigaction(SIGTERM, &this->old_term, nullptr);
+    sigaction(SIGUSR1, &this->old_usr1, nullptr);
+    this->handling_signals = false;
+}
+
+
+
+
+
+//==============================================================================
+// Public Methods
+//==============================================================================
+
+tile_checkpoint_t::tile_checkpoint_t(const string filename) {
+    this->filename = filename;
+}
+
+tile_checkpoint_t::~tile_checkpoint_t() {
+    this->close_file();
+}
+
+void tile_checkpoint_t::set_key(const string key) {
+    this->key = key;
+}
+
+bool tile_checkpoint_t::is_done(size_t tile) const {
+    return this->done[tile];
+}
+
+void tile_checkpoint_t::complete(size_t tile) {
+    this->done[tile] = true;
+    this->num_done++;
+
+    int sig = pending_signal;
+    if (sig == 0 && time(nullptr) - this->last_flush < FLUSH_SECONDS) {
+        return;
+    }
+
+    pending_signal = 0;
+    this->flush();
+
+    if (sig == SIGTERM) {
+        this->restore_signals();
+        std::ostringstream msg;
+        msg << "Stopped by SIGTERM with " << this->num_done << " of " << this->done.size()
+            << " covariance tiles saved in \"" << this->filename << "\"";
+        throw eof_error_t(msg.str());
+    }
+}
+
+void tile_checkpoint_t::finish() {
+    this->flush();
+    this->restore_signals();
+
+    // Eigensolvers may work on the matrix in place, which must not make the
+    // finished tiles in the file wrong
+    void* remapped = mmap(this->mapped, this->mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, this->fd, 0);
+    if (remapped == MAP_FAILED) {
+        throw eof_error_t("Could not map tile checkpoint \"" + this->filename + "\": " + std::strerror(errno));
+    }
+
+    // A SIGTERM after the last tile stops the run as it would have otherwise
+    if (pending_signal == SIGTERM) {
+        pending_signal = 0;
+        raise(SIGTERM);
+    }
+}
@@ -0,0 +1,177 @@
+/***********************************************************************
+ *                   GNU Lesser General Public License
+ *
+ * This file is part of the EDGI prototype package, developed by the
+ * GFDL Flexible Modeling System (FMS) group.
+ *
+ * EDGI is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * EDGI is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with EDGI.  If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************/
+
+#ifndef TILE_CHECKPOINT_HPP
+#define TILE_CHECKPOINT_HPP
+
+/** Use matrix_t */
+#include "matrix.hpp"
+
+/** Use size_t */
+#include <cstddef>
+
+/** Use uint32_t, uint64_t */
+#include <cstdint>
+
+/** Use time_t */
+#include <ctime>
+
+/** Use struct sigaction */
+#include <csignal>
+
+/** Use std::string */
+#include <string>
+
+/** Use std::vector */
+#include <vector>
+
+
+
+
+
+//==============================================================================
+// Declaration
+//==============================================================================
+
+/**
+ * A scratch file holding the covariance matrix while it is being built, with
+ * a bitmap of which of its tiles (blocks of rows of one pair of variables)
+ * are finished, so that a run that is stopped can be continued by another,
+ * which only builds the missing tiles.
+ *
+ * The matrix is built in place in a shared mapping of the file. The bitmap
+ * in the file is only brought up to date after the matrix is synced, every
+ * FLUSH_SECONDS and on SIGUSR1, so it never claims a tile that did not reach
+ * the file. On SIGTERM it is brought up to date and the run is stopped by an
+ * eof_error_t.
+ */
+class tile_checkpoint_t {
+public:
+    /** Rows of the covariance matrix in each tile */
+    static const size_t TILE_ROWS = 256;
+
+    /** Most seconds between bringing the file up to date */
+    static const time_t FLUSH_SECONDS = 60;
+
+private:
+    //==========================================================================
+    // Private Fields
+    //==========================================================================
+
+    /** The fixed-size start of the file, followed by the key, the bitmap and the matrix */
+    struct file_header_t {
+        char magic[8];
+        uint32_t version;
+        uint32_t value_size;
+        uint64_t key_len;
+        uint64_t rows;
+        uint64_t num_tiles;
+        uint64_t bitmap_offset;
+        uint64_t data_offset;
+    };
+
+    std::string filename;
+
+    /** What the matrix is made from, set before each matrix is built */
+    std::string key;
+
+    int fd = -1;
+    unsigned char* mapped = nullptr;
+    size_t mapped_size = 0;
+    file_header_t header;
+
+    /** Finished tiles, which reach the bitmap in the file when it is flushed */
+    std::vector<bool> done;
+    size_t num_done = 0;
+    time_t last_flush = 0;
+
+    /** The handlers replaced while building */
+    bool handling_signals = false;
+    struct sigaction old_term;
+    struct sigaction old_usr1;
+
+
+
+    //==========================================================================
+    // Private Methods
+    //==========================================================================
+
+    void* map_file(size_t value_size, size_t rows, size_t num_tiles, const std::string layout);
+
+    void close_file();
+
+    void flush();
+
+    void handle_signals();
+
+    void restore_signals();
+
+
+
+public:
+    //==========================================================================
+    // Public Methods
+    //==========================================================================
+
+    tile_checkpoint_t(const std::string filename);
+
+    ~tile_checkpoint_t();
+
+    /**
+     * Sets what the next matrix is made from (the identity of the input
+     * files, the selection and the settings); a file made with another key
+     * is started over
+     */
+    void set_key(const std::string key);
+
+    /**
+     * Shapes `cov` as a `size` by `size` matrix in the file, made of
+     * `num_tiles` tiles laid out as described by `layout`, keeping the tiles
+     * already finished there if the key and layout match
+     */
+    template<typename S>
+    void open(matrix_t<S>* cov, size_t size, size_t num_tiles, const std::string layout);
+
+    bool is_done(size_t tile) const;
+
+    /**
+     * Marks `tile` as finished, flushing the file if it is time to, or if a
+     * signal asked to. Throws if SIGTERM asked to stop.
+     */
+    void complete(size_t tile);
+
+    /**
+     * Flushes the finished matrix, and maps it privately, so that changes to
+     * it no longer reach the file
+     */
+    void finish();
+};
+
+
+
+
+
+//==============================================================================
+// Implementation
+//==============================================================================
+
+#include "tile_checkpoint.tpp"
+
+#endif
@@ -22,6 +22,7 @@
 #define UTILS_HPP
 
 #include <cstddef>
+#include <complex>
 #include "debug.hpp"
 
 /**
@@ -36,6 +37,52 @@ T dot_product(const T* v1, const T* v2, size_t length) {
     return sum;
 }
 
+/**
+ * Calculates the dot product of two vectors stored as U, widening every
+ * element to the accumulation type A as it is loaded
+ */
+template<typename A, typename U>
+A widening_dot(const U* v1, const U* v2, size_t length) {
+    A sum = 0;
+    #pragma omp simd reduction(+:sum)
+    for (size_t i = 0; i < length; i++) {
+        sum += (A) v1[i] * (A) v2[i];
+    }
+    return sum;
+}
+
+/**
+ * Calculates the (unconjugated) dot product of two complex vectors stored
+ * split into real and imaginary parts, accumulating in A. Every term is a
+ * plain real multiply-add, so the loop vectorizes.
+ */
+template<typename A, typename U>
+std::complex<A> split_dot(const U* re1, const U* im1, const U* re2, const U* im2, size_t length) {
+    A re = 0;
+    A im = 0;
+    #pragma omp simd reduction(+:re,im)
+    for (size_t i = 0; i < length; i++) {
+        A ar = re1[i];
+        A ai = im1[i];
+        A br = re2[i];
+        A bi = im2[i];
+        re += ar * br - ai * bi;
+        im += ar * bi + ai * br;
+    }
+    return std::complex<A>(re, im);
+}
+
+/**
+ * Converts a vector stored as U to the compute type C
+ */
+template<typename C, typename U>
+void widen(const U* src, C* dst, size_t length) {
+    #pragma omp simd
+    for (size_t i = 0; i < length; i++) {
+        dst[i] = (C) src[i];
+    }
+}
+
 /**
  * Calculates the circular covariance of two vectors
  */
@@ -121,6 +168,72 @@ S convolve(const S* v1, const S* v2, const T* omegas, size_t length) {
     return sum;
 }
 
+/**
+ * Split-complex version of convolve
+ */
+template<typename U, typename T>
+std::complex<U> split_convolve(const U* re1, const U* im1, const U* re2, const U* im2, const T* omegas, size_t length) {
+    U re = 0;
+    U im = 0;
+    for (size_t i = 0; i < length - 1; i++) {
+        U dr1 = re1[i+1] - re1[i];
+        U di1 = im1[i+1] - im1[i];
+        U dr2 = re2[i+1] - re2[i];
+        U di2 = im2[i+1] - im2[i];
+        U w = 0.5f * omegas[i];
+        re += w * (dr1 * dr2 - di1 * di2);
+        im += w * (dr1 * di2 + di1 * dr2);
+    }
+
+    return std::complex<U>(re, im);
+}
+
+/**
+ * Operations on one anomaly series, chosen by the type R of the result. Real
+ * series are `length` contiguous values; complex series are `length` real
+ * parts followed by `length` imaginary parts (see split_traits).
+ */
+template<typename R>
+struct series_ops {
+    template<typename U>
+    static R dot(const U* v1, const U* v2, size_t length) {
+        return widening_dot<R>(v1, v2, length);
+    }
+
+    template<typename U, typename T>
+    static R convolve(const U* v1, const U* v2, const T* omegas, size_t length) {
+        return ::convolve(v1, v2, omegas, length);
+    }
+};
+
+template<typename R>
+struct series_ops<std::complex<R>> {
+    template<typename U>
+    static std::complex<R> dot(const U* v1, const U* v2, size_t length) {
+        return split_dot<R>(v1, v1 + length, v2, v2 + length, length);
+    }
+
+    template<typename U, typename T>
+    static std::complex<R> convolve(const U* v1, const U* v2, const T* omegas, size_t length) {
+        return split_convolve(v1, v1 + length, v2, v2 + length, omegas, length);
+    }
+};
+
+/**
+ * Returns whether n is a prime number
+ */
+inline bool is_prime(size_t n) {
+    if (n < 2) {
+        return false;
+    }
+    for (size_t d = 2; d * d <= n; d++) {
+        if (n % d == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
 /**
  * Simulates arbitrarily nested for loops in which every loop starts at 0,
  * ends at a constant, and steps by 1. Will break if any value of the
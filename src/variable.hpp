@@ -30,6 +30,24 @@
 /** Use netcdf_file_t */
 #include "netcdf_file.hpp"
 
+/** Use netcdf_writer_t */
+#include "netcdf_writer.hpp"
+
+/** Use slab_reader_t */
+#include "slab_reader.hpp"
+
+/** Use hdf5_chunk_reader_t (only built with WITH_HDF5) */
+#include "hdf5_chunk_reader.hpp"
+
+/** Use cdf_mmap_reader_t */
+#include "cdf_mmap_reader.hpp"
+
+/** Use raw_file_t */
+#include "raw_file.hpp"
+
+/** Use selection_t */
+#include "selection.hpp"
+
 /** Use matrix_t */
 #include "matrix.hpp"
 
@@ -58,6 +76,10 @@
  */
 template<typename S, typename T>
 class variable_t {
+public:
+    /** Default for set_chunk_cache_limit (256 MiB) */
+    static const size_t DEFAULT_CHUNK_CACHE_LIMIT = 256 * 1024 * 1024;
+
 private:
     //==========================================================================
     // Private Fields
@@ -81,12 +103,111 @@ private:
     /** The actual data */
     S* data = nullptr;
 
+    /** Was the data allocated by this variable (rather than mapped in)? */
+    bool owns_data = true;
+
     /** Does this variable contain missing values? */
     bool contains_missing_value = false;
 
     /** What is the missing value? */
     S missing_value;
 
+    /**
+     * Are the values in the file packed (with a CF scale_factor and/or
+     * add_offset)? They are unpacked as they are read.
+     */
+    bool packed = false;
+    double scale_factor = 1;
+    double add_offset = 0;
+
+    /** Is a packed variable stored as short, so it can be read as it is? */
+    bool packed_short = false;
+
+    /** The missing value of a packed variable, before unpacking */
+    short packed_missing_value = 0;
+
+    /** The file a lazy variable reads its data from, owned by this variable */
+    netcdf_file_t* source = nullptr;
+
+    /** The NetCDF ID of a lazy variable in its source file */
+    netcdf_var_t source_var;
+
+    /**
+     * The file a lazy variable reads its data from, and its name there, or
+     * those of the variable a derived variable was made from
+     */
+    std::string source_filename;
+    std::string source_name;
+
+    /** How a derived variable was made from its source, or "" */
+    std::string derivation;
+
+    /**
+     * Reads a lazy variable without the NetCDF library, when it can. A
+     * variable read from a raw dump has only this, and no source.
+     */
+    slab_reader_t* fast_reader = nullptr;
+
+    /** The part of each dimension of the file's variable that was loaded */
+    selection_t selection;
+
+    /**
+     * Where each dimension of a lazy variable starts in its file's variable,
+     * and the stride between its steps there, if only part of it is read
+     */
+    size_t* source_start = nullptr;
+    size_t* source_stride = nullptr;
+
+    /**
+     * Which part of complex values in the file a lazy variable is (0 for the
+     * real part, 1 for the imaginary part), or -1 if they are real. The parts
+     * are either the members of a compound type (of type part_type) or the
+     * two steps of a trailing dimension, which is not one of the variable's.
+     */
+    int source_part = -1;
+    bool parts_along_dim = false;
+    nc_type part_type = NC_NAT;
+
+    /** The largest magnitude in a lazy variable, once it has been found */
+    mutable bool lazy_absmax_known = false;
+    mutable S lazy_absmax;
+
+    /** The most memory (in bytes) the chunk cache of a lazy variable may use */
+    size_t chunk_cache_limit = DEFAULT_CHUNK_CACHE_LIMIT;
+
+
+
+    //==========================================================================
+    // Private Methods
+    //==========================================================================
+
+    void load_metadata_from_netcdf(const std::string name, const netcdf_file_t* file, const selection_t& selection);
+
+    void select_dims(size_t num_dims, dimension_t<T>** dims, const selection_t& selection);
+
+    void load_missing_value(bool has_missing, double missing);
+
+    void open_netcdf(const std::string name, const std::string filename, const selection_t& selection);
+
+    template<typename U>
+    void read_parts(const size_t* start, const size_t* size, U* vals) const;
+
+    template<typename U>
+    void read_spanned(const size_t* start, const size_t* size, U* vals) const;
+
+    template<typename U>
+    void read_source(const size_t* start, const size_t* size, U* vals) const;
+
+    void read_matrix_slice(const size_t* start, const size_t* size, S* vals) const;
+
+    void read_matrix_slice(const size_t* start, const size_t* size, short* vals) const;
+
+    template<typename U>
+    matrix_t<U>* read_lazy_matrix(size_t dim_ind) const;
+
+    template<typename U>
+    void read_slab_rows(size_t dim_ind, size_t first, size_t num, U* buffer, matrix_t<U>* mat) const;
+
 
 
 public:
@@ -104,6 +225,12 @@ public:
 
     variable_t(const std::string name, const netcdf_file_t* file);
 
+    variable_t(const std::string name, const std::string filename);
+
+    variable_t(const std::string name, const netcdf_file_t* file, const selection_t& selection);
+
+    variable_t(const std::string name, const std::string filename, const selection_t& selection);
+
     variable_t(size_t num_dims, dimension_t<T>** dims);
 
     variable_t(size_t num_dims, const dimension_t<T>** dims);
@@ -120,6 +247,18 @@ public:
 
     void load_from_netcdf(const std::string name, const netcdf_file_t* file);
 
+    void load_lazily_from_netcdf(const std::string name, const std::string filename);
+
+    void load_from_netcdf(const std::string name, const netcdf_file_t* file, const selection_t& selection);
+
+    void load_lazily_from_netcdf(const std::string name, const std::string filename, const selection_t& selection);
+
+    void load_lazily_from_raw(const std::string name, const std::string filename, const selection_t& selection);
+
+    void load_lazily(const std::string name, const std::string filename, const selection_t& selection);
+
+    void load_part_lazily_from_netcdf(const std::string name, const std::string filename, const selection_t& selection, int part, const std::string part_dim);
+
     void load_from_dims(size_t num_dims, dimension_t<T>** dims);
 
     void load_from_dims(size_t num_dims, const dimension_t<T>** dims);
@@ -200,11 +339,43 @@ public:
 
     const S get_absmax() const;
 
+    void set_known_absmax(S absmax) const;
+
+    const selection_t& get_selection() const;
+
+    bool is_packed() const;
+
+    double get_scale_factor() const;
+
+    double get_add_offset() const;
+
+    bool can_read_packed() const;
+
+    short get_packed_missing_value() const;
+
+    bool is_complex_part() const;
+
+    const std::string& get_source_filename() const;
+
+    const std::string& get_source_name() const;
+
+    void set_derived_from(const variable_t<S, T>* var, const std::string derivation);
+
+    const std::string& get_derivation() const;
+
 
     //==================================
     // Getting and Setting Data
     //==================================
 
+    bool is_lazy() const;
+
+    void set_chunk_cache_limit(size_t bytes);
+
+    void map_data(S* data);
+
+    size_t get_slab_len(size_t index) const;
+
     const S* get_data() const;
     //const std::complex<S>* get_data_complex() const;
 
@@ -224,9 +395,15 @@ public:
 
     matrix_t<S>* to_matrix(std::string dim_name) const;
 
+    matrix_t<short>* to_packed_matrix(std::string dim_name) const;
+
+    void to_part_matrices(std::string dim_name, matrix_t<S>** re, matrix_t<S>** im) const;
+
     variable_t<S, T>* from_matrix(const matrix_t<S>* mat, std::string dim_name, dimension_t<T>* new_dim) const;
     variable_t<std::complex<T>, T>* from_matrix_complex(const matrix_t<std::complex<T>>* mat, std::string dim_name, dimension_t<T>* new_dim) const;
 
+    variable_t<S, T>* from_matrix_gathered(const matrix_t<S>* mat, std::string dim_name, dimension_t<T>* new_dim, const int* cols, size_t num_cols, std::string list_name) const;
+
     template<typename U, typename V>
     friend variable_t<std::complex<U>, V>* make_complex_variable(variable_t<U, V>* real, variable_t<U, V>* imag);
 
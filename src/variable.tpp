@@ -29,12 +29,73 @@
 
 #include <complex>
 #include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <vector>
 
 using std::cout;
 using std::endl;
 using std::complex;
 
-static const std::string MISSING_VALUE_NAME = "_FillValue";
+/** How much a lazy read of an unchunked variable fetches at once */
+static const size_t CONTIGUOUS_SLAB_BYTES = 16 * 1024 * 1024;
+
+/** The fewest values worth unpacking on all threads */
+static const size_t UNPACK_PARALLEL_LEN = 64 * 1024;
+
+/**
+ * Reads a hyperslab of a NetCDF variable into `vals`. Only real-valued data
+ * is stored in NetCDF files, so complex variables can never be lazy.
+ */
+template<typename S>
+void read_netcdf_slab(const netcdf_file_t* file, netcdf_var_t var, const size_t* start, const size_t* count, S* vals) {
+    file->get_var_vals<S>(var, start, count, vals);
+}
+
+template<typename S>
+void read_netcdf_slab(const netcdf_file_t*, netcdf_var_t, const size_t*, const size_t*, std::complex<S>*) {
+    throw eof_error_t("(Internal Error) Complex-valued variables cannot be read lazily");
+}
+
+/**
+ * Reads a strided hyperslab of a NetCDF variable into `vals`
+ */
+template<typename S>
+void read_netcdf_slab(const netcdf_file_t* file, netcdf_var_t var, const size_t* start, const size_t* count, const size_t* stride, S* vals) {
+    file->get_var_vals<S>(var, start, count, stride, vals);
+}
+
+template<typename S>
+void read_netcdf_slab(const netcdf_file_t*, netcdf_var_t, const size_t*, const size_t*, const size_t*, std::complex<S>*) {
+    throw eof_error_t("(Internal Error) Complex-valued variables cannot be read lazily");
+}
+
+/**
+ * Unpacks `len` values of a packed variable in place, as CF does:
+ * value * scale_factor + add_offset
+ */
+template<typename S>
+void unpack_values(size_t len, double scale_factor, double add_offset, S* vals) {
+    #pragma omp parallel for if (len >= UNPACK_PARALLEL_LEN)
+    for (size_t i = 0; i < len; i++) {
+        vals[i] = (S) ((double) vals[i] * scale_factor + add_offset);
+    }
+}
+
+template<typename S>
+void unpack_values(size_t, double, double, std::complex<S>*) {
+    throw eof_error_t("(Internal Error) Complex-valued variables cannot be packed");
+}
+
+template<typename S>
+void read_fast_slab(const slab_reader_t* reader, const size_t* start, const size_t* count, S* vals) {
+    reader->read(start, count, vals);
+}
+
+template<typename S>
+void read_fast_slab(const slab_reader_t*, const size_t*, const size_t*, std::complex<S>*) {
+    throw eof_error_t("(Internal Error) Complex-valued variables cannot be read lazily");
+}
 
 
 
@@ -59,6 +120,21 @@ variable_t<S, T>::variable_t(const std::string name, const netcdf_file_t* file)
     this->load_from_netcdf(name, file);
 }
 
+template<typename S, typename T>
+variable_t<S, T>::variable_t(const std::string name, const std::string filename) {
+    this->load_lazily(name, filename, selection_t());
+}
+
+template<typename S, typename T>
+variable_t<S, T>::variable_t(const std::string name, const netcdf_file_t* file, const selection_t& selection) {
+    this->load_from_netcdf(name, file, selection);
+}
+
+template<typename S, typename T>
+variable_t<S, T>::variable_t(const std::string name, const std::string filename, const selection_t& selection) {
+    this->load_lazily(name, filename, selection);
+}
+
 template<typename S, typename T>
 variable_t<S, T>::variable_t(size_t num_dims, dimension_t<T>** dims) {
     this->load_from_dims(num_dims, dims);
@@ -85,40 +161,312 @@ void variable_t<S, T>::load_from_var(const variable_t<S, T>&) {
 
 template<typename S, typename T>
 void variable_t<S, T>::load_from_netcdf(const std::string name, const netcdf_file_t* file) {
+    this->load_from_netcdf(name, file, selection_t());
+}
+
+template<typename S, typename T>
+void variable_t<S, T>::load_lazily_from_netcdf(const std::string name, const std::string filename) {
+    this->load_lazily_from_netcdf(name, filename, selection_t());
+}
+
+/**
+ * Loads only the part of variable `name` of `file` given by `selection`,
+ * whose dimensions then only have the selected steps
+ */
+template<typename S, typename T>
+void variable_t<S, T>::load_from_netcdf(const std::string name, const netcdf_file_t* file, const selection_t& selection) {
+    this->source_part = -1;
+    this->parts_along_dim = false;
+    this->load_metadata_from_netcdf(name, file, selection);
+
+    // Any earlier lazy source is replaced by the data itself
+    if (this->source != nullptr) {
+        delete this->source;
+        this->source = nullptr;
+    }
+
+    delete this->fast_reader;
+    this->fast_reader = nullptr;
+
+    // Load the data from NetCDF
+    if (this->data != nullptr && this->owns_data) {
+        delete[] this->data;
+    }
+
+    size_t num_dims = this->get_num_dims();
+    size_t count[num_dims];
+    size_t len = 1;
+    for (size_t i = 0; i < num_dims; i++) {
+        count[i] = this->get_dim(i)->get_size();
+        len *= count[i];
+    }
+
+    if (this->source_start == nullptr) {
+        this->data = file->get_var_vals<S>(file->get_var(name));
+    } else {
+        this->data = new S[len];
+        read_netcdf_slab(file, file->get_var(name), this->source_start, count, this->source_stride, this->data);
+
+        // The data is resident now, so it is no longer read from the file
+        delete[] this->source_start;
+        delete[] this->source_stride;
+        this->source_start = nullptr;
+        this->source_stride = nullptr;
+    }
+    this->owns_data = true;
+
+    if (this->packed) {
+        unpack_values(len, this->scale_factor, this->add_offset, this->data);
+    }
+}
+
+/**
+ * Loads only the dimensions and attributes of a variable, and keeps its own
+ * handle on the file so that hyperslabs of the data can be read when they are
+ * needed (by get_slice, to_matrix, get_absmax and write). Only the part given
+ * by `selection` is ever read.
+ */
+template<typename S, typename T>
+void variable_t<S, T>::load_lazily_from_netcdf(const std::string name, const std::string filename, const selection_t& selection) {
+    this->source_part = -1;
+    this->parts_along_dim = false;
+    this->open_netcdf(name, filename, selection);
+}
+
+/**
+ * Loads variable `name` lazily from `filename`, which is either a NetCDF file
+ * or a raw dump with a sidecar file (see raw_file_t)
+ */
+template<typename S, typename T>
+void variable_t<S, T>::load_lazily(const std::string name, const std::string filename, const selection_t& selection) {
+    if (raw_file_t::is_raw(filename)) {
+        this->load_lazily_from_raw(name, filename, selection);
+    } else {
+        this->load_lazily_from_netcdf(name, filename, selection);
+    }
+}
+
+/**
+ * Loads the variable in the raw dump `filename` lazily, as
+ * load_lazily_from_netcdf does. Its name in the sidecar file must be `name`.
+ * All of it is read by its raw_file_t.
+ */
+template<typename S, typename T>
+void variable_t<S, T>::load_lazily_from_raw(const std::string name, const std::string filename, const selection_t& selection) {
+    raw_file_t* file = new raw_file_t(filename);
+    if (file->get_var_name() != name) {
+        delete file;
+        throw eof_error_t("Variable \"" + name + "\" is not the one in raw file \"" + filename + "\"");
+    }
+
+    size_t num_dims = file->get_num_dims();
+    dimension_t<T>** dims = new dimension_t<T>*[num_dims];
+    for (size_t i = 0; i < num_dims; i++) {
+        const std::vector<double>& coords = file->get_coords(i);
+        std::vector<T> values(coords.begin(), coords.end());
+        dims[i] = new dimension_t<T>(file->get_dim_name(i), values.size(), values.data(), 0, nullptr);
+    }
+
+    try {
+        this->select_dims(num_dims, dims, selection);
+    } catch (...) {
+        for (size_t i = 0; i < num_dims; i++) {
+            delete dims[i];
+        }
+        delete[] dims;
+        delete file;
+        throw;
+    }
+    this->set_dims(num_dims, dims);
+
+    this->source_part = -1;
+    this->parts_along_dim = false;
+    this->packed = file->is_packed();
+    this->scale_factor = file->get_scale_factor();
+    this->add_offset = file->get_add_offset();
+    this->packed_short = this->packed && file->get_var_type() == NC_SHORT;
+    this->load_missing_value(file->has_fill(), file->get_fill());
+
+    // The text attributes, each holding its value as a netcdf_file_t would
+    size_t num_attrs = file->get_num_attrs();
+    attribute_t** attrs = new attribute_t*[num_attrs];
+    for (size_t i = 0; i < num_attrs; i++) {
+        std::string value = file->get_attr_value(i);
+        char* text = (char*) malloc(value.size());
+        std::copy(value.begin(), value.end(), text);
+        attrs[i] = new attribute_t(file->get_attr_name(i), NC_CHAR, 1, value.size(), text);
+    }
+    this->set_attrs(num_attrs, attrs);
+
+    // A raw variable has no NetCDF source, only its reader
+    if (this->source != nullptr) {
+        delete this->source;
+        this->source = nullptr;
+    }
+    delete this->fast_reader;
+    this->fast_reader = file;
+    this->source_filename = filename;
+    this->source_name = name;
+    this->lazy_absmax_known = false;
+
+    if (this->data != nullptr && this->owns_data) {
+        delete[] this->data;
+    }
+    this->data = nullptr;
+    this->owns_data = true;
+}
+
+/**
+ * Loads one part (0 for the real part, 1 for the imaginary part) of the
+ * complex values of variable `name` lazily, as load_lazily_from_netcdf does.
+ * The parts are the two steps of the variable's last dimension, which must
+ * be `part_dim` and of length 2 (and is then not one of this variable's), or,
+ * if `part_dim` is empty, the two members of its compound type.
+ */
+template<typename S, typename T>
+void variable_t<S, T>::load_part_lazily_from_netcdf(const std::string name, const std::string filename, const selection_t& selection, int part, const std::string part_dim) {
+    nc_type part_type = NC_NAT;
+    {
+        netcdf_file_t file(filename, NETCDF_READ);
+        if (!file.has_var(name)) {
+            throw eof_error_t("Variable \"" + name + "\" does not exist in this NetCDF file");
+        }
+
+        netcdf_var_t var = file.get_var(name);
+        int num_dims = file.get_var_n_dims(var);
+        if (part_dim.empty()) {
+            if (!file.get_complex_compound(var, &part_type)) {
+                throw eof_error_t("Variable \"" + name + "\" is not of a compound type of real and imaginary parts");
+            }
+        } else if (num_dims == 0 || file.get_var_dim_name(var, num_dims - 1) != part_dim ||
+                file.get_var_dim_len(var, num_dims - 1) != 2) {
+            throw eof_error_t("The last dimension of variable \"" + name + "\" is not \"" + part_dim + "\" of length 2");
+        }
+    }
+
+    this->source_part = part;
+    this->parts_along_dim = !part_dim.empty();
+    this->part_type = part_type;
+    this->open_netcdf(name, filename, selection);
+}
+
+/**
+ * Opens `filename` and loads the metadata of variable `name` from it, for
+ * both kinds of lazy variable
+ */
+template<typename S, typename T>
+void variable_t<S, T>::open_netcdf(const std::string name, const std::string filename, const selection_t& selection) {
+    netcdf_file_t* file = new netcdf_file_t(filename, NETCDF_READ);
+
+    try {
+        this->load_metadata_from_netcdf(name, file, selection);
+    } catch (...) {
+        delete file;
+        throw;
+    }
+
+    if (this->source != nullptr) {
+        delete this->source;
+    }
+    this->source = file;
+    this->source_var = file->get_var(name);
+    this->source_filename = filename;
+    this->source_name = name;
+    this->lazy_absmax_known = false;
+
+    // Decompress NetCDF-4 chunks on all threads, or copy classic-format data
+    // straight out of a memory map, where possible, and fall back to the
+    // NetCDF library otherwise. Neither reads compound types.
+    delete this->fast_reader;
+    this->fast_reader = nullptr;
+    slab_reader_t* reader = nullptr;
+    bool is_compound = this->source_part >= 0 && !this->parts_along_dim;
+#ifdef WITH_HDF5
+    if (!is_compound && hdf5_chunk_reader_t::is_hdf5(filename)) {
+        reader = new hdf5_chunk_reader_t(filename, name);
+    }
+#endif
+    if (reader == nullptr && !is_compound && cdf_mmap_reader_t::is_classic(filename)) {
+        reader = new cdf_mmap_reader_t(filename, name);
+    }
+    if (reader != nullptr && reader->is_supported()) {
+        this->fast_reader = reader;
+    } else {
+        delete reader;
+    }
+
+    if (this->data != nullptr && this->owns_data) {
+        delete[] this->data;
+    }
+    this->data = nullptr;
+    this->owns_data = true;
+}
+
+/**
+ * Loads the dimensions (as far as `selection` reaches in each) and the
+ * attributes of variable `name` of `file`
+ */
+template<typename S, typename T>
+void variable_t<S, T>::load_metadata_from_netcdf(const std::string name, const netcdf_file_t* file, const selection_t& selection) {
     if (!file->has_var(name)) {
         throw eof_error_t("Variable \"" + name + "\" does not exist in this NetCDF file");
     }
 
     netcdf_var_t var_id = file->get_var(name);
     size_t num_dims = file->get_var_n_dims(var_id);
+    if (this->parts_along_dim) {
+        // The dimension of the real and imaginary parts
+        num_dims--;
+    }
     size_t num_attrs = file->get_n_attrs(var_id);
     dimension_t<T>** dims = new dimension_t<T>*[num_dims];
     attribute_t**   attrs = new attribute_t*[num_attrs];
 
-    // Load the dimensions
+    // Load the dimensions, keeping only the selected steps of each
     for (size_t i = 0; i < num_dims; i++) {
         netcdf_dim_t dim_id = file->get_var_dim(var_id, i);
-        std::string dim_name = file->get_dim_name(dim_id);
-        dims[i] = new dimension_t<T>(dim_name, file);
+        dims[i] = new dimension_t<T>(file->get_dim_name(dim_id), file);
     }
+    this->select_dims(num_dims, dims, selection);
 
     // Set the name and dimensions
     this->set_dims(num_dims, dims);
 
-    // Try loading the missing value
-    if (file->has_fill(var_id)) {
-        this->set_missing_value(file->get_fill<S>(var_id));
-    } else if (file->has_attr(var_id, MISSING_VALUE_NAME)) {
-        this->set_missing_value(*((int*)file->get_attr_val(var_id, MISSING_VALUE_NAME)));
+    // Packed values are unpacked as they are read
+    this->packed = file->has_attr(var_id, "scale_factor") || file->has_attr(var_id, "add_offset");
+    this->scale_factor = file->has_attr(var_id, "scale_factor") ? file->get_attr_double(var_id, "scale_factor") : 1;
+    this->add_offset = file->has_attr(var_id, "add_offset") ? file->get_attr_double(var_id, "add_offset") : 0;
+    this->packed_short = this->packed && file->get_var_type(var_id) == NC_SHORT;
+
+    // Try loading the missing value: an explicit fill value, then a CF
+    // missing_value, and otherwise the default fill value
+    bool has_missing = true;
+    double missing = 0;
+    if (file->get_var_type(var_id) > NC_MAX_ATOMIC_TYPE) {
+        // Compound values have no fill value either part could be compared to
+        has_missing = false;
+    } else if (file->has_attr(var_id, MISSING_VALUE_NAME) && file->has_fill(var_id)) {
+        missing = file->get_fill<double>(var_id);
+    } else if (file->has_attr(var_id, "missing_value")) {
+        missing = file->get_attr_double(var_id, "missing_value");
+    } else if (file->has_fill(var_id)) {
+        missing = file->get_fill<double>(var_id);
+    } else {
+        has_missing = false;
     }
 
-    // Load the attributes (aside from missing value attributes)
+    this->load_missing_value(has_missing, missing);
+
+    // Load the attributes (aside from missing value and packing attributes)
     size_t num_attrs_filtered = num_attrs;
     for (size_t i = 0; i < num_attrs; i++) {
         std::string attr_name = file->get_attr(var_id, i);
+        attrs[i] = nullptr;
         if(attr_name != "_FillValue" &&
            attr_name != "missing_value" &&
-           attr_name != "missing_val"){
+           attr_name != "missing_val" &&
+           attr_name != "scale_factor" &&
+           attr_name != "add_offset"){
             attrs[i] = new attribute_t(attr_name, file, name);
         }else{
             num_attrs_filtered--;
@@ -134,15 +482,70 @@ void variable_t<S, T>::load_from_netcdf(const std::string name, const netcdf_fil
 
     // Set the name and dimensions
     this->set_attrs(num_attrs_filtered, attrs_filtered);
+}
 
-    // Load the data from NetCDF
-    if (this->data != nullptr) {
-        delete[] this->data;
+/**
+ * Keeps only the steps of each of `dims` (those of the file's variable) given
+ * by `selection`, and remembers where they are in the file
+ */
+template<typename S, typename T>
+void variable_t<S, T>::select_dims(size_t num_dims, dimension_t<T>** dims, const selection_t& selection) {
+    delete[] this->source_start;
+    delete[] this->source_stride;
+    this->source_start = nullptr;
+    this->source_stride = nullptr;
+    this->selection = selection;
+
+    bool is_partial = false;
+    size_t* start = new size_t[num_dims];
+    size_t* stride = new size_t[num_dims];
+    for (size_t i = 0; i < num_dims; i++) {
+        size_t len = dims[i]->get_size();
+        const T* values = dims[i]->get_values();
+        std::vector<double> coords(values, values + len);
+        size_t count;
+        try {
+            selection.resolve(dims[i]->get_name(), len, coords, &start[i], &count, &stride[i]);
+        } catch (...) {
+            delete[] start;
+            delete[] stride;
+            throw;
+        }
+
+        if (count != len) {
+            std::vector<T> selected(count);
+            for (size_t j = 0; j < count; j++) {
+                selected[j] = values[start[i] + j * stride[i]];
+            }
+            dims[i]->set_values(count, selected.data());
+            is_partial = true;
+        }
     }
 
-    // TODO Change to get_vara_vals to fix strided accesses later
-    this->data = file->get_var_vals<S>(var_id);
+    if (is_partial) {
+        this->source_start = start;
+        this->source_stride = stride;
+    } else {
+        delete[] start;
+        delete[] stride;
+    }
+}
 
+/**
+ * Sets the missing value of the file's variable, if it has one, as it is read
+ */
+template<typename S, typename T>
+void variable_t<S, T>::load_missing_value(bool has_missing, double missing) {
+    this->unset_missing_value();
+    if (has_missing) {
+        // Unpacked just as the values are, so that they still compare equal
+        S value = (S) missing;
+        if (this->packed) {
+            unpack_values(1, this->scale_factor, this->add_offset, &value);
+            this->packed_missing_value = (short) missing;
+        }
+        this->set_missing_value(value);
+    }
 }
 
 template<typename S, typename T>
@@ -171,6 +574,19 @@ variable_t<S, T>::~variable_t() {
 template<typename S, typename T>
 void variable_t<S, T>::clear() {
     this->clear_dims();
+
+    if (this->source != nullptr) {
+        delete this->source;
+        this->source = nullptr;
+    }
+
+    delete this->fast_reader;
+    this->fast_reader = nullptr;
+
+    delete[] this->source_start;
+    delete[] this->source_stride;
+    this->source_start = nullptr;
+    this->source_stride = nullptr;
 }
 
 template<typename S, typename T>
@@ -188,10 +604,11 @@ void variable_t<S, T>::clear_dims() {
         this->striding = nullptr;
     }
 
-    if (this->data != nullptr) {
+    if (this->data != nullptr && this->owns_data) {
         delete[] this->data;
-        this->data = nullptr;
     }
+    this->data = nullptr;
+    this->owns_data = true;
 
     this->num_dims = 0;
 }
@@ -399,6 +816,92 @@ void variable_t<S, T>::set_missing_value(S missing_value) {
     this->contains_missing_value = true;
 }
 
+/**
+ * Returns the selection this variable was loaded with, which is empty if it
+ * was loaded whole (or not from a file at all)
+ */
+template<typename S, typename T>
+const selection_t& variable_t<S, T>::get_selection() const {
+    return this->selection;
+}
+
+/**
+ * Were the values packed in the file (with a CF scale_factor and/or
+ * add_offset)? They are always unpacked as they are read, by
+ * value * get_scale_factor() + get_add_offset().
+ */
+template<typename S, typename T>
+bool variable_t<S, T>::is_packed() const {
+    return this->packed;
+}
+
+template<typename S, typename T>
+double variable_t<S, T>::get_scale_factor() const {
+    return this->scale_factor;
+}
+
+template<typename S, typename T>
+double variable_t<S, T>::get_add_offset() const {
+    return this->add_offset;
+}
+
+/**
+ * Can this variable be read packed, by to_packed_matrix? Only lazy variables
+ * packed as short can.
+ */
+template<typename S, typename T>
+bool variable_t<S, T>::can_read_packed() const {
+    return this->is_lazy() && this->packed_short && this->source_part < 0;
+}
+
+/**
+ * Returns the missing value (if there is one) before it was unpacked
+ */
+template<typename S, typename T>
+short variable_t<S, T>::get_packed_missing_value() const {
+    return this->packed_missing_value;
+}
+
+/**
+ * Is this variable one part of complex values in its file, which
+ * to_part_matrices can read together with the other part?
+ */
+template<typename S, typename T>
+bool variable_t<S, T>::is_complex_part() const {
+    return this->is_lazy() && this->source_part >= 0;
+}
+
+/**
+ * Returns the file a lazy variable is read from, and its name there (or
+ * those of the variable a derived variable was made from)
+ */
+template<typename S, typename T>
+const std::string& variable_t<S, T>::get_source_filename() const {
+    return this->source_filename;
+}
+
+template<typename S, typename T>
+const std::string& variable_t<S, T>::get_source_name() const {
+    return this->source_name;
+}
+
+/**
+ * Remembers that this variable holds `derivation` (e.g. "analytic im") of
+ * `var`, so that it is described by the same source as `var`
+ */
+template<typename S, typename T>
+void variable_t<S, T>::set_derived_from(const variable_t<S, T>* var, const std::string derivation) {
+    this->source_filename = var->get_source_filename();
+    this->source_name = var->get_source_name();
+    this->selection = var->get_selection();
+    this->derivation = derivation;
+}
+
+template<typename S, typename T>
+const std::string& variable_t<S, T>::get_derivation() const {
+    return this->derivation;
+}
+
 template<typename S, typename T>
 void variable_t<S, T>::unset_missing_value() {
     this->contains_missing_value = false;
@@ -412,6 +915,122 @@ void variable_t<S, T>::unset_missing_value() {
 // Miscellaneous
 //==============================================================================
 
+/**
+ * Is this variable's data read from its file on demand? Lazy variables have
+ * no resident data, so get_data() returns nullptr for them.
+ */
+template<typename S, typename T>
+bool variable_t<S, T>::is_lazy() const {
+    return this->source != nullptr || this->fast_reader != nullptr;
+}
+
+template<typename S, typename T>
+void variable_t<S, T>::set_chunk_cache_limit(size_t bytes) {
+    this->chunk_cache_limit = bytes;
+}
+
+/**
+ * Makes `data` the storage of this variable, without copying it or taking
+ * ownership of it. It must hold the whole variable, laid out as get_slice
+ * would return it, and must outlive this variable (or its next reload). A
+ * lazy variable stops reading from its file.
+ */
+template<typename S, typename T>
+void variable_t<S, T>::map_data(S* data) {
+    if (this->source != nullptr) {
+        delete this->source;
+        this->source = nullptr;
+    }
+
+    delete this->fast_reader;
+    this->fast_reader = nullptr;
+
+    delete[] this->source_start;
+    delete[] this->source_stride;
+    this->source_start = nullptr;
+    this->source_stride = nullptr;
+
+    if (this->data != nullptr && this->owns_data) {
+        delete[] this->data;
+    }
+    this->data = data;
+    this->owns_data = false;
+}
+
+/**
+ * Returns how many steps of dimension `index` a lazy variable should read at
+ * once when it is read in order along that dimension, and sizes its chunk
+ * cache for that order.
+ *
+ * For a chunked variable every read spans exactly one layer of chunks along
+ * `index`, so that each chunk is decompressed once, by a single read. The
+ * cache is made large enough to hold a whole layer (up to the configured
+ * limit) and set to evict fully read chunks first. An unchunked variable is
+ * read in slabs of about CONTIGUOUS_SLAB_BYTES.
+ */
+template<typename S, typename T>
+size_t variable_t<S, T>::get_slab_len(size_t index) const {
+    size_t num_dims = this->get_num_dims();
+    size_t len = this->get_dim(index)->get_size();
+    if (!this->is_lazy() || len == 0) {
+        return 1;
+    }
+
+    size_t num_source_dims = (this->source != nullptr) ? this->source->get_var_n_dims(this->source_var) : num_dims;
+    size_t chunks[num_source_dims];
+    if (this->source != nullptr && this->source->get_var_chunking(this->source_var, chunks)) {
+        size_t chunk_bytes = this->source->get_type_size(this->source->get_var_type(this->source_var));
+        size_t chunks_per_layer = 1;
+        size_t stride = 1;
+        for (size_t i = 0; i < num_dims; i++) {
+            // How far the selected steps spread in the file
+            size_t size = this->get_dim(i)->get_size();
+            if (this->source_stride != nullptr && size > 0) {
+                size = (size - 1) * this->source_stride[i] + 1;
+                if (i == index) {
+                    stride = this->source_stride[i];
+                }
+            }
+
+            chunk_bytes *= chunks[i];
+            if (i != index) {
+                chunks_per_layer *= (size + chunks[i] - 1) / chunks[i];
+            }
+        }
+
+        // Both steps of a trailing dimension of complex parts are read
+        if (this->parts_along_dim) {
+            chunk_bytes *= chunks[num_dims];
+            chunks_per_layer *= (2 + chunks[num_dims] - 1) / chunks[num_dims];
+        }
+
+        size_t cache_bytes = chunks_per_layer * chunk_bytes;
+        if (cache_bytes > this->chunk_cache_limit) {
+            cache_bytes = this->chunk_cache_limit;
+        }
+
+        // HDF5 wants a prime number of hash slots, well above the number of
+        // chunks that fit in the cache
+        size_t nelems = 100 * chunks_per_layer + 1;
+        while (!is_prime(nelems)) {
+            nelems += 2;
+        }
+        this->source->set_var_chunk_cache(this->source_var, cache_bytes, nelems, 1.0f);
+
+        return std::max((size_t) 1, std::min(chunks[index] / stride, len));
+    }
+
+    size_t layer_bytes = (this->source_part >= 0) ? 2 * sizeof(S) : sizeof(S);
+    for (size_t i = 0; i < num_dims; i++) {
+        if (i != index) {
+            layer_bytes *= this->get_dim(i)->get_size();
+        }
+    }
+
+    size_t slab_len = CONTIGUOUS_SLAB_BYTES / std::max(layer_bytes, (size_t) 1);
+    return std::max((size_t) 1, std::min(slab_len, len));
+}
+
 template<typename S, typename T>
 const S* variable_t<S, T>::get_data() const {
     return (const S*) this->data;
@@ -422,8 +1041,154 @@ const std::complex<S>* variable_t<S, T>::get_data_complex() const {
     return (const std::complex<S>*) this->data;
 }
 */
+/**
+ * Reads a slice of a lazy variable from its file, as the values are stored
+ * there (so still packed, if they are)
+ */
+template<typename S, typename T>
+template<typename U>
+void variable_t<S, T>::read_source(const size_t* start, const size_t* size, U* vals) const {
+    if (this->source_part >= 0) {
+        // Both parts are read together, and only this one is kept
+        size_t len = 1;
+        for (size_t i = 0; i < this->get_num_dims(); i++) {
+            len *= size[i];
+        }
+
+        std::vector<U> parts(2 * len);
+        this->read_parts(start, size, parts.data());
+        for (size_t i = 0; i < len; i++) {
+            vals[i] = parts[2 * i + this->source_part];
+        }
+        return;
+    }
+
+    if (this->source_start != nullptr) {
+        // Map the slice onto the selected part of the file's variable. The
+        // fast readers only read contiguous hyperslabs, so strided ones are
+        // left to the NetCDF library.
+        size_t num_dims = this->get_num_dims();
+        size_t source_start[num_dims];
+        bool is_strided = false;
+        for (size_t i = 0; i < num_dims; i++) {
+            source_start[i] = this->source_start[i] + start[i] * this->source_stride[i];
+            is_strided = is_strided || (this->source_stride[i] > 1 && size[i] > 1);
+        }
+
+        if (this->fast_reader != nullptr && !is_strided) {
+            read_fast_slab(this->fast_reader, source_start, size, vals);
+            return;
+        }
+        if (this->source == nullptr) {
+            this->read_spanned(source_start, size, vals);
+            return;
+        }
+        read_netcdf_slab(this->source, this->source_var, source_start, size, this->source_stride, vals);
+        return;
+    }
+
+    if (this->fast_reader != nullptr) {
+        read_fast_slab(this->fast_reader, start, size, vals);
+        return;
+    }
+    read_netcdf_slab(this->source, this->source_var, start, size, vals);
+}
+
+/**
+ * Reads a strided slice of a variable that only has a fast reader (from a
+ * raw dump), by reading the whole hyperslab it spans in the file and picking
+ * the selected steps out of that. `start` is in the file's coordinates.
+ */
+template<typename S, typename T>
+template<typename U>
+void variable_t<S, T>::read_spanned(const size_t* start, const size_t* size, U* vals) const {
+    size_t num_dims = this->get_num_dims();
+    size_t span[num_dims];
+    size_t len = 1;
+    for (size_t i = 0; i < num_dims; i++) {
+        span[i] = (size[i] > 0) ? (size[i] - 1) * this->source_stride[i] + 1 : 0;
+        len *= span[i];
+    }
+
+    std::vector<U> spanned(len);
+    read_fast_slab(this->fast_reader, start, span, spanned.data());
+
+    size_t n = 0;
+    nested_for(num_dims, size, [&, this](size_t* indices) {
+        size_t index = 0;
+        for (size_t i = 0; i < num_dims; i++) {
+            index = index * span[i] + indices[i] * this->source_stride[i];
+        }
+        vals[n] = spanned[index];
+        n++;
+    });
+}
+
+/**
+ * Reads a slice of a lazy variable that is one part of complex values in its
+ * file, as pairs of a real and an imaginary part (still packed, if they are),
+ * with one read
+ */
+template<typename S, typename T>
+template<typename U>
+void variable_t<S, T>::read_parts(const size_t* start, const size_t* size, U* vals) const {
+    size_t num_dims = this->get_num_dims();
+    size_t num_source_dims = this->parts_along_dim ? num_dims + 1 : num_dims;
+    size_t source_start[num_source_dims];
+    size_t source_count[num_source_dims];
+    size_t source_stride[num_source_dims];
+    size_t len = 1;
+    bool is_strided = false;
+    for (size_t i = 0; i < num_dims; i++) {
+        size_t stride = (this->source_stride != nullptr) ? this->source_stride[i] : 1;
+        size_t offset = (this->source_start != nullptr) ? this->source_start[i] : 0;
+        source_start[i] = offset + start[i] * stride;
+        source_count[i] = size[i];
+        source_stride[i] = stride;
+        len *= size[i];
+        is_strided = is_strided || (stride > 1 && size[i] > 1);
+    }
+
+    if (this->parts_along_dim) {
+        source_start[num_dims] = 0;
+        source_count[num_dims] = 2;
+        source_stride[num_dims] = 1;
+
+        if (this->fast_reader != nullptr && !is_strided) {
+            read_fast_slab(this->fast_reader, source_start, source_count, vals);
+            return;
+        }
+        read_netcdf_slab(this->source, this->source_var, source_start, source_count, source_stride, vals);
+        return;
+    }
+
+    // Compound values are read as they are stored, and then converted
+    std::vector<char> raw(2 * len * this->source->get_type_size(this->part_type));
+    this->source->get_var_raw(this->source_var, source_start, source_count, source_stride, raw.data());
+    if (this->part_type == NC_FLOAT) {
+        const float* parts = (const float*) raw.data();
+        std::copy(parts, parts + 2 * len, vals);
+    } else {
+        const double* parts = (const double*) raw.data();
+        std::copy(parts, parts + 2 * len, vals);
+    }
+}
+
 template<typename S, typename T>
 void variable_t<S, T>::get_slice(const size_t* start, const size_t* size, S* slice) const {
+    if (this->is_lazy()) {
+        this->read_source(start, size, slice);
+
+        if (this->packed) {
+            size_t len = 1;
+            for (size_t i = 0; i < this->get_num_dims(); i++) {
+                len *= size[i];
+            }
+            unpack_values(len, this->scale_factor, this->add_offset, slice);
+        }
+        return;
+    }
+
     size_t len = this->get_num_dims();
     size_t start_index = dot_product<size_t>(start, this->striding, len);
     size_t n = 0;
@@ -437,6 +1202,10 @@ void variable_t<S, T>::get_slice(const size_t* start, const size_t* size, S* sli
 
 template<typename S, typename T>
 void variable_t<S, T>::set_slice(const size_t* start, const size_t* size, const S* slice) {
+    if (this->is_lazy()) {
+        throw eof_error_t("Cannot set values of a variable read lazily from a file");
+    }
+
     size_t len = this->get_num_dims();
     size_t start_index = dot_product<size_t>(start, this->striding, len);
     size_t n = 0;
@@ -455,72 +1224,9 @@ void variable_t<S, T>::set_slice(const size_t* start, const size_t* size, const
  */
 template<typename S, typename T>
 void write_var(const variable_t<S, T>* var, const std::string name, netcdf_file_t* file) {
-    netcdf_dim_t dim_ids[var->get_num_dims()];
-    for (size_t i = 0; i < var->get_num_dims(); i++) {
-        const dimension_t<T>* dim = var->get_dim(i);
-
-        // Define this dimension if it doesn't already exist
-        // Either way, get the dimension ID
-        if (!file->has_dim(dim->get_name())) {
-            file->begin_def();
-            dim_ids[i] = file->def_dim(dim->get_name(), dim->get_size());
-            file->end_def();
-        } else {
-            dim_ids[i] = file->get_dim(dim->get_name());
-        }
-
-        // Define this dimension's variable if it doesn't already exist
-        // Either way, get the variable ID
-        netcdf_var_t var_id;
-        if (!file->has_var(dim->get_name())) {
-            file->begin_def();
-            var_id = file->def_var<T>(dim->get_name(), 1, &dim_ids[i]);
-            file->end_def();
-            for(size_t j = 0; j < dim->get_num_attrs(); j++){
-                const attribute_t* attr = dim->get_attr(j);
-                if(!file->has_attr(var_id, attr->get_name())){
-                    file->begin_def();
-                    file->set_attr(var_id, attr->get_name(), attr->get_type(), attr->get_length(), attr->get_value());
-                    file->end_def();
-                }
-            }
-        } else {
-            var_id = file->get_var(dim->get_name());
-        }
-
-        // Set this dimension's values
-        file->set_var_vals<T>(var_id, dim->get_values());
-    }
-
-    // Define this variable if it doesn't already exist
-    // Either way, get the variable ID
-    netcdf_var_t var_id;
-    if (!file->has_var(name)) {
-        file->begin_def();
-        var_id = file->def_var<S>(name, var->get_num_dims(), dim_ids);
-
-        // Write the fill value, if applicable
-        if (var->has_missing_value()) {
-            file->set_fill(var_id, var->get_missing_value(), MISSING_VALUE_NAME);
-        }
-        file->end_def();
-    } else {
-        var_id = file->get_var(name);
-    }
-
-    // Write the variable attributes
-    for(size_t i = 0; i < var->get_num_attrs(); i++){
-        const attribute_t* attr = var->get_attr(i);
-        if(!file->has_attr(var_id, attr->get_name())){
-            file->begin_def();
-            file->set_attr(var_id, attr->get_name(), attr->get_type(), attr->get_length(), attr->get_value());
-            file->end_def();
-        }
-    }
-
-    // Set its values and synchronize the file
-    file->set_var_vals<S>(var_id, var->get_data());
-    file->sync();
+    netcdf_writer_t writer(file);
+    writer.add(var, name);
+    writer.commit();
 }
 
 /**
@@ -528,80 +1234,9 @@ void write_var(const variable_t<S, T>* var, const std::string name, netcdf_file_
  */
 template<typename S, typename T>
 void write_complex_var(const variable_t<std::complex<S>, T>* var, const std::string name_re, const std::string name_im, netcdf_file_t* file) {
-    size_t total_size = 1;
-    netcdf_dim_t dim_ids[var->get_num_dims()];
-    for (size_t i = 0; i < var->get_num_dims(); i++) {
-        const dimension_t<T>* dim = var->get_dim(i);
-
-        // Define this dimension if it doesn't already exist
-        // Either way, get the dimension ID
-        if (!file->has_dim(dim->get_name())) {
-            file->begin_def();
-            dim_ids[i] = file->def_dim(dim->get_name(), dim->get_size());
-            file->end_def();
-        } else {
-            dim_ids[i] = file->get_dim(dim->get_name());
-        }
-
-        // Define this dimension's variable if it doesn't already exist
-        // Either way, get the variable ID
-        netcdf_var_t var_id;
-        if (!file->has_var(dim->get_name())) {
-            file->begin_def();
-            var_id = file->def_var<T>(dim->get_name(), 1, &dim_ids[i]);
-            file->end_def();
-        } else {
-            var_id = file->get_var(dim->get_name());
-        }
-
-        // Set this dimension's values and update the total size
-        file->set_var_vals<T>(var_id, dim->get_values());
-        total_size *= dim->get_size();
-    }
-
-    // Define this variable if it doesn't already exist
-    // Either way, get the variable ID
-    netcdf_var_t var_re_id;
-    if (!file->has_var(name_re)) {
-        file->begin_def();
-        var_re_id = file->def_var<S>(name_re, var->get_num_dims(), dim_ids);
-
-        // Write the fill value, if applicable
-        if (var->has_missing_value()) {
-            file->set_fill(var_re_id, var->get_missing_value().real(), MISSING_VALUE_NAME);
-        }
-        file->end_def();
-    } else {
-        var_re_id = file->get_var(name_re);
-    }
-
-    netcdf_var_t var_im_id;
-    if (!file->has_var(name_im)) {
-        file->begin_def();
-        var_im_id = file->def_var<S>(name_im, var->get_num_dims(), dim_ids);
-
-        // Write the fill value, if applicable
-        if (var->has_missing_value()) {
-            file->set_fill(var_im_id, var->get_missing_value().imag(), MISSING_VALUE_NAME);
-        }
-        file->end_def();
-    } else {
-        var_im_id = file->get_var(name_im);
-    }
-
-    // Separate the real and imaginary parts
-    S* data_re = new S[total_size];
-    S* data_im = new S[total_size];
-    const std::complex<S>* data = var->get_data();
-    for (size_t i = 0; i < total_size; i++) {
-        data_re[i] = data[i].real();
-        data_im[i] = data[i].imag();
-    }
-
-    // Set its values and synchronize the file
-    file->set_var_vals<S>(var_re_id, data_re);
-    file->set_var_vals<S>(var_im_id, data_im);
-    file->sync();
+    netcdf_writer_t writer(file);
+    writer.add_complex(var, name_re, name_im);
+    writer.commit();
 }
 
 template<>
@@ -614,6 +1249,16 @@ void variable_t<std::complex<float>, float>::write_complex(const std::string nam
     write_complex_var(this, name_re, name_im, file);
 }
 
+template<>
+void variable_t<double, double>::write(const std::string name, netcdf_file_t* file) const {
+    write_var(this, name, file);
+}
+
+template<>
+void variable_t<std::complex<double>, double>::write_complex(const std::string name_re, const std::string name_im, netcdf_file_t* file) const {
+    write_complex_var(this, name_re, name_im, file);
+}
+
 
 
 
@@ -627,6 +1272,10 @@ matrix_t<S>* variable_t<S, T>::to_matrix(std::string dim_name) const {
     size_t num_dims = this->get_num_dims();
     size_t dim_ind = this->find_dim(dim_name);
 
+    if (this->is_lazy()) {
+        return this->template read_lazy_matrix<S>(dim_ind);
+    }
+
     size_t cols = 1;
     size_t rows = 0;
     size_t traverse_shape[num_dims];
@@ -645,6 +1294,7 @@ matrix_t<S>* variable_t<S, T>::to_matrix(std::string dim_name) const {
     }
 
     matrix_t<S>* mat = new matrix_t<S>(rows, cols);
+
     size_t c = 0;
     nested_for(num_dims, traverse_shape, [&](size_t* indices) {
         S slice[rows];
@@ -656,6 +1306,181 @@ matrix_t<S>* variable_t<S, T>::to_matrix(std::string dim_name) const {
     return mat;
 }
 
+/**
+ * Like to_matrix, but the values are left packed, as they are stored in the
+ * file, so that they can be unpacked straight into wherever they are needed
+ * (see can_read_packed)
+ */
+template<typename S, typename T>
+matrix_t<short>* variable_t<S, T>::to_packed_matrix(std::string dim_name) const {
+    if (!this->can_read_packed()) {
+        throw eof_error_t("(Internal Error) Only lazy variables packed as short can be read packed");
+    }
+
+    return this->template read_lazy_matrix<short>(this->find_dim(dim_name));
+}
+
+/**
+ * Reads both parts of the complex values this variable is one part of (see
+ * is_complex_part) into two matrices laid out as by to_matrix, with one read
+ * per slab rather than one per part
+ */
+template<typename S, typename T>
+void variable_t<S, T>::to_part_matrices(std::string dim_name, matrix_t<S>** re, matrix_t<S>** im) const {
+    if (!this->is_complex_part()) {
+        throw eof_error_t("(Internal Error) Only lazy parts of complex variables can be read as both parts");
+    }
+
+    size_t num_dims = this->get_num_dims();
+    size_t dim_ind = this->find_dim(dim_name);
+    size_t rows = this->get_dim(dim_ind)->get_size();
+    size_t cols = 1;
+    size_t outer = 1;
+    for (size_t i = 0; i < num_dims; i++) {
+        if (i != dim_ind) {
+            cols *= this->get_dim(i)->get_size();
+        }
+        if (i < dim_ind) {
+            outer *= this->get_dim(i)->get_size();
+        }
+    }
+
+    *re = new matrix_t<S>(rows, cols);
+    *im = new matrix_t<S>(rows, cols);
+    S* re_data = (*re)->get_data_unsafe();
+    S* im_data = (*im)->get_data_unsafe();
+
+    size_t slab_len = this->get_slab_len(dim_ind);
+    S* buffer = new S[2 * slab_len * cols];
+
+    size_t start[num_dims];
+    size_t count[num_dims];
+    for (size_t i = 0; i < num_dims; i++) {
+        start[i] = 0;
+        count[i] = this->get_dim(i)->get_size();
+    }
+
+    for (size_t first = 0; first < rows; first += slab_len) {
+        size_t num = std::min(slab_len, rows - first);
+        start[dim_ind] = first;
+        count[dim_ind] = num;
+        this->read_parts(start, count, buffer);
+
+        if (this->packed) {
+            unpack_values(2 * num * cols, this->scale_factor, this->add_offset, buffer);
+        }
+
+        // The slab is laid out as [outer][num][inner][part]
+        size_t inner = cols / outer;
+        #pragma omp parallel for
+        for (size_t j = 0; j < num; j++) {
+            S* re_row = re_data + (first + j) * cols;
+            S* im_row = im_data + (first + j) * cols;
+            for (size_t o = 0; o < outer; o++) {
+                const S* src = buffer + 2 * (o * num + j) * inner;
+                for (size_t k = 0; k < inner; k++) {
+                    re_row[o * inner + k] = src[2 * k];
+                    im_row[o * inner + k] = src[2 * k + 1];
+                }
+            }
+        }
+    }
+
+    delete[] buffer;
+}
+
+/**
+ * Reads a lazy variable into a matrix laid out as by to_matrix, in
+ * chunk-aligned slabs of consecutive steps of dimension `dim_ind`, each of
+ * which fills consecutive rows of the matrix
+ */
+template<typename S, typename T>
+template<typename U>
+matrix_t<U>* variable_t<S, T>::read_lazy_matrix(size_t dim_ind) const {
+    size_t rows = this->get_dim(dim_ind)->get_size();
+    size_t cols = 1;
+    size_t outer = 1;
+    for (size_t i = 0; i < this->get_num_dims(); i++) {
+        if (i != dim_ind) {
+            cols *= this->get_dim(i)->get_size();
+        }
+        if (i < dim_ind) {
+            outer *= this->get_dim(i)->get_size();
+        }
+    }
+
+    matrix_t<U>* mat = new matrix_t<U>(rows, cols);
+
+    size_t slab_len = this->get_slab_len(dim_ind);
+    U* buffer = (outer > 1) ? new U[slab_len * cols] : nullptr;
+
+    for (size_t r = 0; r < rows; r += slab_len) {
+        this->read_slab_rows(dim_ind, r, std::min(slab_len, rows - r), buffer, mat);
+    }
+
+    delete[] buffer;
+    return mat;
+}
+
+/**
+ * Reads a slice for read_slab_rows: unpacked values as get_slice does, or
+ * the values as they are stored
+ */
+template<typename S, typename T>
+void variable_t<S, T>::read_matrix_slice(const size_t* start, const size_t* size, S* vals) const {
+    this->get_slice(start, size, vals);
+}
+
+template<typename S, typename T>
+void variable_t<S, T>::read_matrix_slice(const size_t* start, const size_t* size, short* vals) const {
+    this->read_source(start, size, vals);
+}
+
+/**
+ * Reads steps [first, first + num) of dimension `dim_ind` of a lazy variable
+ * into the same rows of `mat` (as laid out by to_matrix). When dimensions
+ * come before `dim_ind`, the slab is read into `buffer` and then scattered,
+ * since its steps are not contiguous in it.
+ */
+template<typename S, typename T>
+template<typename U>
+void variable_t<S, T>::read_slab_rows(size_t dim_ind, size_t first, size_t num, U* buffer, matrix_t<U>* mat) const {
+    size_t num_dims = this->get_num_dims();
+    size_t cols = mat->get_cols();
+    U* mat_data = mat->get_data_unsafe();
+
+    size_t start[num_dims];
+    size_t count[num_dims];
+    size_t outer = 1;
+    for (size_t i = 0; i < num_dims; i++) {
+        start[i] = 0;
+        count[i] = this->get_dim(i)->get_size();
+        if (i < dim_ind) {
+            outer *= count[i];
+        }
+    }
+    start[dim_ind] = first;
+    count[dim_ind] = num;
+
+    if (outer == 1) {
+        this->read_matrix_slice(start, count, mat_data + first * cols);
+        return;
+    }
+
+    this->read_matrix_slice(start, count, buffer);
+
+    // The slab is laid out as [outer][num][inner]
+    size_t inner = cols / outer;
+    #pragma omp parallel for
+    for (size_t j = 0; j < num; j++) {
+        U* row = mat_data + (first + j) * cols;
+        for (size_t o = 0; o < outer; o++) {
+            const U* src = buffer + (o * num + j) * inner;
+            std::copy(src, src + inner, row + o * inner);
+        }
+    }
+}
+
 template<typename S, typename T>
 const S variable_t<S, T>::get_absmax() const {
 
@@ -665,6 +1490,45 @@ const S variable_t<S, T>::get_absmax() const {
     }
 
     S absmax = 0;
+
+    // Lazy variables are scanned in chunk-aligned slabs along the first
+    // dimension
+    if (this->is_lazy() && this->get_num_dims() > 0) {
+        if (this->lazy_absmax_known) {
+            return this->lazy_absmax;
+        }
+
+        size_t num_dims = this->get_num_dims();
+        size_t records = this->get_dim(0)->get_size();
+        size_t slab_len = this->get_slab_len(0);
+        size_t record_size = 1;
+        size_t start[num_dims];
+        size_t count[num_dims];
+        for (size_t i = 0; i < num_dims; i++) {
+            start[i] = 0;
+            count[i] = this->get_dim(i)->get_size();
+            if (i > 0) {
+                record_size *= count[i];
+            }
+        }
+
+        S* slab = new S[slab_len * record_size];
+        for (size_t r = 0; r < records; r += slab_len) {
+            start[0] = r;
+            count[0] = std::min(slab_len, records - r);
+            this->get_slice(start, count, slab);
+            for (size_t i = 0; i < count[0] * record_size; i++){
+                if(absmax < abs(slab[i])) absmax = abs(slab[i]);
+            }
+        }
+        delete[] slab;
+
+        // A lazy variable's data can't change, so it is only scanned once
+        this->lazy_absmax = absmax;
+        this->lazy_absmax_known = true;
+        return absmax;
+    }
+
     for (size_t i = 0; i < product; i++){
         if(absmax < abs(this->get_data()[i])) absmax = abs(this->get_data()[i]);
     }
@@ -672,22 +1536,45 @@ const S variable_t<S, T>::get_absmax() const {
     return absmax;
 }
 
-template<>
-const std::complex<float> variable_t<std::complex<float>, float>::get_absmax() const {
+/**
+ * Records the largest magnitude in a lazy variable, found elsewhere (such as
+ * in an anomaly cache), so that get_absmax need not read the data for it
+ */
+template<typename S, typename T>
+void variable_t<S, T>::set_known_absmax(S absmax) const {
+    this->lazy_absmax = absmax;
+    this->lazy_absmax_known = true;
+}
+
+/**
+ * Finds the largest magnitude of the real and imaginary parts separately
+ */
+template<typename S, typename T>
+std::complex<S> complex_absmax(const variable_t<std::complex<S>, T>* var) {
 
     size_t product = 1;
-    for (size_t i = 0; i < this->get_num_dims(); i++) {
-        product *= this->get_dims()[this->get_num_dims() - 1 - i]->get_size();
+    for (size_t i = 0; i < var->get_num_dims(); i++) {
+        product *= var->get_dims()[var->get_num_dims() - 1 - i]->get_size();
     }
 
-    float absmax_re = 0;
-    float absmax_im = 0;
+    S absmax_re = 0;
+    S absmax_im = 0;
     for (size_t i = 0; i < product; i++){
-        if(absmax_re < abs(this->get_data()[i].real())) absmax_re = abs(this->get_data()[i].real());
-        if(absmax_im < abs(this->get_data()[i].imag())) absmax_im = abs(this->get_data()[i].imag());
+        if(absmax_re < abs(var->get_data()[i].real())) absmax_re = abs(var->get_data()[i].real());
+        if(absmax_im < abs(var->get_data()[i].imag())) absmax_im = abs(var->get_data()[i].imag());
     }
 
-    return std::complex<float>(absmax_re, absmax_im);
+    return std::complex<S>(absmax_re, absmax_im);
+}
+
+template<>
+const std::complex<float> variable_t<std::complex<float>, float>::get_absmax() const {
+    return complex_absmax(this);
+}
+
+template<>
+const std::complex<double> variable_t<std::complex<double>, double>::get_absmax() const {
+    return complex_absmax(this);
 }
 
 template<typename S, typename T>
@@ -720,7 +1607,7 @@ variable_t<S, T>* variable_t<S, T>::from_matrix(const matrix_t<S>* mat, std::str
     }
 
     variable_t<S, T>* var = new variable_t<S, T>(num_dims, dims);
-    var->set_missing_value(10.f*(this->get_absmax()));
+    var->set_missing_value(S(10) * this->get_absmax());
 
     size_t c = 0;
     nested_for(num_dims, traverse_shape, [&](size_t* indices) {
@@ -762,7 +1649,7 @@ variable_t<std::complex<T>, T>* variable_t<S, T>::from_matrix_complex(const matr
     }
 
     variable_t<std::complex<T>, T>* var = new variable_t<std::complex<T>, T>(num_dims, dims);
-    var->set_missing_value(std::complex<T>(1.0,1.0)*10.f*(this->get_absmax()));
+    var->set_missing_value(std::complex<T>(1.0,1.0) * (T) 10 * this->get_absmax());
 
     size_t c = 0;
     nested_for(num_dims, traverse_shape, [&](size_t* indices) {
@@ -775,12 +1662,80 @@ variable_t<std::complex<T>, T>* variable_t<S, T>::from_matrix_complex(const matr
     return var;
 }
 
+/**
+ * Like from_matrix, but `mat` only holds the `num_cols` columns of the full
+ * matrix listed in `cols`, and no others are filled in. Instead, the new
+ * variable is in CF "compression by gathering" form: its dimensions are
+ * `new_dim` and a list dimension `list_name`, whose values are the indices of
+ * the columns in the dimensions other than `dim_name` (flattened in order),
+ * and whose "compress" attribute names those dimensions. If this variable is
+ * already gathered, the new list indexes its original dimensions.
+ */
+template<typename S, typename T>
+variable_t<S, T>* variable_t<S, T>::from_matrix_gathered(const matrix_t<S>* mat, std::string dim_name, dimension_t<T>* new_dim, const int* cols, size_t num_cols, std::string list_name) const {
+    if (num_cols != mat->get_cols() || new_dim->get_size() != mat->get_rows()) {
+        throw eof_error_t("Matrix has incorrect dimensions for loading into a new variable");
+    }
+
+    std::vector<const dimension_t<T>*> gathered;
+    for (size_t i = 0; i < this->get_num_dims(); i++) {
+        if (this->get_dim(i)->get_name() != dim_name) {
+            gathered.push_back(this->get_dim(i));
+        }
+    }
+
+    T* list_values = new T[num_cols];
+    attribute_t** list_attrs = new attribute_t*[1];
+    if (gathered.size() == 1 && gathered[0]->has_attr(COMPRESS_ATTR_NAME)) {
+        const T* indices = gathered[0]->get_values();
+        for (size_t c = 0; c < num_cols; c++) {
+            list_values[c] = indices[cols[c]];
+        }
+        list_attrs[0] = new attribute_t(*gathered[0]->get_attr(COMPRESS_ATTR_NAME));
+    } else {
+        // The indices are kept as dimension values, which must hold them exactly
+        if (num_cols > 0 && (double) cols[num_cols - 1] > std::pow(2.0, std::numeric_limits<T>::digits)) {
+            delete[] list_values;
+            delete[] list_attrs;
+            throw eof_error_t("Too many grid points to gather with this dimension type");
+        }
+
+        for (size_t c = 0; c < num_cols; c++) {
+            list_values[c] = (T) cols[c];
+        }
+
+        std::string compress = "";
+        for (const dimension_t<T>* dim : gathered) {
+            compress += (compress.empty() ? "" : " ") + dim->get_name();
+        }
+
+        // Attributes hold on to their values, so this outlives the variable
+        char* compress_value = new char[compress.size()];
+        std::copy(compress.begin(), compress.end(), compress_value);
+        list_attrs[0] = new attribute_t(COMPRESS_ATTR_NAME, NC_CHAR, sizeof(char), compress.size(), compress_value);
+    }
+
+    dimension_t<T>** dims = new dimension_t<T>*[2];
+    dims[0] = new dimension_t<T>(*new_dim);
+    dims[1] = new dimension_t<T>(list_name, num_cols, list_values, 1, list_attrs);
+    delete[] list_values;
+
+    variable_t<S, T>* var = new variable_t<S, T>(2, dims);
+    std::copy(mat->get_data(), mat->get_data() + mat->get_rows() * num_cols, var->data);
+
+    return var;
+}
+
 template<typename S, typename T>
 variable_t<std::complex<S>, T>* make_complex_variable(variable_t<S, T>* real, variable_t<S, T>* imag) {
     if (real->get_num_dims() != imag->get_num_dims()) {
         throw eof_error_t("Cannot make a complex variable from variables with different numbers of dimensions.");
     }
 
+    if (real->is_lazy() || imag->is_lazy()) {
+        throw eof_error_t("Cannot make a complex variable from variables read lazily from a file.");
+    }
+
     size_t size = 1;
     size_t num_dims = real->get_num_dims();
     dimension_t<T>** dims = new dimension_t<T>*[num_dims];
@@ -799,14 +1754,22 @@ variable_t<std::complex<S>, T>* make_complex_variable(variable_t<S, T>* real, va
     }
 
 
-    // Copy attributes from both variables
+    // Create the resulting complex variable
+    variable_t<std::complex<S>, T>* result = new variable_t<std::complex<S>, T>(num_dims, dims);
+
+    // Copy attributes from both variables, those of the real part first
+    size_t num_attrs = real->get_num_attrs();
     attribute_t** attrs = new attribute_t*[real->get_num_attrs() + imag->get_num_attrs()];
     for (size_t i = 0; i < real->get_num_attrs(); i++) {
-        // TODO: fill this in
+        attrs[i] = new attribute_t(*real->get_attr(i));
     }
-
-    // Create the resulting complex variable
-    variable_t<std::complex<S>, T>* result = new variable_t<std::complex<S>, T>(num_dims, dims);
+    for (size_t i = 0; i < imag->get_num_attrs(); i++) {
+        if (!real->has_attr(imag->get_attr(i)->get_name())) {
+            attrs[num_attrs] = new attribute_t(*imag->get_attr(i));
+            num_attrs++;
+        }
+    }
+    result->set_attrs(num_attrs, attrs);
 
     // Get missing values from the real and imaginary parts
     S missing_re;
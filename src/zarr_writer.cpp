@@ -0,0 +1,386 @@
+/***********************************************************************
+ *                   GNU Lesser General Public License
+ *
+ * This file is part of the EDGI prototype package, developed by the
+ * GFDL Flexible Modeling System (FMS) group.
+ *
+ * EDGI is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * EDGI is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with EDGI.  If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************/
+
+#include "zarr_writer.hpp"
+
+#include "error.hpp"
+
+/** Use uint32_t, uint64_t */
+#include <cstdint>
+
+/** Use snprintf */
+#include <cstdio>
+
+/** Use std::memcpy */
+#include <cstring>
+
+/** Use std::ofstream */
+#include <fstream>
+
+/** Use std::numeric_limits */
+#include <limits>
+
+/** Use std::ostringstream */
+#include <sstream>
+
+/** Use mkdir */
+#include <sys/stat.h>
+
+/** Use opendir, readdir, closedir */
+#include <dirent.h>
+
+/** Use unlink */
+#include <unistd.h>
+
+/** Use errno */
+#include <cerrno>
+
+#ifdef WITH_ZLIB
+    /** Use compress2 */
+    #include <zlib.h>
+#endif
+
+// <string> included in header
+using std::string;
+
+
+
+
+
+//==============================================================================
+// Local functions
+//==============================================================================
+
+namespace {
+
+    /**
+     * Returns the byte order of this machine as Zarr writes it in a dtype
+     */
+    const char* byte_order() {
+        const int one = 1;
+        return (*(const char*) &one == 1) ? "<" : ">";
+    }
+
+    /**
+     * Returns `length` values of type V at `value` as a JSON number, or an
+     * array of them when there is not exactly one
+     */
+    template<typename V>
+    string numbers_to_json(const void* value, size_t length) {
+        const V* values = (const V*) value;
+
+        std::ostringstream json;
+        json.precision(std::numeric_limits<V>::max_digits10);
+        if (length != 1) {
+            json << "[";
+        }
+        for (size_t i = 0; i < length; i++) {
+            json << (i > 0 ? ", " : "");
+            if (values[i] != values[i]) {
+                json << "NaN";
+            } else if (values[i] > std::numeric_limits<V>::max()) {
+                json << "Infinity";
+            } else if (values[i] < std::numeric_limits<V>::lowest()) {
+                json << "-Infinity";
+            } else {
+                json << +values[i];
+            }
+        }
+        if (length != 1) {
+            json << "]";
+        }
+
+        return json.str();
+    }
+
+    /**
+     * Keeps `keep_bits` bits of the mantissa of each value, rounding half to
+     * even, as the numcodecs BitRound codec does. The zeroed bits make the
+     * values compress better.
+     */
+    template<typename V, typename U>
+    void round_mantissas(V* values, size_t len, int keep_bits) {
+        const int mantissa_bits = std::numeric_limits<V>::digits - 1;
+        if (keep_bits <= 0 || keep_bits >= mantissa_bits) {
+            return;
+        }
+
+        const int drop = mantissa_bits - keep_bits;
+        const U mask = ~((U(1) << drop) - 1);
+        const U half = (U(1) << (drop - 1)) - 1;
+        for (size_t i = 0; i < len; i++) {
+            U bits;
+            std::memcpy(&bits, &values[i], sizeof(U));
+            bits += ((bits >> drop) & 1) + half;
+            bits &= mask;
+            std::memcpy(&values[i], &bits, sizeof(U));
+        }
+    }
+
+}
+
+
+
+
+
+//==============================================================================
+// Private Methods
+//==============================================================================
+
+/**
+ * Returns `text` as a JSON string
+ */
+string zarr_writer_t::to_json(const string& text) {
+    std::ostringstream json;
+    json << "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            json << '\\' << c;
+        } else if (c == '\n') {
+            json << "\\n";
+        } else if (c == '\t') {
+            json << "\\t";
+        } else if ((unsigned char) c < 0x20) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned char) c);
+            json << escaped;
+        } else {
+            json << c;
+        }
+    }
+    json << "\"";
+
+    return json.str();
+}
+
+/**
+ * Returns the value of an attribute as JSON: text as a string, and numbers
+ * as a number or an array of them
+ */
+string zarr_writer_t::to_json(const attribute_t* attr) {
+    const void* value = attr->get_value();
+    size_t length = attr->get_length();
+
+    switch (attr->get_type()) {
+        case NC_CHAR: {
+            string text((const char*) value, length);
+            return to_json(text.substr(0, text.find('\0')));
+        }
+        case NC_BYTE:
+            return numbers_to_json<signed char>(value, length);
+        case NC_UBYTE:
+            return numbers_to_json<unsigned char>(value, length);
+        case NC_SHORT:
+            return numbers_to_json<short>(value, length);
+        case NC_USHORT:
+            return numbers_to_json<unsigned short>(value, length);
+        case NC_INT:
+            return numbers_to_json<int>(value, length);
+        case NC_UINT:
+            return numbers_to_json<unsigned int>(value, length);
+        case NC_INT64:
+            return numbers_to_json<long long>(value, length);
+        case NC_UINT64:
+            return numbers_to_json<unsigned long long>(value, length);
+        case NC_FLOAT:
+            return numbers_to_json<float>(value, length);
+        case NC_DOUBLE:
+            return numbers_to_json<double>(value, length);
+        default:
+            throw eof_error_t("Cannot write attribute \"" + attr->get_name() + "\" of this type to a Zarr store");
+    }
+}
+
+string zarr_writer_t::dtype_of(const int*) {
+    return string(byte_order()) + "i4";
+}
+
+string zarr_writer_t::dtype_of(const float*) {
+    return string(byte_order()) + "f4";
+}
+
+string zarr_writer_t::dtype_of(const double*) {
+    return string(byte_order()) + "f8";
+}
+
+void zarr_writer_t::round_bits(int*, size_t, int) {
+    // Integers are always kept exactly
+}
+
+void zarr_writer_t::round_bits(float* values, size_t len, int keep_bits) {
+    round_mantissas<float, uint32_t>(values, len, keep_bits);
+}
+
+void zarr_writer_t::round_bits(double* values, size_t len, int keep_bits) {
+    round_mantissas<double, uint64_t>(values, len, keep_bits);
+}
+
+/**
+ * Returns the bytes of a chunk as they are stored: shuffled (in place) if
+ * asked, then compressed by the storage's codec
+ */
+string zarr_writer_t::encode(std::vector<char>& bytes, size_t elem_size, const output_storage_t& storage) const {
+    if (storage.shuffle && elem_size > 1) {
+        size_t len = bytes.size() / elem_size;
+        std::vector<char> shuffled(bytes.size());
+        for (size_t i = 0; i < len; i++) {
+            for (size_t b = 0; b < elem_size; b++) {
+                shuffled[b * len + i] = bytes[i * elem_size + b];
+            }
+        }
+        bytes.swap(shuffled);
+    }
+
+    if (storage.codec == "deflate") {
+#ifdef WITH_ZLIB
+        uLongf len = compressBound(bytes.size());
+        string compressed(len, '\0');
+        int status = compress2((Bytef*) &compressed[0], &len, (const Bytef*) bytes.data(), bytes.size(), storage.level);
+        if (status != Z_OK) {
+            throw eof_error_t("Could not compress a Zarr chunk (zlib error " + std::to_string(status) + ")");
+        }
+        compressed.resize(len);
+        return compressed;
+#else
+        throw eof_error_t("Zarr stores can only be compressed in builds with zlib (with_zlib=1).");
+#endif
+    }
+
+    return string(bytes.begin(), bytes.end());
+}
+
+/**
+ * Creates the directory `name` in the store, unless it already exists
+ */
+void zarr_writer_t::make_dir(const string name) const {
+    string dir = name.empty() ? this->path : this->path + "/" + name;
+    if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+        throw eof_error_t("Could not create directory \"" + dir + "\": " + strerror(errno));
+    }
+}
+
+/**
+ * Removes every file in the directory `name` of the store, so that chunks
+ * left over from an earlier, larger array don't outlive it
+ */
+void zarr_writer_t::clear_dir(const string name) const {
+    string dir = this->path + "/" + name;
+    DIR* handle = opendir(dir.c_str());
+    if (handle == nullptr) {
+        throw eof_error_t("Could not open directory \"" + dir + "\": " + strerror(errno));
+    }
+
+    struct dirent* entry;
+    while ((entry = readdir(handle)) != nullptr) {
+        string entry_name = entry->d_name;
+        if (entry_name == "." || entry_name == "..") {
+            continue;
+        }
+
+        string filename = dir + "/" + entry_name;
+        if (unlink(filename.c_str()) != 0 && errno != ENOENT) {
+            int error = errno;
+            closedir(handle);
+            throw eof_error_t("Could not remove \"" + filename + "\": " + strerror(error));
+        }
+    }
+    closedir(handle);
+}
+
+/**
+ * Writes (or replaces) the file `name` in the store
+ */
+void zarr_writer_t::write_file(const string name, const string& contents) const {
+    string filename = this->path + "/" + name;
+    std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    file.write(contents.data(), contents.size());
+    file.close();
+    if (!file) {
+        throw eof_error_t("Could not write \"" + filename + "\"");
+    }
+}
+
+
+
+
+
+//==============================================================================
+// Public Methods
+//==============================================================================
+
+/**
+ * Returns whether output to `path` should go to a Zarr store rather than a
+ * NetCDF file, going by its ".zarr" extension
+ */
+bool zarr_writer_t::is_zarr_path(const string path) {
+    string trimmed = path.substr(0, path.find_last_not_of('/') + 1);
+    return trimmed.size() >= 5 && trimmed.compare(trimmed.size() - 5, 5, ".zarr") == 0;
+}
+
+zarr_writer_t::zarr_writer_t(const string path) : path(path.substr(0, path.find_last_not_of('/') + 1)) {}
+
+/**
+ * Sets how the variables added from now on (but not their coordinate
+ * variables) are chunked, filtered and compressed. Zarr stores can only be
+ * compressed with zlib (deflate).
+ */
+void zarr_writer_t::set_storage(const output_storage_t& storage) {
+    if (storage.codec != "none" && storage.codec != "deflate") {
+        throw eof_error_t("Zarr stores cannot be compressed with \"" + storage.codec + "\".");
+    }
+#ifndef WITH_ZLIB
+    if (storage.codec == "deflate") {
+        throw eof_error_t("Zarr stores can only be compressed in builds with zlib (with_zlib=1).");
+    }
+#endif
+
+    this->storage = storage;
+}
+
+/**
+ * Plans a global attribute
+ */
+void zarr_writer_t::add_attr(const attribute_t* attr) {
+    this->global_attrs.push_back(attr);
+}
+
+/**
+ * Creates the store (as a Zarr group) if needed, writes its attributes, and
+ * then writes every array planned so far
+ */
+void zarr_writer_t::commit() {
+    this->make_dir("");
+    this->write_file(".zgroup", "{\n    \"zarr_format\": 2\n}\n");
+
+    std::ostringstream zattrs;
+    zattrs << "{";
+    for (size_t i = 0; i < this->global_attrs.size(); i++) {
+        const attribute_t* attr = this->global_attrs[i];
+        zattrs << (i > 0 ? "," : "") << "\n    " << to_json(attr->get_name()) << ": " << to_json(attr);
+    }
+    zattrs << "\n}\n";
+    this->write_file(".zattrs", zattrs.str());
+
+    for (std::function<void()>& write : this->writes) {
+        write();
+    }
+
+    this->writes.clear();
+}
@@ -0,0 +1,170 @@
+/***********************************************************************
+ *                   GNU Lesser General Public License
+ *
+ * This file is part of the EDGI prototype package, developed by the
+ * GFDL Flexible Modeling System (FMS) group.
+ *
+ * EDGI is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * EDGI is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with EDGI.  If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************/
+
+#ifndef ZARR_WRITER_HPP
+#define ZARR_WRITER_HPP
+
+/** Use output_storage_t */
+#include "netcdf_writer.hpp"
+
+/** Use attribute_t */
+#include "attribute.hpp"
+
+/** Use dimension_t */
+#include "dimension.hpp"
+
+/** Use std::function */
+#include <functional>
+
+/** Use std::set */
+#include <set>
+
+/** Use std::string */
+#include <string>
+
+/** Use std::vector */
+#include <vector>
+
+template<typename S, typename T>
+class variable_t;
+
+
+
+
+
+//==============================================================================
+// Declaration
+//==============================================================================
+
+/**
+ * Writes a batch of variables and attributes to a Zarr (version 2) store in
+ * a local directory, the way netcdf_writer_t writes them to a NetCDF file.
+ * Each variable, and each coordinate variable of their dimensions, becomes an
+ * array of the same name, with its dimension names in "_ARRAY_DIMENSIONS"
+ * (as xarray expects) and its attributes alongside.
+ *
+ * Everything added is only planned at first; commit() writes it all. The
+ * chunks of each array are split among the threads, each compressing and
+ * writing its own chunk files. Chunks span one step of the storage's
+ * chunk_dim and all of every other dimension (one chunk per array without
+ * it). Arrays are compressed with zlib when the storage asks for deflate.
+ *
+ * Variables (and their dimensions and attributes) are read when they are
+ * committed, not when they are added, so they must outlive the commit.
+ */
+class zarr_writer_t {
+private:
+    //==========================================================================
+    // Private Fields
+    //==========================================================================
+
+    /** The directory of the store */
+    std::string path;
+
+    std::vector<const attribute_t*> global_attrs;
+
+    /** The names of the arrays planned so far */
+    std::set<std::string> arrays;
+
+    /** Run in order by commit() */
+    std::vector<std::function<void()>> writes;
+
+    /** How variables added from now on are stored */
+    output_storage_t storage;
+
+
+
+    //==========================================================================
+    // Private Methods
+    //==========================================================================
+
+    static std::string to_json(const std::string& text);
+
+    static std::string to_json(const attribute_t* attr);
+
+    template<typename O>
+    static std::string attrs_to_json(const O* owner, const std::vector<std::string>& dim_names);
+
+    static std::string dtype_of(const int*);
+    static std::string dtype_of(const float*);
+    static std::string dtype_of(const double*);
+
+    static void round_bits(int* values, size_t len, int keep_bits);
+    static void round_bits(float* values, size_t len, int keep_bits);
+    static void round_bits(double* values, size_t len, int keep_bits);
+
+    std::string encode(std::vector<char>& bytes, size_t elem_size, const output_storage_t& storage) const;
+
+    void make_dir(const std::string name) const;
+
+    void clear_dir(const std::string name) const;
+
+    void write_file(const std::string name, const std::string& contents) const;
+
+    template<typename E>
+    void write_array(
+        const std::string name,
+        const std::vector<std::string>& dim_names,
+        const std::vector<size_t>& shape,
+        const E* data,
+        bool has_fill,
+        E fill,
+        const std::string attrs,
+        const output_storage_t& storage
+    ) const;
+
+    template<typename T>
+    void plan_dim(const dimension_t<T>* dim);
+
+
+
+public:
+    //==========================================================================
+    // Public Methods
+    //==========================================================================
+
+    static bool is_zarr_path(const std::string path);
+
+    zarr_writer_t(const std::string path);
+
+    void set_storage(const output_storage_t& storage);
+
+    void add_attr(const attribute_t* attr);
+
+    template<typename T>
+    void add_dim(const dimension_t<T>* dim);
+
+    template<typename S, typename T>
+    void add(const variable_t<S, T>* var, const std::string name);
+
+    void commit();
+};
+
+
+
+
+
+//==============================================================================
+// Implementation
+//==============================================================================
+
+#include "zarr_writer.tpp"
+
+#endif
@@ -0,0 +1,253 @@
+/***********************************************************************
+ *                   GNU Lesser General Public License
+ *
+ * This file is part of the EDGI prototype package, developed by the
+ * GFDL Flexible Modeling System (FMS) group.
+ *
+ * EDGI is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * EDGI is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with EDGI.  If not, see <http://www.gnu.org/licenses/>.
+ **********************************************************************/
+
+// Note: This is not intended to be a standalone implementation file.
+
+#include "error.hpp"
+
+/** Use std::isinf */
+#include <cmath>
+
+/** Use std::ostringstream */
+#include <sstream>
+
+
+
+
+
+//==============================================================================
+// Private Methods
+//==============================================================================
+
+/**
+ * Returns the ".zattrs" of an array: the attributes of `owner` (a variable
+ * or dimension) and the names of its dimensions, as a JSON object
+ */
+template<typename O>
+std::string zarr_writer_t::attrs_to_json(const O* owner, const std::vector<std::string>& dim_names) {
+    std::ostringstream json;
+    json << "{\n    \"_ARRAY_DIMENSIONS\": [";
+    for (size_t i = 0; i < dim_names.size(); i++) {
+        json << (i > 0 ? ", " : "") << to_json(dim_names[i]);
+    }
+    json << "]";
+
+    for (size_t i = 0; i < owner->get_num_attrs(); i++) {
+        const attribute_t* attr = owner->get_attr(i);
+        json << ",\n    " << to_json(attr->get_name()) << ": " << to_json(attr);
+    }
+    json << "\n}\n";
+
+    return json.str();
+}
+
+/**
+ * Writes the array `name` with the given dimensions and values, and its
+ * attributes `attrs` (as JSON). Each thread gathers, filters, compresses and
+ * writes whole chunks on its own.
+ */
+template<typename E>
+void zarr_writer_t::write_array(
+    const std::string name,
+    const std::vector<std::string>& dim_names,
+    const std::vector<size_t>& shape,
+    const E* data,
+    bool has_fill,
+    E fill,
+    const std::string attrs,
+    const output_storage_t& storage
+) const {
+    size_t num_dims = shape.size();
+
+    // Chunks span one step of the chunk dimension and all of the others
+    size_t chunk_ind = num_dims;
+    for (size_t i = 0; i < num_dims; i++) {
+        if (dim_names[i] == storage.chunk_dim) {
+            chunk_ind = i;
+        }
+    }
+
+    size_t num_chunks = 1;
+    size_t outer = 1;
+    size_t inner = 1;
+    std::vector<size_t> chunks(shape);
+    for (size_t i = 0; i < num_dims; i++) {
+        if (i < chunk_ind) {
+            outer *= shape[i];
+        } else if (i > chunk_ind) {
+            inner *= shape[i];
+        }
+    }
+    if (chunk_ind < num_dims) {
+        num_chunks = shape[chunk_ind];
+        chunks[chunk_ind] = 1;
+    }
+
+    std::ostringstream zarray;
+    zarray.precision(17);
+    zarray << "{\n    \"chunks\": [";
+    for (size_t i = 0; i < num_dims; i++) {
+        zarray << (i > 0 ? ", " : "") << chunks[i];
+    }
+    zarray << "],\n    \"compressor\": ";
+    if (storage.codec == "deflate") {
+        zarray << "{\"id\": \"zlib\", \"level\": " << storage.level << "}";
+    } else {
+        zarray << "null";
+    }
+    zarray << ",\n    \"dimension_separator\": \".\",\n    \"dtype\": \"" << dtype_of(data) << "\",\n    \"fill_value\": ";
+    if (!has_fill) {
+        zarray << "null";
+    } else if (fill != fill) {
+        zarray << "\"NaN\"";
+    } else if (std::isinf(fill)) {
+        zarray << (fill > 0 ? "\"Infinity\"" : "\"-Infinity\"");
+    } else {
+        zarray << fill;
+    }
+    zarray << ",\n    \"filters\": ";
+    if (storage.shuffle) {
+        zarray << "[{\"id\": \"shuffle\", \"elementsize\": " << sizeof(E) << "}]";
+    } else {
+        zarray << "null";
+    }
+    zarray << ",\n    \"order\": \"C\",\n    \"shape\": [";
+    for (size_t i = 0; i < num_dims; i++) {
+        zarray << (i > 0 ? ", " : "") << shape[i];
+    }
+    zarray << "],\n    \"zarr_format\": 2\n}\n";
+
+    this->make_dir(name);
+    this->clear_dir(name);
+    this->write_file(name + "/.zarray", zarray.str());
+    this->write_file(name + "/.zattrs", attrs);
+
+    // Exceptions cannot leave a parallel region, so the first is kept
+    std::string error = "";
+
+    size_t chunk_len = outer * inner;
+    size_t step_len = (chunk_ind < num_dims) ? shape[chunk_ind] * inner : inner;
+    #pragma omp parallel for schedule(dynamic)
+    for (size_t k = 0; k < num_chunks; k++) {
+        try {
+            std::vector<char> bytes(chunk_len * sizeof(E));
+            E* values = (E*) bytes.data();
+            for (size_t o = 0; o < outer; o++) {
+                std::copy(data + o * step_len + k * inner, data + o * step_len + (k + 1) * inner, values + o * inner);
+            }
+            round_bits(values, chunk_len, storage.keep_bits);
+
+            std::string key = "";
+            for (size_t i = 0; i < num_dims; i++) {
+                key += (i > 0 ? "." : "") + std::to_string(i == chunk_ind ? k : 0);
+            }
+            this->write_file(name + "/" + (num_dims == 0 ? "0" : key), this->encode(bytes, sizeof(E), storage));
+        } catch (const eof_error_t& e) {
+            #pragma omp critical
+            {
+                if (error.empty()) {
+                    error = e.what();
+                }
+            }
+        }
+    }
+
+    if (!error.empty()) {
+        throw eof_error_t(error);
+    }
+}
+
+/**
+ * Plans a dimension's coordinate variable as an array, unless it is already
+ * planned. As in netcdf_writer_t, the coordinate variable of a CF list
+ * dimension holds indices, so it is written as integers.
+ */
+template<typename T>
+void zarr_writer_t::plan_dim(const dimension_t<T>* dim) {
+    std::string name = dim->get_name();
+    if (this->arrays.count(name) > 0) {
+        return;
+    }
+    this->arrays.insert(name);
+
+    this->writes.push_back([this, name, dim]() {
+        std::vector<std::string> dim_names(1, name);
+        std::vector<size_t> shape(1, dim->get_size());
+        std::string attrs = attrs_to_json(dim, dim_names);
+
+        if (dim->has_attr(COMPRESS_ATTR_NAME)) {
+            std::vector<int> indices(dim->get_values(), dim->get_values() + dim->get_size());
+            this->write_array<int>(name, dim_names, shape, indices.data(), false, 0, attrs, output_storage_t());
+        } else {
+            this->write_array<T>(name, dim_names, shape, dim->get_values(), false, T(), attrs, output_storage_t());
+        }
+    });
+}
+
+
+
+
+
+//==============================================================================
+// Public Methods
+//==============================================================================
+
+/**
+ * Plans a dimension and its coordinate variable on their own, such as the
+ * dimensions a CF list dimension gathers
+ */
+template<typename T>
+void zarr_writer_t::add_dim(const dimension_t<T>* dim) {
+    this->plan_dim(dim);
+}
+
+/**
+ * Plans a real-valued variable, along with the coordinate variables of its
+ * dimensions and all their attributes
+ */
+template<typename S, typename T>
+void zarr_writer_t::add(const variable_t<S, T>* var, const std::string name) {
+    if (var->is_lazy()) {
+        throw eof_error_t("Cannot write a variable read lazily from a file to a Zarr store");
+    }
+
+    for (size_t i = 0; i < var->get_num_dims(); i++) {
+        this->plan_dim(var->get_dim(i));
+    }
+
+    if (this->arrays.count(name) > 0) {
+        throw eof_error_t("Zarr store already has an array \"" + name + "\"");
+    }
+    this->arrays.insert(name);
+
+    output_storage_t storage = this->storage;
+    this->writes.push_back([this, name, var, storage]() {
+        std::vector<std::string> dim_names;
+        std::vector<size_t> shape;
+        for (size_t i = 0; i < var->get_num_dims(); i++) {
+            dim_names.push_back(var->get_dim(i)->get_name());
+            shape.push_back(var->get_dim(i)->get_size());
+        }
+
+        bool has_fill = var->has_missing_value();
+        S fill = has_fill ? var->get_missing_value() : S();
+        this->write_array<S>(name, dim_names, shape, var->get_data(), has_fill, fill, attrs_to_json(var, dim_names), storage);
+    });
+}